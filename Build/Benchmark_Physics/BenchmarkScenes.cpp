@@ -0,0 +1,219 @@
+#include "BenchmarkScenes.h"
+#include <ncltech/PhysicsEngine.h>
+#include <ncltech/SphereCollisionShape.h>
+#include <ncltech/CuboidCollisionShape.h>
+#include <ncltech/CapsuleCollisionShape.h>
+#include <ncltech/CompoundCollisionShape.h>
+#include <ncltech/DistanceConstraint.h>
+#include <ncltech/SoftBody.h>
+#include <ncltech/Octree.h>
+
+//Same bounds as TestScene, built from the ground's bounding radius
+static void CreateOctree(PhysicsNode* ground)
+{
+	const float r = ground->GetCollisionShape()->GetRadius();
+	PhysicsEngine::Instance()->octree = new Octree(
+		ground->GetPosition() - Vector3(r, r, r),
+		Vector3(r * 2.0f, r * 10.0f, r * 2.0f));
+}
+
+static PhysicsNode* CreateNode(const Vector3& pos, CollisionShape* shape, float inverse_mass)
+{
+	PhysicsNode* pnode = new PhysicsNode();
+	pnode->SetPosition(pos);
+	pnode->SetInverseMass(inverse_mass);
+	pnode->SetCollisionShape(shape);
+	pnode->SetInverseInertia(shape->BuildInverseInertia(inverse_mass));
+	return pnode;
+}
+
+PhysicsNode* BenchmarkScenes::CreateSphere(const Vector3& pos, float radius, float inverse_mass)
+{
+	return CreateNode(pos, new SphereCollisionShape(radius), inverse_mass);
+}
+
+PhysicsNode* BenchmarkScenes::CreateCuboid(const Vector3& pos, const Vector3& halfdims, float inverse_mass)
+{
+	return CreateNode(pos, new CuboidCollisionShape(halfdims), inverse_mass);
+}
+
+PhysicsNode* BenchmarkScenes::AddSphere(const Vector3& pos, float radius, float inverse_mass)
+{
+	PhysicsNode* pnode = CreateSphere(pos, radius, inverse_mass);
+	PhysicsEngine::Instance()->AddPhysicsObject(pnode);
+	return pnode;
+}
+
+PhysicsNode* BenchmarkScenes::AddCuboid(const Vector3& pos, const Vector3& halfdims, float inverse_mass)
+{
+	PhysicsNode* pnode = CreateCuboid(pos, halfdims, inverse_mass);
+	PhysicsEngine::Instance()->AddPhysicsObject(pnode);
+	return pnode;
+}
+
+//The ground has to be created before the octree, and the octree before anything is added to the engine
+static PhysicsNode* AddGround(const Vector3& pos, const Vector3& halfdims)
+{
+	PhysicsNode* ground = CreateNode(pos, new CuboidCollisionShape(halfdims), 0.0f);
+	CreateOctree(ground);
+	PhysicsEngine::Instance()->AddPhysicsObject(ground);
+	return ground;
+}
+
+
+void BenchmarkScenes::BuildSolverStacks(int stack_height)
+{
+	AddGround(Vector3(0.0f, -1.0f, 0.0f), Vector3(20.0f, 1.0f, 20.0f));
+
+	//Pyramid of cubes stacked on top of eachother
+	std::vector<PhysicsNode*> cubes;
+	cubes.reserve(stack_height * (stack_height + 1) / 2);
+	for (int y = 0; y < stack_height; ++y)
+	{
+		for (int x = 0; x <= y; ++x)
+		{
+			PhysicsNode* cube = CreateCuboid(
+				Vector3(x * 1.1f - y * 0.5f, 0.5f + float(stack_height - 1) - y, -0.5f),
+				Vector3(0.5f, 0.5f, 0.5f),
+				1.0f);
+			cube->SetElasticity(0.0f);
+			cube->SetFriction(1.0f);
+			cubes.push_back(cube);
+		}
+	}
+	PhysicsEngine::Instance()->AddPhysicsObjects(cubes);
+}
+
+void BenchmarkScenes::BuildTestScene()
+{
+	AddGround(Vector3(0.0f, -1.0f, 0.0f), Vector3(20.0f, 1.0f, 20.0f));
+
+	//Player (static, as it is only ever moved by the keyboard)
+	PhysicsEngine::Instance()->AddPhysicsObject(CreateNode(Vector3(5.f, 0.5f, 0.0f), new CapsuleCollisionShape(0.5f, 0.5f, 2), 0.0f));
+
+	auto create_cube_tower = [&](const Vector3& offset, float cubewidth)
+	{
+		const Vector3 halfdims = Vector3(cubewidth, cubewidth, cubewidth) * 0.5f;
+
+		std::vector<PhysicsNode*> cubes;
+		cubes.reserve(2 * 6);
+		for (int x = 0; x < 2; ++x)
+		{
+			for (int y = 0; y < 6; ++y)
+			{
+				uint idx = x * 5 + y;
+				Vector3 pos = offset + Vector3(x * cubewidth, 1e-3f + y * cubewidth, cubewidth * (idx % 2 == 0) ? 0.5f : -0.5f);
+				cubes.push_back(CreateCuboid(pos, halfdims, 1.f));
+			}
+		}
+		PhysicsEngine::Instance()->AddPhysicsObjects(cubes);
+	};
+
+	auto create_ball_cube = [&](const Vector3& offset, const Vector3& scale, float ballsize)
+	{
+		const int dims = 4;
+
+		std::vector<PhysicsNode*> spheres;
+		spheres.reserve(dims * dims * dims);
+		for (int x = 0; x < dims; ++x)
+		{
+			for (int y = 0; y < dims; ++y)
+			{
+				for (int z = 0; z < dims; ++z)
+				{
+					Vector3 pos = offset + Vector3(scale.x *x, scale.y * y, scale.z * z);
+					spheres.push_back(CreateNode(pos, new SphereCollisionShape(ballsize), 10.f));
+				}
+			}
+		}
+		PhysicsEngine::Instance()->AddPhysicsObjects(spheres);
+	};
+
+	auto create_soft_body = [&](const Vector3& offset, const Vector3& scale, float ballsize)
+	{
+		const int dims = 15;
+
+		SoftBody* cloth = new SoftBody();
+		cloth->BuildClothGrid(
+			offset + Vector3(0.0f, 0.0f, scale.z),
+			Vector3(scale.x * (dims - 1), 0.0f, 0.0f),
+			Vector3(0.0f, scale.y * (dims - 1), 0.0f),
+			dims, dims,
+			10.f * dims * dims,
+			ballsize);
+
+		//Pin the top two corners
+		cloth->SetParticleInverseMass(cloth->GetClothParticleIndex(0, dims - 1), 0.0f);
+		cloth->SetParticleInverseMass(cloth->GetClothParticleIndex(dims - 1, dims - 1), 0.0f);
+
+		PhysicsEngine::Instance()->AddSoftBody(cloth);
+	};
+
+	create_cube_tower(Vector3(3.0f, 0.5f, 3.0f), 1.0f);
+	create_cube_tower(Vector3(-3.0f, 0.5f, -3.0f), 1.0f);
+
+	create_ball_cube(Vector3(-8.0f, 0.5f, 12.0f), Vector3(0.5f, 0.5f, 0.5f), 0.1f);
+	create_ball_cube(Vector3(8.0f, 0.5f, 12.0f), Vector3(0.3f, 0.3f, 0.3f), 0.1f);
+	create_ball_cube(Vector3(-8.0f, 0.5f, -12.0f), Vector3(0.2f, 0.2f, 0.2f), 0.1f);
+	create_ball_cube(Vector3(8.0f, 0.5f, -12.0f), Vector3(0.5f, 0.5f, 0.5f), 0.1f);
+
+	create_soft_body(Vector3(10.0f, 10.0f, 10.0f), Vector3(0.25f, 0.25f, 0.25f), 0.1f);
+
+	//Target hanging from a static sphere
+	PhysicsNode* target = AddCuboid(Vector3(10.0f, 10.0f, 0.0f), Vector3(1.0f, 1.0f, 1.0f), 10.0f);
+	PhysicsNode* anchor = AddSphere(Vector3(0.0f, 10.0f, 0.0f), 1.0f, 0.0f);
+	PhysicsEngine::Instance()->AddConstraint(new DistanceConstraint(anchor, target, anchor->GetPosition(), target->GetPosition()));
+
+	//Cube and sphere glued into a single body
+	CompoundCollisionShape* compound = new CompoundCollisionShape();
+	compound->AddChild(new CuboidCollisionShape(Vector3(1.0f, 1.0f, 1.0f)));
+	compound->AddChild(new SphereCollisionShape(1.0f), Vector3(0.0f, -1.0f, 0.0f));
+	PhysicsEngine::Instance()->AddPhysicsObject(CreateNode(Vector3(10.0f, 15.0f, 0.0f), compound, 10.0f));
+}
+
+void BenchmarkScenes::BuildBallPool()
+{
+	//Floor, ceiling and four walls
+	AddGround(Vector3(0.0f, -1.0f, 0.0f), Vector3(20.0f, 1.0f, 20.0f));
+	PhysicsEngine::Instance()->AddPhysicsObjects({
+		CreateCuboid(Vector3(0.0f, 39.0f, 0.0f), Vector3(20.0f, 1.0f, 20.0f), 0.0f),
+		CreateCuboid(Vector3(-20.0f, 19.0f, 0.0f), Vector3(1.0f, 20.0f, 20.0f), 0.0f),
+		CreateCuboid(Vector3(20.0f, 19.0f, 0.0f), Vector3(1.0f, 20.0f, 20.0f), 0.0f),
+		CreateCuboid(Vector3(0.0f, 19.0f, -20.0f), Vector3(20.0f, 20.0f, 1.0f), 0.0f),
+		CreateCuboid(Vector3(0.0f, 19.0f, 20.0f), Vector3(20.0f, 20.0f, 1.0f), 0.0f) });
+
+	const int dims = 13;
+	const Vector3 offset = Vector3(-18.0f, 1.0f, -18.0f);
+	const float spacing = 3.0f;
+
+	std::vector<PhysicsNode*> spheres;
+	spheres.reserve(dims * dims * dims);
+	for (int x = 0; x < dims; ++x)
+	{
+		for (int y = 0; y < dims; ++y)
+		{
+			for (int z = 0; z < dims; ++z)
+			{
+				PhysicsNode* sphere = CreateNode(offset + Vector3(x, y, z) * spacing, new SphereCollisionShape(1.0f), 10.f);
+				sphere->SetElasticity(0.0f);
+				spheres.push_back(sphere);
+			}
+		}
+	}
+	PhysicsEngine::Instance()->AddPhysicsObjects(spheres);
+}
+
+bool BenchmarkScenes::BuildScene(const std::string& name)
+{
+	if (name == "solver")			BuildSolverStacks();
+	else if (name == "testscene")	BuildTestScene();
+	else if (name == "ballpool")	BuildBallPool();
+	else							return false;
+
+	return true;
+}
+
+void BenchmarkScenes::ClearScene()
+{
+	PhysicsEngine::Instance()->RemoveAllPhysicsObjects();
+}
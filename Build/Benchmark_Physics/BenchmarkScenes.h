@@ -0,0 +1,48 @@
+/******************************************************************************
+Namespace: BenchmarkScenes
+Implements:
+Author:
+Pieran Marris      <p.marris@newcastle.ac.uk> and YOU!
+Description:
+
+Rebuilds the layouts of the physics scenes straight into the PhysicsEngine, without any
+GameObjects, RenderNodes or graphics context, so they can be stepped headless by the benchmark.
+
+ - Solver Stacks: The pyramid of cubes from Tuts_Physics -> Phy7_Solver
+ - Test Scene:    The cube towers, ball cubes, cloth and constraint from GameTech Coursework -> TestScene
+ - Ball Pool:     The 13x13x13 cube of balls inside the walls of GameTech Coursework -> BallPool
+
+The layouts are copied by hand, so if one of the scenes above changes it's builder here should
+follow, otherwise the benchmark results will no longer reflect the scene.
+
+*//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <nclgl/Vector3.h>
+#include <ncltech/PhysicsNode.h>
+#include <string>
+
+namespace BenchmarkScenes
+{
+	//Scene builders, each expects the PhysicsEngine to be empty
+	// - The world is built around an octree covering the ground, which is owned by the PhysicsEngine.
+	void BuildSolverStacks(int stack_height = 6);
+	void BuildTestScene();
+	void BuildBallPool();
+
+	//Builds a scene by name ("solver", "testscene" or "ballpool"), returning false if the name is not recognised
+	bool BuildScene(const std::string& name);
+
+	//Removes all bodies/constraints, along with the scene's octree
+	void ClearScene();
+
+
+	//Creates a single collidable body, without adding it to the PhysicsEngine (an inverse mass of zero is static)
+	PhysicsNode* CreateSphere(const Vector3& pos, float radius, float inverse_mass);
+	PhysicsNode* CreateCuboid(const Vector3& pos, const Vector3& halfdims, float inverse_mass);
+
+	//As above, but also adds the body to the PhysicsEngine
+	PhysicsNode* AddSphere(const Vector3& pos, float radius, float inverse_mass);
+	PhysicsNode* AddCuboid(const Vector3& pos, const Vector3& halfdims, float inverse_mass);
+};
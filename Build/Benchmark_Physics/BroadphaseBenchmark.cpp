@@ -0,0 +1,341 @@
+#include "BroadphaseBenchmark.h"
+#include "BenchmarkScenes.h"
+#include <ncltech/CollisionDetectionSAT.h>
+#include <ncltech/Octree.h>
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#define NUM_BROADPHASE_METHODS 3
+
+//Indexed by PhysicsBroadphaseMethod
+static const char* g_MethodNames[NUM_BROADPHASE_METHODS] = { "Brute Force", "Sphere-Sphere", "Octree" };
+
+//Distance each dynamic body is moved (on each axis) between iterations
+static const float g_JitterDistance = 0.05f;
+
+struct BroadphaseResult
+{
+	float	insertMs;
+	float	buildMs;		//Averaged over every iteration
+	float	queryMs;
+	uint	pairs;			//From the last iteration
+	uint	duplicates;
+	uint	overlapping;	//Unique pairs whose shapes are actually touching
+};
+
+BroadphaseBenchmark::Settings::Settings()
+	: iterations(10)
+	, maxBruteForceBodies(5000)
+	, maxSphereBodies(20000)
+{
+	workloads.push_back("uniform");
+	workloads.push_back("clustered");
+	workloads.push_back("stacks");
+	workloads.push_back("mixed");
+
+	bodyCounts.push_back(100);
+	bodyCounts.push_back(1000);
+	bodyCounts.push_back(10000);
+	bodyCounts.push_back(100000);
+}
+
+static float RandomFloat(float lower, float upper)
+{
+	return lower + (upper - lower) * (rand() / float(RAND_MAX));
+}
+
+//Roughly normal distribution in [-1, 1], for packing bodies towards the centre of a cluster
+static float RandomClustered()
+{
+	return (RandomFloat(-1.0f, 1.0f) + RandomFloat(-1.0f, 1.0f) + RandomFloat(-1.0f, 1.0f)) / 3.0f;
+}
+
+static Vector3 RandomVector(float lower, float upper)
+{
+	return Vector3(RandomFloat(lower, upper), RandomFloat(lower, upper), RandomFloat(lower, upper));
+}
+
+
+//Workload builders, each returns num_bodies bodies that have not yet been added to the PhysicsEngine
+static void BuildUniform(uint num_bodies, std::vector<PhysicsNode*>& out_nodes)
+{
+	//Keeps the density the same at every body count
+	const float size = powf(float(num_bodies), 1.0f / 3.0f) * 2.5f;
+	for (uint i = 0; i < num_bodies; ++i)
+	{
+		const Vector3 pos = RandomVector(0.0f, size);
+		if (i % 2 == 0)
+			out_nodes.push_back(BenchmarkScenes::CreateSphere(pos, 0.5f, 1.0f));
+		else
+			out_nodes.push_back(BenchmarkScenes::CreateCuboid(pos, Vector3(0.4f, 0.4f, 0.4f), 1.0f));
+	}
+}
+
+static void BuildClustered(uint num_bodies, std::vector<PhysicsNode*>& out_nodes)
+{
+	const uint num_clusters = 16;
+	const float size = powf(float(num_bodies), 1.0f / 3.0f) * 10.0f;
+	const float cluster_radius = powf(float(num_bodies) / num_clusters, 1.0f / 3.0f) * 1.25f;
+
+	std::vector<Vector3> centres(num_clusters);
+	for (Vector3& centre : centres)
+	{
+		centre = RandomVector(cluster_radius, size - cluster_radius);
+	}
+
+	for (uint i = 0; i < num_bodies; ++i)
+	{
+		const Vector3 pos = centres[i % num_clusters]
+			+ Vector3(RandomClustered(), RandomClustered(), RandomClustered()) * cluster_radius;
+		if (i % 2 == 0)
+			out_nodes.push_back(BenchmarkScenes::CreateSphere(pos, 0.5f, 1.0f));
+		else
+			out_nodes.push_back(BenchmarkScenes::CreateCuboid(pos, Vector3(0.4f, 0.4f, 0.4f), 1.0f));
+	}
+}
+
+static void BuildStacks(uint num_bodies, std::vector<PhysicsNode*>& out_nodes)
+{
+	const uint stack_height = 10;
+	const float spacing = 1.5f;
+
+	//Each cube sinks slightly into the one below, as they would when resting on each other
+	const float cube_step = 0.99f;
+
+	const uint num_cubes = (num_bodies > 0) ? num_bodies - 1 : 0;
+	const uint num_stacks = (num_cubes + stack_height - 1) / stack_height;
+	const uint grid_width = (uint)ceilf(sqrtf(float(num_stacks)));
+
+	const float ground_half = grid_width * spacing * 0.5f + 1.0f;
+	out_nodes.push_back(BenchmarkScenes::CreateCuboid(
+		Vector3(grid_width * spacing * 0.5f, -1.0f, grid_width * spacing * 0.5f),
+		Vector3(ground_half, 1.0f, ground_half),
+		0.0f));
+
+	for (uint i = 0; i < num_cubes; ++i)
+	{
+		const uint stack = i / stack_height;
+		const uint level = i % stack_height;
+		const Vector3 pos = Vector3(
+			(stack % grid_width + 0.5f) * spacing,
+			0.5f + level * cube_step - 0.005f,
+			(stack / grid_width + 0.5f) * spacing);
+		out_nodes.push_back(BenchmarkScenes::CreateCuboid(pos, Vector3(0.5f, 0.5f, 0.5f), 1.0f));
+	}
+}
+
+static void BuildMixed(uint num_bodies, std::vector<PhysicsNode*>& out_nodes)
+{
+	const float size = powf(float(num_bodies), 1.0f / 3.0f) * 3.0f;
+	for (uint i = 0; i < num_bodies; ++i)
+	{
+		const Vector3 pos = RandomVector(0.0f, size);
+
+		//One in twenty bodies is large, half of which are cuboids
+		if (i % 20 == 0)
+		{
+			if (i % 40 == 0)
+				out_nodes.push_back(BenchmarkScenes::CreateSphere(pos, RandomFloat(3.0f, 6.0f), 0.0f));
+			else
+				out_nodes.push_back(BenchmarkScenes::CreateCuboid(pos, RandomVector(2.0f, 6.0f), 0.0f));
+		}
+		else
+		{
+			out_nodes.push_back(BenchmarkScenes::CreateSphere(pos, RandomFloat(0.25f, 0.5f), 1.0f));
+		}
+	}
+}
+
+typedef void(*WorkloadBuilder)(uint num_bodies, std::vector<PhysicsNode*>& out_nodes);
+
+//Returns NULL if the name is not recognised
+static WorkloadBuilder FindWorkload(const std::string& workload)
+{
+	if (workload == "uniform")			return BuildUniform;
+	else if (workload == "clustered")	return BuildClustered;
+	else if (workload == "stacks")		return BuildStacks;
+	else if (workload == "mixed")		return BuildMixed;
+	else								return NULL;
+}
+
+//Fits the octree around every body, with room for them to move
+static Octree* CreateFittedOctree(const std::vector<PhysicsNode*>& nodes)
+{
+	Vector3 lower = Vector3(FLT_MAX, FLT_MAX, FLT_MAX);
+	Vector3 upper = Vector3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	for (PhysicsNode* pnode : nodes)
+	{
+		const float r = pnode->GetCollisionShape()->GetRadius();
+		const Vector3& pos = pnode->GetPosition();
+		lower = Vector3(min(lower.x, pos.x - r), min(lower.y, pos.y - r), min(lower.z, pos.z - r));
+		upper = Vector3(max(upper.x, pos.x + r), max(upper.y, pos.y + r), max(upper.z, pos.z + r));
+	}
+
+	const Vector3 padding = Vector3(1.0f, 1.0f, 1.0f);
+	return new Octree(lower - padding, upper - lower + padding * 2.0f);
+}
+
+static float ElapsedMs(const std::chrono::high_resolution_clock::time_point& begin)
+{
+	return std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - begin).count();
+}
+
+//Counts the duplicate and truly overlapping pairs in the engine's current broadphase output
+static void CountOverlappingPairs(BroadphaseResult& result)
+{
+	std::vector<CollisionPair> pairs = PhysicsEngine::Instance()->GetBroadphasePairs();
+	for (CollisionPair& cp : pairs)
+	{
+		if (cp.pObjectB < cp.pObjectA) std::swap(cp.pObjectA, cp.pObjectB);
+	}
+	std::sort(pairs.begin(), pairs.end(), [](const CollisionPair& l, const CollisionPair& r)
+	{
+		return (l.pObjectA != r.pObjectA) ? (l.pObjectA < r.pObjectA) : (l.pObjectB < r.pObjectB);
+	});
+	pairs.erase(std::unique(pairs.begin(), pairs.end(), [](const CollisionPair& l, const CollisionPair& r)
+	{
+		return l.pObjectA == r.pObjectA && l.pObjectB == r.pObjectB;
+	}), pairs.end());
+
+	result.duplicates = result.pairs - (uint)pairs.size();
+	result.overlapping = 0;
+
+	CollisionDetectionSAT colDetect;
+	for (const CollisionPair& cp : pairs)
+	{
+		colDetect.BeginNewPair(cp.pObjectA, cp.pObjectB, cp.pObjectA->GetCollisionShape(), cp.pObjectB->GetCollisionShape());
+		if (colDetect.AreColliding())
+			result.overlapping++;
+	}
+}
+
+static void RunMethod(const std::string& workload, uint num_bodies, PhysicsBroadphaseMethod method, uint iterations, BroadphaseResult& result)
+{
+	PhysicsEngine* engine = PhysicsEngine::Instance();
+	engine->SetDefaults();
+	engine->SetBroadphaseMethod(method);
+
+	//Same seed for every method, so they all see exactly the same bodies
+	srand(1);
+	std::vector<PhysicsNode*> nodes;
+	nodes.reserve(num_bodies);
+	FindWorkload(workload)(num_bodies, nodes);
+
+	//Only the octree method needs (or maintains) an octree
+	if (method == BROADPHASE_OCTREE)
+		engine->octree = CreateFittedOctree(nodes);
+
+	auto begin = std::chrono::high_resolution_clock::now();
+	engine->AddPhysicsObjects(nodes);
+	result.insertMs = ElapsedMs(begin);
+
+	double build_ms = 0.0, query_ms = 0.0;
+	for (uint i = 0; i < iterations; ++i)
+	{
+		if (i > 0)
+		{
+			for (PhysicsNode* pnode : nodes)
+			{
+				if (pnode->GetInverseMass() > 0.0f)
+					pnode->SetPosition(pnode->GetPosition() + RandomVector(-g_JitterDistance, g_JitterDistance));
+			}
+		}
+
+		begin = std::chrono::high_resolution_clock::now();
+		engine->BuildBroadphase();
+		build_ms += ElapsedMs(begin);
+
+		begin = std::chrono::high_resolution_clock::now();
+		engine->FindBroadphasePairs();
+		query_ms += ElapsedMs(begin);
+	}
+
+	result.buildMs = float(build_ms / iterations);
+	result.queryMs = float(query_ms / iterations);
+	result.pairs = (uint)engine->GetBroadphasePairs().size();
+	CountOverlappingPairs(result);
+
+	BenchmarkScenes::ClearScene();
+}
+
+static float FalsePositiveRatio(const BroadphaseResult& result)
+{
+	return (result.pairs > 0) ? 1.0f - float(result.overlapping) / float(result.pairs) : 0.0f;
+}
+
+bool BroadphaseBenchmark::Run(const Settings& settings)
+{
+	for (const std::string& workload : settings.workloads)
+	{
+		if (!FindWorkload(workload))
+		{
+			printf("Unknown broadphase workload: %s\n", workload.c_str());
+			return false;
+		}
+	}
+
+	FILE* csv = NULL;
+	if (!settings.csvFilename.empty())
+	{
+		if (fopen_s(&csv, settings.csvFilename.c_str(), "w") || !csv)
+		{
+			printf("Unable to open \"%s\" for writing\n", settings.csvFilename.c_str());
+			csv = NULL;
+		}
+		else
+		{
+			fputs("workload,bodies,method,insert_ms,build_ms,query_ms,pairs,duplicates,overlapping,false_positive_ratio\n", csv);
+		}
+	}
+
+	const uint iterations = max(settings.iterations, 1u);
+	const uint method_limits[NUM_BROADPHASE_METHODS] = { settings.maxBruteForceBodies, settings.maxSphereBodies, UINT_MAX };
+
+	for (const std::string& workload : settings.workloads)
+	{
+		printf("\n[broadphase: %s] %d iterations\n", workload.c_str(), iterations);
+		printf("    %8s %-14s %10s %10s %10s %10s %10s %10s\n",
+			"Bodies", "Method", "Insert(ms)", "Build(ms)", "Query(ms)", "Pairs", "Touching", "False Pos");
+
+		for (uint num_bodies : settings.bodyCounts)
+		{
+			for (uint m = 0; m < NUM_BROADPHASE_METHODS; ++m)
+			{
+				if (num_bodies > method_limits[m])
+				{
+					printf("    %8d %-14s    skipped (limited to %d bodies)\n", num_bodies, g_MethodNames[m], method_limits[m]);
+					continue;
+				}
+
+				BroadphaseResult result;
+				RunMethod(workload, num_bodies, PhysicsBroadphaseMethod(m), iterations, result);
+
+				printf("    %8d %-14s %10.3f %10.3f %10.3f %10d %10d %9.1f%%\n",
+					num_bodies, g_MethodNames[m], result.insertMs, result.buildMs, result.queryMs,
+					result.pairs, result.overlapping, FalsePositiveRatio(result) * 100.0f);
+				if (result.duplicates > 0)
+				{
+					printf("    %8s %-14s    (%d duplicate pairs)\n", "", "", result.duplicates);
+				}
+
+				if (csv)
+				{
+					fprintf(csv, "%s,%d,%s,%f,%f,%f,%d,%d,%d,%f\n",
+						workload.c_str(), num_bodies, g_MethodNames[m], result.insertMs, result.buildMs, result.queryMs,
+						result.pairs, result.duplicates, result.overlapping, FalsePositiveRatio(result));
+					fflush(csv);
+				}
+			}
+		}
+	}
+
+	if (csv) fclose(csv);
+
+	PhysicsEngine::Instance()->SetBroadphaseMethod(BROADPHASE_OCTREE);
+	return true;
+}
@@ -0,0 +1,56 @@
+/******************************************************************************
+Namespace: BroadphaseBenchmark
+Implements:
+Author:
+Pieran Marris      <p.marris@newcastle.ac.uk> and YOU!
+Description:
+
+Compares the broadphase methods (See PhysicsBroadphaseMethod) on synthetic workloads, from a
+hundred bodies up to as many as you are willing to wait for. Only the broadphase is run, the bodies
+are jittered a little between each iteration to look like a simulation step without paying for the
+narrowphase or solver.
+
+Workloads:
+ - Uniform:   Small spheres and cubes spread evenly through a box with a constant density
+ - Clustered: The same bodies packed into a handful of dense clumps in a much larger box
+ - Stacks:    Columns of touching cubes standing on a single large static ground
+ - Mixed:     Mostly small spheres with a few large cuboids and spheres scattered between them
+
+For each workload/body count/method it reports:
+ - Insert:    Time taken to add the bodies to the engine (bulk loading the octree if used)
+ - Build:     Average time to bring the broadphase structure up to date each iteration
+ - Query:     Average time to find the pairs each iteration
+ - Pairs:     Number of pairs handed to the narrowphase
+ - False Pos: Fraction of those pairs whose shapes are not actually touching, duplicate pairs are
+              counted as false positives as the narrowphase has to test them again
+
+The quadratic methods are skipped above a body limit, as brute force in particular needs memory
+for every pair of bodies.
+
+*//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <ncltech/PhysicsEngine.h>
+#include <string>
+#include <vector>
+
+namespace BroadphaseBenchmark
+{
+	struct Settings
+	{
+		std::vector<std::string>	workloads;		//"uniform", "clustered", "stacks" and/or "mixed"
+		std::vector<uint>			bodyCounts;
+		uint						iterations;		//Build/query iterations to average over
+		uint						maxBruteForceBodies;
+		uint						maxSphereBodies;
+		std::string					csvFilename;	//Every result is also written here, if not empty
+
+		Settings();
+	};
+
+	//Runs every workload at every body count with each broadphase method, printing the results
+	// - Expects the PhysicsEngine to be empty, and leaves it empty
+	// - Returns false if a workload is not recognised
+	bool Run(const Settings& settings);
+};
@@ -0,0 +1,259 @@
+/******************************************************************************
+Project: Benchmark_Physics
+Author:
+Pieran Marris      <p.marris@newcastle.ac.uk> and YOU!
+Description:
+
+Headless physics benchmark. Builds the tutorial/coursework scene layouts (See BenchmarkScenes.h)
+directly into the PhysicsEngine with no window or renderer, steps each of them a fixed number of
+times with a fixed timestep and reports the time taken by each stage of the step along with the
+averaged step counters (pairs, contacts etc).
+
+Usage: Benchmark_Physics [options]
+  --scene <name>      solver, testscene, ballpool or all (default: all)
+  --steps <n>         Steps to record per scene (default: 1000)
+  --warmup <n>        Steps to run before recording starts (default: 60)
+  --timestep <secs>   Fixed physics timestep (default: 1/60)
+  --reorder <n>       Steps between re-sorting the bodies by position, 0 for never (default: 0)
+  --csv <prefix>      Writes every recorded step to <prefix>_<scene>.csv
+  --json <prefix>     Writes every recorded step to <prefix>_<scene>.json
+
+Broadphase suite (See BroadphaseBenchmark.h), run instead of the scenes:
+  --broadphase <name> uniform, clustered, stacks, mixed or all
+  --bodies <n,n,..>   Body counts to test (default: 100,1000,10000,100000)
+  --iterations <n>    Build/query iterations averaged for each result (default: 10)
+  --csv <prefix>      Writes every result to <prefix>_broadphase.csv
+
+The random seed is reset before each scene, so runs on the same machine are directly comparable.
+
+Besides the Visual Studio project, the benchmark can be built on any platform with Build/CMakeLists.txt,
+which compiles the physics core of ncltech headless (USE_HEADLESS_PHYSICS) with no GL dependencies.
+
+*//////////////////////////////////////////////////////////////////////////////
+
+#include <ncltech/PhysicsEngine.h>
+#include "BenchmarkScenes.h"
+#include "BroadphaseBenchmark.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+struct BenchmarkSettings
+{
+	std::vector<std::string> scenes;
+	uint		numSteps;
+	uint		numWarmupSteps;
+	float		timestep;
+	uint		reorderInterval;
+	std::string	csvPrefix;
+	std::string	jsonPrefix;
+
+	bool		runBroadphase;
+	BroadphaseBenchmark::Settings broadphase;
+};
+
+//Summary of a single value over every recorded step
+struct BenchmarkStat
+{
+	float mean, p50, p95, max;
+};
+
+static BenchmarkStat ComputeStat(std::vector<float>& samples)
+{
+	BenchmarkStat stat;
+	memset(&stat, 0, sizeof(BenchmarkStat));
+	if (samples.empty())
+		return stat;
+
+	std::sort(samples.begin(), samples.end());
+
+	double sum = 0.0;
+	for (float s : samples) sum += s;
+
+	const size_t last = samples.size() - 1;
+	stat.mean = float(sum / samples.size());
+	stat.p50 = samples[last / 2];
+	stat.p95 = samples[(last * 95) / 100];
+	stat.max = samples[last];
+	return stat;
+}
+
+static void PrintStat(const char* name, const BenchmarkStat& stat)
+{
+	printf("    %-14s %9.4f %9.4f %9.4f %9.4f\n", name, stat.mean, stat.p50, stat.p95, stat.max);
+}
+
+static bool ParseArguments(int argc, char** argv, BenchmarkSettings& settings)
+{
+	settings.numSteps = 1000;
+	settings.numWarmupSteps = 60;
+	settings.timestep = 1.0f / 60.0f;
+	settings.reorderInterval = 0;
+	settings.runBroadphase = false;
+
+	std::string scene = "all";
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string arg = argv[i];
+		const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+		//Every option takes a value
+		if (value) i++;
+
+		if (arg == "--scene" && value)			scene = value;
+		else if (arg == "--steps" && value)		settings.numSteps = (uint)max(atoi(value), 1);
+		else if (arg == "--warmup" && value)	settings.numWarmupSteps = (uint)max(atoi(value), 0);
+		else if (arg == "--timestep" && value)	settings.timestep = max((float)atof(value), 1e-4f);
+		else if (arg == "--reorder" && value)	settings.reorderInterval = (uint)max(atoi(value), 0);
+		else if (arg == "--csv" && value)		settings.csvPrefix = value;
+		else if (arg == "--json" && value)		settings.jsonPrefix = value;
+		else if (arg == "--broadphase" && value)
+		{
+			settings.runBroadphase = true;
+			if (strcmp(value, "all") != 0)
+			{
+				settings.broadphase.workloads.clear();
+				settings.broadphase.workloads.push_back(value);
+			}
+		}
+		else if (arg == "--bodies" && value)
+		{
+			settings.broadphase.bodyCounts.clear();
+			for (const char* itr = value; *itr; )
+			{
+				const int count = atoi(itr);
+				if (count > 0) settings.broadphase.bodyCounts.push_back((uint)count);
+
+				itr = strchr(itr, ',');
+				if (!itr) break;
+				itr++;
+			}
+		}
+		else if (arg == "--iterations" && value)	settings.broadphase.iterations = (uint)max(atoi(value), 1);
+		else
+		{
+			printf("Unknown argument: %s\n", arg.c_str());
+			printf("Usage: Benchmark_Physics [--scene solver|testscene|ballpool|all] [--steps n] [--warmup n] [--timestep secs] [--reorder n] [--csv prefix] [--json prefix]\n");
+			printf("       Benchmark_Physics --broadphase uniform|clustered|stacks|mixed|all [--bodies n,n,..] [--iterations n] [--csv prefix]\n");
+			return false;
+		}
+	}
+
+	if (!settings.csvPrefix.empty())
+		settings.broadphase.csvFilename = settings.csvPrefix + "_broadphase.csv";
+
+	if (scene == "all")
+	{
+		settings.scenes.push_back("solver");
+		settings.scenes.push_back("testscene");
+		settings.scenes.push_back("ballpool");
+	}
+	else
+	{
+		settings.scenes.push_back(scene);
+	}
+	return true;
+}
+
+static bool RunScene(const std::string& scene, const BenchmarkSettings& settings)
+{
+	PhysicsEngine* engine = PhysicsEngine::Instance();
+	engine->SetDefaults();
+	engine->SetUpdateTimestep(settings.timestep);
+	engine->SetReorderInterval(settings.reorderInterval);
+	engine->SetPaused(false);
+
+	srand(1);
+	if (!BenchmarkScenes::BuildScene(scene))
+	{
+		printf("Unknown scene: %s\n", scene.c_str());
+		return false;
+	}
+
+	const uint num_bodies = engine->GetNumPhysicsObjects();
+
+	//Let the scene settle out of it's spawn positions before anything is recorded
+	for (uint i = 0; i < settings.numWarmupSteps; ++i)
+	{
+		engine->Update(settings.timestep);
+	}
+
+	PhysicsCounterLog& log = engine->GetCounterLog();
+	log.SetCapacity(settings.numSteps);
+
+	std::vector<float> step_ms;
+	step_ms.reserve(settings.numSteps);
+	for (uint i = 0; i < settings.numSteps; ++i)
+	{
+		auto begin = std::chrono::high_resolution_clock::now();
+		engine->Update(settings.timestep);
+		auto end = std::chrono::high_resolution_clock::now();
+		step_ms.push_back(std::chrono::duration<float, std::milli>(end - begin).count());
+	}
+
+	const uint num_steps = log.GetNumSteps();
+
+	std::vector<float> broadphase, narrowphase, integration, solver, soft_body;
+	double pairs = 0.0, axes = 0.0, early_outs = 0.0, manifolds = 0.0, contacts = 0.0, awake = 0.0;
+	for (uint i = 0; i < num_steps; ++i)
+	{
+		const PhysicsStepCounters& c = log.GetStep(i);
+		broadphase.push_back(c.broadphaseMs);
+		narrowphase.push_back(c.narrowphaseMs);
+		integration.push_back(c.integrationMs);
+		solver.push_back(c.solverMs);
+		soft_body.push_back(c.softBodyMs);
+
+		pairs += c.broadphasePairs;
+		axes += c.satAxesTested;
+		early_outs += c.satEarlyOuts;
+		manifolds += c.manifolds;
+		contacts += c.contacts;
+		awake += c.awakeBodies;
+	}
+	const double inv_steps = (num_steps > 0) ? 1.0 / num_steps : 0.0;
+
+	printf("\n[%s] %d bodies, %d steps of %.4fs\n", scene.c_str(), num_bodies, num_steps, settings.timestep);
+	printf("    %-14s %9s %9s %9s %9s\n", "Stage (ms)", "mean", "p50", "p95", "max");
+	PrintStat("Step Total", ComputeStat(step_ms));
+	PrintStat("Broadphase", ComputeStat(broadphase));
+	PrintStat("Narrowphase", ComputeStat(narrowphase));
+	PrintStat("Integration", ComputeStat(integration));
+	PrintStat("Solver", ComputeStat(solver));
+	PrintStat("Soft Bodies", ComputeStat(soft_body));
+	printf("    Avg per step: %.1f pairs, %.1f SAT axes (%.1f early outs), %.1f manifolds, %.1f contacts, %.1f awake bodies\n",
+		pairs * inv_steps, axes * inv_steps, early_outs * inv_steps, manifolds * inv_steps, contacts * inv_steps, awake * inv_steps);
+
+	if (!settings.csvPrefix.empty()) log.ExportCSV(settings.csvPrefix + "_" + scene + ".csv");
+	if (!settings.jsonPrefix.empty()) log.ExportJSON(settings.jsonPrefix + "_" + scene + ".json");
+
+	BenchmarkScenes::ClearScene();
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	BenchmarkSettings settings;
+	if (!ParseArguments(argc, argv, settings))
+		return 1;
+
+	bool ok = true;
+	if (settings.runBroadphase)
+	{
+		ok = BroadphaseBenchmark::Run(settings.broadphase);
+	}
+	else
+	{
+		for (const std::string& scene : settings.scenes)
+		{
+			ok = RunScene(scene, settings) && ok;
+		}
+	}
+
+	PhysicsEngine::Release();
+	return ok ? 0 : 1;
+}
@@ -44,18 +44,21 @@ void BallPool::OnInitializeScene()
 	GameObject* front = BuildCuboidObject("InvisibleWall", Vector3(20.0f, 19.0f, 0.0f), Vector3(1.0f, 20.0f, 20.0f), true, 0.0f, true, false, Vector4(0.2f, 0.5f, 1.0f, 0.0f));
 	GameObject* right = BuildCuboidObject("InvisibleWall", Vector3(0.0f, 19.0f, -20.0f), Vector3(20.0f, 20.0f, 1.0f), true, 0.0f, true, false, Vector4(0.2f, 0.5f, 1.0f, 0.0f));
 	GameObject* left = BuildCuboidObject("InvisibleWall", Vector3(0.0f, 19.0f, 20.0f), Vector3(20.0f, 20.0f, 1.0f), true, 0.0f, true, false, Vector4(0.2f, 0.5f, 1.0f, 0.0f));
-	this->AddGameObject(ground);
-	this->AddGameObject(top);
-	this->AddGameObject(back);
-	this->AddGameObject(front);
-	this->AddGameObject(right);
-	this->AddGameObject(left);
+	for (GameObject* wall : { ground, top, back, front, right, left })
+	{
+		//Projectiles are masked out of the walls, so can be fired in from outside (See TestScene.h)
+		wall->Physics()->SetCollisionLayer(COLLISION_LAYER_INVISIBLEWALL);
+		wall->Physics()->SetCollisionMask(~uint(COLLISION_LAYER_PROJECTILE));
+	}
+	this->AddGameObjects({ ground, top, back, front, right, left });
 
 	auto create_ball_cube = [&](const Vector3& offset, const Vector3& scale, float ballsize)
 	{
 		const int dims = 13;
 		const Vector4 col = Vector4(0.0f, 0.0f, 1.0f, 1.0f);
 
+		std::vector<GameObject*> spheres;
+		spheres.reserve(dims * dims * dims);
 		for (int x = 0; x < dims; ++x)
 		{
 			for (int y = 0; y < dims; ++y)
@@ -73,10 +76,11 @@ void BallPool::OnInitializeScene()
 						true,				// Dragable by user?
 						col);// Render color
 					sphere->Physics()->SetElasticity(0.0f);
-					this->AddGameObject(sphere);
+					spheres.push_back(sphere);
 				}
 			}
 		}
+		this->AddGameObjects(spheres);
 	};
 
 	create_ball_cube(Vector3(-18.0f, 1.0f, -18.0f), Vector3(3.0f, 3.0f, 3.0f), 1.0f);
@@ -117,6 +121,8 @@ void BallPool::OnUpdateScene(float dt)
 
 void BallPool::SpawnSphere() {
 	GameObject* sphere = BuildSphereObject("Spawn", GraphicsPipeline::Instance()->GetCamera()->GetPosition(), 1.0f, true, 10.0f, true, true, Vector4(1, 0, 0, 1), S_texture);
+	sphere->Physics()->SetCollisionLayer(COLLISION_LAYER_PROJECTILE);
+	sphere->Physics()->SetCollisionMask(~uint(COLLISION_LAYER_INVISIBLEWALL));
 	sphere->Physics()->SetLinearVelocity(Matrix3::Transpose(GraphicsPipeline::Instance()->GetCamera()->BuildViewMatrix()) * Vector3(0, 0, -1) * 100);
 	this->AddGameObject(sphere);
 }*/
\ No newline at end of file
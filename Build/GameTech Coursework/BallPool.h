@@ -7,7 +7,11 @@
 #include <ncltech\CommonUtils.h>
 
 #include "RenderNodeParticles.h"
+#ifdef USE_CUDA
 #include "CudaCollidingParticles.cuh"
+#endif
+#include "CpuCollidingParticles.h"
+#include "CpuSphParticles.h"
 
 using namespace CommonUtils;
 
@@ -16,6 +20,9 @@ class BallPool : public Scene
 public:
 	BallPool(const std::string& friendly_name)
 		: Scene(friendly_name)
+		, particleProg(NULL)
+		, usingCuda(false)
+		, usingFluid(false)
 	{
 	}
 
@@ -35,16 +42,30 @@ public:
 		PhysicsEngine::Instance()->octree = new Octree(ground->Physics()->GetPosition() - Vector3(ground->Physics()->GetCollisionShape()->GetRadius(), ground->Physics()->GetCollisionShape()->GetRadius(), ground->Physics()->GetCollisionShape()->GetRadius()), Vector3(ground->Physics()->GetCollisionShape()->GetRadius() * 2, ground->Physics()->GetCollisionShape()->GetRadius() * 10, ground->Physics()->GetCollisionShape()->GetRadius() * 2));
 		this->AddGameObject(ground);
 
-		cudaParticleProg = new CudaCollidingParticles();
+		//Fall back to the multithreaded CPU version on machines without a cuda capable GPU,
+		// or when built without the cuda toolkit (USE_CUDA not defined)
+#ifdef USE_CUDA
+		usingCuda = !usingFluid && CudaCollidingParticles::IsCudaDeviceAvailable();
+#else
+		usingCuda = false;
+#endif
+		if (usingFluid)
+			particleProg = new CpuSphParticles();
+#ifdef USE_CUDA
+		else if (usingCuda)
+			particleProg = new CudaCollidingParticles();
+#endif
+		else
+			particleProg = new CpuCollidingParticles();
 
 		//The dam size (<value> * PARTICLE_RADIUS * 2) must be smaller than the simulation world size!
-		cudaParticleProg->InitializeParticleDam(32, 32, 32);
+		particleProg->InitializeParticleDam(32, 32, 32);
 
-		uint num_particles = cudaParticleProg->GetNumParticles();
+		uint num_particles = particleProg->GetNumParticles();
 
 		RenderNodeParticles* rnode = new RenderNodeParticles();
-		rnode->SetParticleRadius(PARTICLE_RADIUS);
-		rnode->SetColor(Vector4(1.f, 0.f, 1.f, 1.f));
+		rnode->SetParticleRadius(particleProg->GetParticleRadius());
+		rnode->SetColor(usingFluid ? Vector4(0.2f, 0.4f, 1.f, 1.f) : Vector4(1.f, 0.f, 1.f, 1.f));
 		rnode->GeneratePositionBuffer(num_particles, NULL);
 
 		const float half_grid_world_size = PARTICLE_GRID_SIZE * PARTICLE_GRID_CELL_SIZE * 0.5f;
@@ -57,13 +78,13 @@ public:
 
 
 
-		cudaParticleProg->InitializeOpenGLVertexBuffer(rnode->GetGLVertexBuffer());
+		particleProg->InitializeOpenGLVertexBuffer(rnode->GetGLVertexBuffer());
 	}
 
 	virtual void OnCleanupScene() override
 	{
 		Scene::OnCleanupScene();
-		delete cudaParticleProg;
+		SAFE_DELETE(particleProg);
 	}
 
 	virtual void OnUpdateScene(float dt) override
@@ -73,12 +94,28 @@ public:
 		NCLDebug::AddStatusEntry(Vector4(1.0f, 0.9f, 0.8f, 1.0f), "  is the GPU equivalent of the C++ STL and makes things easier ");
 		NCLDebug::AddStatusEntry(Vector4(1.0f, 0.9f, 0.8f, 1.0f), "  with vector's, sorting, iterators and array manipulation.");
 		NCLDebug::AddStatusEntry(Vector4(1.0f, 0.9f, 0.8f, 1.0f), "");
-		NCLDebug::AddStatusEntry(Vector4(1.0f, 0.9f, 0.8f, 1.0f), "  No. Particles: %d", cudaParticleProg->GetNumParticles());
-
-		cudaParticleProg->UpdateParticles(dt);
+		NCLDebug::AddStatusEntry(Vector4(1.0f, 0.9f, 0.8f, 1.0f), "  No. Particles: %d (%s)", particleProg->GetNumParticles(), usingCuda ? "CUDA" : "CPU");
+		NCLDebug::AddStatusEntry(Vector4(1.0f, 0.9f, 0.8f, 1.0f), "  Simulation: %s (Press F to toggle)", usingFluid ? "SPH Fluid" : "Colliding Spheres");
+		if (usingFluid)
+		{
+			CpuSphParticles* sph = static_cast<CpuSphParticles*>(particleProg);
+			NCLDebug::AddStatusEntry(Vector4(1.0f, 0.9f, 0.8f, 1.0f), "  Neighbours: %d (Lists rebuilt %d times)", sph->GetNumNeighbours(), sph->GetNeighbourListRebuilds());
+		}
+
+		//Switching modes needs a new particle program, so just reload the scene
+		if (Window::GetKeyboard()->KeyTriggered(KEYBOARD_F))
+		{
+			usingFluid = !usingFluid;
+			SceneManager::Instance()->JumpToScene(SceneManager::Instance()->GetCurrentSceneIndex());
+			return;
+		}
+
+		particleProg->UpdateParticles(dt);
 	}
 
 
 protected:
-	CudaCollidingParticles* cudaParticleProg;
+	CollidingParticles* particleProg;
+	bool usingCuda;
+	bool usingFluid;
 };
\ No newline at end of file
@@ -0,0 +1,38 @@
+#pragma once
+#include <nclgl\common.h>
+#include <GL\glew.h>
+
+//Shared settings and interface for all colliding particle backends
+// - CudaCollidingParticles: Runs on NVIDIA GPUs through thrust (Only built with USE_CUDA defined)
+// - CpuCollidingParticles:  Multithreaded SIMD version for machines without a GPU
+// - CpuSphParticles:        Smoothed particle hydrodynamics fluid on the CPU grid
+//
+//This header is included by both the cuda and c++ code, so can't have any
+// cuda or thrust specific code within it.
+
+//Size of our particles in world space
+#define PARTICLE_RADIUS 0.1f
+
+//defines a 3D grid of cells 128x128x128
+#define PARTICLE_GRID_SIZE 128
+
+//defines a world transform from grid to world, e.g. particles can move from 0 to (PARTICLE_GRID_SIZE * PARTICLE_GRID_CELL_SIZE)
+// in each axis.
+//!! This MUST be equal or larger than particle_radius for the broadphase to work !!
+#define PARTICLE_GRID_CELL_SIZE 0.15f
+
+#define COLLISION_ELASTICITY 0.5f
+
+class CollidingParticles
+{
+public:
+	virtual ~CollidingParticles() {}
+
+	virtual uint GetNumParticles() = 0;
+	virtual float GetParticleRadius() { return PARTICLE_RADIUS; }
+
+	virtual void InitializeParticleDam(int dam_width, int dam_height, int dam_depth) = 0;
+	virtual void InitializeOpenGLVertexBuffer(GLuint buffer_idx) = 0;
+
+	virtual void UpdateParticles(float dt) = 0;
+};
@@ -0,0 +1,445 @@
+#include "CpuCollidingParticles.h"
+#include <nclgl\NCLDebug.h>
+#include <omp.h>
+#include <emmintrin.h>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+
+//Number of bits sorted per radix sort pass, our grid cell indices are
+// 21 bits (128^3) so this gives three passes.
+#define RADIX_BITS		8
+#define RADIX_BUCKETS	(1 << RADIX_BITS)
+#define RADIX_PASSES	3
+
+inline float HorizontalSum(__m128 v)
+{
+	__m128 shuf = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+	__m128 sums = _mm_add_ps(v, shuf);
+	shuf = _mm_movehl_ps(shuf, sums);
+	sums = _mm_add_ss(sums, shuf);
+	return _mm_cvtss_f32(sums);
+}
+
+
+CpuCollidingParticles::CpuCollidingParticles()
+	: num_particles(0)
+	, pos_ping(0)
+	, vel_ping(0)
+	, gl_vertex_buffer(0)
+{
+}
+
+CpuCollidingParticles::~CpuCollidingParticles()
+{
+}
+
+void CpuCollidingParticles::InitializeParticleDam(int dam_width, int dam_height, int dam_depth)
+{
+	///Same compacted dam as CudaCollidingParticles::InitializeParticleDam
+	uint num_even_rowed_particles = dam_width * dam_depth * dam_height / 2;
+	num_particles = num_even_rowed_particles + (dam_width - 1) * (dam_depth - 1) * dam_height / 2;
+	AllocateParticleBuffers();
+
+	//Generate initial Particle data for our dam
+	const float sqrt2 = sqrt(2.f);
+
+	const float dam_size_x = dam_width * PARTICLE_RADIUS * 2.f;
+	const float dam_size_z = dam_depth * PARTICLE_RADIUS * 2.f;
+
+	const float world_dim = PARTICLE_GRID_SIZE * PARTICLE_GRID_CELL_SIZE - PARTICLE_RADIUS * 2.f;
+	const float start_offset_x = world_dim * 0.5f - dam_size_x * 0.5f;
+	const float start_offset_z = world_dim * 0.5f - dam_size_z * 0.5f;
+
+	ParticleArrays& pos = positions[pos_ping];
+	ParticleArrays& vel = velocities[vel_ping];
+	std::fill(vel.x.begin(), vel.x.end(), 0.0f);
+	std::fill(vel.y.begin(), vel.y.end(), 0.0f);
+	std::fill(vel.z.begin(), vel.z.end(), 0.0f);
+
+	//Initialize all the even rows of the dam
+	for (int y = 0; y < dam_height / 2; y++)
+	{
+		for (int z = 0; z < dam_depth; ++z)
+		{
+			for (int x = 0; x < dam_width; ++x)
+			{
+				int idx = ((y * dam_depth) + z) * dam_width + x;
+				pos.x[idx] = PARTICLE_RADIUS * (1.0f + x * 2.f) + start_offset_x;
+				pos.y[idx] = PARTICLE_RADIUS * (1.0f + y * (2.f + sqrt2));
+				pos.z[idx] = PARTICLE_RADIUS * (1.0f + z * 2.f) + start_offset_z;
+			}
+		}
+	}
+
+	//Initialize all the odd rows of the dam
+	for (int y = 0; y < dam_height / 2; y++)
+	{
+		for (int z = 0; z < dam_depth - 1; ++z)
+		{
+			for (int x = 0; x < dam_width - 1; ++x)
+			{
+				int idx = num_even_rowed_particles + ((y * (dam_depth - 1)) + z) * (dam_width - 1) + x;
+				pos.x[idx] = PARTICLE_RADIUS * (2.f + x * 2.f) + start_offset_x;
+				pos.y[idx] = PARTICLE_RADIUS * ((1.f + sqrt2) + y * (2.f + sqrt2));
+				pos.z[idx] = PARTICLE_RADIUS * (2.f + z * 2.f) + start_offset_z;
+			}
+		}
+	}
+}
+
+void CpuCollidingParticles::AllocateParticleBuffers()
+{
+	for (int i = 0; i < 2; ++i)
+	{
+		positions[i].resize(num_particles);
+		velocities[i].resize(num_particles);
+		particles_grid_cell_index[i].resize(num_particles);
+		particles_sort_index[i].resize(num_particles);
+	}
+	pos_ping = 0;
+	vel_ping = 0;
+
+	const uint num_grid_cells = PARTICLE_GRID_SIZE*PARTICLE_GRID_SIZE*PARTICLE_GRID_SIZE;
+	grid_cell_start.resize(num_grid_cells + 1);
+	gl_positions.resize(num_particles * 3);
+}
+
+void CpuCollidingParticles::InitializeOpenGLVertexBuffer(GLuint buffer_idx)
+{
+	gl_vertex_buffer = buffer_idx;
+}
+
+void CpuCollidingParticles::UpdateParticles(float dt)
+{
+	//See "ALGORITHM EXPLANATION" in CudaCollidingParticles.cu for info on what is meant to be happening here.
+	// - Gravity and timestep are kept identical to the cuda version, so both behave the same.
+	const float gravity_y = -0.02f;
+	const float fixed_timestep = 1.0f / 60.0f;
+
+	if (num_particles == 0)
+		return;
+
+	//Integrate our particles through time, and compute their grid cell indices
+	IntegrateParticles(fixed_timestep, gravity_y);
+	ComputeGridCells();
+
+	//Sort our particles based on their grid cell indices
+	SortParticlesByCell();
+
+	//Compute grid cell start/end indices
+	BuildGridCellTable();
+
+	//Handle our collision resolution
+	float baumgarte_factor = 0.05f / fixed_timestep;
+	for (int i = 0; i < 10; ++i)
+	{
+		CollideParticles(baumgarte_factor);
+	}
+
+	//Finally, copy our particle positions to openGL to be renderered as particles.
+	CopyToOpenGL();
+}
+
+void CpuCollidingParticles::IntegrateParticles(float dt, const float gravity_y)
+{
+	ParticleArrays& pos = positions[pos_ping];
+	ParticleArrays& vel = velocities[vel_ping];
+
+	const float min_bounds = PARTICLE_RADIUS;
+	const float max_bounds = PARTICLE_GRID_SIZE * PARTICLE_GRID_CELL_SIZE - PARTICLE_RADIUS;
+
+	//Out of bounds check, clamping the particle to the grid and bouncing it back in
+	auto bound_axis = [&](float& p, float& v)
+	{
+		if (p < min_bounds)
+		{
+			p = min_bounds;
+			v = fabs(v) * COLLISION_ELASTICITY;
+		}
+		if (p > max_bounds)
+		{
+			p = max_bounds;
+			v = -fabs(v) * COLLISION_ELASTICITY;
+		}
+	};
+
+#pragma omp parallel for schedule(static)
+	for (int i = 0; i < (int)num_particles; ++i)
+	{
+		//Time integration
+		vel.y[i] += gravity_y;
+		vel.x[i] *= 0.999f;
+		vel.y[i] *= 0.999f;
+		vel.z[i] *= 0.999f;
+
+		pos.x[i] += vel.x[i] * dt;
+		pos.y[i] += vel.y[i] * dt;
+		pos.z[i] += vel.z[i] * dt;
+
+		bound_axis(pos.x[i], vel.x[i]);
+		bound_axis(pos.y[i], vel.y[i]);
+		bound_axis(pos.z[i], vel.z[i]);
+	}
+}
+
+void CpuCollidingParticles::ComputeGridCells()
+{
+	const ParticleArrays& pos = positions[pos_ping];
+	uint* cell_index = &particles_grid_cell_index[0][0];
+	uint* sort_index = &particles_sort_index[0][0];
+
+#pragma omp parallel for schedule(static)
+	for (int i = 0; i < (int)num_particles; ++i)
+	{
+		cell_index[i] = GetGridCellHash(GetGridCellCoord(pos.x[i]), GetGridCellCoord(pos.y[i]), GetGridCellCoord(pos.z[i]));
+		sort_index[i] = i;
+	}
+}
+
+void CpuCollidingParticles::SortParticlesByCell()
+{
+	//Parallel LSD radix sort of (grid cell index, particle index) pairs
+	// - Each thread builds a histogram of it's own chunk of the array, these are
+	//   then prefix summed (bucket-major, thread-minor) so each thread knows exactly
+	//   where to scatter it's elements while keeping the sort stable.
+	const int max_threads = omp_get_max_threads();
+	radix_histograms.resize(max_threads * RADIX_BUCKETS);
+
+	uint in_buf = 0;
+	for (uint pass = 0; pass < RADIX_PASSES; ++pass)
+	{
+		const uint shift = pass * RADIX_BITS;
+		const uint* keys_in = &particles_grid_cell_index[in_buf][0];
+		const uint* vals_in = &particles_sort_index[in_buf][0];
+		uint* keys_out = &particles_grid_cell_index[1 - in_buf][0];
+		uint* vals_out = &particles_sort_index[1 - in_buf][0];
+
+#pragma omp parallel num_threads(max_threads)
+		{
+			const uint tid = omp_get_thread_num();
+			const uint nthreads = omp_get_num_threads();
+			const uint begin = (uint)(((uint64_t)num_particles * tid) / nthreads);
+			const uint end = (uint)(((uint64_t)num_particles * (tid + 1)) / nthreads);
+
+			uint* hist = &radix_histograms[tid * RADIX_BUCKETS];
+			memset(hist, 0, RADIX_BUCKETS * sizeof(uint));
+			for (uint i = begin; i < end; ++i)
+			{
+				hist[(keys_in[i] >> shift) & (RADIX_BUCKETS - 1)]++;
+			}
+
+#pragma omp barrier
+#pragma omp single
+			{
+				uint sum = 0;
+				for (uint b = 0; b < RADIX_BUCKETS; ++b)
+				{
+					for (uint t = 0; t < nthreads; ++t)
+					{
+						uint count = radix_histograms[t * RADIX_BUCKETS + b];
+						radix_histograms[t * RADIX_BUCKETS + b] = sum;
+						sum += count;
+					}
+				}
+			}
+
+			for (uint i = begin; i < end; ++i)
+			{
+				uint dst = hist[(keys_in[i] >> shift) & (RADIX_BUCKETS - 1)]++;
+				keys_out[dst] = keys_in[i];
+				vals_out[dst] = vals_in[i];
+			}
+		}
+
+		in_buf = 1 - in_buf;
+	}
+
+	//Make sure the sorted result always ends up in buffer zero
+	if (in_buf != 0)
+	{
+		particles_grid_cell_index[0].swap(particles_grid_cell_index[1]);
+		particles_sort_index[0].swap(particles_sort_index[1]);
+	}
+
+	//Gather the particle data into sorted order
+	const uint* sort_index = &particles_sort_index[0][0];
+	const ParticleArrays& pos_in = positions[pos_ping];
+	const ParticleArrays& vel_in = velocities[vel_ping];
+	ParticleArrays& pos_out = positions[1 - pos_ping];
+	ParticleArrays& vel_out = velocities[1 - vel_ping];
+
+#pragma omp parallel for schedule(static)
+	for (int i = 0; i < (int)num_particles; ++i)
+	{
+		const uint src = sort_index[i];
+		pos_out.x[i] = pos_in.x[src]; pos_out.y[i] = pos_in.y[src]; pos_out.z[i] = pos_in.z[src];
+		vel_out.x[i] = vel_in.x[src]; vel_out.y[i] = vel_in.y[src]; vel_out.z[i] = vel_in.z[src];
+	}
+
+	pos_ping = 1 - pos_ping;
+	vel_ping = 1 - vel_ping;
+}
+
+void CpuCollidingParticles::BuildGridCellTable()
+{
+	//For each sorted particle, write it's index as the start of every cell between the previous
+	// particle's cell (exclusive) and it's own cell (inclusive). Every cell is written exactly
+	// once, so no clearing of the (large) table is required between frames.
+	const uint num_grid_cells = PARTICLE_GRID_SIZE*PARTICLE_GRID_SIZE*PARTICLE_GRID_SIZE;
+	const uint* keys = &particles_grid_cell_index[0][0];
+	uint* cell_start = &grid_cell_start[0];
+
+#pragma omp parallel for schedule(static)
+	for (int i = 0; i <= (int)num_particles; ++i)
+	{
+		const uint first = (i == 0) ? 0 : keys[i - 1] + 1;
+		const uint last = (i == (int)num_particles) ? num_grid_cells : keys[i];
+		for (uint cell = first; cell <= last; ++cell)
+		{
+			cell_start[cell] = i;
+		}
+	}
+}
+
+void CpuCollidingParticles::CollideParticles(float baumgarte_factor)
+{
+	const ParticleArrays& pos = positions[pos_ping];
+	const ParticleArrays& vel = velocities[vel_ping];
+	ParticleArrays& out_vel = velocities[1 - vel_ping];
+	const uint* cell_start = &grid_cell_start[0];
+
+	const float diameter = PARTICLE_RADIUS * 2.f;
+	const float diameterSq = diameter * diameter;
+
+	const __m128 sse_diameter = _mm_set1_ps(diameter);
+	const __m128 sse_diameterSq = _mm_set1_ps(diameterSq);
+	const __m128 sse_epsilon = _mm_set1_ps(1e-12f);
+	const __m128 sse_elasticity = _mm_set1_ps(-(1.f + COLLISION_ELASTICITY));
+	const __m128 sse_baumgarte = _mm_set1_ps(baumgarte_factor);
+	const __m128 sse_half = _mm_set1_ps(0.5f);
+	const __m128 sse_zero = _mm_setzero_ps();
+
+#pragma omp parallel for schedule(dynamic, 256)
+	for (int index = 0; index < (int)num_particles; ++index)
+	{
+		const float px = pos.x[index], py = pos.y[index], pz = pos.z[index];
+		const float vx = vel.x[index], vy = vel.y[index], vz = vel.z[index];
+
+		const __m128 sse_px = _mm_set1_ps(px), sse_py = _mm_set1_ps(py), sse_pz = _mm_set1_ps(pz);
+		const __m128 sse_vx = _mm_set1_ps(vx), sse_vy = _mm_set1_ps(vy), sse_vz = _mm_set1_ps(vz);
+		__m128 sse_dvx = _mm_setzero_ps(), sse_dvy = _mm_setzero_ps(), sse_dvz = _mm_setzero_ps();
+		float dvx = 0.0f, dvy = 0.0f, dvz = 0.0f;
+
+		const int cx = (int)GetGridCellCoord(px);
+		const int cy = (int)GetGridCellCoord(py);
+		const int cz = (int)GetGridCellCoord(pz);
+
+		//Cells neighbouring in y are contiguous in the sorted array, so each (x, z) column
+		// of three cells can be processed as a single run of particles.
+		// - Particles are clamped inside the grid, so cells outside of it can be skipped
+		//   rather than wrapped around as the cuda version does.
+		const uint y_lo = (uint)max(cy - 1, 0);
+		const uint y_hi = (uint)min(cy + 1, PARTICLE_GRID_SIZE - 1);
+
+		for (int z = max(cz - 1, 0); z <= min(cz + 1, PARTICLE_GRID_SIZE - 1); ++z)
+		{
+			for (int x = max(cx - 1, 0); x <= min(cx + 1, PARTICLE_GRID_SIZE - 1); ++x)
+			{
+				uint arr_idx = cell_start[GetGridCellHash(x, y_lo, z)];
+				const uint arr_end = cell_start[GetGridCellHash(x, y_hi, z) + 1];
+
+				//Four neighbours at a time
+				for (; arr_idx + 4 <= arr_end; arr_idx += 4)
+				{
+					__m128 abx = _mm_sub_ps(_mm_loadu_ps(&pos.x[arr_idx]), sse_px);
+					__m128 aby = _mm_sub_ps(_mm_loadu_ps(&pos.y[arr_idx]), sse_py);
+					__m128 abz = _mm_sub_ps(_mm_loadu_ps(&pos.z[arr_idx]), sse_pz);
+					__m128 lengthSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(abx, abx), _mm_mul_ps(aby, aby)), _mm_mul_ps(abz, abz));
+
+					//Colliding, and not ourselves (the only particle at a distance of zero)
+					__m128 mask = _mm_and_ps(_mm_cmplt_ps(lengthSq, sse_diameterSq), _mm_cmpgt_ps(lengthSq, sse_epsilon));
+					if (_mm_movemask_ps(mask) == 0)
+						continue;
+
+					__m128 len = _mm_sqrt_ps(_mm_max_ps(lengthSq, sse_epsilon));
+					abx = _mm_div_ps(abx, len);
+					aby = _mm_div_ps(aby, len);
+					abz = _mm_div_ps(abz, len);
+
+					//Direct normal collision (no friction/shear)
+					__m128 rvx = _mm_sub_ps(_mm_loadu_ps(&vel.x[arr_idx]), sse_vx);
+					__m128 rvy = _mm_sub_ps(_mm_loadu_ps(&vel.y[arr_idx]), sse_vy);
+					__m128 rvz = _mm_sub_ps(_mm_loadu_ps(&vel.z[arr_idx]), sse_vz);
+					__m128 abnVel = _mm_add_ps(_mm_add_ps(_mm_mul_ps(rvx, abx), _mm_mul_ps(rvy, aby)), _mm_mul_ps(rvz, abz));
+					__m128 jn = _mm_mul_ps(abnVel, sse_elasticity);
+
+					//Extra energy to overcome overlap error
+					__m128 overlap = _mm_sub_ps(sse_diameter, len);
+					jn = _mm_add_ps(jn, _mm_mul_ps(overlap, sse_baumgarte));
+
+					jn = _mm_max_ps(jn, sse_zero);
+					jn = _mm_and_ps(_mm_mul_ps(jn, sse_half), mask);
+
+					sse_dvx = _mm_sub_ps(sse_dvx, _mm_mul_ps(abx, jn));
+					sse_dvy = _mm_sub_ps(sse_dvy, _mm_mul_ps(aby, jn));
+					sse_dvz = _mm_sub_ps(sse_dvz, _mm_mul_ps(abz, jn));
+				}
+
+				//Remainder
+				for (; arr_idx < arr_end; ++arr_idx)
+				{
+					float abx = pos.x[arr_idx] - px;
+					float aby = pos.y[arr_idx] - py;
+					float abz = pos.z[arr_idx] - pz;
+					float lengthSq = abx * abx + aby * aby + abz * abz;
+					if (lengthSq >= diameterSq || lengthSq <= 1e-12f)
+						continue;
+
+					float len = sqrtf(lengthSq);
+					abx /= len; aby /= len; abz /= len;
+
+					float abnVel = (vel.x[arr_idx] - vx) * abx + (vel.y[arr_idx] - vy) * aby + (vel.z[arr_idx] - vz) * abz;
+					float jn = -(abnVel * (1.f + COLLISION_ELASTICITY));
+					jn += (diameter - len) * baumgarte_factor;
+					jn = max(jn, 0.0f) * 0.5f;
+
+					dvx -= abx * jn;
+					dvy -= aby * jn;
+					dvz -= abz * jn;
+				}
+			}
+		}
+
+		out_vel.x[index] = vx + dvx + HorizontalSum(sse_dvx);
+		out_vel.y[index] = vy + dvy + HorizontalSum(sse_dvy);
+		out_vel.z[index] = vz + dvz + HorizontalSum(sse_dvz);
+	}
+
+	vel_ping = 1 - vel_ping;
+}
+
+void CpuCollidingParticles::CopyToOpenGL()
+{
+	if (gl_vertex_buffer == 0)
+		return;
+
+	//Particles are go from 0 - grid width, and we want it to be centred on 0,0,0!
+	const float world_dim = PARTICLE_GRID_SIZE * PARTICLE_GRID_CELL_SIZE;
+	const float world_offset_xz = world_dim * 0.5f;
+
+	const ParticleArrays& pos = positions[pos_ping];
+	float* out = &gl_positions[0];
+
+#pragma omp parallel for schedule(static)
+	for (int i = 0; i < (int)num_particles; ++i)
+	{
+		out[i * 3 + 0] = pos.x[i] - world_offset_xz;
+		out[i * 3 + 1] = pos.y[i];
+		out[i * 3 + 2] = pos.z[i] - world_offset_xz;
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, gl_vertex_buffer);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, num_particles * 3 * sizeof(float), out);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include "CollidingParticles.h"
+#include <vector>
+
+//CPU version of CudaCollidingParticles, for machines without a cuda capable GPU.
+//
+//It follows the same algorithm as the cuda version (See "ALGORITHM EXPLANATION"
+// in CudaCollidingParticles.cu), with each stage split across all available
+// cores using OpenMP:
+//	1. Integrate particles and compute their grid cell index
+//	2. Sort the particles by grid cell with a parallel LSD radix sort
+//	3. Build the grid cell start/end table
+//	4. Resolve collisions, reading velocities from one (ping) buffer and writing
+//	   to another (pong), with the inner neighbour loop vectorised four particles
+//	   at a time using SSE.
+//
+//Particles are stored as a structure of arrays, so once sorted, all particles in
+// a run of neighbouring cells are contiguous in memory and can be loaded straight
+// into SIMD registers.
+
+class CpuCollidingParticles : public CollidingParticles
+{
+public:
+	CpuCollidingParticles();
+	virtual ~CpuCollidingParticles();
+
+	virtual uint GetNumParticles() override { return num_particles; }
+
+	virtual void InitializeParticleDam(int dam_width, int dam_height, int dam_depth) override;
+	virtual void InitializeOpenGLVertexBuffer(GLuint buffer_idx) override;
+
+	virtual void UpdateParticles(float dt) override;
+
+protected:
+	struct ParticleArrays
+	{
+		std::vector<float> x, y, z;
+
+		void resize(uint n) { x.resize(n); y.resize(n); z.resize(n); }
+	};
+
+	static inline uint GetGridCellCoord(float pos)
+	{
+		int cell = static_cast<int>(pos * (1.0f / PARTICLE_GRID_CELL_SIZE));
+		return static_cast<uint>(cell) & (PARTICLE_GRID_SIZE - 1);
+	}
+
+	static inline uint GetGridCellHash(uint x, uint y, uint z)
+	{
+		//Same layout as the cuda version, cells neighbouring in y are contiguous
+		return ((z * PARTICLE_GRID_SIZE) + x) * PARTICLE_GRID_SIZE + y;
+	}
+
+	//Resizes all per-particle buffers to hold num_particles
+	void AllocateParticleBuffers();
+
+	void IntegrateParticles(float dt, const float gravity_y);
+	void ComputeGridCells();
+	void SortParticlesByCell();
+	void BuildGridCellTable();
+	void CollideParticles(float baumgarte_factor);
+	void CopyToOpenGL();
+
+protected:
+	uint num_particles;
+
+	//Positions are ping-ponged by the sort, velocities are ping-ponged
+	// by both the sort and each collision iteration.
+	ParticleArrays positions[2];
+	ParticleArrays velocities[2];
+	uint pos_ping, vel_ping;
+
+	//Radix sort data, keys are the particle grid cell indices and values
+	// the particle's index before sorting
+	std::vector<uint> particles_grid_cell_index[2];
+	std::vector<uint> particles_sort_index[2];
+	std::vector<uint> radix_histograms;
+
+	//Grid cell lookup, cell 'i' contains particles grid_cell_start[i] to grid_cell_start[i+1]
+	// (So the start table of cell i+1 doubles as the end table of cell i)
+	std::vector<uint> grid_cell_start;
+
+	//OpenGL vertex buffer to copy particle positions into
+	GLuint gl_vertex_buffer;
+	std::vector<float> gl_positions;
+};
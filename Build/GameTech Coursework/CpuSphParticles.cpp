@@ -0,0 +1,351 @@
+#include "CpuSphParticles.h"
+#include <omp.h>
+#include <algorithm>
+
+#define SPH_PI 3.14159265358979f
+
+CpuSphParticles::CpuSphParticles()
+	: CpuCollidingParticles()
+	, smoothing_radius(0.1f)
+	, rest_density(1000.0f)
+	, stiffness(200.0f)
+	, viscosity(0.5f)
+	, container_half_width(2.0f)
+	, num_substeps(8)
+	, list_valid(false)
+	, num_list_rebuilds(0)
+{
+	//The neighbour lists are found by searching the 3x3x3 surrounding grid cells, so the
+	// smoothing radius plus skin must fit inside a single grid cell.
+	skin_distance = PARTICLE_GRID_CELL_SIZE - smoothing_radius;
+	particle_spacing = smoothing_radius * 0.5f;
+
+	const float h = smoothing_radius;
+	const float h2 = h * h;
+	const float h6 = h2 * h2 * h2;
+	const float h9 = h6 * h2 * h;
+	poly6_factor = 315.0f / (64.0f * SPH_PI * h9);
+	spiky_grad_factor = -45.0f / (SPH_PI * h6);
+	visc_laplacian_factor = 45.0f / (SPH_PI * h6);
+
+	//Calibrate the particle mass so that a particle inside the initial lattice is exactly at rest density,
+	// otherwise the fluid starts out compressed (or stretched) and jumps on the first frame.
+	float kernel_sum = 0.0f;
+	const int range = (int)ceil(h / particle_spacing);
+	for (int z = -range; z <= range; ++z)
+	{
+		for (int y = -range; y <= range; ++y)
+		{
+			for (int x = -range; x <= range; ++x)
+			{
+				float r2 = (float)(x * x + y * y + z * z) * particle_spacing * particle_spacing;
+				if (r2 < h2)
+				{
+					float diff = h2 - r2;
+					kernel_sum += poly6_factor * diff * diff * diff;
+				}
+			}
+		}
+	}
+	particle_mass = rest_density / kernel_sum;
+}
+
+CpuSphParticles::~CpuSphParticles()
+{
+}
+
+void CpuSphParticles::InitializeParticleDam(int dam_width, int dam_height, int dam_depth)
+{
+	num_particles = dam_width * dam_height * dam_depth;
+	AllocateParticleBuffers();
+
+	densities.resize(num_particles);
+	pressures.resize(num_particles);
+	accelerations.resize(num_particles);
+	list_positions.resize(num_particles);
+	neighbour_start.resize(num_particles + 1);
+	list_valid = false;
+	num_list_rebuilds = 0;
+
+	//Place the dam in the (min x, min z) corner of the container
+	const float world_centre = PARTICLE_GRID_SIZE * PARTICLE_GRID_CELL_SIZE * 0.5f;
+	const float start_x = world_centre - container_half_width + particle_spacing * 0.5f;
+	const float start_z = world_centre - container_half_width + particle_spacing * 0.5f;
+	const float start_y = PARTICLE_RADIUS + particle_spacing * 0.5f;
+
+	ParticleArrays& pos = positions[pos_ping];
+	ParticleArrays& vel = velocities[vel_ping];
+	for (int y = 0; y < dam_height; ++y)
+	{
+		for (int z = 0; z < dam_depth; ++z)
+		{
+			for (int x = 0; x < dam_width; ++x)
+			{
+				int idx = ((y * dam_depth) + z) * dam_width + x;
+				pos.x[idx] = start_x + x * particle_spacing;
+				pos.y[idx] = start_y + y * particle_spacing;
+				pos.z[idx] = start_z + z * particle_spacing;
+
+				vel.x[idx] = 0.0f;
+				vel.y[idx] = 0.0f;
+				vel.z[idx] = 0.0f;
+			}
+		}
+	}
+}
+
+void CpuSphParticles::UpdateParticles(float dt)
+{
+	//Fixed timestep, as with the other particle backends
+	const float fixed_timestep = 1.0f / 60.0f;
+	const float substep_dt = fixed_timestep / (float)num_substeps;
+
+	if (num_particles == 0)
+		return;
+
+	for (uint i = 0; i < num_substeps; ++i)
+	{
+		if (!list_valid)
+			RebuildNeighbourLists();
+
+		ComputeDensityAndPressure();
+		ComputeAccelerations();
+
+		//Only invalidates the lists once a particle has moved far enough that it could
+		// have a neighbour that isn't in it's list
+		list_valid = IntegrateSph(substep_dt);
+	}
+
+	CopyToOpenGL();
+}
+
+void CpuSphParticles::RebuildNeighbourLists()
+{
+	num_list_rebuilds++;
+
+	//Sort particles by grid cell, so the particles in each cell (and neighbouring cells in y) are contiguous
+	ComputeGridCells();
+	SortParticlesByCell();
+	BuildGridCellTable();
+
+	const ParticleArrays& pos = positions[pos_ping];
+	const uint* cell_start = &grid_cell_start[0];
+	const float search_radius = smoothing_radius + skin_distance;
+	const float search_radiusSq = search_radius * search_radius;
+
+	//Two passes over the grid, the first counts the neighbours of each particle so the second
+	// can write them directly into a single flat array.
+	for (int pass = 0; pass < 2; ++pass)
+	{
+		uint* out_list = (pass == 1 && !neighbour_list.empty()) ? &neighbour_list[0] : NULL;
+
+#pragma omp parallel for schedule(dynamic, 256)
+		for (int index = 0; index < (int)num_particles; ++index)
+		{
+			const float px = pos.x[index], py = pos.y[index], pz = pos.z[index];
+			const int cx = (int)GetGridCellCoord(px);
+			const int cy = (int)GetGridCellCoord(py);
+			const int cz = (int)GetGridCellCoord(pz);
+
+			const uint y_lo = (uint)max(cy - 1, 0);
+			const uint y_hi = (uint)min(cy + 1, PARTICLE_GRID_SIZE - 1);
+
+			uint count = 0;
+			uint out_idx = (pass == 1) ? neighbour_start[index] : 0;
+
+			for (int z = max(cz - 1, 0); z <= min(cz + 1, PARTICLE_GRID_SIZE - 1); ++z)
+			{
+				for (int x = max(cx - 1, 0); x <= min(cx + 1, PARTICLE_GRID_SIZE - 1); ++x)
+				{
+					const uint arr_end = cell_start[GetGridCellHash(x, y_hi, z) + 1];
+					for (uint arr_idx = cell_start[GetGridCellHash(x, y_lo, z)]; arr_idx < arr_end; ++arr_idx)
+					{
+						if (arr_idx == (uint)index)
+							continue;
+
+						float abx = pos.x[arr_idx] - px;
+						float aby = pos.y[arr_idx] - py;
+						float abz = pos.z[arr_idx] - pz;
+						if (abx * abx + aby * aby + abz * abz < search_radiusSq)
+						{
+							if (pass == 1)
+								out_list[out_idx++] = arr_idx;
+							else
+								count++;
+						}
+					}
+				}
+			}
+
+			if (pass == 0)
+				neighbour_start[index] = count;
+		}
+
+		if (pass == 0)
+		{
+			//Exclusive prefix sum of the neighbour counts
+			uint sum = 0;
+			for (uint i = 0; i < num_particles; ++i)
+			{
+				uint count = neighbour_start[i];
+				neighbour_start[i] = sum;
+				sum += count;
+			}
+			neighbour_start[num_particles] = sum;
+			neighbour_list.resize(sum);
+		}
+	}
+
+	//Store the positions the lists were built from, to check against as the particles move
+	list_positions.x = pos.x;
+	list_positions.y = pos.y;
+	list_positions.z = pos.z;
+}
+
+void CpuSphParticles::ComputeDensityAndPressure()
+{
+	const ParticleArrays& pos = positions[pos_ping];
+	const uint* nstart = &neighbour_start[0];
+	const uint* nlist = neighbour_list.empty() ? NULL : &neighbour_list[0];
+
+	const float h2 = smoothing_radius * smoothing_radius;
+	const float self_density = particle_mass * poly6_factor * h2 * h2 * h2;
+
+#pragma omp parallel for schedule(static)
+	for (int i = 0; i < (int)num_particles; ++i)
+	{
+		const float px = pos.x[i], py = pos.y[i], pz = pos.z[i];
+
+		float kernel_sum = 0.0f;
+		for (uint n = nstart[i]; n < nstart[i + 1]; ++n)
+		{
+			const uint j = nlist[n];
+			float abx = pos.x[j] - px;
+			float aby = pos.y[j] - py;
+			float abz = pos.z[j] - pz;
+			float r2 = abx * abx + aby * aby + abz * abz;
+			if (r2 < h2)
+			{
+				float diff = h2 - r2;
+				kernel_sum += diff * diff * diff;
+			}
+		}
+
+		float density = self_density + particle_mass * poly6_factor * kernel_sum;
+		densities[i] = density;
+
+		//Negative pressures are clamped, as they pull particles into clumps at the fluid surface
+		pressures[i] = max(stiffness * (density - rest_density), 0.0f);
+	}
+}
+
+void CpuSphParticles::ComputeAccelerations()
+{
+	const ParticleArrays& pos = positions[pos_ping];
+	const ParticleArrays& vel = velocities[vel_ping];
+	const uint* nstart = &neighbour_start[0];
+	const uint* nlist = neighbour_list.empty() ? NULL : &neighbour_list[0];
+
+	const float h = smoothing_radius;
+	const float h2 = h * h;
+
+#pragma omp parallel for schedule(static)
+	for (int i = 0; i < (int)num_particles; ++i)
+	{
+		const float px = pos.x[i], py = pos.y[i], pz = pos.z[i];
+		const float vx = vel.x[i], vy = vel.y[i], vz = vel.z[i];
+		const float inv_density = 1.0f / densities[i];
+		const float pressure_term_i = pressures[i] * inv_density * inv_density;
+
+		float ax = 0.0f, ay = 0.0f, az = 0.0f;
+		for (uint n = nstart[i]; n < nstart[i + 1]; ++n)
+		{
+			const uint j = nlist[n];
+			float abx = px - pos.x[j];
+			float aby = py - pos.y[j];
+			float abz = pz - pos.z[j];
+			float r2 = abx * abx + aby * aby + abz * abz;
+			if (r2 >= h2 || r2 < 1e-12f)
+				continue;
+
+			float r = sqrtf(r2);
+			float h_r = h - r;
+			float inv_density_j = 1.0f / densities[j];
+
+			//Pressure (Symmetric form so the forces between each pair are equal and opposite)
+			float pressure_term = pressure_term_i + pressures[j] * inv_density_j * inv_density_j;
+			float grad = spiky_grad_factor * h_r * h_r / r;
+			float p = -particle_mass * pressure_term * grad;
+			ax += abx * p;
+			ay += aby * p;
+			az += abz * p;
+
+			//Viscosity
+			float v = viscosity * particle_mass * inv_density_j * inv_density * visc_laplacian_factor * h_r;
+			ax += (vel.x[j] - vx) * v;
+			ay += (vel.y[j] - vy) * v;
+			az += (vel.z[j] - vz) * v;
+		}
+
+		accelerations.x[i] = ax;
+		accelerations.y[i] = ay;
+		accelerations.z[i] = az;
+	}
+}
+
+bool CpuSphParticles::IntegrateSph(float dt)
+{
+	ParticleArrays& pos = positions[pos_ping];
+	ParticleArrays& vel = velocities[vel_ping];
+
+	const float gravity_y = -9.81f;
+	const float world_centre = PARTICLE_GRID_SIZE * PARTICLE_GRID_CELL_SIZE * 0.5f;
+	const float min_xz = world_centre - container_half_width;
+	const float max_xz = world_centre + container_half_width;
+	const float min_y = PARTICLE_RADIUS;
+	const float max_y = PARTICLE_GRID_SIZE * PARTICLE_GRID_CELL_SIZE - PARTICLE_RADIUS;
+
+	const float max_displacement = skin_distance * 0.5f;
+	const float max_displacementSq = max_displacement * max_displacement;
+
+	auto bound_axis = [](float& p, float& v, float min_bound, float max_bound)
+	{
+		if (p < min_bound)
+		{
+			p = min_bound;
+			v = fabs(v) * COLLISION_ELASTICITY;
+		}
+		if (p > max_bound)
+		{
+			p = max_bound;
+			v = -fabs(v) * COLLISION_ELASTICITY;
+		}
+	};
+
+	int lists_invalid = 0;
+
+#pragma omp parallel for schedule(static) reduction(|:lists_invalid)
+	for (int i = 0; i < (int)num_particles; ++i)
+	{
+		//Symplectic euler
+		vel.x[i] += accelerations.x[i] * dt;
+		vel.y[i] += (accelerations.y[i] + gravity_y) * dt;
+		vel.z[i] += accelerations.z[i] * dt;
+
+		pos.x[i] += vel.x[i] * dt;
+		pos.y[i] += vel.y[i] * dt;
+		pos.z[i] += vel.z[i] * dt;
+
+		bound_axis(pos.x[i], vel.x[i], min_xz, max_xz);
+		bound_axis(pos.y[i], vel.y[i], min_y, max_y);
+		bound_axis(pos.z[i], vel.z[i], min_xz, max_xz);
+
+		float dx = pos.x[i] - list_positions.x[i];
+		float dy = pos.y[i] - list_positions.y[i];
+		float dz = pos.z[i] - list_positions.z[i];
+		if (dx * dx + dy * dy + dz * dz > max_displacementSq)
+			lists_invalid |= 1;
+	}
+
+	return lists_invalid == 0;
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include "CpuCollidingParticles.h"
+
+//Smoothed particle hydrodynamics (SPH) fluid, built on top of the CPU particle grid.
+//
+//Rather than pushing overlapping spheres apart, each particle samples the fluid
+// density from it's neighbours within the smoothing radius, turns that into a
+// pressure and is accelerated by the pressure gradient and viscosity of the
+// surrounding fluid (Muller et al. 2003 kernels).
+//
+//Neighbour search reuses the sort and grid cell table of CpuCollidingParticles,
+// however the smoothing radius is smaller than a grid cell so the search radius
+// can be padded by a 'skin'. The resulting neighbour lists are then cached and
+// reused across substeps (and frames) until any particle has moved further than
+// half the skin distance, at which point the particles are re-sorted and the lists
+// rebuilt.
+
+class CpuSphParticles : public CpuCollidingParticles
+{
+public:
+	CpuSphParticles();
+	virtual ~CpuSphParticles();
+
+	virtual float GetParticleRadius() override { return particle_spacing * 0.5f; }
+
+	//Fills one corner of the fluid container with a block of particles
+	virtual void InitializeParticleDam(int dam_width, int dam_height, int dam_depth) override;
+
+	virtual void UpdateParticles(float dt) override;
+
+	//<--------- SETTERS ------------->
+	inline void SetStiffness(float k)				{ stiffness = k; }
+	inline void SetViscosity(float mu)				{ viscosity = mu; }
+	inline void SetSolverSubsteps(uint n)			{ num_substeps = max(n, 1u); }
+
+	//Fluid is kept inside a box of (2 * half_width) x grid height x (2 * half_width) in
+	// the centre of the grid, so it has something to slosh against
+	inline void SetContainerHalfWidth(float half_width) { container_half_width = half_width; }
+
+	//<--------- GETTERS ------------->
+	inline uint GetNeighbourListRebuilds() const	{ return num_list_rebuilds; }
+	inline uint GetNumNeighbours() const			{ return neighbour_start.empty() ? 0 : neighbour_start[num_particles]; }
+
+protected:
+	void RebuildNeighbourLists();
+	void ComputeDensityAndPressure();
+	void ComputeAccelerations();
+	bool IntegrateSph(float dt);
+
+protected:
+	float smoothing_radius;
+	float skin_distance;
+	float particle_spacing;
+	float particle_mass;
+	float rest_density;
+
+	float stiffness;
+	float viscosity;
+	float container_half_width;
+	uint  num_substeps;
+
+	//Precomputed kernel constants
+	float poly6_factor;
+	float spiky_grad_factor;
+	float visc_laplacian_factor;
+
+	//Per-particle fluid state (in sorted order, recomputed every substep)
+	std::vector<float> densities;
+	std::vector<float> pressures;
+	ParticleArrays accelerations;
+
+	//Cached neighbour lists, particle i's neighbours are neighbour_list[neighbour_start[i]] to neighbour_list[neighbour_start[i+1]]
+	std::vector<uint> neighbour_start;
+	std::vector<uint> neighbour_list;
+	ParticleArrays list_positions;			//Particle positions when the lists were last built
+	bool list_valid;
+	uint num_list_rebuilds;
+};
@@ -1,3 +1,5 @@
+//Only built with the cuda toolkit (See USE_CUDA in the project's preprocessor definitions)
+#ifdef USE_CUDA
 #include "CudaCollidingParticles.cuh"
 
 
@@ -313,6 +315,12 @@ CudaCollidingParticles::~CudaCollidingParticles()
 
 
 
+bool CudaCollidingParticles::IsCudaDeviceAvailable()
+{
+	int device_count = 0;
+	return (cudaGetDeviceCount(&device_count) == cudaSuccess) && (device_count > 0);
+}
+
 void CudaCollidingParticles::InitializeParticleDam(int dam_width, int dam_height, int dam_depth)
 {
 	///This function could have been a lot simpler, but I wanted nicely compacted dam... >.>
@@ -512,4 +520,5 @@ void CudaCollidingParticles::UpdateParticles(float dt)
 		CopyToOpenGL());
 
 	gpuErrchk(cudaGraphicsUnmapResources(1, &cGLOutPositions, 0));
-}
\ No newline at end of file
+}
+#endif
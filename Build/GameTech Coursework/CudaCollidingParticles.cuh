@@ -5,23 +5,11 @@
 #include <thrust\sort.h>
 #include "CudaCommon.cuh"
 #include <nclgl\common.h>
+#include "CollidingParticles.h"
 
 //The header files here will be including in c++ code,
 // so can't have any cuda kernels within it.
 
-//Size of our particles in world space
-#define PARTICLE_RADIUS 0.1f
-
-//defines a 3D grid of cells 128x128x128
-#define PARTICLE_GRID_SIZE 128
-
-//defines a world transform from grid to world, e.g. particles can move from 0 to (PARTICLE_GRID_SIZE * PARTICLE_GRID_CELL_SIZE)
-// in each axis.
-//!! This MUST be equal or larger than particle_radius for the broadphase to work !!
-#define PARTICLE_GRID_CELL_SIZE 0.15f
-
-#define COLLISION_ELASTICITY 0.5f
-
 //#pragma pack(push, 16)
 struct Particle
 {
@@ -32,18 +20,21 @@ struct Particle
 };
 //#pragma pack(pop)
 
-class CudaCollidingParticles
+class CudaCollidingParticles : public CollidingParticles
 {
 public:
 	CudaCollidingParticles();
-	~CudaCollidingParticles();
+	virtual ~CudaCollidingParticles();
+
+	//Returns true if there is a cuda capable device to run on
+	static bool IsCudaDeviceAvailable();
 
-	uint GetNumParticles() { return num_particles; }
+	virtual uint GetNumParticles() override { return num_particles; }
 
-	void InitializeParticleDam(int dam_width, int dam_height, int dam_depth);
-	void InitializeOpenGLVertexBuffer(GLuint buffer_idx);
+	virtual void InitializeParticleDam(int dam_width, int dam_height, int dam_depth) override;
+	virtual void InitializeOpenGLVertexBuffer(GLuint buffer_idx) override;
 
-	void UpdateParticles(float dt);
+	virtual void UpdateParticles(float dt) override;
 
 protected:
 	uint num_particles;
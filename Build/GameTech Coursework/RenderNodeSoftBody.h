@@ -0,0 +1,136 @@
+#pragma once
+
+//Draws a SoftBody (cloth) as part of the normal scene, lit and shadowed
+// like any other mesh, rather than only through the physics debug draw.
+//
+// - The mesh shares the soft body's particles as it's vertices and it's
+//   triangle list as it's indices. Positions and normals are copied back
+//   into the vertex buffers each frame in Update().
+//
+// - As with RenderNodeParticles the vertices are already in world space,
+//   so the node's transform should be left as the identity.
+//
+// - The cloth can be dragged around by registering OnMouseDrag with the
+//   ScreenPicker, which pins the particle closest to the mouse while
+//   it is held. The picker draws meshes with back faces culled, so the
+//   cloth can only be picked from it's front.
+//
+// Note: The soft body is owned by the PhysicsEngine, so this node needs to
+//       be deleted (along with it's GameObject) before the engine is cleared.
+
+#include <nclgl\RenderNode.h>
+#include <ncltech\SoftBody.h>
+#include <ncltech\CommonMeshes.h>
+#include <ncltech\ScreenPicker.h>
+
+class RenderNodeSoftBody : public RenderNode
+{
+public:
+	RenderNodeSoftBody(SoftBody* soft_body)
+		: RenderNode(NULL, soft_body->GetColor())
+		, softBody(soft_body)
+		, grabbedParticle(-1)
+		, grabbedInvMass(0.0f)
+	{
+		const uint num_particles = softBody->GetNumParticles();
+		const std::vector<uint>& tris = softBody->GetTriangleIndices();
+
+		Mesh* m = new Mesh();
+		m->type = GL_TRIANGLES;
+		m->numVertices = num_particles;
+		m->numIndices = (GLuint)tris.size();
+		m->vertices = new Vector3[num_particles];
+		m->normals = new Vector3[num_particles];
+		m->textureCoords = new Vector2[num_particles];
+		m->indices = new unsigned int[tris.size()];
+		memcpy(m->indices, &tris[0], tris.size() * sizeof(uint));
+
+		//Checkerboard repeated four times along each side of the sheet
+		const uint dimsU = softBody->GetClothDimsU();
+		const uint dimsV = softBody->GetClothDimsV();
+		for (uint u = 0; u < dimsU; ++u)
+		{
+			for (uint v = 0; v < dimsV; ++v)
+			{
+				m->textureCoords[softBody->GetClothParticleIndex(u, v)] = Vector2(
+					u / float(max(dimsU - 1, 1u)) * 4.0f,
+					v / float(max(dimsV - 1, 1u)) * 4.0f);
+			}
+		}
+		m->SetTexture(CommonMeshes::CheckerboardTex());
+
+		SetMesh(m);
+		CopyParticles();
+		m->BufferData();
+	}
+
+	virtual ~RenderNodeSoftBody()
+	{
+		//The texture is shared with the common meshes, so must not be deleted with our mesh
+		if (mesh)
+		{
+			mesh->SetTexture(0);
+			SAFE_DELETE(mesh);
+		}
+	}
+
+	virtual void Update(float msec) override
+	{
+		RenderNode::Update(msec);
+
+		CopyParticles();
+
+		glBindBuffer(GL_ARRAY_BUFFER, mesh->bufferObject[VERTEX_BUFFER]);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, mesh->numVertices * sizeof(Vector3), mesh->vertices);
+		glBindBuffer(GL_ARRAY_BUFFER, mesh->bufferObject[NORMAL_BUFFER]);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, mesh->numVertices * sizeof(Vector3), mesh->normals);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	virtual void DrawOpenGL(bool isShadowPass) override
+	{
+		//Both sides of the sheet are visible
+		glDisable(GL_CULL_FACE);
+		mesh->Draw();
+		glEnable(GL_CULL_FACE);
+	}
+
+	//ScreenPicker callback (See OnMouseDownCallback)
+	void OnMouseDrag(float dt, const Vector3& new_pos, const Vector3& pos_change, bool stopDragging)
+	{
+		if (stopDragging)
+		{
+			if (grabbedParticle >= 0)
+				softBody->SetParticleInverseMass(grabbedParticle, grabbedInvMass);
+			grabbedParticle = -1;
+			return;
+		}
+
+		//new_pos follows the node's origin, the point actually under the mouse is needed to pick the particle
+		const Vector3& mouse_pos = ScreenPicker::Instance()->GetMouseWorldSpacePos();
+		if (grabbedParticle < 0)
+		{
+			grabbedParticle = (int)softBody->FindClosestParticle(mouse_pos);
+			grabbedInvMass = softBody->GetParticleInverseMass(grabbedParticle);
+			softBody->SetParticleInverseMass(grabbedParticle, 0.0f);
+		}
+
+		softBody->SetParticlePosition(grabbedParticle, mouse_pos);
+	}
+
+protected:
+	void CopyParticles()
+	{
+		for (uint i = 0; i < mesh->numVertices; ++i)
+		{
+			mesh->vertices[i] = softBody->GetParticlePosition(i);
+		}
+		mesh->GenerateNormals();
+	}
+
+protected:
+	SoftBody*	softBody;
+
+	int			grabbedParticle;	//Particle pinned to the mouse while dragging, -1 if none
+	float		grabbedInvMass;		//It's inverse mass before it was grabbed
+};
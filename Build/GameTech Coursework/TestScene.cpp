@@ -6,11 +6,15 @@
 #include <ncltech\DistanceConstraint.h>
 #include <ncltech\SceneManager.h>
 #include <ncltech\CommonUtils.h>
+#include <ncltech\CapsuleCollisionShape.h>
+#include <ncltech\ScreenPicker.h>
+#include "RenderNodeSoftBody.h"
 using namespace CommonUtils;
 
 TestScene::TestScene(const std::string& friendly_name)
 	: Scene(friendly_name)
 	, m_AccumTime(0.0f)
+	, m_Score(0)
 	, m_pPlayer(NULL)
 {
 }
@@ -32,6 +36,14 @@ void TestScene::OnInitializeScene()
 	GraphicsPipeline::Instance()->GetCamera()->SetPitch(-20.f);
 
 	m_AccumTime = 0.0f;
+	m_Score = 0;
+
+	//Scoring is game logic, so is worked out from the engine's contact events rather than inside the engine
+	// - Listeners are cleared whenever the scene changes, so this is registered again on every load
+	PhysicsEngine::Instance()->AddContactListener([this](const PhysicsContactEvent* events, size_t num_events)
+	{
+		OnContactEvents(events, num_events);
+	});
 
 	//Example usage of Log 
 	//- The on screen log can be opened from the bottom left though the
@@ -58,16 +70,22 @@ void TestScene::OnInitializeScene()
 		Vector3(0.5f, 0.5f, 1.0f),  // Half-Dimensions
 		true,						// Physics Enabled?
 		0.f,						// Physical Mass (must have physics enabled)
-		true,						// Physically Collidable (has collision shape)
+		false,						// Physically Collidable (has collision shape)
 		false,						// Dragable by user?
 		Vector4(0.1f, 0.1f, 0.1f, 1.0f)); // Render color*/
 										  //m_pPlayer->SetRender(new RenderNode(new OBJMesh(MESHDIR"trex.obj")));
+
+	//Collides as a capsule lying along it's length, with the same extents as the cuboid
+	m_pPlayer->Physics()->SetCollisionShape(new CapsuleCollisionShape(0.5f, 0.5f, 2));
 	this->AddGameObject(m_pPlayer);
 
 
 	auto create_cube_tower = [&](const Vector3& offset, float cubewidth)
 	{
 		const Vector3 halfdims = Vector3(cubewidth, cubewidth, cubewidth) * 0.5f;
+
+		std::vector<GameObject*> cubes;
+		cubes.reserve(2 * 6);
 		for (int x = 0; x < 2; ++x)
 		{
 			for (int y = 0; y < 6; ++y)
@@ -85,9 +103,10 @@ void TestScene::OnInitializeScene()
 					true,					// Physically Collidable (has collision shape)
 					true,					// Dragable by user?
 					color);					// Render color
-				this->AddGameObject(cube);
+				cubes.push_back(cube);
 			}
 		}
+		this->AddGameObjects(cubes);
 	};
 
 	auto create_ball_cube = [&](const Vector3& offset, const Vector3& scale, float ballsize)
@@ -95,6 +114,8 @@ void TestScene::OnInitializeScene()
 		const int dims = 4;
 		const Vector4 col = Vector4(1.0f, 0.5f, 0.2f, 1.0f);
 
+		std::vector<GameObject*> spheres;
+		spheres.reserve(dims * dims * dims);
 		for (int x = 0; x < dims; ++x)
 		{
 			for (int y = 0; y < dims; ++y)
@@ -111,69 +132,41 @@ void TestScene::OnInitializeScene()
 						true,				// Physically Collidable (has collision shape)
 						false,				// Dragable by user?
 						col);// Render color
-					this->AddGameObject(sphere);
+					spheres.push_back(sphere);
 				}
 			}
 		}
+		this->AddGameObjects(spheres);
 	};
 
 	auto create_soft_body = [&](const Vector3& offset, const Vector3& scale, float ballsize)
 	{
 		const int dims = 15;
-		const Vector4 col = Vector4(1.0f, 0.5f, 0.2f, 1.0f);
-
-		GameObject *objects[dims][dims];
-
-		for (int x = 0; x < dims; ++x)
-		{
-			for (int y = 0; y < dims; ++y)
-			{
-				Vector3 pos = offset + Vector3(scale.x *x, scale.y * y, scale.z);
-				GameObject* sphere;
-				if ((x == 0 || x == dims - 1) && y == dims - 1) {
-					sphere = BuildSphereObject(
-						"soft_body",					// Optional: Name
-						pos,				// Position
-						ballsize,			// Half-Dimensions
-						true,				// Physics Enabled?
-						0.0f,				// Physical Mass (must have physics enabled)
-						true,				// Physically Collidable (has collision shape)
-						true,				// Dragable by user?
-						col);// Render color
-					objects[x][y] = sphere;
-				}
-				else {
-					sphere = BuildSphereObject(
-						"soft_body",					// Optional: Name
-						pos,				// Position
-						ballsize,			// Half-Dimensions
-						true,				// Physics Enabled?
-						10.f,				// Physical Mass (must have physics enabled)
-						true,				// Physically Collidable (has collision shape)
-						true,				// Dragable by user?
-						col);// Render color
-					objects[x][y] = sphere;
-				}
-				//sphere->Physics()->SetElasticity(0.1);
-				if (x != 0) {
-					GameObject* obj1 = objects[x][y];
-					GameObject* obj2 = objects[x - 1][y];
-
-
-					Constraint *c = new DistanceConstraint(obj1->Physics(), obj2->Physics(), obj1->Physics()->GetPosition(), obj2->Physics()->GetPosition());
-					PhysicsEngine::Instance()->AddConstraint(c);
-				}
-				if (y != 0) {
-					GameObject* obj1 = objects[x][y];
-					GameObject* obj2 = objects[x][y - 1];
 
-
-					Constraint *c = new DistanceConstraint(obj1->Physics(), obj2->Physics(), obj1->Physics()->GetPosition(), obj2->Physics()->GetPosition());
-					PhysicsEngine::Instance()->AddConstraint(c);
-				}
-				this->AddGameObject(sphere);
-			}
-		}
+		//Hanging cloth sheet, solved with XPBD as a single soft body rather than a grid of rigid spheres
+		SoftBody* cloth = new SoftBody();
+		cloth->BuildClothGrid(
+			offset + Vector3(0.0f, 0.0f, scale.z),		// Origin
+			Vector3(scale.x * (dims - 1), 0.0f, 0.0f),	// Extent along the first grid axis
+			Vector3(0.0f, scale.y * (dims - 1), 0.0f),	// Extent along the second grid axis
+			dims, dims,									// Number of particles along each axis
+			10.f * dims * dims,							// Total mass
+			ballsize);									// Particle radius
+		cloth->SetColor(Vector4(1.0f, 0.5f, 0.2f, 1.0f));
+
+		//Pin the top two corners
+		cloth->SetParticleInverseMass(cloth->GetClothParticleIndex(0, dims - 1), 0.0f);
+		cloth->SetParticleInverseMass(cloth->GetClothParticleIndex(dims - 1, dims - 1), 0.0f);
+
+		PhysicsEngine::Instance()->AddSoftBody(cloth);
+
+		//Rendered and dragged through it's own GameObject, which has no PhysicsNode as the cloth is stepped by the PhysicsEngine directly
+		RenderNodeSoftBody* cloth_render = new RenderNodeSoftBody(cloth);
+		ScreenPicker::Instance()->RegisterNodeForMouseCallback(
+			cloth_render,
+			std::bind(&RenderNodeSoftBody::OnMouseDrag, cloth_render, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4)
+		);
+		this->AddGameObject(new GameObject("Cloth", cloth_render));
 	};
 
 	//Create Cube Towers
@@ -242,6 +235,7 @@ void TestScene::OnUpdateScene(float dt)
 	NCLDebug::AddStatusEntry(Vector4(1.0f, 0.4f, 0.4f, 1.0f), "   The %s in this scene are dragable", donkeys ? "donkeys" : "cubes");
 	NCLDebug::AddStatusEntry(Vector4(1.0f, 0.4f, 0.4f, 1.0f), "   - Left click to move");
 	NCLDebug::AddStatusEntry(Vector4(1.0f, 0.4f, 0.4f, 1.0f), "   - Right click to rotate (They will be more spinnable after tutorial 2)");
+	NCLDebug::AddStatusEntry(Vector4(1.0f, 0.0f, 0.0f, 1.0f), "   Score: %d (Press J to fire)", m_Score);
 
 	//Or move our car around the scene..
 	{
@@ -299,8 +293,29 @@ void TestScene::OnUpdateScene(float dt)
 	}
 }
 
+void TestScene::OnContactEvents(const PhysicsContactEvent* events, size_t num_events)
+{
+	for (size_t i = 0; i < num_events; ++i)
+	{
+		const PhysicsContactEvent& evt = events[i];
+		if (evt.type == CONTACT_END)
+			continue;
+
+		PhysicsNode* target = NULL;
+		if (evt.pObjectA->GetCollisionLayer() & COLLISION_LAYER_PROJECTILE) target = evt.pObjectB;
+		else if (evt.pObjectB->GetCollisionLayer() & COLLISION_LAYER_PROJECTILE) target = evt.pObjectA;
+		if (!target || !target->GetParent())
+			continue;
+
+		if (target->GetParent()->GetName().compare("Bad Target") == 0) m_Score -= 50;
+		if (target->GetParent()->GetName().compare("Good Target") == 0) m_Score += 100;
+	}
+}
+
 void TestScene::SpawnSphere() {
 	GameObject* sphere = BuildSphereObject("Spawn", GraphicsPipeline::Instance()->GetCamera()->GetPosition(), 1.0f, true, 10.0f, true, true, Vector4(1, 0, 0, 1), S_texture);
+	sphere->Physics()->SetCollisionLayer(COLLISION_LAYER_PROJECTILE);
+	sphere->Physics()->SetCollisionMask(~uint(COLLISION_LAYER_INVISIBLEWALL));
 	sphere->Physics()->SetLinearVelocity(Matrix3::Transpose(GraphicsPipeline::Instance()->GetCamera()->BuildViewMatrix()) * Vector3(0, 0, -1) * 100);
 	this->AddGameObject(sphere);
 }
\ No newline at end of file
@@ -4,6 +4,15 @@
 #include <nclgl\OBJMesh.h>
 #include <ncltech\SpringConstraint.h>
 
+//Collision layers used by the coursework scenes (See PhysicsNode::SetCollisionLayer)
+// - Projectiles pass straight through the invisible walls, everything else collides with everything
+enum CourseworkCollisionLayer
+{
+	COLLISION_LAYER_DEFAULT			= 0x1,
+	COLLISION_LAYER_PROJECTILE		= 0x2,
+	COLLISION_LAYER_INVISIBLEWALL	= 0x4
+};
+
 class TestScene : public Scene
 {
 public:
@@ -17,7 +26,11 @@ public:
 	void SpawnSphere();
 
 protected:
+	//Contact listener, scores projectiles hitting the targets every step they remain in contact
+	void OnContactEvents(const PhysicsContactEvent* events, size_t num_events);
+
 	float m_AccumTime;
+	int m_Score;
 	GameObject* m_pPlayer;
 	GLuint S_texture;
 };
\ No newline at end of file
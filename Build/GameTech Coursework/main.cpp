@@ -3,6 +3,7 @@
 #include <nclgl\Window.h>
 #include <nclgl\NCLDebug.h>
 #include <nclgl\PerfTimer.h>
+#include <nclgl\Profiler.h>
 
 #include "TestScene.h"
 #include "EmptyScene.h"
@@ -15,6 +16,8 @@ bool show_perf_metrics = false;
 bool draw_performance = false;
 PerfTimer timer_total, timer_physics, timer_update, timer_render;
 uint shadowCycleKey = 4;
+PhysicsSnapshot physics_checkpoint;
+const char* broadphase_names[] = { "Brute Force  ", "Sphere-Sphere", "Octree       " };
 
 // Program Deconstructor
 //  - Releases all global components and memory
@@ -67,6 +70,7 @@ void PrintStatusEntries()
 	NCLDebug::AddStatusEntry(status_colour_header, "NCLTech Settings");
 	NCLDebug::AddStatusEntry(status_colour, "     Physics Engine: %s (Press P to toggle)", PhysicsEngine::Instance()->IsPaused() ? "Paused  " : "Enabled ");
 	NCLDebug::AddStatusEntry(status_colour, "     Monitor V-Sync: %s (Press V to toggle)", GraphicsPipeline::Instance()->GetVsyncEnabled() ? "Enabled " : "Disabled");
+	NCLDebug::AddStatusEntry(status_colour, "     Broadphase    : %s (Press B to cycle)", broadphase_names[PhysicsEngine::Instance()->GetBroadphaseMethod()]);
 	NCLDebug::AddStatusEntry(status_colour, "");
 
 	//Print Current Scene Name
@@ -76,6 +80,8 @@ void PrintStatusEntries()
 		SceneManager::Instance()->GetCurrentScene()->GetSceneName().c_str()
 	);
 	NCLDebug::AddStatusEntry(status_colour, "     \x01 T/Y to cycle or R to reload scene");
+	NCLDebug::AddStatusEntry(status_colour, "     \x01 K to checkpoint or L to rewind physics");
+	NCLDebug::AddStatusEntry(status_colour, "     \x01 F9 to capture a profile of the next 120 frames%s", Profiler::IsCapturing() ? " (Capturing...)" : "");
 
 	//Print Performance Timers
 	NCLDebug::AddStatusEntry(status_colour, "     FPS: %5.2f  (Press G for %s info)", 1000.f / timer_total.GetAvg(), show_perf_metrics ? "less" : "more");
@@ -94,7 +100,6 @@ void PrintStatusEntries()
 			NCLDebug::AddStatusEntry(status_color_performance, "");
 		}
 	}
-	NCLDebug::AddStatusEntry(Vector4(1, 0, 0, 1), "score: " + std::to_string(PhysicsEngine::Instance()->GetScore()));
 	NCLDebug::AddStatusEntry(status_colour, "");
 }
 
@@ -111,6 +116,9 @@ void HandleKeyboardInputs()
 	if (Window::GetKeyboard()->KeyTriggered(KEYBOARD_V))
 		GraphicsPipeline::Instance()->SetVsyncEnabled(!GraphicsPipeline::Instance()->GetVsyncEnabled());
 
+	if (Window::GetKeyboard()->KeyTriggered(KEYBOARD_B))
+		PhysicsEngine::Instance()->SetBroadphaseMethod(PhysicsBroadphaseMethod((PhysicsEngine::Instance()->GetBroadphaseMethod() + 1) % 3));
+
 	uint sceneIdx = SceneManager::Instance()->GetCurrentSceneIndex();
 	uint sceneMax = SceneManager::Instance()->SceneCount();
 	if (Window::GetKeyboard()->KeyTriggered(KEYBOARD_Y))
@@ -122,12 +130,24 @@ void HandleKeyboardInputs()
 	if (Window::GetKeyboard()->KeyTriggered(KEYBOARD_R))
 		SceneManager::Instance()->JumpToScene(sceneIdx);
 
+	//Checkpoints only store the physics world, so rewinding is much cheaper than reloading
+	// the scene, though it will fail if bodies have since been added or removed
+	if (Window::GetKeyboard()->KeyTriggered(KEYBOARD_K))
+		PhysicsEngine::Instance()->SaveSnapshot(physics_checkpoint);
+
+	if (Window::GetKeyboard()->KeyTriggered(KEYBOARD_L) && !physics_checkpoint.empty())
+		PhysicsEngine::Instance()->RestoreSnapshot(physics_checkpoint);
+
 	if (Window::GetKeyboard()->KeyTriggered(KEYBOARD_G))
 		show_perf_metrics = !show_perf_metrics;
 
 	if (Window::GetKeyboard()->KeyTriggered(KEYBOARD_H))
 		draw_performance = !draw_performance;
 
+	//Open the capture in chrome://tracing to see each stage of the frame
+	if (Window::GetKeyboard()->KeyTriggered(KEYBOARD_F9))
+		Profiler::CaptureFrames(120, "profile_capture.json");
+
 }
 
 
@@ -140,8 +160,12 @@ int main()
 
 	Window::GetWindow().GetTimer()->GetTimedMS();
 
+	Profiler::SetThreadName("Main Thread");
+
 	//Create main game-loop
 	while (Window::GetWindow().UpdateWindow() && !(Window::GetKeyboard()->KeyDown(KEYBOARD_ESCAPE) || Window::GetKeyboard()->KeyDown(KEYBOARD_X))) {
+		Profiler::NewFrame();
+
 		//Start Timing
 
 		float dt = Window::GetWindow().GetTimer()->GetTimedMS() * 0.001f;	//How many milliseconds since last update?
@@ -162,9 +186,16 @@ int main()
 
 		//Update Scene
 		timer_update.BeginTimingSection();
-		SceneManager::Instance()->GetCurrentScene()->OnUpdateScene(dt);
+		{
+			PROFILE_SCOPE("Scene Update");
+			SceneManager::Instance()->GetCurrentScene()->OnUpdateScene(dt);
+		}
 		timer_update.EndTimingSection();
 
+		//Physics level of detail (if enabled by the scene) is measured from the camera
+		PhysicsEngine::Instance()->ClearLODInterestPoints();
+		PhysicsEngine::Instance()->AddLODInterestPoint(GraphicsPipeline::Instance()->GetCamera()->GetPosition());
+
 		//Update Physics	
 		timer_physics.BeginTimingSection();
 		PhysicsEngine::Instance()->Update(dt);
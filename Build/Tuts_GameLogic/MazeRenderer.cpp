@@ -195,6 +195,7 @@ void MazeRenderer::Generate_BuildRenderNodes()
 
 //Turn walls into 3D Cuboids
 	const float scalar = 1.f / (float)flat_maze_size;
+	wall_transforms.reserve(wall_descriptors.size() + 4);
 	for (const WallDescriptor& w : wall_descriptors)
 	{
 		Vector3 start = Vector3(
@@ -216,28 +217,21 @@ void MazeRenderer::Generate_BuildRenderNodes()
 		Vector3 centre = (end + start) * 0.5f;
 		Vector3 halfDims = centre - start;
 
-		cube = new RenderNode(mesh, wall_color);
-		cube->SetTransform(Matrix4::Translation(centre) * Matrix4::Scale(halfDims));
-		root->AddChild(cube);
-
+		wall_transforms.push_back(Matrix4::Translation(centre) * Matrix4::Scale(halfDims));
 	}
 
 //Add bounding edge walls to the maze
-	cube = new RenderNode(mesh, wall_color);
-	cube->SetTransform(Matrix4::Translation(Vector3(-scalar*0.5f, 0.25f, 0.5)) * Matrix4::Scale(Vector3(scalar*0.5f, 0.25f, scalar + 0.5f)));
-	root->AddChild(cube);
+	wall_transforms.push_back(Matrix4::Translation(Vector3(-scalar*0.5f, 0.25f, 0.5)) * Matrix4::Scale(Vector3(scalar*0.5f, 0.25f, scalar + 0.5f)));
+	wall_transforms.push_back(Matrix4::Translation(Vector3(1.f + scalar*0.5f, 0.25f, 0.5)) * Matrix4::Scale(Vector3(scalar*0.5f, 0.25f, scalar + 0.5f)));
+	wall_transforms.push_back(Matrix4::Translation(Vector3(0.5, 0.25f, -scalar*0.5f)) * Matrix4::Scale(Vector3(0.5f, 0.25f, scalar*0.5f)));
+	wall_transforms.push_back(Matrix4::Translation(Vector3(0.5, 0.25f, 1.f + scalar*0.5f)) * Matrix4::Scale(Vector3(0.5f, 0.25f, scalar*0.5f)));
 
-	cube = new RenderNode(mesh, wall_color);
-	cube->SetTransform(Matrix4::Translation(Vector3(1.f + scalar*0.5f, 0.25f, 0.5)) * Matrix4::Scale(Vector3(scalar*0.5f, 0.25f, scalar + 0.5f)));
-	root->AddChild(cube);
-
-	cube = new RenderNode(mesh, wall_color);
-	cube->SetTransform(Matrix4::Translation(Vector3(0.5, 0.25f, -scalar*0.5f)) * Matrix4::Scale(Vector3(0.5f, 0.25f, scalar*0.5f)));
-	root->AddChild(cube);
-
-	cube = new RenderNode(mesh, wall_color);
-	cube->SetTransform(Matrix4::Translation(Vector3(0.5, 0.25f, 1.f + scalar*0.5f)) * Matrix4::Scale(Vector3(0.5f, 0.25f, scalar*0.5f)));
-	root->AddChild(cube);
+	for (const Matrix4& transform : wall_transforms)
+	{
+		cube = new RenderNode(mesh, wall_color);
+		cube->SetTransform(transform);
+		root->AddChild(cube);
+	}
 
 
 //Finally - our start/end goals
@@ -269,4 +263,15 @@ void MazeRenderer::Generate_BuildRenderNodes()
 	root->AddChild(cube);
 
 	this->SetRender(root);
+}
+
+TriangleMeshCollisionShape* MazeRenderer::BuildCollisionShape(const Matrix4& transform) const
+{
+	TriangleMeshCollisionShape* shape = new TriangleMeshCollisionShape();
+	for (const Matrix4& wall : wall_transforms)
+	{
+		shape->AddMesh(mesh, transform * wall);
+	}
+	shape->BuildBVH();
+	return shape;
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include <ncltech\GameObject.h>
 #include <ncltech\CommonMeshes.h>
+#include <ncltech\TriangleMeshCollisionShape.h>
 #include "MazeGenerator.h"
 #include "SearchAlgorithm.h"
 
@@ -27,6 +28,12 @@ public:
 	// and 'from' of GraphNodes.
 	void DrawSearchHistory(const SearchHistory& history, float line_width);
 
+	//Builds a single static collision shape out of every wall in the maze (including the
+	// outer walls), so the whole maze is just one object to the physics engine. The transform
+	// (usually the same as Render()'s, minus the parent PhysicsNode's position) is baked into the
+	// triangles.
+	TriangleMeshCollisionShape* BuildCollisionShape(const Matrix4& transform = Matrix4()) const;
+
 
 protected:
 	//Turn MazeGenerator data into flat 2D map (3 size x 3 size) of boolean's
@@ -50,4 +57,5 @@ protected:
 	uint	flat_maze_size;
 
 	WallDescriptorVec	wall_descriptors;
+	std::vector<Matrix4> wall_transforms;	//Maze space transform of each wall's mesh
 };
\ No newline at end of file
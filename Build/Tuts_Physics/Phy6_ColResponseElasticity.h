@@ -50,6 +50,7 @@ public:
 			this->AddGameObject(obj);
 
 			//Create Bouncing Spheres
+			std::vector<GameObject*> spheres;
 			for (int i = 0; i <= 5; ++i)
 			{
 				Vector4 color = CommonUtils::GenColor(0.7f + i * 0.05f, 1.0f);
@@ -64,8 +65,9 @@ public:
 					color);
 				obj->Physics()->SetFriction(0.0f);
 				obj->Physics()->SetElasticity(i * 0.2f);
-				this->AddGameObject(obj);
+				spheres.push_back(obj);
 			}
+			this->AddGameObjects(spheres);
 		}
 	}
 
@@ -55,6 +55,7 @@ public:
 			);
 
 			//Create Cubes to roll on ramp
+			std::vector<GameObject*> cubes;
 			for (int i = 0; i <= 5; ++i)
 			{
 				Vector4 color = Vector4(i * 0.25f, 0.7f, (2 - i) * 0.25f, 1.0f);
@@ -73,8 +74,9 @@ public:
 
 				//Initial push??
 				//cube->Physics()->SetLinearVelocity(Quaternion::AxisAngleToQuaterion(Vector3(0.0f, 0.0f, 1.0f), 20.0f).ToMatrix3() * Vector3(-1.f, 0.f, 0.f));
-				this->AddGameObject(cube);
+				cubes.push_back(cube);
 			}
+			this->AddGameObjects(cubes);
 		}
 	}
 
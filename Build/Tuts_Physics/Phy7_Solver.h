@@ -36,6 +36,8 @@ public:
 		const float width_scalar = 1.0f; 
 		const float height_scalar = 1.0f; 
 
+		std::vector<GameObject*> cubes;
+		cubes.reserve(m_StackHeight * (m_StackHeight + 1) / 2);
 		for (int y = 0; y < m_StackHeight; ++y)
 		{
 			for (int x = 0; x <= y; ++x)
@@ -53,9 +55,10 @@ public:
 				cube->Physics()->SetElasticity(0.0f); //No elasticity (Little cheaty)
 				cube->Physics()->SetFriction(1.0f);
 
-				this->AddGameObject(cube);
+				cubes.push_back(cube);
 			}
 		}
+		this->AddGameObjects(cubes);
 		
 
 	}
@@ -31,6 +31,11 @@ public:
 		children.push_back(m);
 	}
 
+	//Gets the child meshes (not including the parent mesh itself)
+	const std::vector<Mesh*>& GetChildren() const	{
+		return children;
+	}
+
 	virtual ~ChildMeshInterface() {
 		for(unsigned int i = 0; i < children.size(); ++i) {
 			delete children.at(i);
@@ -22,8 +22,8 @@ _-_-_-_-_-_-_-""  ""
 *//////////////////////////////////////////////////////////////////////////////
 
 #pragma once
-#include "..\nclgl\RenderNode.h"
-#include "..\nclgl\OBJMesh.h"
+#include "../nclgl/RenderNode.h"
+#include "../nclgl/OBJMesh.h"
 
 class CubeRobot : public RenderNode	{
 public:
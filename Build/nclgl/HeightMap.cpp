@@ -1,6 +1,12 @@
 #include "HeightMap.h"
 
 HeightMap::HeightMap(std::string name, const uint rawWidth, const uint rawHeight, const float HeightMapX, const float HeightMapY, const float HeightMapZ, const float HeightMapTexX, const float HeightMapTexZ) {
+	heights = std::make_shared<std::vector<float>>();
+	numSamplesX = 0;
+	numSamplesZ = 0;
+	sampleSpacingX = HeightMapX;
+	sampleSpacingZ = HeightMapZ;
+
 	std::ifstream file(name.c_str(), ios::binary);
 	if (!file) {
 		return;
@@ -14,11 +20,16 @@ HeightMap::HeightMap(std::string name, const uint rawWidth, const uint rawHeight
 	file.read((char *)data, numVertices * sizeof(unsigned char));
 	file.close();
 
+	numSamplesX = rawWidth;
+	numSamplesZ = rawHeight;
+	heights->resize(numVertices);
+
 	for (uint x = 0; x < rawWidth; ++x) {
 		for (uint z = 0; z < rawHeight; ++z) {
 			uint offset = (x * rawWidth) + z;
 
 			vertices[offset] = Vector3(x * HeightMapX, data[offset] * HeightMapY, z * HeightMapZ);
+			(*heights)[x * rawHeight + z] = vertices[offset].y;
 
 			textureCoords[offset] = Vector2(x * HeightMapTexX, z * HeightMapTexZ);
 		}
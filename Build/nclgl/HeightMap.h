@@ -2,8 +2,10 @@
 #include <string>
 #include <iostream>
 #include <fstream>
+#include <memory>
+#include <vector>
 
-#include "..\nclgl\mesh.h"
+#include "../nclgl/mesh.h"
 
 
 #ifndef HEIGHT_MAP_DEF_OFF
@@ -22,4 +24,18 @@ public:
 	HeightMap(std::string name, const uint rawWidth = RAW_WIDTH, const uint rawHeight = RAW_HEIGHT, const float HeightMapX= HEIGHTMAP_X, const float HeightMapY = HEIGHTMAP_Y, const float HeightMapZ = HEIGHTMAP_Z, const float HeightMapTexX = HEIGHTMAP_TEX_X, const float HeightMapTexZ = HEIGHTMAP_TEX_Z);
 	~HeightMap(void) {};
 
+	//Raw (already scaled) sample heights, indexed [x * GetNumSamplesZ() + z]. The array is shared so
+	// collision shapes (See HeightFieldCollisionShape) can keep using it without a copy.
+	inline std::shared_ptr<const std::vector<float>> GetHeights() const { return heights; }
+	inline uint GetNumSamplesX() const { return numSamplesX; }
+	inline uint GetNumSamplesZ() const { return numSamplesZ; }
+
+	//Distance between neighbouring samples along x/z
+	inline float GetSampleSpacingX() const { return sampleSpacingX; }
+	inline float GetSampleSpacingZ() const { return sampleSpacingZ; }
+
+protected:
+	std::shared_ptr<std::vector<float>> heights;
+	uint	numSamplesX, numSamplesZ;
+	float	sampleSpacingX, sampleSpacingZ;
 };
@@ -1,8 +1,10 @@
 #include "NCLDebug.h"
 #include "Window.h"
 #include "Mesh.h"
+#include "Profiler.h"
 #include <SOIL.h>
 #include <algorithm>
+#include <mutex>
 #include <sstream>
 
 Vector3	NCLDebug::g_CameraPosition;
@@ -20,6 +22,9 @@ FILE* NCLDebug::g_vOutLogFile		= NULL;
 std::deque<LogEntry> NCLDebug::g_vLogEntries; 
 int NCLDebug::g_vLogOffsetIdx = -1;
 
+//Physics worlds can be updated on worker threads (See PhysicsEngine::UpdateWorlds), so logging has to be thread safe
+static std::mutex g_LogMutex;
+
 std::vector<Vector4> NCLDebug::g_vChars;
 uint NCLDebug::g_vCharsLogStart = 0;
 
@@ -349,6 +354,7 @@ void NCLDebug::AddLogEntry(const Vector3& color, const std::string& text)
 	le.text = prepend + text;
 	le.color = Vector4(color.x, color.y, color.z, 1.0f);
 
+	std::lock_guard<std::mutex> lock(g_LogMutex);
 	g_vLogEntries.push_back(le);	
 	if (g_vLogOffsetIdx == int(g_vLogEntries.size()) - 2)
 	{
@@ -469,6 +475,8 @@ struct TriVertex
 
 void NCLDebug::_BuildRenderLists()
 {
+	PROFILE_SCOPE("NCLDebug::_BuildRenderLists");
+
 	//Sort the lists for transparent rendering
 	_SortRenderLists();
 
@@ -65,8 +65,16 @@ function as it will include the filename and linenumber it was triggered on with
 #include "Matrix3.h"
 #include "Vector4.h"
 #include "Vector3.h"
-#include "Shader.h"
 #include <vector>
+
+//Headless builds (See USE_HEADLESS_PHYSICS) are linked against NCLDebugHeadless.cpp instead, which
+// discards all drawing and prints log entries to the console, so never need the GL headers
+#ifdef USE_HEADLESS_PHYSICS
+typedef unsigned int GLuint;
+class Shader;
+#else
+#include "Shader.h"
+#endif
 #include <mutex>
 #include <deque>
 
@@ -88,12 +96,12 @@ enum TextAlignment
 };
 
 #if _DEBUG
-#define NCLERROR(str, ...) {NCLDebug::LogE(__FILE__, __LINE__, str, __VA_ARGS__);  __debugbreak();}
+#define NCLERROR(str, ...) {NCLDebug::LogE(__FILE__, __LINE__, str, ##__VA_ARGS__);  __debugbreak();}
 #else
-#define NCLERROR(str, ...) {NCLDebug::LogE(__FILE__, __LINE__, str, __VA_ARGS__);} 
+#define NCLERROR(str, ...) {NCLDebug::LogE(__FILE__, __LINE__, str, ##__VA_ARGS__);} 
 #endif
 
-#define NCLLOG(str, ...) NCLDebug::Log(str, __VA_ARGS__)
+#define NCLLOG(str, ...) NCLDebug::Log(str, ##__VA_ARGS__)
 
 
 
@@ -0,0 +1,106 @@
+#include "NCLDebug.h"
+#include <cstdarg>
+#include <cstdio>
+#include <ctime>
+#include <iostream>
+#include <mutex>
+
+//Stand-in for NCLDebug.cpp used by headless builds (USE_HEADLESS_PHYSICS), which have no renderer
+// - All drawing is discarded, log entries are only printed to the console
+
+static std::mutex g_HeadlessLogMutex;
+
+static void HeadlessLogEntry(const std::string& text)
+{
+	std::lock_guard<std::mutex> lock(g_HeadlessLogMutex);
+
+	char buf[80];
+	time_t now = time(NULL);
+	strftime(buf, sizeof(buf), "[%H:%M:%S] ", localtime(&now));
+
+	std::cout << buf << text << std::endl;
+}
+
+static std::string HeadlessFormat(const char* format, va_list args)
+{
+	char buf[1024];
+	int needed = vsnprintf(buf, sizeof(buf), format, args);
+	size_t length = (needed < 0 || needed >= int(sizeof(buf))) ? sizeof(buf) - 1 : (size_t)needed;
+	return std::string(buf, length);
+}
+
+
+void NCLDebug::DrawPoint(const Vector3& pos, float point_radius, const Vector3& color) {}
+void NCLDebug::DrawPoint(const Vector3& pos, float point_radius, const Vector4& color) {}
+void NCLDebug::DrawPointNDT(const Vector3& pos, float point_radius, const Vector3& color) {}
+void NCLDebug::DrawPointNDT(const Vector3& pos, float point_radius, const Vector4& color) {}
+
+void NCLDebug::DrawThickLine(const Vector3& start, const Vector3& end, float line_width, const Vector3& color) {}
+void NCLDebug::DrawThickLine(const Vector3& start, const Vector3& end, float line_width, const Vector4& color) {}
+void NCLDebug::DrawThickLineNDT(const Vector3& start, const Vector3& end, float line_width, const Vector3& color) {}
+void NCLDebug::DrawThickLineNDT(const Vector3& start, const Vector3& end, float line_width, const Vector4& color) {}
+
+void NCLDebug::DrawHairLine(const Vector3& start, const Vector3& end, const Vector3& color) {}
+void NCLDebug::DrawHairLine(const Vector3& start, const Vector3& end, const Vector4& color) {}
+void NCLDebug::DrawHairLineNDT(const Vector3& start, const Vector3& end, const Vector3& color) {}
+void NCLDebug::DrawHairLineNDT(const Vector3& start, const Vector3& end, const Vector4& color) {}
+
+void NCLDebug::DrawMatrix(const Matrix4& transform_mtx) {}
+void NCLDebug::DrawMatrix(const Matrix3& rotation_mtx, const Vector3& position) {}
+void NCLDebug::DrawMatrixNDT(const Matrix4& transform_mtx) {}
+void NCLDebug::DrawMatrixNDT(const Matrix3& rotation_mtx, const Vector3& position) {}
+
+void NCLDebug::DrawTriangle(const Vector3& v0, const Vector3& v1, const Vector3& v2, const Vector4& color) {}
+void NCLDebug::DrawTriangleNDT(const Vector3& v0, const Vector3& v1, const Vector3& v2, const Vector4& color) {}
+
+void NCLDebug::DrawPolygon(int n_verts, const Vector3* verts, const Vector4& color) {}
+void NCLDebug::DrawPolygonNDT(int n_verts, const Vector3* verts, const Vector4& color) {}
+
+void NCLDebug::DrawTextWs(const Vector3& pos, const float font_size, const TextAlignment alignment, const Vector4 color, const std::string text, ...) {}
+void NCLDebug::DrawTextWsNDT(const Vector3& pos, const float font_size, const TextAlignment alignment, const Vector4 color, const std::string text, ...) {}
+void NCLDebug::DrawTextCs(const Vector4& pos, const float font_size, const std::string& text, const TextAlignment alignment, const Vector4 color) {}
+
+void NCLDebug::AddStatusEntry(const Vector4& color, const std::string text, ...) {}
+
+
+void NCLDebug::Log(const Vector3& color, const std::string text, ...)
+{
+	va_list args;
+	va_start(args, text);
+	std::string entry = HeadlessFormat(text.c_str(), args);
+	va_end(args);
+
+	HeadlessLogEntry(entry);
+}
+
+void NCLDebug::Log(const std::string text, ...)
+{
+	va_list args;
+	va_start(args, text);
+	std::string entry = HeadlessFormat(text.c_str(), args);
+	va_end(args);
+
+	HeadlessLogEntry(entry);
+}
+
+void NCLDebug::LogE(const char* filename, int linenumber, const std::string text, ...)
+{
+	va_list args;
+	va_start(args, text);
+	std::string entry = HeadlessFormat(text.c_str(), args);
+	va_end(args);
+
+	//Same format as the on-screen log
+	HeadlessLogEntry("[ERROR] " + std::string(filename) + ":" + std::to_string(linenumber));
+	HeadlessLogEntry("\t \"" + entry + "\"");
+}
+
+
+void NCLDebug::_ClearLog() {}
+void NCLDebug::_ClearDebugLists() {}
+void NCLDebug::_BuildRenderLists() {}
+void NCLDebug::_RenderDebugDepthTested() {}
+void NCLDebug::_RenderDebugNonDepthTested() {}
+void NCLDebug::_RenderDebugClipSpace() {}
+void NCLDebug::_LoadShaders() {}
+void NCLDebug::_ReleaseShaders() {}
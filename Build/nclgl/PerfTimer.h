@@ -4,7 +4,8 @@ Author:
 Pieran Marris <p.marris@newcastle.ac.uk>
 Description:
 
-Extension of the GameTimer class in nclgl for the purpose of creating a FPS based timer.
+Timer for the purpose of creating a FPS based timer. Built on std::chrono (rather than the QueryPerformanceCounter
+based GameTimer) so it can be used by the headless physics builds on any platform.
 
 The PerfTimer is designed to help time how long various parts of code take to execute. By
 wrapping the timed part of code with a call to BeginTimingSection and EndTimingSection respectively
@@ -13,13 +14,30 @@ it will automatically keep track of how long it took to execute.
 The results are cached and only updated once per second (see m_UpdateInterval to change this), so can
 be output directly to the user without having to worry about changing too fast to be readable.
 
+Alongside the min/max/average, every sample is counted in a log-bucketed histogram (8 buckets per
+doubling of time, from ~1us to ~16s) so percentiles can be queried. An average hides the occasional
+hitch, the p99 doesn't. Results can cover more than one window (see SetNumWindows), e.g. 10 one
+second windows gives a rolling view of the last 10 seconds that still updates every second.
+
+Begin/EndTimingSection use a single timer so must be called from one thread, but RecordSample is
+lock-free and can be called from any number of worker threads at once.
+
 Example usage can be seen inside the Tuts_Physics project where a PerfTimer is used to measure execution
 time of the various components of the game engine.
 */
 
 #pragma once
-#include "GameTimer.h"
 #include "NCLDebug.h"
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <memory>
+#include <cmath>
+
+#define PERFTIMER_BUCKETS_PER_OCTAVE	8
+#define PERFTIMER_MIN_OCTAVE			-10		//Smallest bucket starts at 2^-10 ms (~1us)
+#define PERFTIMER_NUM_OCTAVES			24
+#define PERFTIMER_NUM_BUCKETS			(PERFTIMER_BUCKETS_PER_OCTAVE * PERFTIMER_NUM_OCTAVES)
 
 class PerfTimer
 {
@@ -27,55 +45,105 @@ public:
 	PerfTimer()
 		: m_UpdateInterval(1.0f)
 		, m_RealTimeElapsed(0.0f)
+		, m_CurrentWindow(0)
 	{
-		m_Timer.GetTimedMS();
-		memset(&m_CurrentData, 0, sizeof(PerfTimer_Data));
-		memset(&m_PreviousData, 0, sizeof(PerfTimer_Data));
+		m_SectionStart = std::chrono::steady_clock::now();
+		SetNumWindows(1);
 	}
 
 	virtual ~PerfTimer() {}
 
 
-	//Returns the maximum execution time recorded in the last second
+	//Returns the maximum execution time recorded in the last window(s)
 	inline float GetHigh() const { return m_PreviousData._max; }
 
-	//Returns the minimum execution time recorded in the last second
+	//Returns the minimum execution time recorded in the last window(s)
 	inline float GetLow() const { return m_PreviousData._min; }
 
-	//Returns the average execution time
-	inline float GetAvg() const { return m_PreviousData._sum / float(m_PreviousData._num); }
+	//Returns the average execution time, or zero if nothing was recorded
+	inline float GetAvg() const { return (m_PreviousData._num > 0) ? float(m_PreviousData._sum / double(m_PreviousData._num)) : 0.0f; }
+
+	//Returns the number of samples recorded in the last window(s)
+	inline uint GetNumSamples() const { return m_PreviousData._num; }
+
+	//Returns the execution time that the given fraction (0-1) of samples came in under, e.g. 0.99f for the p99.
+	// - Accurate to the width of a histogram bucket (~9%)
+	float GetPercentile(float fraction) const
+	{
+		const uint num = m_PreviousData._num;
+		if (num == 0)
+			return 0.0f;
+
+		const uint rank = max(1u, (uint)ceil(double(fraction) * num));
+		uint count = 0;
+		for (uint i = 0; i < PERFTIMER_NUM_BUCKETS; ++i)
+		{
+			count += m_PreviousHistogram[i];
+			if (count >= rank)
+			{
+				//Geometric centre of the bucket, kept within the real range of the samples
+				const float centre = exp2f(float(PERFTIMER_MIN_OCTAVE) + (float(i) + 0.5f) / PERFTIMER_BUCKETS_PER_OCTAVE);
+				return min(max(centre, m_PreviousData._min), m_PreviousData._max);
+			}
+		}
+		return m_PreviousData._max;
+	}
 
 	//Changes the rate at which the results are updated/replaced
 	void SetUpdateInterval(float seconds) { m_UpdateInterval = seconds; }
 
+	//Number of update intervals the results cover, the oldest dropping out as each new one completes.
+	// - Must not be called while other threads are recording, clears all results
+	void SetNumWindows(uint num_windows)
+	{
+		//One extra window is always being recorded into
+		m_NumWindows = max(num_windows, 1u) + 1;
+		m_Windows.reset(new PerfTimer_Window[m_NumWindows]);
+		for (uint i = 0; i < m_NumWindows; ++i)
+		{
+			m_Windows[i].Reset();
+		}
+		m_CurrentWindow = 0;
+
+		memset(&m_PreviousData, 0, sizeof(PerfTimer_Data));
+		memset(m_PreviousHistogram, 0, sizeof(m_PreviousHistogram));
+	}
+	inline uint GetNumWindows() const { return m_NumWindows - 1; }
+
 
 
 	//Called /before/ the section of code to measure
 	void BeginTimingSection()
 	{
-		m_Timer.GetTimedMS(); //In the underlying GameTimer class this resets the time since last called variable.
+		m_SectionStart = std::chrono::steady_clock::now();
 	}
 
 
-	void EndTimingSection()
+	//Returns the time taken (in milliseconds) since BeginTimingSection
+	float EndTimingSection()
 	{
-		float elapsed = m_Timer.GetTimedMS();
+		const float elapsed = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - m_SectionStart).count();
+		RecordSample(elapsed);
+		return elapsed;
+	}
 
-		//Set the min/max execution times
-		if (m_CurrentData._num == 0)
-		{
-			m_CurrentData._max = elapsed;
-			m_CurrentData._min = elapsed;
-		}
-		else
-		{
-			m_CurrentData._max = max(m_CurrentData._max, elapsed);
-			m_CurrentData._min = min(m_CurrentData._min, elapsed);
-		}
 
-		//Accumulate data required for calculating average execution time
-		m_CurrentData._num++;
-		m_CurrentData._sum += elapsed;
+	//Adds an execution time (in milliseconds) measured elsewhere, safe to call from any thread
+	void RecordSample(float elapsed)
+	{
+		PerfTimer_Window& window = m_Windows[m_CurrentWindow.load(std::memory_order_acquire)];
+
+		window._histogram[GetBucket(elapsed)].fetch_add(1, std::memory_order_relaxed);
+		window._num.fetch_add(1, std::memory_order_relaxed);
+
+		double sum = window._sum.load(std::memory_order_relaxed);
+		while (!window._sum.compare_exchange_weak(sum, sum + elapsed, std::memory_order_relaxed)) {}
+
+		float cur_max = window._max.load(std::memory_order_relaxed);
+		while (elapsed > cur_max && !window._max.compare_exchange_weak(cur_max, elapsed, std::memory_order_relaxed)) {}
+
+		float cur_min = window._min.load(std::memory_order_relaxed);
+		while (elapsed < cur_min && !window._min.compare_exchange_weak(cur_min, elapsed, std::memory_order_relaxed)) {}
 	}
 
 
@@ -89,8 +157,13 @@ public:
 		if (m_RealTimeElapsed >= m_UpdateInterval)
 		{
 			m_RealTimeElapsed -= m_UpdateInterval;
-			m_PreviousData = m_CurrentData;
-			memset(&m_CurrentData, 0, sizeof(PerfTimer_Data));
+
+			//Clear out the oldest window before handing it to the recording threads
+			const uint next_window = (m_CurrentWindow.load(std::memory_order_relaxed) + 1) % m_NumWindows;
+			m_Windows[next_window].Reset();
+			m_CurrentWindow.store(next_window, std::memory_order_release);
+
+			BuildPreviousData(next_window);
 		}
 	}
 
@@ -98,14 +171,62 @@ public:
 	// Must be called once per frame in order to be shown.
 	void PrintOutputToStatusEntry(const Vector4& colour, const std::string& name)
 	{
-		NCLDebug::AddStatusEntry(colour, "%s%5.2fms [max:%5.2fms, min:%5.2fms]", name.c_str(), GetAvg(), GetHigh(), GetLow());
+		NCLDebug::AddStatusEntry(colour, "%s%5.2fms [max:%5.2fms, min:%5.2fms, p99:%5.2fms]", name.c_str(), GetAvg(), GetHigh(), GetLow(), GetPercentile(0.99f));
+	}
+
+	// As above, but with the full spread of percentiles instead of the min/max
+	void PrintPercentilesToStatusEntry(const Vector4& colour, const std::string& name)
+	{
+		NCLDebug::AddStatusEntry(colour, "%s[p50:%5.2fms, p90:%5.2fms, p99:%5.2fms, p99.9:%5.2fms]", name.c_str(),
+			GetPercentile(0.5f), GetPercentile(0.9f), GetPercentile(0.99f), GetPercentile(0.999f));
+	}
+
+protected:
+	static uint GetBucket(float elapsed)
+	{
+		if (!(elapsed > 0.0f))
+			return 0;
+
+		const int bucket = (int)floor((log2f(elapsed) - PERFTIMER_MIN_OCTAVE) * PERFTIMER_BUCKETS_PER_OCTAVE);
+		return (uint)min(max(bucket, 0), PERFTIMER_NUM_BUCKETS - 1);
+	}
+
+	//Combines every completed window (all but current_window) into the cached results
+	void BuildPreviousData(uint current_window)
+	{
+		memset(&m_PreviousData, 0, sizeof(PerfTimer_Data));
+		memset(m_PreviousHistogram, 0, sizeof(m_PreviousHistogram));
+		m_PreviousData._min = FLT_MAX;
+
+		for (uint w = 0; w < m_NumWindows; ++w)
+		{
+			if (w == current_window)
+				continue;
+
+			const PerfTimer_Window& window = m_Windows[w];
+			const uint num = window._num.load(std::memory_order_relaxed);
+			if (num == 0)
+				continue;
+
+			m_PreviousData._num += num;
+			m_PreviousData._sum += window._sum.load(std::memory_order_relaxed);
+			m_PreviousData._max = max(m_PreviousData._max, window._max.load(std::memory_order_relaxed));
+			m_PreviousData._min = min(m_PreviousData._min, window._min.load(std::memory_order_relaxed));
+
+			for (uint i = 0; i < PERFTIMER_NUM_BUCKETS; ++i)
+			{
+				m_PreviousHistogram[i] += window._histogram[i].load(std::memory_order_relaxed);
+			}
+		}
+
+		if (m_PreviousData._num == 0) m_PreviousData._min = 0.0f;
 	}
 
 protected:
 	float m_UpdateInterval;
 	float m_RealTimeElapsed;
 
-	GameTimer m_Timer;
+	std::chrono::steady_clock::time_point m_SectionStart;
 
 	struct PerfTimer_Data
 	{
@@ -113,10 +234,33 @@ protected:
 		float	_min;
 
 		//Average defined by (_sum / _num)
-		float	_sum;
-		int		_num;
+		double	_sum;
+		uint	_num;
 	};
 
-	PerfTimer_Data m_PreviousData;	// Front - Last completed measurement, shown for output
-	PerfTimer_Data m_CurrentData;	// Back - Currently Updating
-};
\ No newline at end of file
+	//Samples recorded during a single update interval, written to by any thread
+	struct PerfTimer_Window
+	{
+		std::atomic<float>	_max;
+		std::atomic<float>	_min;
+		std::atomic<double>	_sum;
+		std::atomic<uint>	_num;
+		std::atomic<uint>	_histogram[PERFTIMER_NUM_BUCKETS];
+
+		void Reset()
+		{
+			_max.store(0.0f, std::memory_order_relaxed);
+			_min.store(FLT_MAX, std::memory_order_relaxed);
+			_sum.store(0.0, std::memory_order_relaxed);
+			_num.store(0, std::memory_order_relaxed);
+			for (uint i = 0; i < PERFTIMER_NUM_BUCKETS; ++i) _histogram[i].store(0, std::memory_order_relaxed);
+		}
+	};
+
+	std::unique_ptr<PerfTimer_Window[]>	m_Windows;			// Ring of the last m_NumWindows windows
+	uint								m_NumWindows;
+	std::atomic<uint>					m_CurrentWindow;	// Window currently being recorded into
+
+	PerfTimer_Data	m_PreviousData;									// Front - Completed windows combined, shown for output
+	uint			m_PreviousHistogram[PERFTIMER_NUM_BUCKETS];
+};
@@ -0,0 +1,195 @@
+#include "Profiler.h"
+#include "NCLDebug.h"
+#include <chrono>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <cstdio>
+
+//Maximum zones each thread can record per capture, any further zones are dropped
+#define PROFILER_MAX_ZONES_PER_THREAD (1 << 16)
+
+std::atomic<bool>	Profiler::recording(false);
+std::atomic<uint>	Profiler::captureId(0);
+
+uint				Profiler::frameIndex = 0;
+long long			Profiler::frameBegin = 0;
+
+uint				Profiler::captureFirstFrame = 0;
+uint				Profiler::captureLastFrame = 0;
+std::string			Profiler::captureFilename;
+
+
+struct ProfileZoneRecord
+{
+	const char*	name;
+	long long	begin;
+	long long	end;
+};
+
+//Only ever written to by it's owning thread, and only read once recording has stopped
+struct ProfileThreadBuffer
+{
+	uint				threadIdx;
+	std::string			threadName;
+
+	std::atomic<uint>	captureId;		//Capture the zones belong to, stale buffers are emptied on their next write
+	std::atomic<uint>	numZones;
+	std::atomic<uint>	numDropped;
+	std::unique_ptr<ProfileZoneRecord[]> zones;
+};
+
+//The lock is only taken the first time each thread records a zone, and when a capture is written out
+static std::mutex g_ThreadBuffersMutex;
+static std::vector<std::unique_ptr<ProfileThreadBuffer>> g_ThreadBuffers;
+static thread_local ProfileThreadBuffer* g_pThreadBuffer = NULL;
+
+static long long g_CaptureBegin = 0;
+
+static ProfileThreadBuffer* GetThreadBuffer()
+{
+	if (!g_pThreadBuffer)
+	{
+		ProfileThreadBuffer* buffer = new ProfileThreadBuffer();
+		buffer->captureId.store(0);
+		buffer->numZones.store(0);
+		buffer->numDropped.store(0);
+		buffer->zones.reset(new ProfileZoneRecord[PROFILER_MAX_ZONES_PER_THREAD]);
+
+		std::lock_guard<std::mutex> lock(g_ThreadBuffersMutex);
+		buffer->threadIdx = (uint)g_ThreadBuffers.size();
+		g_ThreadBuffers.push_back(std::unique_ptr<ProfileThreadBuffer>(buffer));
+		g_pThreadBuffer = buffer;
+	}
+	return g_pThreadBuffer;
+}
+
+long long Profiler::GetTimestamp()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Profiler::SetThreadName(const char* name)
+{
+	GetThreadBuffer()->threadName = name;
+}
+
+void Profiler::RecordZone(const char* name, long long begin, long long end)
+{
+	ProfileThreadBuffer* buffer = GetThreadBuffer();
+
+	const uint capture = captureId.load(std::memory_order_acquire);
+	if (buffer->captureId.load(std::memory_order_relaxed) != capture)
+	{
+		buffer->numZones.store(0, std::memory_order_relaxed);
+		buffer->numDropped.store(0, std::memory_order_relaxed);
+		buffer->captureId.store(capture, std::memory_order_release);
+	}
+
+	const uint idx = buffer->numZones.load(std::memory_order_relaxed);
+	if (idx >= PROFILER_MAX_ZONES_PER_THREAD)
+	{
+		buffer->numDropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	ProfileZoneRecord& zone = buffer->zones[idx];
+	zone.name = name;
+	zone.begin = begin;
+	zone.end = end;
+
+	//Publish the zone only once it has been written
+	buffer->numZones.store(idx + 1, std::memory_order_release);
+}
+
+void Profiler::NewFrame()
+{
+	const long long now = GetTimestamp();
+
+	//Zone covering the frame that just finished
+	if (IsRecording() && frameBegin != 0)
+		RecordZone("Frame", frameBegin, now);
+
+	frameIndex++;
+	frameBegin = now;
+
+	if (!IsCapturing())
+		return;
+
+	if (frameIndex == captureFirstFrame)
+	{
+		g_CaptureBegin = now;
+		captureId.fetch_add(1, std::memory_order_release);
+		recording.store(true, std::memory_order_relaxed);
+	}
+	else if (frameIndex > captureLastFrame)
+	{
+		recording.store(false, std::memory_order_relaxed);
+		WriteChromeTrace(captureFilename);
+		captureFilename.clear();
+	}
+}
+
+void Profiler::CaptureFrameRange(uint first_frame, uint last_frame, const std::string& filename)
+{
+	recording.store(false, std::memory_order_relaxed);
+
+	//Frames that have already started can't be captured
+	captureFirstFrame = max(first_frame, frameIndex + 1);
+	captureLastFrame = max(last_frame, captureFirstFrame);
+	captureFilename = filename;
+}
+
+bool Profiler::WriteChromeTrace(const std::string& filename)
+{
+	FILE* file = NULL;
+	if (fopen_s(&file, filename.c_str(), "w") || !file)
+	{
+		NCLDebug::Log("[Profiler] - Unable to open \"%s\" for writing", filename.c_str());
+		return false;
+	}
+
+	const uint capture = captureId.load(std::memory_order_acquire);
+	uint total_zones = 0, total_dropped = 0;
+	bool first_event = true;
+
+	fputs("{\"traceEvents\":[\n", file);
+
+	std::lock_guard<std::mutex> lock(g_ThreadBuffersMutex);
+	for (const std::unique_ptr<ProfileThreadBuffer>& buffer : g_ThreadBuffers)
+	{
+		//Threads that didn't record anything during this capture still hold zones from an older one
+		if (buffer->captureId.load(std::memory_order_acquire) != capture)
+			continue;
+
+		const uint num_zones = buffer->numZones.load(std::memory_order_acquire);
+		total_zones += num_zones;
+		total_dropped += buffer->numDropped.load(std::memory_order_relaxed);
+
+		fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+			first_event ? "" : ",\n", buffer->threadIdx,
+			buffer->threadName.empty() ? ("Thread " + std::to_string(buffer->threadIdx)).c_str() : buffer->threadName.c_str());
+		first_event = false;
+
+		//Chrome expects timestamps in (fractional) microseconds
+		for (uint i = 0; i < num_zones; ++i)
+		{
+			const ProfileZoneRecord& zone = buffer->zones[i];
+			fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"ncl\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+				zone.name, buffer->threadIdx,
+				(zone.begin - g_CaptureBegin) * 0.001, (zone.end - zone.begin) * 0.001);
+		}
+	}
+
+	fputs("\n],\"displayTimeUnit\":\"ms\"}\n", file);
+	fclose(file);
+
+	NCLDebug::Log("[Profiler] - Wrote %d zones from frames %d-%d to \"%s\"",
+		total_zones, captureFirstFrame, captureLastFrame, filename.c_str());
+	if (total_dropped > 0)
+	{
+		NCLDebug::Log("[Profiler] - %d zones were dropped, as they didn't fit in the per-thread buffers", total_dropped);
+	}
+	return true;
+}
@@ -0,0 +1,102 @@
+/******************************************************************************
+Class: Profiler
+Author:
+Pieran Marris <p.marris@newcastle.ac.uk> and YOU!
+Description:
+
+Hierarchical profiling zones, for seeing exactly where the time went in a single frame and how the
+different stages (and threads) overlap, rather than the per-section averages given by PerfTimer.
+
+Wrap any section of code in PROFILE_SCOPE("Name") and, while a capture is running, the time it was
+entered/left and the id of the calling thread are recorded. Each thread writes into it's own buffer,
+so recording never takes a lock. Zones nest by their timestamps, so no parent/child bookkeeping is
+needed either.
+
+Captures cover a range of frames (See CaptureFrames/CaptureFrameRange) and are written out in the
+Chrome trace_event JSON format once the last frame has finished. To view them, open
+chrome://tracing (or https://ui.perfetto.dev) and load the file.
+
+Profiler::NewFrame() must be called once at the start of every frame by the main loop. Outside of a
+capture each zone costs a single atomic load.
+
+Note: Zone names are stored by pointer, so must be string literals (or otherwise outlive the capture).
+Note: Thread buffers are allocated on a threads first zone and kept until exit, so zones are best kept to
+      long lived (or pooled) threads.
+
+*//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include "common.h"
+#include <atomic>
+#include <string>
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+//Records a zone from this line to the end of the enclosing scope
+#define PROFILE_SCOPE(name) ProfileZone PROFILE_CONCAT(profileZone_, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__FUNCTION__)
+
+class Profiler
+{
+public:
+	//Marks the start of a new frame, also starts/finishes any requested capture
+	static void NewFrame();
+	static inline uint GetFrameIndex() { return frameIndex; }
+
+	//Records frames [first_frame, last_frame] and writes them to filename once the last one has finished.
+	// - Replaces any capture still in progress
+	static void CaptureFrameRange(uint first_frame, uint last_frame, const std::string& filename);
+
+	//Records the next num_frames frames
+	static void CaptureFrames(uint num_frames, const std::string& filename) { CaptureFrameRange(frameIndex + 1, frameIndex + num_frames, filename); }
+
+	static inline bool IsCapturing() { return captureFilename.size() > 0; }
+
+	//Name shown for the calling thread in the trace, otherwise threads are just numbered
+	static void SetThreadName(const char* name);
+
+
+	//Used by ProfileZone
+	static inline bool IsRecording() { return recording.load(std::memory_order_relaxed); }
+	static long long GetTimestamp();	//Nanoseconds
+	static void RecordZone(const char* name, long long begin, long long end);
+
+protected:
+	//Writes out every zone recorded by every thread, returns false if the file couldn't be opened
+	static bool WriteChromeTrace(const std::string& filename);
+
+protected:
+	static std::atomic<bool>	recording;
+	static std::atomic<uint>	captureId;		//Bumped at the start of each capture, so each thread knows to empty it's buffer
+
+	static uint			frameIndex;
+	static long long	frameBegin;
+
+	static uint			captureFirstFrame;
+	static uint			captureLastFrame;
+	static std::string	captureFilename;
+};
+
+
+//Records the lifetime of the object as a zone, use PROFILE_SCOPE rather than creating these directly
+class ProfileZone
+{
+public:
+	ProfileZone(const char* name)
+		: zoneName(name)
+		, zoneBegin(Profiler::IsRecording() ? Profiler::GetTimestamp() : 0)
+	{
+	}
+
+	~ProfileZone()
+	{
+		//Zones that started before the capture are ignored, as they would appear to start at time zero
+		if (zoneBegin != 0 && Profiler::IsRecording())
+			Profiler::RecordZone(zoneName, zoneBegin, Profiler::GetTimestamp());
+	}
+
+protected:
+	const char*	zoneName;
+	long long	zoneBegin;
+};
@@ -35,12 +35,29 @@ static inline double DegToRad(const double rad)	{
 typedef unsigned int uint;
 
 //I blame Microsoft...
+#ifdef _MSC_VER
 #define max(a,b)    (((a) > (b)) ? (a) : (b))
 #define min(a,b)    (((a) < (b)) ? (a) : (b))
+#else
+//Everywhere else these are functions, as the macros break any standard library headers included after them
+#include <type_traits>
+template <typename A, typename B> inline typename std::common_type<A, B>::type max(const A& a, const B& b) { return (a > b) ? a : b; }
+template <typename A, typename B> inline typename std::common_type<A, B>::type min(const A& a, const B& b) { return (a < b) ? a : b; }
+#endif
 
 #define SHADERDIR	"../../Data/Shaders/"
 #define MESHDIR		"../../Data/Meshes/"
 #define TEXTUREDIR  "../../Data/Textures/"
 #define SOUNDSDIR	"../../Data/Sounds/"
 
-#define SAFE_DELETE(x) if(x) { delete x; x = NULL; }
\ No newline at end of file
+#define SAFE_DELETE(x) if(x) { delete x; x = NULL; }
+
+#include <cstdio>
+#include <cmath>
+#include <cfloat>
+
+//MSVC only (secure) CRT functions, for everywhere else
+#ifndef _MSC_VER
+inline int fopen_s(FILE** file, const char* filename, const char* mode) { *file = fopen(filename, mode); return (*file == NULL) ? 1 : 0; }
+#define _copysign copysign
+#endif
\ No newline at end of file
@@ -0,0 +1,280 @@
+#include "CapsuleCollisionShape.h"
+#include "CuboidCollisionShape.h"
+#include "PhysicsNode.h"
+#include <nclgl/NCLDebug.h>
+#include <nclgl/Matrix3.h>
+#include <nclgl/Vector3.h>
+
+
+CapsuleCollisionShape::CapsuleCollisionShape()
+{
+	capsuleRadius = 0.5f;
+	halfHeight = 0.5f;
+	capsuleAxis = 1;
+	m_Radius = halfHeight + capsuleRadius;
+}
+
+CapsuleCollisionShape::CapsuleCollisionShape(float radius, float half_height, int axis)
+{
+	capsuleRadius = fabs(radius);
+	halfHeight = fabs(half_height);
+	capsuleAxis = min(max(axis, 0), 2);
+
+	//Bounding radius reaches the tips of the hemispheres
+	m_Radius = halfHeight + capsuleRadius;
+}
+
+CapsuleCollisionShape::~CapsuleCollisionShape()
+{
+
+}
+
+void CapsuleCollisionShape::GetWorldSegment(Vector3& out_start, Vector3& out_end) const
+{
+	const Vector3 offset = Parent()->GetOrientation().ToMatrix3().GetCol(capsuleAxis) * halfHeight;
+	out_start = Parent()->GetPosition() - offset;
+	out_end = Parent()->GetPosition() + offset;
+}
+
+Matrix3 CapsuleCollisionShape::BuildInverseInertia(float invMass) const
+{
+	//Solid cylinder plus two solid hemispheres, each taking a share of the mass by volume
+	// - The hemispheres are offset from the centre by the cylinder's half height (parallel axis theorem)
+	//https://en.wikipedia.org/wiki/List_of_moments_of_inertia
+	const float r = capsuleRadius;
+	const float h = halfHeight;
+	const float r_sq = r * r;
+
+	const float cylinder_volume = 2.0f * h * r_sq;
+	const float spheres_volume = 4.0f / 3.0f * r_sq * r;
+	const float cylinder_share = cylinder_volume / (cylinder_volume + spheres_volume);
+	const float spheres_share = 1.0f - cylinder_share;
+
+	const float i_axis = cylinder_share * r_sq * 0.5f
+		+ spheres_share * r_sq * 0.4f;
+	const float i_perp = cylinder_share * (r_sq * 0.25f + h * h / 3.0f)
+		+ spheres_share * (r_sq * 0.4f + h * h + 0.75f * h * r);
+
+	Matrix3 inertia;
+	inertia._11 = invMass / ((capsuleAxis == 0) ? i_axis : i_perp);
+	inertia._22 = invMass / ((capsuleAxis == 1) ? i_axis : i_perp);
+	inertia._33 = invMass / ((capsuleAxis == 2) ? i_axis : i_perp);
+
+	return inertia;
+}
+
+
+void CapsuleCollisionShape::GetCollisionAxes(const PhysicsNode* otherObject, std::vector<Vector3>& out_axes) const
+{
+	//As with the sphere there are infinite possible axes, so use the direction between the closest point
+	// on our segment to the other object and the closest point on the other object to that
+	Vector3 start, end, p1, unused;
+	GetWorldSegment(start, end);
+	ClosestPointsSegmentSegment(start, end, otherObject->GetPosition(), otherObject->GetPosition(), p1, unused);
+
+	Vector3 p2 = otherObject->GetCollisionShape()->GetClosestPoint(p1);
+
+	out_axes.push_back((p1 - p2).Normalise());
+}
+
+Vector3 CapsuleCollisionShape::GetClosestPoint(const Vector3& point) const
+{
+	Vector3 start, end, on_segment, unused;
+	GetWorldSegment(start, end);
+	ClosestPointsSegmentSegment(start, end, point, point, on_segment, unused);
+
+	Vector3 diff = (point - on_segment).Normalise();
+	return on_segment + diff * capsuleRadius;
+}
+
+void CapsuleCollisionShape::GetMinMaxVertexOnAxis(
+	const Vector3& axis,
+	Vector3& out_min,
+	Vector3& out_max) const
+{
+	Vector3 start, end;
+	GetWorldSegment(start, end);
+	if (Vector3::Dot(end - start, axis) < 0.0f)
+		std::swap(start, end);
+
+	out_min = start - axis * capsuleRadius;
+	out_max = end + axis * capsuleRadius;
+}
+
+
+void CapsuleCollisionShape::GetIncidentReferencePolygon(
+	const Vector3& axis,
+	std::list<Vector3>& out_face,
+	Vector3& out_normal,
+	std::vector<Plane>& out_adjacent_planes) const
+{
+	//Same as the sphere, the furthest point along the axis
+	Vector3 lower, upper;
+	GetMinMaxVertexOnAxis(axis, lower, upper);
+	out_face.push_back(upper);
+	out_normal = axis;
+}
+
+//Ray against a sphere, for rays starting outside of it
+static bool RayCastSphere(const Vector3& origin, const Vector3& dir, const Vector3& centre, float radius, float& out_dist)
+{
+	const Vector3 m = origin - centre;
+	const float b = Vector3::Dot(m, dir);
+	const float c = Vector3::Dot(m, m) - radius * radius;
+	const float discr = b * b - c;
+	if (b > 0.0f || discr < 0.0f)
+		return false;
+
+	out_dist = -b - sqrtf(discr);
+	return true;
+}
+
+bool CapsuleCollisionShape::RayCast(
+	const Vector3& origin,
+	const Vector3& dir,
+	float max_dist,
+	float inflate,
+	float& out_dist,
+	Vector3& out_normal) const
+{
+	const float radius = capsuleRadius + inflate;
+
+	Vector3 start, end, on_segment, unused;
+	GetWorldSegment(start, end);
+
+	//Starting inside
+	if (ClosestPointsSegmentSegment(start, end, origin, origin, on_segment, unused) <= radius * radius)
+	{
+		out_dist = 0.0f;
+		out_normal = -dir;
+		return true;
+	}
+
+	//Infinite cylinder around the segment, only counted if the hit is between the two end caps
+	// - See Real-Time Collision Detection (Christer Ericson) 5.3.7
+	const Vector3 d = end - start;
+	const Vector3 m = origin - start;
+	const float dd = Vector3::Dot(d, d);
+	const float md = Vector3::Dot(m, d);
+	const float nd = Vector3::Dot(dir, d);
+
+	float best_dist = FLT_MAX;
+	const float a = dd - nd * nd;
+	if (a > 1e-8f)
+	{
+		const float b = dd * Vector3::Dot(m, dir) - nd * md;
+		const float c = dd * (Vector3::Dot(m, m) - radius * radius) - md * md;
+		const float discr = b * b - a * c;
+		if (discr >= 0.0f)
+		{
+			const float t = (-b - sqrtf(discr)) / a;
+			const float s = md + t * nd;
+			if (t >= 0.0f && s >= 0.0f && s <= dd)
+				best_dist = t;
+		}
+	}
+
+	//End caps
+	float t;
+	if (RayCastSphere(origin, dir, start, radius, t) && t < best_dist) best_dist = t;
+	if (RayCastSphere(origin, dir, end, radius, t) && t < best_dist) best_dist = t;
+
+	if (best_dist > max_dist)
+		return false;
+
+	const Vector3 hit = origin + dir * best_dist;
+	ClosestPointsSegmentSegment(start, end, hit, hit, on_segment, unused);
+
+	out_dist = best_dist;
+	out_normal = (hit - on_segment) / radius;
+	return true;
+}
+
+bool CapsuleCollisionShape::OverlapsSphere(const Vector3& centre, float radius) const
+{
+	Vector3 start, end, on_segment, unused;
+	GetWorldSegment(start, end);
+
+	const float sum_radius = capsuleRadius + radius;
+	return ClosestPointsSegmentSegment(start, end, centre, centre, on_segment, unused) <= sum_radius * sum_radius;
+}
+
+bool CapsuleCollisionShape::OverlapsBox(const Vector3& centre, const Vector3& half_dims) const
+{
+	Vector3 start, end, on_segment, on_box;
+	GetWorldSegment(start, end);
+
+	return ClosestPointsSegmentBox(start, end, centre, Matrix3::Identity, half_dims, on_segment, on_box) <= capsuleRadius * capsuleRadius;
+}
+
+bool CapsuleCollisionShape::OverlapsCapsule(const CapsuleCollisionShape& other) const
+{
+	Vector3 start1, end1, start2, end2, c1, c2;
+	GetWorldSegment(start1, end1);
+	other.GetWorldSegment(start2, end2);
+
+	const float sum_radius = capsuleRadius + other.capsuleRadius;
+	return ClosestPointsSegmentSegment(start1, end1, start2, end2, c1, c2) <= sum_radius * sum_radius;
+}
+
+bool CapsuleCollisionShape::OverlapsCuboid(const CuboidCollisionShape& cuboid) const
+{
+	Vector3 start, end, on_segment, on_box;
+	GetWorldSegment(start, end);
+
+	const PhysicsNode* box = cuboid.Parent();
+	return ClosestPointsSegmentBox(start, end,
+		box->GetPosition(), box->GetOrientation().ToMatrix3(), cuboid.GetHalfDims(),
+		on_segment, on_box) <= capsuleRadius * capsuleRadius;
+}
+
+void CapsuleCollisionShape::DebugDraw() const
+{
+	const Matrix3 rot = Parent()->GetOrientation().ToMatrix3();
+	const Vector3 axis = rot.GetCol(capsuleAxis);
+	const Vector3 u = rot.GetCol((capsuleAxis + 1) % 3);
+	const Vector3 v = rot.GetCol((capsuleAxis + 2) % 3);
+
+	Vector3 start, end;
+	GetWorldSegment(start, end);
+
+	//Draw Filled Capsule (Thick lines are capped with a point on each end)
+	NCLDebug::DrawThickLineNDT(start, end, capsuleRadius * 2.0f, Vector4(1.0f, 1.0f, 1.0f, 0.2f));
+
+	//Draw Sides
+	for (const Vector3& side : { u, -u, v, -v })
+	{
+		NCLDebug::DrawThickLineNDT(start + side * capsuleRadius, end + side * capsuleRadius, 0.02f, Vector4(1.0f, 0.3f, 1.0f, 1.0f));
+	}
+
+	//Draw a ring around each end of the segment, and two half circles over each hemisphere
+	Vector3 lastRing = u * capsuleRadius;
+	Vector3 lastArcU = u * capsuleRadius;
+	Vector3 lastArcV = v * capsuleRadius;
+	const int nSubdivisions = 20;
+	for (int itr = 1; itr <= nSubdivisions; ++itr)
+	{
+		float angle = itr / float(nSubdivisions) * PI * 2.f;
+		float alpha = cosf(angle) * capsuleRadius;
+		float beta = sinf(angle) * capsuleRadius;
+
+		Vector3 newRing = u * alpha + v * beta;
+		NCLDebug::DrawThickLineNDT(start + lastRing, start + newRing, 0.02f, Vector4(1.0f, 0.3f, 1.0f, 1.0f));
+		NCLDebug::DrawThickLineNDT(end + lastRing, end + newRing, 0.02f, Vector4(1.0f, 0.3f, 1.0f, 1.0f));
+		lastRing = newRing;
+
+		//Each half circle is drawn once around the end, and mirrored around the start
+		angle = itr / float(nSubdivisions) * PI;
+		alpha = cosf(angle) * capsuleRadius;
+		beta = sinf(angle) * capsuleRadius;
+
+		Vector3 newArcU = u * alpha + axis * beta;
+		Vector3 newArcV = v * alpha + axis * beta;
+		NCLDebug::DrawThickLineNDT(end + lastArcU, end + newArcU, 0.02f, Vector4(1.0f, 0.3f, 1.0f, 1.0f));
+		NCLDebug::DrawThickLineNDT(end + lastArcV, end + newArcV, 0.02f, Vector4(1.0f, 0.3f, 1.0f, 1.0f));
+		NCLDebug::DrawThickLineNDT(start - lastArcU, start - newArcU, 0.02f, Vector4(1.0f, 0.3f, 1.0f, 1.0f));
+		NCLDebug::DrawThickLineNDT(start - lastArcV, start - newArcV, 0.02f, Vector4(1.0f, 0.3f, 1.0f, 1.0f));
+		lastArcU = newArcU;
+		lastArcV = newArcV;
+	}
+}
@@ -0,0 +1,97 @@
+/******************************************************************************
+Class: CapsuleCollisionShape
+Implements: CollisionShape
+Author:
+Pieran Marris      <p.marris@newcastle.ac.uk> and YOU!
+Description:
+
+Extends CollisionShape to represent a capsule, a line segment with a radius around it (a cylinder with
+a hemisphere on each end).
+
+Like the sphere this is an implicit shape, everything about it can be computed from the closest points
+to it's central segment. This makes it ideal for characters, which are upright, smooth (so they slide
+along walls and step over small edges) and always in contact with something. CollisionDetectionSAT
+collides capsules against capsules, spheres and cuboids directly from the closest points to the
+segment, which never needs more than two contacts, rather than searching vertices and clipping faces.
+
+The segment runs along one of the capsule's local axes (y by default) from -halfHeight to +halfHeight,
+so the whole capsule is 2 * (halfHeight + capsuleRadius) long.
+
+*//////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "CollisionShape.h"
+
+class CuboidCollisionShape;
+
+class CapsuleCollisionShape : public CollisionShape
+{
+public:
+	CapsuleCollisionShape();
+	CapsuleCollisionShape(float radius, float half_height, int axis = 1);
+	virtual ~CapsuleCollisionShape();
+
+
+	// Get/Set Capsule Dimensions
+	// - Axis is the local axis the segment runs along, 0 = x, 1 = y, 2 = z
+	void	SetCapsuleRadius(float radius) { capsuleRadius = fabs(radius); m_Radius = halfHeight + capsuleRadius; }
+	void	SetHalfHeight(float half_height) { halfHeight = fabs(half_height); m_Radius = halfHeight + capsuleRadius; }
+	void	SetAxis(int axis) { capsuleAxis = min(max(axis, 0), 2); }
+
+	float	GetCapsuleRadius() const { return capsuleRadius; }
+	float	GetHalfHeight() const { return halfHeight; }
+	int		GetAxis() const { return capsuleAxis; }
+
+	// Bounding radius, which is set from the capsule's dimensions
+	virtual void	SetRadius(float radius) override {}
+	virtual float	GetRadius() const override { return m_Radius; }
+
+	// World space end points of the capsule's central segment
+	void GetWorldSegment(Vector3& out_start, Vector3& out_end) const;
+
+	// Debug Collision Shape
+	virtual void DebugDraw() const override;
+
+	// Build Inertia Matrix for rotational mass
+	virtual Matrix3 BuildInverseInertia(float invMass) const override;
+
+
+	// Generic Collision Detection Routines
+	//  - Only used by CollisionDetectionSAT for shapes it has no direct capsule test for
+	virtual void GetCollisionAxes(
+		const PhysicsNode* otherObject,
+		std::vector<Vector3>& out_axes) const override;
+
+	virtual Vector3 GetClosestPoint(const Vector3& point) const override;
+
+	virtual void GetMinMaxVertexOnAxis(
+		const Vector3& axis,
+		Vector3& out_min,
+		Vector3& out_max) const override;
+
+	virtual void GetIncidentReferencePolygon(
+		const Vector3& axis,
+		std::list<Vector3>& out_face,
+		Vector3& out_normal,
+		std::vector<Plane>& out_adjacent_planes) const override;
+
+
+	// Spatial Queries
+	virtual bool RayCast(
+		const Vector3& origin,
+		const Vector3& dir,
+		float max_dist,
+		float inflate,
+		float& out_dist,
+		Vector3& out_normal) const override;
+
+	virtual bool OverlapsSphere(const Vector3& centre, float radius) const override;
+	virtual bool OverlapsBox(const Vector3& centre, const Vector3& half_dims) const override;
+	bool OverlapsCapsule(const CapsuleCollisionShape& other) const;
+	bool OverlapsCuboid(const CuboidCollisionShape& cuboid) const;
+
+protected:
+	float	capsuleRadius;
+	float	halfHeight;
+	int		capsuleAxis;
+};
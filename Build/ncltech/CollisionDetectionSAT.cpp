@@ -1,10 +1,15 @@
 #include "CollisionDetectionSAT.h"
-#include <nclgl\NCLDebug.h>
+#include <nclgl/NCLDebug.h>
 #include "GeometryUtils.h"
+#include "CuboidCollisionShape.h"
+#include "SphereCollisionShape.h"
+#include "CapsuleCollisionShape.h"
 
 using namespace GeometryUtils;
 
 CollisionDetectionSAT::CollisionDetectionSAT()
+	: numAxesTested(0)
+	, numEarlyOuts(0)
 {
 }
 
@@ -21,6 +26,16 @@ void CollisionDetectionSAT::BeginNewPair(
 	cshapeA = obj1->GetCollisionShape();
 	cshapeB = obj2->GetCollisionShape();
 
+	boxA = dynamic_cast<const CuboidCollisionShape*>(cshapeA);
+	boxB = dynamic_cast<const CuboidCollisionShape*>(cshapeB);
+
+	//Capsules are tested directly against capsules, spheres and cuboids
+	capsuleA = boxA ? NULL : dynamic_cast<const CapsuleCollisionShape*>(cshapeA);
+	capsuleB = boxB ? NULL : dynamic_cast<const CapsuleCollisionShape*>(cshapeB);
+	capsulePair = (capsuleA && (capsuleB || boxB || dynamic_cast<const SphereCollisionShape*>(cshapeB)))
+		|| (capsuleB && (boxA || dynamic_cast<const SphereCollisionShape*>(cshapeA)));
+	numCapsuleContacts = 0;
+
 	areColliding = false;
 }
 
@@ -34,6 +49,29 @@ bool CollisionDetectionSAT::AreColliding(CollisionData* out_coldata)
 	}
 
 	areColliding = false;
+
+	//Box pairs have their own test, which needs none of the axis lists below
+	if (boxA && boxB) {
+		if (!AreBoxesColliding(bestColData)) {
+			return false;
+		}
+
+		if (out_coldata) *out_coldata = bestColData;
+		areColliding = true;
+		return true;
+	}
+
+	//As are capsule pairs, which only need the closest points to the capsule's segment
+	if (capsulePair) {
+		if (!AreCapsuleColliding(bestColData)) {
+			return false;
+		}
+
+		if (out_coldata) *out_coldata = bestColData;
+		areColliding = true;
+		return true;
+	}
+
 	possibleColAxes.clear();
 
 	//--------Default Axes---------
@@ -60,7 +98,9 @@ bool CollisionDetectionSAT::AreColliding(CollisionData* out_coldata)
 
 	bestColData._penetration = -FLT_MAX;
 	for (const Vector3& axis : possibleColAxes) {
+		numAxesTested++;
 		if (!CheckCollisionAxis(axis, cur_colData)) {
+			numEarlyOuts++;
 			return false;
 		}
 		if (cur_colData._penetration >= bestColData._penetration) {
@@ -128,6 +168,417 @@ bool CollisionDetectionSAT::CheckCollisionAxis(const Vector3& axis, CollisionDat
 
 
 
+bool CollisionDetectionSAT::AreBoxesColliding(CollisionData& out_coldata)
+{
+	//Face axes of B, and then the edge axes, only replace the best axis so far if they are clearly
+	// better. Otherwise near equal axes (e.g. a resting stack) flicker between steps.
+	const float relative_tolerance = 0.98f;
+	const float absolute_tolerance = 0.001f;
+
+	const Vector3& centreA = pnodeA->GetPosition();
+	const Vector3& centreB = pnodeB->GetPosition();
+	boxAxesA = pnodeA->GetOrientation().ToMatrix3();
+	boxAxesB = pnodeB->GetOrientation().ToMatrix3();
+
+	const Vector3& half_dims_a = boxA->GetHalfDims();
+	const Vector3& half_dims_b = boxB->GetHalfDims();
+	const float ea[3] = { half_dims_a.x, half_dims_a.y, half_dims_a.z };
+	const float eb[3] = { half_dims_b.x, half_dims_b.y, half_dims_b.z };
+
+	//Everything is worked out in A's local space
+	// - R[i][j] = Dot(A axis i, B axis j), and AbsR is padded so edges that are almost
+	//   parallel (with a near zero cross product) can't produce a false separation
+	float R[3][3], AbsR[3][3];
+	for (int i = 0; i < 3; ++i) {
+		for (int j = 0; j < 3; ++j) {
+			R[i][j] = Vector3::Dot(boxAxesA.GetCol(i), boxAxesB.GetCol(j));
+			AbsR[i][j] = fabs(R[i][j]) + 1e-6f;
+		}
+	}
+
+	const Vector3 t_ws = centreB - centreA;
+	const float t[3] = {
+		Vector3::Dot(t_ws, boxAxesA.GetCol(0)),
+		Vector3::Dot(t_ws, boxAxesA.GetCol(1)),
+		Vector3::Dot(t_ws, boxAxesA.GetCol(2)) };
+
+	float best_separation = -FLT_MAX;
+	Vector3 best_axis;
+
+	//Seperation along the axis (dist = centre offset, ra/rb = projected radii), scaled back to world units
+	// for edge axes which aren't unit length. Returns false if the boxes are seperated along it.
+	auto test_axis = [&](float dist, float ra, float rb, const Vector3& axis, float axis_length, bool preferred) {
+		numAxesTested++;
+		const float separation = (fabs(dist) - (ra + rb)) / axis_length;
+		if (separation > 0.0f) {
+			numEarlyOuts++;
+			return false;
+		}
+
+		const float threshold = preferred ? best_separation : best_separation * relative_tolerance + absolute_tolerance;
+		if (separation > threshold) {
+			best_separation = separation;
+			best_axis = axis * ((dist < 0.0f ? -1.0f : 1.0f) / axis_length);
+		}
+		return true;
+	};
+
+	//Face axes of A
+	for (int i = 0; i < 3; ++i) {
+		const float rb = eb[0] * AbsR[i][0] + eb[1] * AbsR[i][1] + eb[2] * AbsR[i][2];
+		if (!test_axis(t[i], ea[i], rb, boxAxesA.GetCol(i), 1.0f, true)) return false;
+	}
+
+	//Face axes of B
+	for (int j = 0; j < 3; ++j) {
+		const float ra = ea[0] * AbsR[0][j] + ea[1] * AbsR[1][j] + ea[2] * AbsR[2][j];
+		const float dist = t[0] * R[0][j] + t[1] * R[1][j] + t[2] * R[2][j];
+		if (!test_axis(dist, ra, eb[j], boxAxesB.GetCol(j), 1.0f, false)) return false;
+	}
+
+	//Edge axes, Cross(A axis i, B axis j), skipping any between parallel edges as they
+	// are already covered by the face axes
+	for (int i = 0; i < 3; ++i) {
+		const int i1 = (i + 1) % 3, i2 = (i + 2) % 3;
+		for (int j = 0; j < 3; ++j) {
+			const Vector3 axis = Vector3::Cross(boxAxesA.GetCol(i), boxAxesB.GetCol(j));
+			const float axis_length = axis.Length();
+			if (axis_length < 1e-3f)
+				continue;
+
+			const int j1 = (j + 1) % 3, j2 = (j + 2) % 3;
+			const float ra = ea[i1] * AbsR[i2][j] + ea[i2] * AbsR[i1][j];
+			const float rb = eb[j1] * AbsR[i][j2] + eb[j2] * AbsR[i][j1];
+			const float dist = t[i2] * R[i1][j] - t[i1] * R[i2][j];
+			if (!test_axis(dist, ra, rb, axis, axis_length, false)) return false;
+		}
+	}
+
+	out_coldata._normal = best_axis;
+	out_coldata._penetration = best_separation;
+
+	//Furthest corner of A along the normal, moved back onto B's surface (As CheckCollisionAxis)
+	Vector3 corner = centreA;
+	for (int i = 0; i < 3; ++i) {
+		const Vector3& axis = boxAxesA.GetCol(i);
+		corner = corner + axis * ((Vector3::Dot(axis, best_axis) < 0.0f) ? -ea[i] : ea[i]);
+	}
+	out_coldata._pointOnPlane = corner + best_axis * best_separation;
+	return true;
+}
+
+void CollisionDetectionSAT::GetBoxFacePolygon(
+	const Vector3& centre,
+	const Matrix3& axes,
+	const Vector3& half_dims,
+	const Vector3& axis,
+	std::list<Vector3>& out_face,
+	Vector3& out_normal,
+	std::vector<Plane>& out_adjacent_planes)
+{
+	const float e[3] = { half_dims.x, half_dims.y, half_dims.z };
+
+	//Face normal closest to parallel with the axis
+	int face = 0;
+	float best_correlation = -1.0f;
+	for (int i = 0; i < 3; ++i) {
+		const float correlation = fabs(Vector3::Dot(axis, axes.GetCol(i)));
+		if (correlation > best_correlation) {
+			best_correlation = correlation;
+			face = i;
+		}
+	}
+
+	const float sign = (Vector3::Dot(axis, axes.GetCol(face)) < 0.0f) ? -1.0f : 1.0f;
+	const int u = (face + 1) % 3, v = (face + 2) % 3;
+
+	out_normal = axes.GetCol(face) * sign;
+
+	//Corners in counter-clockwise order about the normal (Cross(u, v) is the face axis, so v is flipped with it)
+	const Vector3 face_centre = centre + out_normal * e[face];
+	const Vector3 du = axes.GetCol(u) * e[u];
+	const Vector3 dv = axes.GetCol(v) * (e[v] * sign);
+	out_face.push_back(face_centre + du + dv);
+	out_face.push_back(face_centre - du + dv);
+	out_face.push_back(face_centre - du - dv);
+	out_face.push_back(face_centre + du - dv);
+
+	//The four faces around it become the clip planes, facing inwards to clip away anything outside the box
+	for (int k : { u, v }) {
+		for (float side : { 1.0f, -1.0f }) {
+			const Vector3 adj_normal = axes.GetCol(k) * side;
+			out_adjacent_planes.push_back(Plane(-adj_normal, Vector3::Dot(adj_normal, centre) + e[k]));
+		}
+	}
+}
+
+bool CollisionDetectionSAT::AreCapsuleColliding(CollisionData& out_coldata)
+{
+	numCapsuleContacts = 0;
+
+	//Everything is worked out with the capsule as the first shape, and swapped back afterwards if it's B
+	const bool flipped = (capsuleA == NULL);
+	const CapsuleCollisionShape* capsule = flipped ? capsuleB : capsuleA;
+	const CapsuleCollisionShape* other_capsule = flipped ? NULL : capsuleB;
+	const CuboidCollisionShape* other_box = flipped ? boxA : boxB;
+	const PhysicsNode* other_node = flipped ? pnodeA : pnodeB;
+	const CollisionShape* other_shape = flipped ? cshapeA : cshapeB;
+
+	Vector3 p1, q1;
+	capsule->GetWorldSegment(p1, q1);
+	const float r1 = capsule->GetCapsuleRadius();
+
+	Vector3 normal;
+	bool colliding;
+	if (other_box) {
+		colliding = CapsuleBoxContacts(p1, q1, r1, other_node, other_box, normal);
+	}
+	else if (other_capsule) {
+		Vector3 p2, q2;
+		other_capsule->GetWorldSegment(p2, q2);
+		colliding = CapsuleSegmentContacts(p1, q1, r1, p2, q2, other_capsule->GetCapsuleRadius(), normal);
+	}
+	else {
+		//Spheres are just a capsule with no length
+		const Vector3& centre = other_node->GetPosition();
+		const float radius = static_cast<const SphereCollisionShape*>(other_shape)->GetRadius();
+		colliding = CapsuleSegmentContacts(p1, q1, r1, centre, centre, radius, normal);
+	}
+
+	if (!colliding || numCapsuleContacts == 0) {
+		return false;
+	}
+
+	if (flipped) {
+		normal = -normal;
+		for (uint i = 0; i < numCapsuleContacts; ++i) {
+			std::swap(capsuleContactsA[i], capsuleContactsB[i]);
+		}
+	}
+
+	//Report the deepest contact, with the point on B's surface (As CheckCollisionAxis)
+	uint deepest = 0;
+	if (numCapsuleContacts > 1 && capsulePenetrations[1] < capsulePenetrations[0]) {
+		deepest = 1;
+	}
+
+	out_coldata._normal = normal;
+	out_coldata._penetration = capsulePenetrations[deepest];
+	out_coldata._pointOnPlane = capsuleContactsB[deepest];
+	return true;
+}
+
+bool CollisionDetectionSAT::CapsuleSegmentContacts(
+	const Vector3& p1, const Vector3& q1, float r1,
+	const Vector3& p2, const Vector3& q2, float r2,
+	Vector3& out_normal)
+{
+	const float radius_sum = r1 + r2;
+
+	Vector3 c1, c2;
+	const float dist_sq = ClosestPointsSegmentSegment(p1, q1, p2, q2, c1, c2);
+	if (dist_sq > radius_sum * radius_sum) {
+		return false;
+	}
+
+	const Vector3 d1 = q1 - p1;
+	const Vector3 d2 = q2 - p2;
+
+	const float dist = sqrtf(dist_sq);
+	if (dist > 1e-6f) {
+		out_normal = (c2 - c1) / dist;
+	}
+	else {
+		//The segments touch, so push them apart perpendicular to both of them (or just the first, if they're parallel)
+		out_normal = Vector3::Cross(d1, d2);
+		if (Vector3::Dot(out_normal, out_normal) < 1e-12f) {
+			out_normal = Vector3::Cross(d1, (fabs(d1.x) < 0.577f) ? Vector3(1.0f, 0.0f, 0.0f) : Vector3(0.0f, 1.0f, 0.0f));
+		}
+		if (Vector3::Dot(out_normal, out_normal) < 1e-12f) {
+			out_normal = Vector3(0.0f, 1.0f, 0.0f);
+		}
+		out_normal.Normalise();
+
+		if (Vector3::Dot(out_normal, (p2 + q2) - (p1 + q1)) < 0.0f) {
+			out_normal = -out_normal;
+		}
+	}
+
+	const float penetration = dist - radius_sum;
+
+	//Near parallel capsules rest along their length, so contacts go at both ends of the part of the
+	// first segment that lies alongside the second
+	const float len_sq1 = Vector3::Dot(d1, d1);
+	const float len_sq2 = Vector3::Dot(d2, d2);
+	const float d1d2 = Vector3::Dot(d1, d2);
+	if (len_sq1 > 1e-12f && len_sq2 > 1e-12f && d1d2 * d1d2 > 0.98f * len_sq1 * len_sq2) {
+		float s0 = Vector3::Dot(p2 - p1, d1) / len_sq1;
+		float s1 = Vector3::Dot(q2 - p1, d1) / len_sq1;
+		if (s0 > s1) std::swap(s0, s1);
+		s0 = max(s0, 0.0f);
+		s1 = min(s1, 1.0f);
+
+		if ((s1 - s0) * sqrtf(len_sq1) > 1e-3f) {
+			for (float s : { s0, s1 }) {
+				const Vector3 a = p1 + d1 * s;
+				Vector3 b, unused;
+				ClosestPointsSegmentSegment(a, a, p2, q2, unused, b);
+				AddCapsuleContact(a + out_normal * r1, b - out_normal * r2, Vector3::Dot(b - a, out_normal) - radius_sum);
+			}
+
+			//Segments that aren't exactly parallel can be closest somewhere between the two ends,
+			// in which case that point replaces the shallower end so the deepest contact is never lost
+			const uint shallowest = (capsulePenetrations[0] > capsulePenetrations[1]) ? 0 : 1;
+			if (penetration < capsulePenetrations[1 - shallowest] - 1e-3f) {
+				capsuleContactsA[shallowest] = c1 + out_normal * r1;
+				capsuleContactsB[shallowest] = c2 - out_normal * r2;
+				capsulePenetrations[shallowest] = penetration;
+			}
+			return true;
+		}
+	}
+
+	AddCapsuleContact(c1 + out_normal * r1, c2 - out_normal * r2, penetration);
+	return true;
+}
+
+bool CollisionDetectionSAT::CapsuleBoxContacts(
+	const Vector3& p1, const Vector3& q1, float r1,
+	const PhysicsNode* box_node,
+	const CuboidCollisionShape* box,
+	Vector3& out_normal)
+{
+	const Vector3& centre = box_node->GetPosition();
+	const Matrix3 axes = box_node->GetOrientation().ToMatrix3();
+	const Vector3& half_dims = box->GetHalfDims();
+	const float e[3] = { half_dims.x, half_dims.y, half_dims.z };
+
+	Vector3 on_segment, on_box;
+	const float dist_sq = ClosestPointsSegmentBox(p1, q1, centre, axes, half_dims, on_segment, on_box);
+	if (dist_sq > r1 * r1) {
+		return false;
+	}
+
+	const Vector3 d1 = q1 - p1;
+	const float dist = sqrtf(dist_sq);
+	if (dist > 1e-4f) {
+		//Segment is outside of the box, so the normal goes straight from it to the closest point on the box
+		out_normal = (on_box - on_segment) / dist;
+
+		//Face of the box we're touching
+		int face = 0;
+		float best_correlation = -1.0f;
+		for (int i = 0; i < 3; ++i) {
+			const float correlation = fabs(Vector3::Dot(out_normal, axes.GetCol(i)));
+			if (correlation > best_correlation) {
+				best_correlation = correlation;
+				face = i;
+			}
+		}
+		const Vector3 face_normal = axes.GetCol(face) * ((Vector3::Dot(out_normal, axes.GetCol(face)) > 0.0f) ? -1.0f : 1.0f);
+
+		//Lying along the face (e.g. a capsule on it's side), so the segment is clipped to the face's
+		// edges and both ends of what's left rest on it
+		const float len_sq = Vector3::Dot(d1, d1);
+		const float along_normal = Vector3::Dot(d1, face_normal);
+		if (best_correlation > 0.99f && len_sq > 1e-12f && along_normal * along_normal < 0.04f * len_sq) {
+			float t0 = 0.0f, t1 = 1.0f;
+			const Vector3 start = p1 - centre;
+			for (int k : { (face + 1) % 3, (face + 2) % 3 }) {
+				const float o = Vector3::Dot(start, axes.GetCol(k));
+				const float d = Vector3::Dot(d1, axes.GetCol(k));
+				if (fabs(d) < 1e-12f) {
+					if (fabs(o) > e[k]) t1 = -1.0f;
+					continue;
+				}
+
+				float ta = (-e[k] - o) / d;
+				float tb = (e[k] - o) / d;
+				if (ta > tb) std::swap(ta, tb);
+				t0 = max(t0, ta);
+				t1 = min(t1, tb);
+			}
+
+			if ((t1 - t0) * sqrtf(len_sq) > 1e-3f) {
+				out_normal = -face_normal;
+
+				const float plane_dist = Vector3::Dot(centre, face_normal) + e[face];
+				for (float t : { t0, t1 }) {
+					const Vector3 a = p1 + d1 * t;
+					const float height = Vector3::Dot(a, face_normal) - plane_dist;
+					AddCapsuleContact(a - face_normal * r1, a - face_normal * height, height - r1);
+				}
+				return true;
+			}
+		}
+
+		AddCapsuleContact(on_segment + out_normal * r1, on_box, dist - r1);
+		return true;
+	}
+
+	//Segment passes through the box, so fall back on SAT with the box's face normals and the cross
+	// products of the segment with each of them
+	Vector3 sat_axes[6];
+	int num_axes = 0;
+	for (int i = 0; i < 3; ++i) {
+		sat_axes[num_axes++] = axes.GetCol(i);
+	}
+	for (int i = 0; i < 3; ++i) {
+		const Vector3 axis = Vector3::Cross(d1, axes.GetCol(i));
+		const float len_sq = Vector3::Dot(axis, axis);
+		if (len_sq > 1e-6f * Vector3::Dot(d1, d1) && len_sq > 1e-12f) {
+			sat_axes[num_axes++] = axis / sqrtf(len_sq);
+		}
+	}
+
+	float best_depth = FLT_MAX, best_score = FLT_MAX;
+	for (int k = 0; k < num_axes; ++k) {
+		numAxesTested++;
+		const Vector3& axis = sat_axes[k];
+
+		float seg_min = Vector3::Dot(p1, axis);
+		float seg_max = Vector3::Dot(q1, axis);
+		if (seg_min > seg_max) std::swap(seg_min, seg_max);
+
+		float box_extent = 0.0f;
+		for (int j = 0; j < 3; ++j) {
+			box_extent += e[j] * fabs(Vector3::Dot(axes.GetCol(j), axis));
+		}
+		const float box_mid = Vector3::Dot(centre, axis);
+
+		//Distance to push the box out along +axis/-axis
+		const float push_pos = (seg_max + r1) - (box_mid - box_extent);
+		const float push_neg = (box_mid + box_extent) - (seg_min - r1);
+		if (push_pos < 0.0f || push_neg < 0.0f) {
+			numEarlyOuts++;
+			return false;
+		}
+
+		//Edge axes have to be noticeably better, as in GeometryUtils::TriangleBoxOverlap
+		const float depth = min(push_pos, push_neg);
+		const float score = (k >= 3) ? depth + 1e-4f : depth;
+		if (score < best_score) {
+			best_score = score;
+			best_depth = depth;
+			out_normal = (push_pos <= push_neg) ? axis : -axis;
+		}
+	}
+
+	const Vector3 on_capsule = on_segment + out_normal * r1;
+	AddCapsuleContact(on_capsule, on_capsule - out_normal * best_depth, -best_depth);
+	return true;
+}
+
+void CollisionDetectionSAT::AddCapsuleContact(const Vector3& globalOnA, const Vector3& globalOnB, float penetration)
+{
+	if (numCapsuleContacts < 2) {
+		capsuleContactsA[numCapsuleContacts] = globalOnA;
+		capsuleContactsB[numCapsuleContacts] = globalOnB;
+		capsulePenetrations[numCapsuleContacts] = penetration;
+		numCapsuleContacts++;
+	}
+}
+
 void CollisionDetectionSAT::GenContactPoints(Manifold* out_manifold)
 {
 	/* TUTORIAL 5 CODE */
@@ -138,24 +589,59 @@ void CollisionDetectionSAT::GenContactPoints(Manifold* out_manifold)
 		return;
 	}
 
+	//Capsule pairs already found their contacts
+	if (capsulePair) {
+		for (uint i = 0; i < numCapsuleContacts; ++i) {
+			if (capsulePenetrations[i] < 0.0f) {
+				out_manifold->AddContact(capsuleContactsA[i], capsuleContactsB[i], bestColData._normal, capsulePenetrations[i]);
+			}
+		}
+		return;
+	}
+
 	std::list<Vector3> polygon1, polygon2;
 	Vector3 normal1, normal2;
 	std::vector<Plane> adjPlanes1, adjPlanes2;
 
-	cshapeA->GetIncidentReferencePolygon(bestColData._normal, polygon1, normal1, adjPlanes1);
-	cshapeB->GetIncidentReferencePolygon(-bestColData._normal, polygon2, normal2, adjPlanes2);
+	if (boxA && boxB) {
+		GetBoxFacePolygon(pnodeA->GetPosition(), boxAxesA, boxA->GetHalfDims(), bestColData._normal, polygon1, normal1, adjPlanes1);
+		GetBoxFacePolygon(pnodeB->GetPosition(), boxAxesB, boxB->GetHalfDims(), -bestColData._normal, polygon2, normal2, adjPlanes2);
+	}
+	else {
+		cshapeA->GetIncidentReferencePolygon(bestColData._normal, polygon1, normal1, adjPlanes1);
+		cshapeB->GetIncidentReferencePolygon(-bestColData._normal, polygon2, normal2, adjPlanes2);
+	}
+
+	ClipPolygonsToManifold(
+		bestColData._normal,
+		bestColData._penetration,
+		polygon1, normal1, adjPlanes1,
+		polygon2, normal2, adjPlanes2,
+		out_manifold);
+}
 
+void CollisionDetectionSAT::ClipPolygonsToManifold(
+	const Vector3& normal,
+	float penetration,
+	std::list<Vector3>& polygon1,
+	Vector3& normal1,
+	std::vector<Plane>& adjPlanes1,
+	std::list<Vector3>& polygon2,
+	Vector3& normal2,
+	std::vector<Plane>& adjPlanes2,
+	Manifold* out_manifold)
+{
 	if (polygon1.size() == 0 || polygon2.size() == 0) {
 		return;
 	}
 	else if (polygon1.size() == 1) {
-		out_manifold->AddContact(polygon1.front(), polygon1.front() + bestColData._normal * bestColData._penetration, bestColData._normal, bestColData._penetration);
+		out_manifold->AddContact(polygon1.front(), polygon1.front() + normal * penetration, normal, penetration);
 	}
 	else if (polygon2.size() == 1) {
-		out_manifold->AddContact(polygon2.front() - bestColData._normal * bestColData._penetration, polygon2.front(), bestColData._normal, bestColData._penetration);
+		out_manifold->AddContact(polygon2.front() - normal * penetration, polygon2.front(), normal, penetration);
 	}
 	else {
-		bool flipped = fabs(Vector3::Dot(bestColData._normal, normal1)) < fabs(Vector3::Dot(bestColData._normal, normal2));
+		bool flipped = fabs(Vector3::Dot(normal, normal1)) < fabs(Vector3::Dot(normal, normal2));
 
 		if (flipped) {
 			std::swap(polygon1, polygon2);
@@ -172,19 +658,19 @@ void CollisionDetectionSAT::GenContactPoints(Manifold* out_manifold)
 
 		for (const Vector3& point : polygon2) {
 			Vector3 pointDiff = point - GetClosestPointPolygon(point, polygon1);
-			float contact_penetration = Vector3::Dot(pointDiff, bestColData._normal);
+			float contact_penetration = Vector3::Dot(pointDiff, normal);
 
 			Vector3 globalOnA = point;
-			Vector3 globalOnB = point - bestColData._normal * contact_penetration;
+			Vector3 globalOnB = point - normal * contact_penetration;
 
 			if (flipped) {
 				contact_penetration = -contact_penetration;
-				globalOnA = point + bestColData._normal * contact_penetration;
+				globalOnA = point + normal * contact_penetration;
 				globalOnB = point;
 			}
 
 			if (contact_penetration < 0.0f) {
-				out_manifold->AddContact(globalOnA, globalOnB, bestColData._normal, contact_penetration);
+				out_manifold->AddContact(globalOnA, globalOnB, normal, contact_penetration);
 			}
 		}
 	}
@@ -33,12 +33,24 @@ https://en.wikipedia.org/wiki/Sutherland%E2%80%93Hodgman_algorithm
 - Used to build collision manifold around instance and reference
 faces.
 
+Cuboid pairs skip the generic axis list and vertex searches entirely (See
+AreBoxesColliding), as they are by far the most common pair in the stacking
+scenes and all 15 of their axes can be tested from a 3x3 relative rotation.
+
+Capsules against capsules, spheres (a capsule with no length) and cuboids don't
+use SAT at all (See AreCapsuleColliding). The closest points between the
+capsule's segment and the other shape give the normal and penetration directly,
+and at most two contacts are needed for the capsule to rest on it's side.
+
 *//////////////////////////////////////////////////////////////////////////////
 #pragma once
 #include "PhysicsNode.h"
 #include "CollisionShape.h"
 #include "Manifold.h"
 
+class CuboidCollisionShape;
+class CapsuleCollisionShape;
+
 struct CollisionData
 {
 	//The direction of collision from obj1 to obj2
@@ -73,6 +85,25 @@ public:
 	//   of the collision region
 	void GenContactPoints(Manifold* out_manifold);
 
+	// Clips the incident polygon against the reference polygon (whichever is closest to
+	//   parallel with the collision normal) and adds the resulting contacts to the manifold.
+	// - Polygon 1 belongs to node A, polygon 2 to node B. Also used by concave shapes, which
+	//   build the polygons for each of their triangles themselves.
+	static void ClipPolygonsToManifold(
+		const Vector3& normal,
+		float penetration,
+		std::list<Vector3>& polygon1,
+		Vector3& normal1,
+		std::vector<Plane>& adjPlanes1,
+		std::list<Vector3>& polygon2,
+		Vector3& normal2,
+		std::vector<Plane>& adjPlanes2,
+		Manifold* out_manifold);
+
+	//Totals since this object was created, reported by the physics engine's step counters
+	inline uint GetNumAxesTested() const { return numAxesTested; }
+	inline uint GetNumEarlyOuts() const { return numEarlyOuts; }
+
 protected:
 	//<---- SAT ---->
 	//Add a new possible colliding axis
@@ -83,6 +114,43 @@ protected:
 	// are indeed colliding in this direction.
 	bool CheckCollisionAxis(const Vector3& axis, CollisionData& coldata);
 
+	//<---- Box vs Box ---->
+	// Tests the 3 face axes of each box and the 9 edge cross products using projected radii (no vertices),
+	// returning false as soon as any of them seperate the boxes
+	bool AreBoxesColliding(CollisionData& out_coldata);
+
+	// Builds the face of the box whose normal is closest to parallel with axis, along with
+	// the clip planes around it's edges (Same output as CollisionShape::GetIncidentReferencePolygon)
+	static void GetBoxFacePolygon(
+		const Vector3& centre,
+		const Matrix3& axes,
+		const Vector3& half_dims,
+		const Vector3& axis,
+		std::list<Vector3>& out_face,
+		Vector3& out_normal,
+		std::vector<Plane>& out_adjacent_planes);
+
+	//<---- Capsules ---->
+	// Finds the contacts between a capsule and a capsule, sphere or cuboid from the closest points
+	// to the capsule's segment, returning false if they don't overlap
+	bool AreCapsuleColliding(CollisionData& out_coldata);
+
+	// Capsule (segment p1-q1, radius r1) against a capsule or sphere (segment p2-q2, radius r2),
+	// adding the contacts with the first shape as A and outputting the shared normal
+	bool CapsuleSegmentContacts(
+		const Vector3& p1, const Vector3& q1, float r1,
+		const Vector3& p2, const Vector3& q2, float r2,
+		Vector3& out_normal);
+
+	// Capsule (segment p1-q1, radius r1) against a cuboid, as above
+	bool CapsuleBoxContacts(
+		const Vector3& p1, const Vector3& q1, float r1,
+		const PhysicsNode* box_node,
+		const CuboidCollisionShape* box,
+		Vector3& out_normal);
+
+	void AddCapsuleContact(const Vector3& globalOnA, const Vector3& globalOnB, float penetration);
+
 private:
 	//Physics Nodes
 	const PhysicsNode*		pnodeA;
@@ -92,10 +160,30 @@ private:
 	const CollisionShape*	cshapeA;
 	const CollisionShape*	cshapeB;
 
+	//Set if both shapes are cuboids, along with their world space axes once AreColliding has been called
+	const CuboidCollisionShape*	boxA;
+	const CuboidCollisionShape*	boxB;
+	Matrix3					boxAxesA;
+	Matrix3					boxAxesB;
+
+	//Set if either shape is a capsule and the pair can use AreCapsuleColliding, along with the (up to
+	// two) contacts it found
+	const CapsuleCollisionShape*	capsuleA;
+	const CapsuleCollisionShape*	capsuleB;
+	bool					capsulePair;
+	uint					numCapsuleContacts;
+	Vector3					capsuleContactsA[2];
+	Vector3					capsuleContactsB[2];
+	float					capsulePenetrations[2];
+
 	//Collision Axes
 	std::vector<Vector3>	possibleColAxes;
 
 	//Collision Data
 	bool					areColliding;
 	CollisionData			bestColData;
+
+	//Counters
+	uint					numAxesTested;
+	uint					numEarlyOuts;
 };
\ No newline at end of file
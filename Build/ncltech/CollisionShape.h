@@ -20,15 +20,16 @@ and CuboidCollisionShape (physical shape defined by a set of vertices/faces)
 
 #include "Hull.h"
 #include "GeometryUtils.h"
-#include <nclgl\Vector3.h>
-#include <nclgl\Plane.h>
-#include <nclgl\Matrix3.h>
+#include <nclgl/Vector3.h>
+#include <nclgl/Plane.h>
+#include <nclgl/Matrix3.h>
 #include <vector>
 #include <list>
 
 using namespace GeometryUtils;
 
 class PhysicsNode;
+class Manifold;
 
 struct CollisionEdge
 {
@@ -88,6 +89,56 @@ public:
 		Vector3& out_normal,
 		std::vector<Plane>& out_adjacent_planes) const = 0;
 
+
+
+	//<----- USED BY CONCAVE SHAPES ----->
+	// Concave shapes (e.g. HeightFieldCollisionShape) can't be handled by CollisionDetectionSAT, so the
+	// narrowphase instead asks them to generate contacts directly against the convex shape of otherObject.
+	// out_manifold is initiated with this shape's parent as node A, so contact normals point from this
+	// shape towards otherObject.
+	virtual bool IsConcave() const { return false; }
+	virtual void GenConcaveContactPoints(const PhysicsNode* otherObject, Manifold* out_manifold) const {}
+
+	//<----- USED BY COMPOUND SHAPES ----->
+	// Compound shapes (See CompoundCollisionShape) are broken down by the narrowphase into just the
+	// convex children that could be touching the other object. Their children follow the parent
+	// PhysicsNode, which calls OnParentTransformChanged every time it moves.
+	virtual bool IsCompound() const { return false; }
+	virtual void OnParentTransformChanged() {}
+
+	// World space axis aligned bounding box, taken from the shape's extents along the world axes
+	void GetWorldAABB(Vector3& out_min, Vector3& out_max) const
+	{
+		Vector3 lower, upper;
+		GetMinMaxVertexOnAxis(Vector3(1.0f, 0.0f, 0.0f), lower, upper);
+		out_min.x = lower.x; out_max.x = upper.x;
+		GetMinMaxVertexOnAxis(Vector3(0.0f, 1.0f, 0.0f), lower, upper);
+		out_min.y = lower.y; out_max.y = upper.y;
+		GetMinMaxVertexOnAxis(Vector3(0.0f, 0.0f, 1.0f), lower, upper);
+		out_min.z = lower.z; out_max.z = upper.z;
+	}
+
+
+
+	//<----- USED BY SPATIAL QUERIES ----->
+	// See PhysicsEngine::RayCast/SphereCast/OverlapSphere/OverlapBox
+
+	// Intersects a ray (with a normalised direction) with the shape grown by 'inflate',
+	// which is zero for ray casts and the sphere radius for sphere casts. Returns true if
+	// the shape is hit within max_dist, along with the distance to the hit and the surface
+	// normal at that point. Rays starting inside the shape hit at distance zero.
+	virtual bool RayCast(
+		const Vector3& origin,
+		const Vector3& dir,
+		float max_dist,
+		float inflate,
+		float& out_dist,
+		Vector3& out_normal) const = 0;
+
+	// Returns true if the shape overlaps the given world space sphere/axis aligned box
+	virtual bool OverlapsSphere(const Vector3& centre, float radius) const = 0;
+	virtual bool OverlapsBox(const Vector3& centre, const Vector3& half_dims) const = 0;
+
 protected:
 	PhysicsNode* m_Parent;
 	float	m_Radius;
@@ -12,8 +12,8 @@ be globally accessed for the entirity of any Scene/GameObject.
 *//////////////////////////////////////////////////////////////////////////////
 
 #pragma once
-#include <nclgl\Mesh.h>
-#include <GL\glew.h>
+#include <nclgl/Mesh.h>
+#include <GL/glew.h>
 
 class Scene;
 
@@ -1,9 +1,12 @@
 #include "CommonUtils.h"
 #include "SphereCollisionShape.h"
 #include "CuboidCollisionShape.h"
+#include "CompoundCollisionShape.h"
+#include "HeightFieldCollisionShape.h"
 #include "CommonMeshes.h"
 #include "ScreenPicker.h"
-#include <nclgl\RenderNode.h>
+#include <nclgl/RenderNode.h>
+#include <nclgl/HeightMap.h>
 #include <functional>
 
 //Horrible!!!
@@ -234,7 +237,7 @@ GameObject* CommonUtils::BuildCombinedObject(
 	rnode->AddChild(cube);
 
 	RenderNode* sphere = new RenderNode(CommonMeshes::Sphere(), color);
-	sphere->SetTransform(Matrix4::Scale(Vector3(radius, radius, radius)) * Matrix4::Translation(Vector3(0, -radius, 0)));
+	sphere->SetTransform(Matrix4::Translation(Vector3(0, -radius, 0)) * Matrix4::Scale(Vector3(radius, radius, radius)));
 	rnode->AddChild(sphere);
 
 	rnode->SetTransform(Matrix4::Translation(pos));
@@ -260,14 +263,13 @@ GameObject* CommonUtils::BuildCombinedObject(
 		}
 		else
 		{
-		CollisionShape* cube = new CuboidCollisionShape(Vector3(radius, radius, radius));
-		pnode->SetCollisionShape(cube);
-		//pnode->SetInverseInertia(cube->BuildInverseInertia(inverse_mass));
-
-		CollisionShape* sphere = new SphereCollisionShape(radius);
-		pnode->SetCollisionShape2(sphere);
-		
-		pnode->SetInverseInertia(sphere->BuildInverseInertia(inverse_mass) );
+		//Both meshes are glued together into one rigid body
+		CompoundCollisionShape* compound = new CompoundCollisionShape();
+		compound->AddChild(new CuboidCollisionShape(Vector3(radius, radius, radius)));
+		compound->AddChild(new SphereCollisionShape(radius), Vector3(0, -radius, 0));
+		pnode->SetCollisionShape(compound);
+
+		pnode->SetInverseInertia(compound->BuildInverseInertia(inverse_mass));
 		}
 
 		//pnode
@@ -284,4 +286,45 @@ GameObject* CommonUtils::BuildCombinedObject(
 	}*/
 
 	return obj;
-}
\ No newline at end of file
+}
+
+std::vector<GameObject*> CommonUtils::BuildHeightFieldObjects(
+	const std::string& name,
+	const HeightMap& heightmap,
+	const Vector3& pos,
+	uint cells_per_chunk)
+{
+	std::vector<GameObject*> chunks;
+	if (heightmap.GetNumSamplesX() < 2 || heightmap.GetNumSamplesZ() < 2 || cells_per_chunk == 0)
+		return chunks;
+
+	const uint num_cells_x = heightmap.GetNumSamplesX() - 1;
+	const uint num_cells_z = heightmap.GetNumSamplesZ() - 1;
+
+	for (uint x = 0; x < num_cells_x; x += cells_per_chunk)
+	{
+		for (uint z = 0; z < num_cells_z; z += cells_per_chunk)
+		{
+			HeightFieldCollisionShape* shape = new HeightFieldCollisionShape(
+				heightmap.GetHeights(),
+				heightmap.GetNumSamplesX(),
+				heightmap.GetNumSamplesZ(),
+				heightmap.GetSampleSpacingX(),
+				heightmap.GetSampleSpacingZ(),
+				x,
+				z,
+				min(cells_per_chunk, num_cells_x - x),
+				min(cells_per_chunk, num_cells_z - z));
+
+			PhysicsNode* pnode = new PhysicsNode();
+			pnode->SetPosition(pos + shape->GetChunkCentre());
+			pnode->SetInverseMass(0.0f);
+			pnode->SetCollisionShape(shape);
+			pnode->SetInverseInertia(shape->BuildInverseInertia(0.0f));
+
+			chunks.push_back(new GameObject(name, NULL, pnode));
+		}
+	}
+
+	return chunks;
+}
@@ -19,6 +19,8 @@ parameter lists) it's here, and here to stay. =]
 
 #include "GameObject.h"
 
+class HeightMap;
+
 namespace CommonUtils
 {
 	void DragableObjectCallback(GameObject* obj, float dt, const Vector3& newWsPos, const Vector3& wsMovedAmount, bool stopDragging);
@@ -63,4 +65,13 @@ namespace CommonUtils
 		bool collidable = true,				//requires physics_enabled = true
 		bool dragable = true,
 		const Vector4& color = Vector4(1.0f, 1.0f, 1.0f, 1.0f));
+
+	//Splits the terrain of a HeightMap into static chunks of (up to) cells_per_chunk x cells_per_chunk
+	// grid cells, each with a HeightFieldCollisionShape sharing the map's height array. The chunks
+	// are physics only, the HeightMap mesh still has to be rendered (at the same 'pos') seperately.
+	std::vector<GameObject*> BuildHeightFieldObjects(
+		const std::string& name,
+		const HeightMap& heightmap,
+		const Vector3& pos = Vector3(0.0f, 0.0f, 0.0f),
+		uint cells_per_chunk = 32);
 };
\ No newline at end of file
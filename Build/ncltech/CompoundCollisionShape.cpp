@@ -0,0 +1,275 @@
+#include "CompoundCollisionShape.h"
+#include "PhysicsNode.h"
+#include <nclgl/NCLDebug.h>
+#include <algorithm>
+
+CompoundCollisionShape::CompoundCollisionShape()
+	: parentPosition(0.0f, 0.0f, 0.0f)
+{
+	m_Radius = 0.0f;
+}
+
+CompoundCollisionShape::~CompoundCollisionShape()
+{
+	for (CompoundChild& child : children)
+	{
+		SAFE_DELETE(child.node);
+	}
+	children.clear();
+}
+
+void CompoundCollisionShape::AddChild(CollisionShape* shape, const Vector3& local_pos, const Quaternion& local_orient)
+{
+	if (shape == NULL)
+		return;
+
+	if (shape->IsConcave() || shape->IsCompound())
+	{
+		NCLERROR("CompoundCollisionShape children must be convex");
+		delete shape;
+		return;
+	}
+
+	CompoundChild child;
+	child.node = new PhysicsNode();
+	child.node->SetCollisionShape(shape);
+	child.localPosition = local_pos;
+	child.localOrientation = local_orient;
+
+	//Bounds in the parent's local space, found by placing the proxy at it's local transform
+	child.node->SetPosition(local_pos);
+	child.node->SetOrientation(local_orient);
+	shape->GetWorldAABB(child.localMin, child.localMax);
+
+	children.push_back(child);
+	BuildBVH();
+
+	OnParentTransformChanged();
+}
+
+void CompoundCollisionShape::OnParentTransformChanged()
+{
+	if (Parent() == NULL)
+		return;
+
+	parentRotation = Parent()->GetOrientation().ToMatrix3();
+	parentPosition = Parent()->GetPosition();
+
+	for (CompoundChild& child : children)
+	{
+		child.node->SetPosition(parentPosition + parentRotation * child.localPosition);
+		child.node->SetOrientation(Parent()->GetOrientation() * child.localOrientation);
+	}
+}
+
+void CompoundCollisionShape::BuildBVH()
+{
+	nodes.clear();
+	if (children.empty())
+	{
+		m_Radius = 0.0f;
+		return;
+	}
+
+	const uint num_children = (uint)children.size();
+	std::vector<uint> child_order(num_children);
+	std::vector<Vector3> child_min(num_children), child_max(num_children);
+
+	//The broadphase bounds the compound with a sphere around the parent's position
+	float max_dist_sq = 0.0f;
+	for (uint i = 0; i < num_children; ++i)
+	{
+		child_order[i] = i;
+		child_min[i] = children[i].localMin;
+		child_max[i] = children[i].localMax;
+
+		const Vector3 corner = Vector3(
+			max(fabs(child_min[i].x), fabs(child_max[i].x)),
+			max(fabs(child_min[i].y), fabs(child_max[i].y)),
+			max(fabs(child_min[i].z), fabs(child_max[i].z)));
+		max_dist_sq = max(max_dist_sq, Vector3::Dot(corner, corner));
+	}
+	m_Radius = sqrtf(max_dist_sq);
+
+	nodes.reserve(2 * num_children - 1);
+	BuildNode(child_order, child_min, child_max, 0, num_children);
+}
+
+uint CompoundCollisionShape::BuildNode(std::vector<uint>& child_order, const std::vector<Vector3>& child_min, const std::vector<Vector3>& child_max, uint first, uint count)
+{
+	const uint node_idx = (uint)nodes.size();
+	nodes.push_back(CompoundBVHNode());
+
+	Vector3 bounds_min(FLT_MAX, FLT_MAX, FLT_MAX), bounds_max(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	for (uint i = first; i < first + count; ++i)
+	{
+		const uint c = child_order[i];
+		bounds_min = Vector3(min(bounds_min.x, child_min[c].x), min(bounds_min.y, child_min[c].y), min(bounds_min.z, child_min[c].z));
+		bounds_max = Vector3(max(bounds_max.x, child_max[c].x), max(bounds_max.y, child_max[c].y), max(bounds_max.z, child_max[c].z));
+	}
+	nodes[node_idx].boundsMin = bounds_min;
+	nodes[node_idx].boundsMax = bounds_max;
+
+	if (count == 1)
+	{
+		nodes[node_idx].offset = child_order[first];
+		nodes[node_idx].count = 1;
+		return node_idx;
+	}
+
+	//Median split along the longest axis of the node's bounds
+	const Vector3 extents = bounds_max - bounds_min;
+	const int axis = (extents.x >= extents.y && extents.x >= extents.z) ? 0 : ((extents.y >= extents.z) ? 1 : 2);
+	auto centre = [&](uint c) {
+		const Vector3 sum = child_min[c] + child_max[c];
+		return (axis == 0) ? sum.x : ((axis == 1) ? sum.y : sum.z);
+	};
+
+	const uint mid = first + count / 2;
+	std::nth_element(
+		child_order.begin() + first,
+		child_order.begin() + mid,
+		child_order.begin() + first + count,
+		[&](uint a, uint b) { return centre(a) < centre(b); });
+
+	BuildNode(child_order, child_min, child_max, first, mid - first);
+	const uint second_child = BuildNode(child_order, child_min, child_max, mid, first + count - mid);
+
+	nodes[node_idx].offset = second_child;
+	nodes[node_idx].count = 0;
+	return node_idx;
+}
+
+Matrix3 CompoundCollisionShape::BuildInverseInertia(float invMass) const
+{
+	if (invMass == 0.0f || children.empty())
+		return Matrix3::ZeroMatrix;
+
+	const float child_mass = 1.0f / (invMass * (float)children.size());
+
+	Matrix3 inertia = Matrix3::ZeroMatrix;
+	for (const CompoundChild& child : children)
+	{
+		//Child's own inertia, rotated into the parent's local space
+		const Matrix3 child_inertia = Matrix3::Inverse(child.node->GetCollisionShape()->BuildInverseInertia(1.0f / child_mass));
+		const Matrix3 rotation = child.localOrientation.ToMatrix3();
+		inertia += rotation * child_inertia * Matrix3::Transpose(rotation);
+
+		//Parallel axis theorem - offset from the parent's centre of mass
+		const Vector3& d = child.localPosition;
+		inertia += (Matrix3::Identity * Vector3::Dot(d, d) - Matrix3::OuterProduct(d, d)) * child_mass;
+	}
+
+	return Matrix3::Inverse(inertia);
+}
+
+void CompoundCollisionShape::GetCollisionAxes(
+	const PhysicsNode* otherObject,
+	std::vector<Vector3>& out_axes) const
+{
+	//Not used, the narrowphase tests each child individually
+}
+
+Vector3 CompoundCollisionShape::GetClosestPoint(const Vector3& point) const
+{
+	float best_dist_sq = FLT_MAX;
+	Vector3 best_point = parentPosition;
+	for (const CompoundChild& child : children)
+	{
+		const Vector3 closest = child.node->GetCollisionShape()->GetClosestPoint(point);
+		const Vector3 diff = closest - point;
+		const float dist_sq = Vector3::Dot(diff, diff);
+		if (dist_sq < best_dist_sq)
+		{
+			best_dist_sq = dist_sq;
+			best_point = closest;
+		}
+	}
+	return best_point;
+}
+
+void CompoundCollisionShape::GetMinMaxVertexOnAxis(
+	const Vector3& axis,
+	Vector3& out_min,
+	Vector3& out_max) const
+{
+	out_min = out_max = parentPosition;
+
+	float min_proj = FLT_MAX, max_proj = -FLT_MAX;
+	for (const CompoundChild& child : children)
+	{
+		Vector3 child_min, child_max;
+		child.node->GetCollisionShape()->GetMinMaxVertexOnAxis(axis, child_min, child_max);
+
+		const float lower = Vector3::Dot(axis, child_min);
+		const float upper = Vector3::Dot(axis, child_max);
+		if (lower < min_proj)
+		{
+			min_proj = lower;
+			out_min = child_min;
+		}
+		if (upper > max_proj)
+		{
+			max_proj = upper;
+			out_max = child_max;
+		}
+	}
+}
+
+void CompoundCollisionShape::GetIncidentReferencePolygon(
+	const Vector3& axis,
+	std::list<Vector3>& out_face,
+	Vector3& out_normal,
+	std::vector<Plane>& out_adjacent_planes) const
+{
+	//Not used, the narrowphase tests each child individually
+}
+
+bool CompoundCollisionShape::RayCast(
+	const Vector3& origin,
+	const Vector3& dir,
+	float max_dist,
+	float inflate,
+	float& out_dist,
+	Vector3& out_normal) const
+{
+	bool hit = false;
+	float best_dist = max_dist;
+	for (const CompoundChild& child : children)
+	{
+		float dist;
+		Vector3 normal;
+		if (child.node->GetCollisionShape()->RayCast(origin, dir, best_dist, inflate, dist, normal))
+		{
+			hit = true;
+			best_dist = dist;
+			out_normal = normal;
+		}
+	}
+
+	if (hit) out_dist = best_dist;
+	return hit;
+}
+
+bool CompoundCollisionShape::OverlapsSphere(const Vector3& centre, float radius) const
+{
+	const Vector3 r = Vector3(radius, radius, radius);
+	return ForEachChildInBounds(centre - r, centre + r, [&](PhysicsNode* child_node) {
+		return child_node->GetCollisionShape()->OverlapsSphere(centre, radius);
+	});
+}
+
+bool CompoundCollisionShape::OverlapsBox(const Vector3& centre, const Vector3& half_dims) const
+{
+	return ForEachChildInBounds(centre - half_dims, centre + half_dims, [&](PhysicsNode* child_node) {
+		return child_node->GetCollisionShape()->OverlapsBox(centre, half_dims);
+	});
+}
+
+void CompoundCollisionShape::DebugDraw() const
+{
+	for (const CompoundChild& child : children)
+	{
+		child.node->GetCollisionShape()->DebugDraw();
+	}
+}
@@ -0,0 +1,169 @@
+/******************************************************************************
+Class: CompoundCollisionShape
+Implements: CollisionShape
+Author:
+Pieran Marris      <p.marris@newcastle.ac.uk> and YOU!
+Description:
+
+Extends CollisionShape to glue together several convex child shapes (each with it's own local
+position and orientation) into a single rigid body. This is far cheaper to simulate than building
+the same object out of multiple bodies held together with constraints, as the solver only ever
+sees the one body.
+
+Each child is attached to it's own internal proxy PhysicsNode, which is never added to the
+PhysicsEngine but is kept in sync with the parent every time it moves. This allows the children to
+be passed straight into CollisionDetectionSAT (or any concave shape's GenConcaveContactPoints) as
+if they were bodies in their own right, while the resulting contacts are all added to the parent's
+manifold.
+
+The children are sorted into a small bounding volume hierarchy in the parent's local space, so the
+narrowphase only has to test the children that overlap the other object (See ForEachChildInBounds).
+
+The parent PhysicsNode's position is treated as the centre of mass, with the mass split evenly
+between each of the children.
+
+*//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "CollisionShape.h"
+#include <nclgl/common.h>
+#include <nclgl/Quaternion.h>
+
+//Node in the flattened BVH, leaves reference a single child
+struct CompoundBVHNode
+{
+	Vector3	boundsMin;
+	Vector3	boundsMax;
+	uint	offset;		//Leaf: Child index, Internal: Index of the second child node (the first always follows it's parent)
+	uint	count;		//One for leaves, zero for internal nodes
+};
+
+class CompoundCollisionShape : public CollisionShape
+{
+public:
+	CompoundCollisionShape();
+	virtual ~CompoundCollisionShape();
+
+	//Adds a convex child shape, positioned/rotated relative to the parent PhysicsNode. The compound
+	// takes ownership of the shape. Concave and compound shapes can't be nested and are ignored.
+	void AddChild(CollisionShape* shape, const Vector3& local_pos = Vector3(0.0f, 0.0f, 0.0f), const Quaternion& local_orient = Quaternion());
+
+	inline uint GetNumChildren() const { return (uint)children.size(); }
+
+	//Proxy node for the given child, which always has the child's current world transform
+	inline PhysicsNode* GetChildNode(uint idx) const { return children[idx].node; }
+
+
+	//Calls func(PhysicsNode* child_node) for each child whose bounds overlap the given world space box,
+	// stopping early if func returns true
+	template <typename Func>
+	bool ForEachChildInBounds(const Vector3& world_min, const Vector3& world_max, Func func) const
+	{
+		if (nodes.empty())
+			return false;
+
+		Vector3 local_min, local_max;
+		WorldToLocalAABB(parentRotation, parentPosition, world_min, world_max, local_min, local_max);
+
+		uint stack[MAX_TREE_DEPTH];
+		uint stack_size = 0;
+		stack[stack_size++] = 0;
+		while (stack_size > 0)
+		{
+			const uint idx = stack[--stack_size];
+			const CompoundBVHNode& node = nodes[idx];
+			if (node.boundsMin.x > local_max.x || node.boundsMax.x < local_min.x
+				|| node.boundsMin.y > local_max.y || node.boundsMax.y < local_min.y
+				|| node.boundsMin.z > local_max.z || node.boundsMax.z < local_min.z)
+				continue;
+
+			if (node.count > 0)
+			{
+				if (func(children[node.offset].node)) return true;
+			}
+			else
+			{
+				stack[stack_size++] = node.offset;
+				stack[stack_size++] = idx + 1;
+			}
+		}
+		return false;
+	}
+
+
+	// Bounding radius is derived from the children
+	virtual void	SetRadius(float radius) override {}
+	virtual float	GetRadius() const override { return m_Radius; }
+
+	// Debug Collision Shape
+	virtual void DebugDraw() const override;
+
+	// Sum of each child's inertia about the parent's centre of mass (See Parallel Axis Theorem)
+	virtual Matrix3 BuildInverseInertia(float invMass) const override;
+
+
+	// Generic Collision Detection Routines
+	//  - The narrowphase always tests the children individually, so only the extents/closest
+	//    point of the whole compound are provided here
+	virtual void GetCollisionAxes(
+		const PhysicsNode* otherObject,
+		std::vector<Vector3>& out_axes) const override;
+
+	virtual Vector3 GetClosestPoint(const Vector3& point) const override;
+
+	virtual void GetMinMaxVertexOnAxis(
+		const Vector3& axis,
+		Vector3& out_min,
+		Vector3& out_max) const override;
+
+	virtual void GetIncidentReferencePolygon(
+		const Vector3& axis,
+		std::list<Vector3>& out_face,
+		Vector3& out_normal,
+		std::vector<Plane>& out_adjacent_planes) const override;
+
+
+	// Compound Collision Detection
+	virtual bool IsCompound() const override { return true; }
+	virtual void OnParentTransformChanged() override;
+
+
+	// Spatial Queries
+	virtual bool RayCast(
+		const Vector3& origin,
+		const Vector3& dir,
+		float max_dist,
+		float inflate,
+		float& out_dist,
+		Vector3& out_normal) const override;
+
+	virtual bool OverlapsSphere(const Vector3& centre, float radius) const override;
+	virtual bool OverlapsBox(const Vector3& centre, const Vector3& half_dims) const override;
+
+protected:
+	//Recursively builds the node covering child_order[first, first + count), returning it's index
+	uint BuildNode(std::vector<uint>& child_order, const std::vector<Vector3>& child_min, const std::vector<Vector3>& child_max, uint first, uint count);
+
+	//Rebuilds the BVH and bounding radius after a child is added
+	void BuildBVH();
+
+protected:
+	struct CompoundChild
+	{
+		PhysicsNode*	node;			//Proxy node, owns the child's shape
+		Vector3			localPosition;
+		Quaternion		localOrientation;
+		Vector3			localMin;		//Bounding box in the parent's local space
+		Vector3			localMax;
+	};
+
+	static const uint MAX_TREE_DEPTH = 64;
+
+	std::vector<CompoundChild>		children;
+	std::vector<CompoundBVHNode>	nodes;		//Depth first, nodes[0] is the root
+
+	//Parent's world transform, as of the last OnParentTransformChanged
+	Matrix3	parentRotation;
+	Vector3	parentPosition;
+};
@@ -28,12 +28,14 @@ Description:
 
 #pragma once
 #include "PhysicsNode.h"
-#include <nclgl\Vector3.h>
+#include <nclgl/Vector3.h>
+#include <cstring>
 
 class Constraint
 {
 public:
 	Constraint() {}
+	virtual ~Constraint() {}	//Constraints are deleted through this base by the PhysicsEngine
 
 
 	// Apply Velocity Impulse to object(s) in order to satisfy given constraint
@@ -50,4 +52,13 @@ public:
 
 	// Visually Debug Constraint 
 	virtual void DebugDraw() const {}
+
+
+	// Optional: Snapshot support (See PhysicsEngine::SaveSnapshot)
+	//  - Writes/Reads all parameters needed to resume the constraint to a block of
+	//    GetSnapshotSize() bytes. A constraint is only ever restored from a snapshot
+	//    written by itself, so the layout is entirely up to the constraint.
+	virtual uint GetSnapshotSize() const { return 0; }
+	virtual void SaveSnapshot(unsigned char* dst) const {}
+	virtual void RestoreSnapshot(const unsigned char* src) {}
 };
\ No newline at end of file
@@ -2,32 +2,22 @@
 #include "PhysicsNode.h"
 #include "GeometryUtils.h"
 #include <nclgl/Matrix3.h>
-
-#define SQRT2 1.41421356237
+#include <algorithm>
+#include <mutex>
 
 Hull CuboidCollisionShape::cubeHull = Hull();
 
+//Shapes can be created by several physics worlds at once, so the shared hull is built exactly once
+static std::once_flag g_CubeHullConstructed;
+
 CuboidCollisionShape::CuboidCollisionShape()
 {
 	halfDims = Vector3(0.5f, 0.5f, 0.5f);
 
-	if (cubeHull.GetNumVertices() == 0)
-	{
-		ConstructCubeHull();
-	}
-
-	int max = 0;
+	std::call_once(g_CubeHullConstructed, ConstructCubeHull);
 
-	if (halfDims.x > max) {
-		max = halfDims.x;
-	}
-	if (halfDims.y > max) {
-		max = halfDims.y;
-	}
-	if (halfDims.z > max) {
-		max = halfDims.z;
-	}
-	m_Radius = max * SQRT2;
+	//Bounding radius reaches the corners, anything less lets the broadphase miss corner contacts
+	m_Radius = halfDims.Length();
 
 }
 
@@ -35,23 +25,10 @@ CuboidCollisionShape::CuboidCollisionShape(const Vector3& halfdims)
 {
 	halfDims = halfdims;
 
-	if (cubeHull.GetNumVertices() == 0)
-	{
-		ConstructCubeHull();
-	}
+	std::call_once(g_CubeHullConstructed, ConstructCubeHull);
 
-	float max = 0.0f;
-
-	if (halfDims.x > max) {
-		max = halfDims.x;
-	}
-	if (halfDims.y > max) {
-		max = halfDims.y;
-	}
-	if (halfDims.z > max) {
-		max = halfDims.z;
-	}
-	m_Radius = max * SQRT2;
+	//Bounding radius reaches the corners, anything less lets the broadphase miss corner contacts
+	m_Radius = halfDims.Length();
 }
 
 CuboidCollisionShape::~CuboidCollisionShape()
@@ -235,6 +212,154 @@ void CuboidCollisionShape::GetIncidentReferencePolygon(
 }
 
 
+bool CuboidCollisionShape::RayCast(
+	const Vector3& origin,
+	const Vector3& dir,
+	float max_dist,
+	float inflate,
+	float& out_dist,
+	Vector3& out_normal) const
+{
+	//Slab test in the cuboid's local space
+	// - For sphere casts the cuboid is grown by the radius along each axis, which slightly
+	//   overestimates hits near the edges/corners (the true shape would be rounded)
+	const Matrix3 orientation = Parent()->GetOrientation().ToMatrix3();
+	const Vector3 rel_origin = origin - Parent()->GetPosition();
+	const float half_dims[3] = { halfDims.x + inflate, halfDims.y + inflate, halfDims.z + inflate };
+
+	float t_min = 0.0f, t_max = max_dist;
+	int hit_axis = -1;
+	float hit_sign = 0.0f;
+	for (int i = 0; i < 3; ++i)
+	{
+		const Vector3& axis = orientation.GetCol(i);
+		const float o = Vector3::Dot(rel_origin, axis);
+		const float d = Vector3::Dot(dir, axis);
+
+		if (fabs(d) < 1e-8f)
+		{
+			//Parallel to the slab, so must start within it
+			if (o < -half_dims[i] || o > half_dims[i])
+				return false;
+			continue;
+		}
+
+		const float inv_d = 1.0f / d;
+		float t1 = (-half_dims[i] - o) * inv_d;
+		float t2 = (half_dims[i] - o) * inv_d;
+		float sign = -1.0f;
+		if (t1 > t2)
+		{
+			std::swap(t1, t2);
+			sign = 1.0f;
+		}
+
+		if (t1 > t_min)
+		{
+			t_min = t1;
+			hit_axis = i;
+			hit_sign = sign;
+		}
+		t_max = min(t_max, t2);
+
+		if (t_min > t_max)
+			return false;
+	}
+
+	out_dist = t_min;
+	out_normal = (hit_axis >= 0) ? orientation.GetCol(hit_axis) * hit_sign : -dir;
+	return true;
+}
+
+bool CuboidCollisionShape::OverlapsSphere(const Vector3& centre, float radius) const
+{
+	//Closest point in the cuboid to the sphere centre (in local space)
+	const Matrix3 orientation = Parent()->GetOrientation().ToMatrix3();
+	const Vector3 rel_centre = centre - Parent()->GetPosition();
+	const float half_dims[3] = { halfDims.x, halfDims.y, halfDims.z };
+
+	float dist_sq = 0.0f;
+	for (int i = 0; i < 3; ++i)
+	{
+		const float o = Vector3::Dot(rel_centre, orientation.GetCol(i));
+		const float excess = fabs(o) - half_dims[i];
+		if (excess > 0.0f)
+			dist_sq += excess * excess;
+	}
+	return dist_sq <= radius * radius;
+}
+
+bool CuboidCollisionShape::OverlapsBox(const Vector3& centre, const Vector3& half_dims) const
+{
+	return OrientedBoxesOverlap(
+		centre, Matrix3::Identity, half_dims,
+		Parent()->GetPosition(), Parent()->GetOrientation().ToMatrix3(), halfDims);
+}
+
+bool CuboidCollisionShape::OverlapsCuboid(const CuboidCollisionShape& other) const
+{
+	return OrientedBoxesOverlap(
+		Parent()->GetPosition(), Parent()->GetOrientation().ToMatrix3(), halfDims,
+		other.Parent()->GetPosition(), other.Parent()->GetOrientation().ToMatrix3(), other.halfDims);
+}
+
+bool CuboidCollisionShape::OrientedBoxesOverlap(
+	const Vector3& centre_a, const Matrix3& orientation_a, const Vector3& half_dims_a,
+	const Vector3& centre_b, const Matrix3& orientation_b, const Vector3& half_dims_b)
+{
+	//Separating axis test between box A and box B, testing the 3 face normals
+	// of each and the 9 edge cross products. Everything is expressed in A's local space.
+	const Vector3 t_ws = centre_b - centre_a;
+	const float t[3] = {
+		Vector3::Dot(t_ws, orientation_a.GetCol(0)),
+		Vector3::Dot(t_ws, orientation_a.GetCol(1)),
+		Vector3::Dot(t_ws, orientation_a.GetCol(2)) };
+	const float ea[3] = { half_dims_a.x, half_dims_a.y, half_dims_a.z };
+	const float eb[3] = { half_dims_b.x, half_dims_b.y, half_dims_b.z };
+
+	//R[i][j] = Dot(A axis i, B axis j), padded to avoid false separations when edges are near parallel
+	float R[3][3], AbsR[3][3];
+	for (int i = 0; i < 3; ++i)
+	{
+		for (int j = 0; j < 3; ++j)
+		{
+			R[i][j] = Vector3::Dot(orientation_a.GetCol(i), orientation_b.GetCol(j));
+			AbsR[i][j] = fabs(R[i][j]) + 1e-6f;
+		}
+	}
+
+	for (int i = 0; i < 3; ++i)
+	{
+		const float rb = eb[0] * AbsR[i][0] + eb[1] * AbsR[i][1] + eb[2] * AbsR[i][2];
+		if (fabs(t[i]) > ea[i] + rb)
+			return false;
+	}
+
+	for (int j = 0; j < 3; ++j)
+	{
+		const float ra = ea[0] * AbsR[0][j] + ea[1] * AbsR[1][j] + ea[2] * AbsR[2][j];
+		const float dist = t[0] * R[0][j] + t[1] * R[1][j] + t[2] * R[2][j];
+		if (fabs(dist) > ra + eb[j])
+			return false;
+	}
+
+	for (int i = 0; i < 3; ++i)
+	{
+		const int i1 = (i + 1) % 3, i2 = (i + 2) % 3;
+		for (int j = 0; j < 3; ++j)
+		{
+			const int j1 = (j + 1) % 3, j2 = (j + 2) % 3;
+			const float ra = ea[i1] * AbsR[i2][j] + ea[i2] * AbsR[i1][j];
+			const float rb = eb[j1] * AbsR[i][j2] + eb[j2] * AbsR[i][j1];
+			const float dist = t[i2] * R[i1][j] - t[i1] * R[i2][j];
+			if (fabs(dist) > ra + rb)
+				return false;
+		}
+	}
+
+	return true;
+}
+
 void CuboidCollisionShape::DebugDraw() const
 {
 	// Just draw the cuboid hull-mesh at the position of our PhysicsNode
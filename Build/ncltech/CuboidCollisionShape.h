@@ -33,9 +33,9 @@ public:
 	virtual ~CuboidCollisionShape();
 
 	// Set Cuboid Dimensions
-	void SetHalfWidth(float half_width) { halfDims.x = fabs(half_width); }
-	void SetHalfHeight(float half_height) { halfDims.y = fabs(half_height); }
-	void SetHalfDepth(float half_depth) { halfDims.z = fabs(half_depth); }
+	void SetHalfWidth(float half_width) { halfDims.x = fabs(half_width); m_Radius = halfDims.Length(); }
+	void SetHalfHeight(float half_height) { halfDims.y = fabs(half_height); m_Radius = halfDims.Length(); }
+	void SetHalfDepth(float half_depth) { halfDims.z = fabs(half_depth); m_Radius = halfDims.Length(); }
 
 	// Get Cuboid Dimensions
 	const Vector3& GetHalfDims() const { return halfDims; }
@@ -71,6 +71,25 @@ public:
 		std::vector<Plane>& out_adjacent_planes) const override;
 
 
+	// Spatial Queries
+	virtual bool RayCast(
+		const Vector3& origin,
+		const Vector3& dir,
+		float max_dist,
+		float inflate,
+		float& out_dist,
+		Vector3& out_normal) const override;
+
+	virtual bool OverlapsSphere(const Vector3& centre, float radius) const override;
+	virtual bool OverlapsBox(const Vector3& centre, const Vector3& half_dims) const override;
+	bool OverlapsCuboid(const CuboidCollisionShape& other) const;
+
+	// Boolean separating axis test between two oriented boxes (no contact data)
+	static bool OrientedBoxesOverlap(
+		const Vector3& centre_a, const Matrix3& orientation_a, const Vector3& half_dims_a,
+		const Vector3& centre_b, const Matrix3& orientation_b, const Vector3& half_dims_b);
+
+
 	void	SetRadius(float radius) { m_Radius = radius; }
 	float	GetRadius() const { return m_Radius; }
 
@@ -14,8 +14,8 @@ position/orientation each frame.
 
 *//////////////////////////////////////////////////////////////////////////////
 #pragma once
-#include <nclgl\Matrix4.h>
-#include <nclgl\RenderNode.h>
+#include <nclgl/Matrix4.h>
+#include <nclgl/RenderNode.h>
 #include "GraphicsPipeline.h"
 #include "PhysicsEngine.h"
 #include "PhysicsNode.h"
@@ -34,12 +34,17 @@ class GameObject
 public:
 	GameObject(const std::string& name = "")
 		: friendlyName(name)
+		, scene(NULL)
+		, sceneIndex(0)
 		, renderNode(NULL)
 		, physicsNode(NULL) {}
 
 	GameObject(const std::string& name, RenderNode* renderNde, PhysicsNode* physicsNde = NULL)
 		: friendlyName(name)
+		, scene(NULL)
+		, sceneIndex(0)
 		, renderNode(renderNde)
+		, physicsNode(NULL)
 	{
 		SetPhysics(physicsNde);
 		//RegisterPhysicsToRenderTransformCallback();
@@ -48,7 +53,7 @@ public:
 	virtual ~GameObject()
 	{
 		if (renderNode)  GraphicsPipeline::Instance()->RemoveRenderNode(renderNode);
-		if (physicsNode) PhysicsEngine::Instance()->RemovePhysicsObject(physicsNode);
+		if (physicsNode && physicsNode->GetWorld()) physicsNode->GetWorld()->RemovePhysicsObject(physicsNode);
 
 		SAFE_DELETE(renderNode);
 		SAFE_DELETE(physicsNode);
@@ -116,14 +121,11 @@ public:
 	//<---------- UTILS ------------>
 	inline void RegisterPhysicsToRenderTransformCallback()
 	{
-		if (physicsNode && renderNode)
+		//RenderNode transforms are written in one batched pass per frame by the PhysicsEngine,
+		// rather than each PhysicsNode firing a callback every physics update.
+		if (physicsNode)
 		{
-			physicsNode->SetOnUpdateCallback(
-				std::bind(
-					&RenderNode::SetTransform,		// Function to call
-					renderNode,					// Constant parameter (in this case, as a member function, we need a 'this' parameter to know which class it is)
-					std::placeholders::_1)			// Variable parameter(s) that will be set by the callback function
-			);
+			physicsNode->SetRenderTarget(renderNode);
 		}
 	}
 
@@ -131,7 +133,7 @@ public:
 	{
 		if (physicsNode)
 		{
-			physicsNode->SetOnUpdateCallback([](const Matrix4&) {});
+			physicsNode->SetRenderTarget(NULL);
 		}
 	}
 
@@ -143,6 +145,7 @@ protected:
 	//Scene  
 	std::string					friendlyName;
 	Scene*						scene;
+	size_t						sceneIndex;		//Index in the scene's object list, so it can be removed with a swap-and-pop
 
 	//Components
 	RenderNode*					renderNode;
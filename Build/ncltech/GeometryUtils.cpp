@@ -1,5 +1,6 @@
 #include "GeometryUtils.h"
-#include <nclgl\common.h>
+#include <nclgl/common.h>
+#include <algorithm>
 
 // Gets the closest point x on the line (edge) to point (pos)
 Vector3 GeometryUtils::GetClosestPoint(
@@ -92,6 +93,365 @@ Vector3 GeometryUtils::GetClosestPoint(
 	return final_closest_point;
 }
 
+// Gets the closest point X on (or inside) the triangle abc to point (pos)
+Vector3 GeometryUtils::GetClosestPointTriangle(
+	const Vector3& pos,
+	const Vector3& a,
+	const Vector3& b,
+	const Vector3& c)
+{
+	//Works out which voronoi region (vertex, edge or face) of the triangle the point lies in
+	// - See Real-Time Collision Detection (Christer Ericson) 5.1.5
+	Vector3 ab = b - a;
+	Vector3 ac = c - a;
+	Vector3 ap = pos - a;
+
+	float d1 = Vector3::Dot(ab, ap);
+	float d2 = Vector3::Dot(ac, ap);
+	if (d1 <= 0.0f && d2 <= 0.0f) return a;
+
+	Vector3 bp = pos - b;
+	float d3 = Vector3::Dot(ab, bp);
+	float d4 = Vector3::Dot(ac, bp);
+	if (d3 >= 0.0f && d4 <= d3) return b;
+
+	float vc = d1 * d4 - d3 * d2;
+	if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) return a + ab * (d1 / (d1 - d3));
+
+	Vector3 cp = pos - c;
+	float d5 = Vector3::Dot(ab, cp);
+	float d6 = Vector3::Dot(ac, cp);
+	if (d6 >= 0.0f && d5 <= d6) return c;
+
+	float vb = d5 * d2 - d1 * d6;
+	if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) return a + ac * (d2 / (d2 - d6));
+
+	float va = d3 * d6 - d5 * d4;
+	if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+	//Inside the face
+	float denom = 1.0f / (va + vb + vc);
+	return a + ab * (vb * denom) + ac * (vc * denom);
+}
+
+// Gets the closest points between the segments [p1, q1] and [p2, q2]
+float GeometryUtils::ClosestPointsSegmentSegment(
+	const Vector3& p1,
+	const Vector3& q1,
+	const Vector3& p2,
+	const Vector3& q2,
+	Vector3& out_c1,
+	Vector3& out_c2)
+{
+	//Solves for the parameters s,t of the closest points p1 + d1 * s and p2 + d2 * t, clamping
+	// each to it's segment in turn - See Real-Time Collision Detection (Christer Ericson) 5.1.9
+	const float epsilon = 1e-12f;
+	const Vector3 d1 = q1 - p1;
+	const Vector3 d2 = q2 - p2;
+	const Vector3 r = p1 - p2;
+	const float a = Vector3::Dot(d1, d1);
+	const float e = Vector3::Dot(d2, d2);
+	const float f = Vector3::Dot(d2, r);
+
+	float s = 0.0f, t = 0.0f;
+	if (a <= epsilon && e <= epsilon)
+	{
+		//Both segments are points
+	}
+	else if (a <= epsilon)
+	{
+		//First segment is a point
+		t = min(max(f / e, 0.0f), 1.0f);
+	}
+	else
+	{
+		const float c = Vector3::Dot(d1, r);
+		if (e <= epsilon)
+		{
+			//Second segment is a point
+			s = min(max(-c / a, 0.0f), 1.0f);
+		}
+		else
+		{
+			//Parallel segments have no unique closest point, so just start from p1's end
+			const float b = Vector3::Dot(d1, d2);
+			const float denom = a * e - b * b;
+			if (denom > epsilon)
+				s = min(max((b * f - c * e) / denom, 0.0f), 1.0f);
+
+			t = (b * s + f) / e;
+			if (t < 0.0f)
+			{
+				t = 0.0f;
+				s = min(max(-c / a, 0.0f), 1.0f);
+			}
+			else if (t > 1.0f)
+			{
+				t = 1.0f;
+				s = min(max((b - c) / a, 0.0f), 1.0f);
+			}
+		}
+	}
+
+	out_c1 = p1 + d1 * s;
+	out_c2 = p2 + d2 * t;
+	const Vector3 diff = out_c1 - out_c2;
+	return Vector3::Dot(diff, diff);
+}
+
+// Gets the closest points between the segment [p, q] and an oriented box
+float GeometryUtils::ClosestPointsSegmentBox(
+	const Vector3& p,
+	const Vector3& q,
+	const Vector3& box_centre,
+	const Matrix3& box_axes,
+	const Vector3& box_half_dims,
+	Vector3& out_on_segment,
+	Vector3& out_on_box)
+{
+	//In the box's local space the distance along each axis is zero inside the box's slab and linear
+	// outside of it, so the squared distance is a quadratic between the points where the segment
+	// crosses a slab boundary. It's also convex, so minimising each of those pieces (at most 7) and
+	// keeping the lowest gives the exact closest point without any iteration.
+	const Vector3 ws_dir = q - p;
+	const Vector3 ws_start = p - box_centre;
+	float o[3], d[3];
+	for (int i = 0; i < 3; ++i)
+	{
+		o[i] = Vector3::Dot(ws_start, box_axes.GetCol(i));
+		d[i] = Vector3::Dot(ws_dir, box_axes.GetCol(i));
+	}
+	const float e[3] = { box_half_dims.x, box_half_dims.y, box_half_dims.z };
+
+	float ts[8];
+	int num_ts = 0;
+	ts[num_ts++] = 0.0f;
+	for (int i = 0; i < 3; ++i)
+	{
+		if (fabs(d[i]) < 1e-12f)
+			continue;
+
+		for (float side : { -1.0f, 1.0f })
+		{
+			const float t = (side * e[i] - o[i]) / d[i];
+			if (t > 0.0f && t < 1.0f)
+				ts[num_ts++] = t;
+		}
+	}
+	ts[num_ts++] = 1.0f;
+	std::sort(ts, ts + num_ts);
+
+	float best_t = 0.0f, best_dist_sq = FLT_MAX;
+	for (int k = 0; k + 1 < num_ts; ++k)
+	{
+		const float t0 = ts[k], t1 = ts[k + 1];
+		const float t_mid = (t0 + t1) * 0.5f;
+
+		//Squared distance over this piece is qa * t^2 + qb * t + c, only the minimum's position is needed
+		float qa = 0.0f, qb = 0.0f;
+		for (int i = 0; i < 3; ++i)
+		{
+			const float x = o[i] + d[i] * t_mid;
+			if (x > e[i] || x < -e[i])
+			{
+				const float offset = o[i] - ((x > e[i]) ? e[i] : -e[i]);
+				qa += d[i] * d[i];
+				qb += 2.0f * d[i] * offset;
+			}
+		}
+
+		const float t = (qa > 1e-12f) ? min(max(-qb / (2.0f * qa), t0), t1) : t0;
+
+		float dist_sq = 0.0f;
+		for (int i = 0; i < 3; ++i)
+		{
+			const float x = o[i] + d[i] * t;
+			const float outside = x - min(max(x, -e[i]), e[i]);
+			dist_sq += outside * outside;
+		}
+
+		if (dist_sq < best_dist_sq)
+		{
+			best_dist_sq = dist_sq;
+			best_t = t;
+		}
+	}
+
+	out_on_segment = p + ws_dir * best_t;
+	out_on_box = box_centre;
+	for (int i = 0; i < 3; ++i)
+	{
+		const float x = o[i] + d[i] * best_t;
+		out_on_box = out_on_box + box_axes.GetCol(i) * min(max(x, -e[i]), e[i]);
+	}
+	return best_dist_sq;
+}
+
+// Intersects a ray (with a normalised direction) with the front face of triangle abc
+bool GeometryUtils::RayTriangleIntersection(
+	const Vector3& origin,
+	const Vector3& dir,
+	const Vector3& a,
+	const Vector3& b,
+	const Vector3& c,
+	float max_dist,
+	float& out_dist)
+{
+	//Moller-Trumbore, rejecting back faces and rays parallel to the triangle
+	Vector3 ab = b - a;
+	Vector3 ac = c - a;
+	Vector3 pvec = Vector3::Cross(dir, ac);
+	float det = Vector3::Dot(ab, pvec);
+	if (det < 1e-8f)
+		return false;
+
+	float inv_det = 1.0f / det;
+	Vector3 tvec = origin - a;
+	float u = Vector3::Dot(tvec, pvec) * inv_det;
+	if (u < 0.0f || u > 1.0f)
+		return false;
+
+	Vector3 qvec = Vector3::Cross(tvec, ab);
+	float v = Vector3::Dot(dir, qvec) * inv_det;
+	if (v < 0.0f || u + v > 1.0f)
+		return false;
+
+	float t = Vector3::Dot(ac, qvec) * inv_det;
+	if (t < 0.0f || t > max_dist)
+		return false;
+
+	out_dist = t;
+	return true;
+}
+
+// Converts a world space axis aligned box into a (conservative) local space axis aligned box
+void GeometryUtils::WorldToLocalAABB(
+	const Matrix3& rotation,
+	const Vector3& position,
+	const Vector3& world_min,
+	const Vector3& world_max,
+	Vector3& out_min,
+	Vector3& out_max)
+{
+	const Vector3 centre = Matrix3::Transpose(rotation) * ((world_min + world_max) * 0.5f - position);
+	const Vector3 half_dims = (world_max - world_min) * 0.5f;
+
+	//Extents of the rotated box along each of the local axes
+	const Vector3& ax = rotation.GetCol(0);
+	const Vector3& ay = rotation.GetCol(1);
+	const Vector3& az = rotation.GetCol(2);
+	const Vector3 local_half_dims = Vector3(
+		fabs(ax.x) * half_dims.x + fabs(ax.y) * half_dims.y + fabs(ax.z) * half_dims.z,
+		fabs(ay.x) * half_dims.x + fabs(ay.y) * half_dims.y + fabs(ay.z) * half_dims.z,
+		fabs(az.x) * half_dims.x + fabs(az.y) * half_dims.y + fabs(az.z) * half_dims.z);
+
+	out_min = centre - local_half_dims;
+	out_max = centre + local_half_dims;
+}
+
+//Spreads the lower 21 bits of v out so there are two zero bits between each one
+static inline unsigned long long ExpandMortonBits(unsigned long long v)
+{
+	v &= 0x1fffff;
+	v = (v | v << 32) & 0x1f00000000ffffull;
+	v = (v | v << 16) & 0x1f0000ff0000ffull;
+	v = (v | v << 8) & 0x100f00f00f00f00full;
+	v = (v | v << 4) & 0x10c30c30c30c30c3ull;
+	v = (v | v << 2) & 0x1249249249249249ull;
+	return v;
+}
+
+unsigned long long GeometryUtils::MortonCode(
+	const Vector3& pos,
+	const Vector3& origin,
+	const Vector3& range)
+{
+	const float cells = float(1 << MORTON_CODE_BITS);
+	const unsigned long long max_cell = (1 << MORTON_CODE_BITS) - 1;
+	auto quantize = [&](float p, float lower, float size) {
+		//Flat boxes (e.g. every body resting on the same floor) have no spread along that axis
+		if (!(size > 0.0f)) return 0ull;
+
+		float t = (p - lower) / size * cells;
+		if (t <= 0.0f) return 0ull;
+		return min((unsigned long long)t, max_cell);
+	};
+
+	return (ExpandMortonBits(quantize(pos.x, origin.x, range.x)) << 2)
+		| (ExpandMortonBits(quantize(pos.y, origin.y, range.y)) << 1)
+		| ExpandMortonBits(quantize(pos.z, origin.z, range.z));
+}
+
+// Separating axis test between triangle abc and an oriented box
+bool GeometryUtils::TriangleBoxOverlap(
+	const Vector3& a,
+	const Vector3& b,
+	const Vector3& c,
+	const Vector3& box_centre,
+	const Matrix3& box_axes,
+	const Vector3& box_half_dims,
+	Vector3* out_normal,
+	float* out_depth)
+{
+	const Vector3 edges[3] = { b - a, c - b, a - c };
+	const float half_dims[3] = { box_half_dims.x, box_half_dims.y, box_half_dims.z };
+
+	//13 possible axes - the triangle normal, the three box face normals and the nine edge/edge cross products
+	Vector3 axes[13];
+	axes[0] = Vector3::Cross(edges[0], -edges[2]);
+	for (int i = 0; i < 3; ++i)
+	{
+		axes[1 + i] = box_axes.GetCol(i);
+		for (int j = 0; j < 3; ++j)
+			axes[4 + i * 3 + j] = Vector3::Cross(box_axes.GetCol(i), edges[j]);
+	}
+
+	float best_depth = FLT_MAX, best_score = FLT_MAX;
+	Vector3 best_normal;
+	for (int i = 0; i < 13; ++i)
+	{
+		Vector3 axis = axes[i];
+		float len_sq = Vector3::Dot(axis, axis);
+		if (len_sq < 1e-12f)
+			continue;	//Parallel edges, already covered by the face axes
+		axis = axis / sqrtf(len_sq);
+
+		float tri_min = Vector3::Dot(a, axis), tri_max = tri_min;
+		float proj = Vector3::Dot(b, axis);
+		tri_min = min(tri_min, proj); tri_max = max(tri_max, proj);
+		proj = Vector3::Dot(c, axis);
+		tri_min = min(tri_min, proj); tri_max = max(tri_max, proj);
+
+		float box_extent = 0.0f;
+		for (int j = 0; j < 3; ++j)
+			box_extent += fabs(Vector3::Dot(box_axes.GetCol(j), axis)) * half_dims[j];
+		const float box_mid = Vector3::Dot(box_centre, axis);
+
+		//Distance to push the box out along +axis/-axis
+		const float push_pos = tri_max - (box_mid - box_extent);
+		const float push_neg = (box_mid + box_extent) - tri_min;
+		if (push_pos < 0.0f || push_neg < 0.0f)
+			return false;
+
+		//Edge axes have to be noticeably better, so resting contacts don't flicker between face and edge normals
+		const float depth = min(push_pos, push_neg);
+		const float score = (i >= 4) ? depth + 1e-4f : depth;
+		if (score < best_score)
+		{
+			best_score = score;
+			best_depth = depth;
+			best_normal = (push_pos <= push_neg) ? axis : -axis;
+		}
+	}
+
+	if (best_depth == FLT_MAX)
+		return false; //Degenerate triangle
+
+	if (out_normal) *out_normal = best_normal;
+	if (out_depth) *out_depth = best_depth;
+	return true;
+}
+
 // Performs a plane/edge collision test, if an intersection does occur then
 //    it will return the point on the line where it intersected the given plane.
 bool GeometryUtils::PlaneEdgeIntersection(
@@ -1,9 +1,13 @@
 #pragma once
-#include <nclgl\Vector3.h>
-#include <nclgl\Plane.h>
+#include <nclgl/Vector3.h>
+#include <nclgl/Plane.h>
+#include <nclgl/Matrix3.h>
 #include <list>
 #include <vector>
 
+//Number of bits per axis in a GeometryUtils::MortonCode
+#define MORTON_CODE_BITS 21
+
 namespace GeometryUtils
 {
 	struct Edge
@@ -37,6 +41,79 @@ namespace GeometryUtils
 		std::vector<Edge>& edges);
 
 
+	// Gets the closest point X on (or inside) the triangle abc to point (pos)
+	Vector3 GetClosestPointTriangle(
+		const Vector3& pos,
+		const Vector3& a,
+		const Vector3& b,
+		const Vector3& c);
+
+	// Gets the closest points between the segments [p1, q1] and [p2, q2], returning the squared distance
+	//    between them. Either segment can have zero length, in which case it's treated as a point.
+	float ClosestPointsSegmentSegment(
+		const Vector3& p1,
+		const Vector3& q1,
+		const Vector3& p2,
+		const Vector3& q2,
+		Vector3& out_c1,
+		Vector3& out_c2);
+
+	// Gets the closest points between the segment [p, q] and an oriented box, whose world space axes are the
+	//    columns of box_axes, returning the squared distance between them. Segments passing through the box
+	//    return zero, with both points somewhere along the part of the segment that is inside it.
+	float ClosestPointsSegmentBox(
+		const Vector3& p,
+		const Vector3& q,
+		const Vector3& box_centre,
+		const Matrix3& box_axes,
+		const Vector3& box_half_dims,
+		Vector3& out_on_segment,
+		Vector3& out_on_box);
+
+	// Intersects a ray (with a normalised direction) with the front face of triangle abc, where the front face
+	//    is the side that Cross(b - a, c - a) points towards. Returns true if the triangle is hit within max_dist.
+	bool RayTriangleIntersection(
+		const Vector3& origin,
+		const Vector3& dir,
+		const Vector3& a,
+		const Vector3& b,
+		const Vector3& c,
+		float max_dist,
+		float& out_dist);
+
+	// Converts a world space axis aligned box into a (conservative) axis aligned box in the local space
+	//    of an object with the given world rotation/position.
+	void WorldToLocalAABB(
+		const Matrix3& rotation,
+		const Vector3& position,
+		const Vector3& world_min,
+		const Vector3& world_max,
+		Vector3& out_min,
+		Vector3& out_max);
+
+	// Separating axis test between triangle abc and an oriented box, whose world space axes are the columns
+	//    of box_axes. If they overlap, optionally outputs the axis of minimum penetration (pointing from the
+	//    triangle towards the box) and the distance the box would have to move along it to seperate them.
+	bool TriangleBoxOverlap(
+		const Vector3& a,
+		const Vector3& b,
+		const Vector3& c,
+		const Vector3& box_centre,
+		const Matrix3& box_axes,
+		const Vector3& box_half_dims,
+		Vector3* out_normal = NULL,
+		float* out_depth = NULL);
+
+
+	// Quantizes pos to a grid of 2^MORTON_CODE_BITS cells along each axis of the box [origin, origin + range] and
+	//    interleaves the bits as x,y,z (from the highest bit down), so positions that are close together usually
+	//    have close codes. Positions outside of the box are clamped to it's edges.
+	unsigned long long MortonCode(
+		const Vector3& pos,
+		const Vector3& origin,
+		const Vector3& range);
+
+
 	// Performs a plane/edge collision test, if an intersection does occur then
 	//    it will return the point on the line where it intersected the given plane.
 	bool PlaneEdgeIntersection(
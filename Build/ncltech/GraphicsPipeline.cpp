@@ -1,7 +1,8 @@
 #include "GraphicsPipeline.h"
 #include "ScreenPicker.h"
 #include "BoundingBox.h"
-#include <nclgl\NCLDebug.h>
+#include <nclgl/NCLDebug.h>
+#include <nclgl/Profiler.h>
 #include <algorithm>
 
 GraphicsPipeline::GraphicsPipeline()
@@ -78,6 +79,7 @@ GraphicsPipeline::~GraphicsPipeline()
 void GraphicsPipeline::InitializeDefaults()
 {
 	allNodes.clear();
+	allNodesLookup.clear();
 	ScreenPicker::Instance()->ClearAllObjects();
 
 	//--- Do we want the camera to reset pos/orientation everytime we reset a scene????
@@ -97,13 +99,25 @@ void GraphicsPipeline::InitializeDefaults()
 
 void GraphicsPipeline::AddRenderNode(RenderNode* node)
 {
-	if (std::find(allNodes.begin(), allNodes.end(), node) == allNodes.end())
+	if (allNodesLookup.find(node) == allNodesLookup.end())
+	{
+		allNodesLookup[node] = allNodes.size();
 		allNodes.push_back(node);
+	}
 }
 
 void GraphicsPipeline::RemoveRenderNode(RenderNode* node)
 {
-	allNodes.erase(std::remove(allNodes.begin(), allNodes.end(), node), allNodes.end());
+	auto found_loc = allNodesLookup.find(node);
+	if (found_loc == allNodesLookup.end())
+		return;
+
+	//Render lists are rebuilt (and sorted) every frame, so the order of allNodes doesn't matter
+	const size_t idx = found_loc->second;
+	allNodes[idx] = allNodes.back();
+	allNodesLookup[allNodes[idx]] = idx;
+	allNodes.pop_back();
+	allNodesLookup.erase(node);
 }
 
 void GraphicsPipeline::LoadShaders()
@@ -226,20 +240,30 @@ void GraphicsPipeline::UpdateScene(float dt)
 
 void GraphicsPipeline::RenderScene()
 {
+	PROFILE_SCOPE("GraphicsPipeline::RenderScene");
+
 	//Build World Transforms
 	// - Most scene objects will probably end up being static, so we really should only be updating
 	//   modelMatrices for objects (and their children) who have actually moved since last frame
-	for (RenderNode* node : allNodes)
-		node->Update(0.0f); //Not sure what the msec is here is for, apologies if this breaks anything in your framework!
+	{
+		PROFILE_SCOPE("Render - World Transforms");
+		for (RenderNode* node : allNodes)
+			node->Update(0.0f); //Not sure what the msec is here is for, apologies if this breaks anything in your framework!
+	}
 	
 	//Build Transparent/Opaque Renderlists
-	BuildAndSortRenderLists();
+	{
+		PROFILE_SCOPE("Render - Render Lists");
+		BuildAndSortRenderLists();
+	}
 
 	//NCLDebug - Build render lists
 	NCLDebug::_BuildRenderLists();
 
 
 	//Build shadowmaps
+	{
+		PROFILE_SCOPE("Render - Shadow Pass");
 		BuildShadowTransforms();
 		glBindFramebuffer(GL_FRAMEBUFFER, shadowFBO);
 		glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, shadowTex, 0);
@@ -256,11 +280,12 @@ void GraphicsPipeline::RenderScene()
 				glUniformMatrix4fv(uModelMtx, 1, GL_FALSE, (float*)&node->GetWorldTransform());
 			}
 		);
-	
-	
+	}
 
 
 	//Render scene to screen fbo
+	{
+		PROFILE_SCOPE("Render - Forward Pass");
 		glBindFramebuffer(GL_FRAMEBUFFER, screenFBO);
 		glViewport(0, 0, screenTexWidth, screenTexHeight);
 		glClearColor(backgroundColor.x, backgroundColor.y, backgroundColor.z, 1.0f);
@@ -281,7 +306,7 @@ void GraphicsPipeline::RenderScene()
 
 		glActiveTexture(GL_TEXTURE2); glBindTexture(GL_TEXTURE_2D_ARRAY, shadowTex);
 
-		uModelMtx = glGetUniformLocation(shaderForwardLighting->GetProgram(), "uModelMtx");
+		GLint uModelMtx = glGetUniformLocation(shaderForwardLighting->GetProgram(), "uModelMtx");
 		GLint uColor = glGetUniformLocation(shaderForwardLighting->GetProgram(), "uColor");
 		RenderAllObjects(false,
 			[&](RenderNode* node)
@@ -302,10 +327,12 @@ void GraphicsPipeline::RenderScene()
 		//NCLDEBUG - World Debug Data (anti-aliased)		
 		NCLDebug::_RenderDebugDepthTested();
 		NCLDebug::_RenderDebugNonDepthTested();
-	
+	}
 
 
 	//Downsample and present to screen
+	{
+		PROFILE_SCOPE("Render - Present");
 		glBindFramebuffer(GL_FRAMEBUFFER, 0);
 		glViewport(0, 0, width, height);
 		glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
@@ -322,9 +349,12 @@ void GraphicsPipeline::RenderScene()
 		//NCLDEBUG - Text Elements (aliased)
 		NCLDebug::_RenderDebugClipSpace();
 		NCLDebug::_ClearDebugLists();
-	
+	}
 
-	OGLRenderer::SwapBuffers();
+	{
+		PROFILE_SCOPE("Render - Swap Buffers");
+		OGLRenderer::SwapBuffers();
+	}
 }
 
 void GraphicsPipeline::Resize(int x, int y)
@@ -1,8 +1,9 @@
 #pragma once
-#include <nclgl\OGLRenderer.h>
-#include <nclgl\TSingleton.h>
-#include <nclgl\Camera.h>
-#include <nclgl\RenderNode.h>
+#include <nclgl/OGLRenderer.h>
+#include <nclgl/TSingleton.h>
+#include <nclgl/Camera.h>
+#include <nclgl/RenderNode.h>
+#include <unordered_map>
 
 //---------------------------
 //------ Base Renderer ------
@@ -164,6 +165,7 @@ protected:
 	Camera* camera;
 	bool isVsyncEnabled;
 	std::vector<RenderNode*> allNodes;
+	std::unordered_map<RenderNode*, size_t> allNodesLookup;	//Index of each node in allNodes, so nodes can be removed with a swap-and-pop
 
 	std::vector<RenderNode*> renderlistOpaque;
 	std::vector<TransparentPair> renderlistTransparent;	//Also stores cameraDist in the second argument for sorting purposes
@@ -0,0 +1,409 @@
+#include "HeightFieldCollisionShape.h"
+#include "SphereCollisionShape.h"
+#include "CuboidCollisionShape.h"
+#include "PhysicsNode.h"
+#include "Manifold.h"
+#include <nclgl/NCLDebug.h>
+#include <algorithm>
+
+HeightFieldCollisionShape::HeightFieldCollisionShape(
+	std::shared_ptr<const std::vector<float>> heights,
+	uint num_samples_x,
+	uint num_samples_z,
+	float spacing_x,
+	float spacing_z,
+	uint first_cell_x,
+	uint first_cell_z,
+	uint num_cells_x,
+	uint num_cells_z)
+	: heights(heights)
+	, numSamplesX(num_samples_x)
+	, numSamplesZ(num_samples_z)
+	, spacingX(spacing_x)
+	, spacingZ(spacing_z)
+	, firstCellX(first_cell_x)
+	, firstCellZ(first_cell_z)
+	, numCellsX(num_cells_x)
+	, numCellsZ(num_cells_z)
+{
+	//Bounding box of every sample touched by this chunk
+	float min_height = FLT_MAX, max_height = -FLT_MAX;
+	for (uint x = firstCellX; x <= firstCellX + numCellsX; ++x)
+	{
+		for (uint z = firstCellZ; z <= firstCellZ + numCellsZ; ++z)
+		{
+			float h = GetSampleHeight(x, z);
+			min_height = min(min_height, h);
+			max_height = max(max_height, h);
+		}
+	}
+
+	halfExtents = Vector3(numCellsX * spacingX, max_height - min_height, numCellsZ * spacingZ) * 0.5f;
+	chunkCentre = Vector3(firstCellX * spacingX, min_height, firstCellZ * spacingZ) + halfExtents;
+	m_Radius = halfExtents.Length();
+}
+
+HeightFieldCollisionShape::~HeightFieldCollisionShape()
+{
+
+}
+
+Matrix3 HeightFieldCollisionShape::BuildInverseInertia(float invMass) const
+{
+	return Matrix3::ZeroMatrix;
+}
+
+Vector3 HeightFieldCollisionShape::GetGridOrigin() const
+{
+	return Parent()->GetPosition() - chunkCentre;
+}
+
+bool HeightFieldCollisionShape::GetCellRange(const Vector3& world_min, const Vector3& world_max, uint& out_x0, uint& out_z0, uint& out_x1, uint& out_z1) const
+{
+	const Vector3 lower = world_min - GetGridOrigin();
+	const Vector3 upper = world_max - GetGridOrigin();
+
+	if (lower.y > chunkCentre.y + halfExtents.y)
+		return false;
+
+	//Clamp in floating point first, so huge (or infinite) boxes can't overflow the conversion
+	const float last_x = (float)(firstCellX + numCellsX - 1);
+	const float last_z = (float)(firstCellZ + numCellsZ - 1);
+	const float x0 = max(floor(lower.x / spacingX), (float)firstCellX);
+	const float z0 = max(floor(lower.z / spacingZ), (float)firstCellZ);
+	const float x1 = min(floor(upper.x / spacingX), last_x);
+	const float z1 = min(floor(upper.z / spacingZ), last_z);
+
+	if (x0 > x1 || z0 > z1)
+		return false;
+
+	out_x0 = (uint)x0;
+	out_z0 = (uint)z0;
+	out_x1 = (uint)x1;
+	out_z1 = (uint)z1;
+	return true;
+}
+
+void HeightFieldCollisionShape::GetCellTriangles(uint cell_x, uint cell_z, Vector3 out_tris[6]) const
+{
+	const Vector3 origin = GetGridOrigin();
+	const Vector3 a = origin + Vector3(cell_x * spacingX, GetSampleHeight(cell_x, cell_z), cell_z * spacingZ);
+	const Vector3 b = origin + Vector3((cell_x + 1) * spacingX, GetSampleHeight(cell_x + 1, cell_z), cell_z * spacingZ);
+	const Vector3 c = origin + Vector3((cell_x + 1) * spacingX, GetSampleHeight(cell_x + 1, cell_z + 1), (cell_z + 1) * spacingZ);
+	const Vector3 d = origin + Vector3(cell_x * spacingX, GetSampleHeight(cell_x, cell_z + 1), (cell_z + 1) * spacingZ);
+
+	//Same split as HeightMap, along the diagonal a-c
+	out_tris[0] = a; out_tris[1] = c; out_tris[2] = b;
+	out_tris[3] = a; out_tris[4] = d; out_tris[5] = c;
+}
+
+bool HeightFieldCollisionShape::GetSurfaceAt(const Vector3& pos, float& out_height, Vector3& out_normal) const
+{
+	const Vector3 local = pos - GetGridOrigin();
+	const float gx = local.x / spacingX;
+	const float gz = local.z / spacingZ;
+
+	//Points on the far edge of the chunk belong to the next chunk, unless this is the last one
+	if (gx < (float)firstCellX || gz < (float)firstCellZ)
+		return false;
+	uint cell_x = (uint)gx;
+	uint cell_z = (uint)gz;
+	if (cell_x == firstCellX + numCellsX && cell_x == numSamplesX - 1 && gx == (float)cell_x) cell_x--;
+	if (cell_z == firstCellZ + numCellsZ && cell_z == numSamplesZ - 1 && gz == (float)cell_z) cell_z--;
+	if (cell_x >= firstCellX + numCellsX || cell_z >= firstCellZ + numCellsZ)
+		return false;
+
+	const float fx = gx - (float)cell_x;
+	const float fz = gz - (float)cell_z;
+	const float ha = GetSampleHeight(cell_x, cell_z);
+	const float hb = GetSampleHeight(cell_x + 1, cell_z);
+	const float hc = GetSampleHeight(cell_x + 1, cell_z + 1);
+	const float hd = GetSampleHeight(cell_x, cell_z + 1);
+
+	//Interpolate across whichever triangle the point is above
+	float dhdx, dhdz;
+	if (fx >= fz)
+	{
+		dhdx = hb - ha;
+		dhdz = hc - hb;
+	}
+	else
+	{
+		dhdx = hc - hd;
+		dhdz = hd - ha;
+	}
+
+	out_height = GetGridOrigin().y + ha + fx * dhdx + fz * dhdz;
+	out_normal = Vector3(-dhdx / spacingX, 1.0f, -dhdz / spacingZ).Normalise();
+	return true;
+}
+
+void HeightFieldCollisionShape::GenConcaveContactPoints(const PhysicsNode* otherObject, Manifold* out_manifold) const
+{
+	const CollisionShape* otherShape = otherObject->GetCollisionShape();
+
+	Vector3 other_min, other_max;
+	otherShape->GetWorldAABB(other_min, other_max);
+
+	uint x0, z0, x1, z1;
+	if (!GetCellRange(other_min, other_max, x0, z0, x1, z1))
+		return;
+
+	//Spheres - Test against every triangle under the sphere, so it can roll smoothly over edges and into valleys
+	const SphereCollisionShape* sphere = dynamic_cast<const SphereCollisionShape*>(otherShape);
+	if (sphere)
+	{
+		const Vector3 centre = otherObject->GetPosition();
+		const float radius = sphere->GetRadius();
+
+		Vector3 tris[6];
+		for (uint x = x0; x <= x1; ++x)
+		{
+			for (uint z = z0; z <= z1; ++z)
+			{
+				GetCellTriangles(x, z, tris);
+				for (int i = 0; i < 6; i += 3)
+				{
+					Vector3 closest = GetClosestPointTriangle(centre, tris[i], tris[i + 1], tris[i + 2]);
+					Vector3 diff = centre - closest;
+					float dist_sq = Vector3::Dot(diff, diff);
+					if (dist_sq >= radius * radius)
+						continue;
+
+					float dist = sqrtf(dist_sq);
+					Vector3 normal = (dist > 1e-6f)
+						? diff / dist
+						: Vector3::Cross(tris[i + 1] - tris[i], tris[i + 2] - tris[i]).Normalise();
+
+					out_manifold->AddContact(closest, centre - normal * radius, normal, dist - radius);
+				}
+			}
+		}
+		return;
+	}
+
+	//Everything else - Test the shape's corners against the surface directly below them
+	Vector3 points[8];
+	int num_points = 0;
+
+	const CuboidCollisionShape* cuboid = dynamic_cast<const CuboidCollisionShape*>(otherShape);
+	if (cuboid)
+	{
+		Matrix4 wsTransform = otherObject->GetWorldSpaceTransform() * Matrix4::Scale(cuboid->GetHalfDims());
+		for (int i = 0; i < 8; ++i)
+		{
+			points[num_points++] = wsTransform * Vector3(
+				(i & 1) ? 1.0f : -1.0f,
+				(i & 2) ? 1.0f : -1.0f,
+				(i & 4) ? 1.0f : -1.0f);
+		}
+	}
+	else
+	{
+		Vector3 upper;
+		otherShape->GetMinMaxVertexOnAxis(Vector3(0.0f, 1.0f, 0.0f), points[num_points++], upper);
+	}
+
+	float height;
+	Vector3 normal;
+	for (int i = 0; i < num_points; ++i)
+	{
+		const Vector3& p = points[i];
+		if (!GetSurfaceAt(p, height, normal))
+			continue;
+
+		//Distance below the triangle's plane
+		float penetration = (p.y - height) * normal.y;
+		if (penetration < 0.0f)
+		{
+			out_manifold->AddContact(p - normal * penetration, p, normal, penetration);
+		}
+	}
+}
+
+bool HeightFieldCollisionShape::RayCast(
+	const Vector3& origin,
+	const Vector3& dir,
+	float max_dist,
+	float inflate,
+	float& out_dist,
+	Vector3& out_normal) const
+{
+	//Clip the ray to the chunk's bounding box, so only the cells it actually passes over are tested
+	const Vector3 rel_origin = origin - Parent()->GetPosition();
+	const float o[3] = { rel_origin.x, rel_origin.y, rel_origin.z };
+	const float d[3] = { dir.x, dir.y, dir.z };
+	const float half_dims[3] = { halfExtents.x + inflate, halfExtents.y + inflate, halfExtents.z + inflate };
+
+	float tmin = 0.0f, tmax = max_dist;
+	for (int i = 0; i < 3; ++i)
+	{
+		if (fabs(d[i]) < 1e-8f)
+		{
+			//Parallel to the slab, so must start within it
+			if (o[i] < -half_dims[i] || o[i] > half_dims[i])
+				return false;
+			continue;
+		}
+
+		float t1 = (-half_dims[i] - o[i]) / d[i];
+		float t2 = (half_dims[i] - o[i]) / d[i];
+		if (t1 > t2) std::swap(t1, t2);
+		tmin = max(tmin, t1);
+		tmax = min(tmax, t2);
+		if (tmin > tmax)
+			return false;
+	}
+
+	const Vector3 seg_start = origin + dir * tmin;
+	const Vector3 seg_end = origin + dir * tmax;
+	const Vector3 inflate_xz = Vector3(inflate, 0.0f, inflate);
+	const Vector3 seg_min = Vector3(min(seg_start.x, seg_end.x), min(seg_start.y, seg_end.y), min(seg_start.z, seg_end.z)) - inflate_xz;
+	const Vector3 seg_max = Vector3(max(seg_start.x, seg_end.x), max(seg_start.y, seg_end.y), max(seg_start.z, seg_end.z)) + inflate_xz;
+
+	uint x0, z0, x1, z1;
+	if (!GetCellRange(seg_min, seg_max, x0, z0, x1, z1))
+		return false;
+
+	bool hit = false;
+	float best_dist = tmax;
+	Vector3 tris[6];
+	for (uint x = x0; x <= x1; ++x)
+	{
+		for (uint z = z0; z <= z1; ++z)
+		{
+			GetCellTriangles(x, z, tris);
+			for (int i = 0; i < 6; i += 3)
+			{
+				Vector3 normal = Vector3::Cross(tris[i + 1] - tris[i], tris[i + 2] - tris[i]).Normalise();
+				Vector3 offset = normal * inflate;
+
+				float dist;
+				if (RayTriangleIntersection(origin, dir, tris[i] + offset, tris[i + 1] + offset, tris[i + 2] + offset, best_dist, dist))
+				{
+					hit = true;
+					best_dist = dist;
+					out_normal = normal;
+				}
+			}
+		}
+	}
+
+	if (hit) out_dist = best_dist;
+	return hit;
+}
+
+bool HeightFieldCollisionShape::OverlapsSphere(const Vector3& centre, float radius) const
+{
+	//Centres under the surface are inside the ground
+	float height;
+	Vector3 normal;
+	if (GetSurfaceAt(centre, height, normal) && centre.y <= height)
+		return true;
+
+	const Vector3 r = Vector3(radius, radius, radius);
+	uint x0, z0, x1, z1;
+	if (!GetCellRange(centre - r, centre + r, x0, z0, x1, z1))
+		return false;
+
+	Vector3 tris[6];
+	for (uint x = x0; x <= x1; ++x)
+	{
+		for (uint z = z0; z <= z1; ++z)
+		{
+			GetCellTriangles(x, z, tris);
+			for (int i = 0; i < 6; i += 3)
+			{
+				Vector3 diff = centre - GetClosestPointTriangle(centre, tris[i], tris[i + 1], tris[i + 2]);
+				if (Vector3::Dot(diff, diff) <= radius * radius)
+					return true;
+			}
+		}
+	}
+	return false;
+}
+
+bool HeightFieldCollisionShape::OverlapsBox(const Vector3& centre, const Vector3& half_dims) const
+{
+	uint x0, z0, x1, z1;
+	if (!GetCellRange(centre - half_dims, centre + half_dims, x0, z0, x1, z1))
+		return false;
+
+	//Conservative, the box overlaps if it's bottom is below the highest sample of any cell under it
+	const float box_bottom = centre.y - half_dims.y - GetGridOrigin().y;
+	for (uint x = x0; x <= x1; ++x)
+	{
+		for (uint z = z0; z <= z1; ++z)
+		{
+			float cell_top = max(max(GetSampleHeight(x, z), GetSampleHeight(x + 1, z)),
+				max(GetSampleHeight(x + 1, z + 1), GetSampleHeight(x, z + 1)));
+			if (box_bottom <= cell_top)
+				return true;
+		}
+	}
+	return false;
+}
+
+void HeightFieldCollisionShape::GetCollisionAxes(
+	const PhysicsNode* otherObject,
+	std::vector<Vector3>& out_axes) const
+{
+	//Not a convex shape, see GenConcaveContactPoints
+}
+
+Vector3 HeightFieldCollisionShape::GetClosestPoint(const Vector3& point) const
+{
+	//Point on the surface directly below (or above) the given point, clamped to the chunk
+	const Vector3 lower = Parent()->GetPosition() - halfExtents;
+	const Vector3 upper = Parent()->GetPosition() + halfExtents;
+	Vector3 surface_point(min(max(point.x, lower.x), upper.x), point.y, min(max(point.z, lower.z), upper.z));
+
+	float height;
+	Vector3 normal;
+	if (GetSurfaceAt(surface_point, height, normal))
+	{
+		surface_point.y = height;
+	}
+	return surface_point;
+}
+
+void HeightFieldCollisionShape::GetMinMaxVertexOnAxis(
+	const Vector3& axis,
+	Vector3& out_min,
+	Vector3& out_max) const
+{
+	//Extents of the chunk's bounding box along the axis
+	const Vector3 corner_min = Vector3(
+		(axis.x >= 0.0f) ? -halfExtents.x : halfExtents.x,
+		(axis.y >= 0.0f) ? -halfExtents.y : halfExtents.y,
+		(axis.z >= 0.0f) ? -halfExtents.z : halfExtents.z);
+
+	out_min = Parent()->GetPosition() + corner_min;
+	out_max = Parent()->GetPosition() - corner_min;
+}
+
+void HeightFieldCollisionShape::GetIncidentReferencePolygon(
+	const Vector3& axis,
+	std::list<Vector3>& out_face,
+	Vector3& out_normal,
+	std::vector<Plane>& out_adjacent_planes) const
+{
+	//Not a convex shape, see GenConcaveContactPoints
+}
+
+void HeightFieldCollisionShape::DebugDraw() const
+{
+	Vector3 tris[6];
+	for (uint x = firstCellX; x < firstCellX + numCellsX; ++x)
+	{
+		for (uint z = firstCellZ; z < firstCellZ + numCellsZ; ++z)
+		{
+			GetCellTriangles(x, z, tris);
+
+			//Two edges per cell (plus the diagonal), the neighbouring cells draw the rest
+			NCLDebug::DrawHairLine(tris[0], tris[2], Vector4(0.5f, 1.0f, 0.5f, 1.0f));
+			NCLDebug::DrawHairLine(tris[0], tris[4], Vector4(0.5f, 1.0f, 0.5f, 1.0f));
+			NCLDebug::DrawHairLine(tris[0], tris[1], Vector4(0.5f, 1.0f, 0.5f, 0.5f));
+		}
+	}
+}
@@ -0,0 +1,132 @@
+/******************************************************************************
+Class: HeightFieldCollisionShape
+Implements: CollisionShape
+Author:
+Pieran Marris      <p.marris@newcastle.ac.uk> and YOU!
+Description:
+
+Extends CollisionShape to represent a (static) chunk of terrain, defined by a regular grid of
+height samples. The sample array is shared between the rendered HeightMap and every chunk of the
+terrain, so no vertices or hulls are ever built for it.
+
+The grid is triangulated the same way as HeightMap, each cell (x,z) being split along the diagonal
+from sample (x,z) to sample (x+1,z+1). Anything below the surface is treated as solid ground.
+
+As the terrain is concave it can't be passed through CollisionDetectionSAT, instead contacts are
+generated on demand (See GenConcaveContactPoints) for just the grid cells under the other object's
+bounding box. Spheres are tested against each triangle, cuboids (and any other convex shape) are
+tested by their corners against the surface directly below them.
+
+A large terrain should be split into several chunks (See CommonUtils::BuildHeightFieldObjects), each
+with it's own PhysicsNode positioned at the chunk's centre, so the broadphase only ever sees a handful
+of bounding spheres. The PhysicsNode's orientation is ignored - the terrain is always y-up.
+
+*//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "CollisionShape.h"
+#include <nclgl/common.h>
+#include <memory>
+
+class HeightFieldCollisionShape : public CollisionShape
+{
+public:
+	//heights			- Shared array of num_samples_x * num_samples_z heights, indexed [x * num_samples_z + z]
+	//spacing_x/z		- Distance between neighbouring samples
+	//first_cell_x/z	- First grid cell (and number of cells) covered by this chunk of the terrain
+	HeightFieldCollisionShape(
+		std::shared_ptr<const std::vector<float>> heights,
+		uint num_samples_x,
+		uint num_samples_z,
+		float spacing_x,
+		float spacing_z,
+		uint first_cell_x,
+		uint first_cell_z,
+		uint num_cells_x,
+		uint num_cells_z);
+	virtual ~HeightFieldCollisionShape();
+
+	//Centre of the chunk's bounding box relative to sample (0,0) of the terrain. The parent PhysicsNode
+	// must be placed at <terrain position> + GetChunkCentre().
+	const Vector3& GetChunkCentre() const { return chunkCentre; }
+
+	//Height and (upward facing) surface normal of the terrain at the given world space x/z, returns
+	// false if the point is not above this chunk
+	bool GetSurfaceAt(const Vector3& pos, float& out_height, Vector3& out_normal) const;
+
+	// Bounding radius is derived from the chunk's extents
+	virtual void	SetRadius(float radius) override {}
+	virtual float	GetRadius() const override { return m_Radius; }
+
+	// Debug Collision Shape
+	virtual void DebugDraw() const override;
+
+	// Terrain is always static, so has no rotational mass
+	virtual Matrix3 BuildInverseInertia(float invMass) const override;
+
+
+	// Generic Collision Detection Routines
+	//  - The terrain is concave, so these only describe the chunk's bounding box and are never
+	//    used by the narrowphase (See GenConcaveContactPoints)
+	virtual void GetCollisionAxes(
+		const PhysicsNode* otherObject,
+		std::vector<Vector3>& out_axes) const override;
+
+	virtual Vector3 GetClosestPoint(const Vector3& point) const override;
+
+	virtual void GetMinMaxVertexOnAxis(
+		const Vector3& axis,
+		Vector3& out_min,
+		Vector3& out_max) const override;
+
+	virtual void GetIncidentReferencePolygon(
+		const Vector3& axis,
+		std::list<Vector3>& out_face,
+		Vector3& out_normal,
+		std::vector<Plane>& out_adjacent_planes) const override;
+
+
+	// Concave Collision Detection
+	virtual bool IsConcave() const override { return true; }
+	virtual void GenConcaveContactPoints(const PhysicsNode* otherObject, Manifold* out_manifold) const override;
+
+
+	// Spatial Queries
+	//  - Sphere casts offset each triangle by the sphere radius, so are slightly optimistic around
+	//    sharp ridges. Box overlaps are tested against each cell's height range.
+	virtual bool RayCast(
+		const Vector3& origin,
+		const Vector3& dir,
+		float max_dist,
+		float inflate,
+		float& out_dist,
+		Vector3& out_normal) const override;
+
+	virtual bool OverlapsSphere(const Vector3& centre, float radius) const override;
+	virtual bool OverlapsBox(const Vector3& centre, const Vector3& half_dims) const override;
+
+protected:
+	inline float GetSampleHeight(uint x, uint z) const { return (*heights)[x * numSamplesZ + z]; }
+
+	//World space position of sample (0,0)
+	Vector3 GetGridOrigin() const;
+
+	//Inclusive range of this chunk's cells that overlap the given world space box on x/z,
+	// returns false if the box misses the chunk or is entirely above it
+	bool GetCellRange(const Vector3& world_min, const Vector3& world_max, uint& out_x0, uint& out_z0, uint& out_x1, uint& out_z1) const;
+
+	//The two world space triangles of the given cell, both wound so their front face points up
+	void GetCellTriangles(uint cell_x, uint cell_z, Vector3 out_tris[6]) const;
+
+protected:
+	std::shared_ptr<const std::vector<float>> heights;
+	uint	numSamplesX, numSamplesZ;
+	float	spacingX, spacingZ;
+
+	uint	firstCellX, firstCellZ;
+	uint	numCellsX, numCellsZ;
+
+	Vector3	chunkCentre;		//Relative to sample (0,0)
+	Vector3	halfExtents;		//Half size of the chunk's bounding box
+};
@@ -1,6 +1,6 @@
 #include "Hull.h"
 #include <algorithm>
-#include <nclgl\NCLDebug.h>
+#include <nclgl/NCLDebug.h>
 
 Hull::Hull()
 {
@@ -24,8 +24,8 @@ so you could represent your mesh as a series of triangles, pentagons, quads etc
 
 #pragma once
 
-#include <nclgl\Vector3.h>
-#include <nclgl\Matrix4.h>
+#include <nclgl/Vector3.h>
+#include <nclgl/Matrix4.h>
 #include <vector>
 
 struct HullEdge;
@@ -72,7 +72,7 @@ public:
 	int AddVertex(const Vector3& v);
 
 	int AddFace(const Vector3& _normal, int nVerts, const int* verts);
-	int AddFace(const Vector3& _normal, const std::vector<int>& vert_ids) { AddFace(_normal, (int)vert_ids.size(), &vert_ids[0]); }
+	int AddFace(const Vector3& _normal, const std::vector<int>& vert_ids) { return AddFace(_normal, (int)vert_ids.size(), &vert_ids[0]); }
 
 
 	void RemoveFace(int faceidx);
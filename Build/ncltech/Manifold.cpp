@@ -1,12 +1,14 @@
 #include "Manifold.h"
-#include <nclgl\Matrix3.h>
-#include <nclgl\NCLDebug.h>
+#include <nclgl/Matrix3.h>
+#include <nclgl/NCLDebug.h>
 #include "PhysicsEngine.h"
 #include <algorithm>
 
 Manifold::Manifold()
 	: pnodeA(NULL)
 	, pnodeB(NULL)
+	, solverIterations(SOLVER_ITERATIONS)
+	, applyFriction(true)
 {
 }
 
@@ -66,6 +68,9 @@ void Manifold::SolveContactPoint(ContactPoint& c)
 	}
 
 	//Friction
+	if (!applyFriction)
+		return;
+
 	Vector3 tangent = dv - c.colNormal * Vector3::Dot(dv, c.colNormal);
 	float tangent_len = tangent.Length();
 
@@ -99,17 +104,17 @@ void Manifold::SolveContactPoint(ContactPoint& c)
 	}
 }
 
-void Manifold::PreSolverStep(float dt)
+void Manifold::PreSolverStep(float dt, PhysicsRandom& random)
 {
-	std::random_shuffle(contactPoints.begin(), contactPoints.end());
+	random.Shuffle(contactPoints);
 
 	for (ContactPoint& contact : contactPoints)
 	{
-		UpdateConstraint(contact);
+		UpdateConstraint(contact, dt);
 	}
 }
 
-void Manifold::UpdateConstraint(ContactPoint& c)
+void Manifold::UpdateConstraint(ContactPoint& c, float dt)
 {
 	//Reset total impulse forces computed this physics timestep 
 	c.sumImpulseContact = 0.0f;
@@ -124,7 +129,7 @@ void Manifold::UpdateConstraint(ContactPoint& c)
 	const float bumgarte_slop = 0.001f;
 	const float penetration_slop = min(c.colPenetration + bumgarte_slop, 0.0f);
 
-	c.b_term += -(bumgarte_scalar / PhysicsEngine::Instance()->GetDeltaTime()) * penetration_slop;
+	c.b_term += -(bumgarte_scalar / dt) * penetration_slop;
 
 	const float elasticity = pnodeA->GetElasticity() * pnodeB->GetElasticity();
 
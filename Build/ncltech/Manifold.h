@@ -19,7 +19,8 @@ additional energy to the system (elasticity) or negate existing velocity (fricti
 #pragma once
 
 #include "PhysicsNode.h"
-#include <nclgl\Vector3.h>
+#include "PhysicsRandom.h"
+#include <nclgl/Vector3.h>
 
 /* A contact constraint is actually the summation of a distance constraint to handle the main collision (normal)
 along with two friction constraints going along the axes perpendicular to the collision
@@ -61,7 +62,7 @@ public:
 
 	//Sequentially solves each contact constraint
 	void ApplyImpulse();
-	void PreSolverStep(float dt);
+	void PreSolverStep(float dt, PhysicsRandom& random);	//Contacts are shuffled by the world's random generator
 
 
 	//Debug draws the manifold surface area
@@ -73,10 +74,14 @@ public:
 
 protected:
 	void SolveContactPoint(ContactPoint& c);
-	void UpdateConstraint(ContactPoint& c);
+	void UpdateConstraint(ContactPoint& c, float dt);
 
 public:
 	PhysicsNode*				pnodeA;
 	PhysicsNode*				pnodeB;
 	std::vector<ContactPoint>	contactPoints;
+
+	//Solver detail, lowered for distant objects (See PhysicsEngine::SetLODPolicy)
+	uint						solverIterations;	//Number of solver iterations this manifold takes part in
+	bool						applyFriction;
 };
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "NetworkBase.h"
-#include <nclgl\NCLDebug.h>
+#include <nclgl/NCLDebug.h>
+#include <nclgl/Profiler.h>
 
 NetworkBase::NetworkBase()
 	: m_pNetwork(NULL)
@@ -115,6 +116,8 @@ void NetworkBase::EnqueuePacket(ENetPeer* peer, PacketTransportType transport_ty
 //			ENET_EVENT_TYPE_DISCONNECT, returned when a peer is disconnected
 void NetworkBase::ServiceNetwork(float dt, std::function<void(const ENetEvent&)> callback)
 {
+	PROFILE_SCOPE("NetworkBase::ServiceNetwork");
+
 	if (m_pNetwork != NULL)
 	{
 		//Handle all incoming packets & send any packets awaiting dispatch
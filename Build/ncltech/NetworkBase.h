@@ -38,7 +38,7 @@ For more information see: http://enet.bespin.org/Features.html
 *//////////////////////////////////////////////////////////////////////////////
 
 #pragma once
-#include <enet\enet.h>
+#include <enet/enet.h>
 #include <stdint.h>
 #include <functional>
 
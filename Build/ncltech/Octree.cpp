@@ -6,17 +6,17 @@ Octree::Octree(Vector3 origin, Vector3 range) {
 }
 
 Octree::~Octree() {
+	//The objects are owned by the PhysicsEngine (and may already be deleted), so only the nodes are freed
 	ClearChildren();
-	ClearObjects();
+	objects.clear();
 }
 
 void Octree::ClearChildren() {
-	if (childrenExist) {
-		for (std::vector<PhysicsNode*>::iterator it = objects.begin();it != objects.end();it++) {
-			delete *it;
-		}
-		children.clear();
+	for (Octree* child : children) {
+		delete child;
 	}
+	children.clear();
+	childrenExist = false;
 }
 
 void Octree::ClearObjects() {
@@ -27,63 +27,146 @@ void Octree::ClearObjects() {
 }
 
 void Octree::CreateChildren() {
-	std::map<Octree*, std::vector<PhysicsNode*>> sendMap;
-	if (!childrenExist) {
-
-		for (int i = 0; i < 2; i++) {
-			for (int j = 0; j < 2; j++) {
-				for (int k = 0; k < 2; k++) {
-					Octree* child = new Octree(origin + Vector3(range.x * 0.5 * i,range.y * 0.5f * j,range.z * 0.5f * k), range/2.0f);
-					child->AddParent(this);
-					child->parentExist = true;
-					children.push_back(child);
-				}
-			}
-		}
-		childrenExist = true;
-	}
-	for (std::vector<PhysicsNode*>::iterator it = objects.begin();it != objects.end();it++) {
-		Vector3 position = (*it)->GetPosition();
-		for (std::vector<Octree*>::iterator jt = children.begin(); jt != children.end(); jt++) {
-			Vector3 origin = (*jt)->getOrigin();
-			Vector3 range = (*jt)->getRange();
-			vector<PhysicsNode*> xlx;
-			sendMap.insert(std::pair<Octree*, std::vector<PhysicsNode*>>(*jt, xlx));
-			if (position.x > origin.x &&
-				position.x < origin.x + range.x &&
-				position.y > origin.y &&
-				position.y < origin.y + range.y &&
-				position.z > origin.z &&
-				position.z < origin.z + range.z) {
-				float radius = (*it)->GetCollisionShape()->GetRadius();
-				if ((position.x - radius > origin.x &&
-					position.x + radius < origin.x + range.x&&
-					position.y - radius > origin.y &&
-					position.y + radius < origin.y + range.y &&
-					position.z - radius > origin.z &&
-					position.z + radius < origin.z + range.z
-					)) {
-					sendMap.at(*jt).push_back(*it);
-				}
+	BuildChildren();
+	PushDownObjects();
+	for (Octree* child : children) {
+		if (child->objects.size() > MAXOBJECTS) child->CreateChildren();
+	}
+}
+
+void Octree::BuildChildren() {
+	if (childrenExist) return;
+
+	for (int i = 0; i < 2; i++) {
+		for (int j = 0; j < 2; j++) {
+			for (int k = 0; k < 2; k++) {
+				Octree* child = new Octree(origin + Vector3(range.x * 0.5 * i,range.y * 0.5f * j,range.z * 0.5f * k), range/2.0f);
+				child->AddParent(this);
+				child->parentExist = true;
+				children.push_back(child);
 			}
 		}
 	}
-	for (std::vector<Octree*>::iterator it = children.begin(); it != children.end(); it++) {
-		(*it)->AddObjects(sendMap.at(*it));
-		for (std::vector<PhysicsNode*>::iterator jt = sendMap.at(*it).begin(); jt != sendMap.at(*it).end(); jt++) {
-			objects.erase(std::remove(objects.begin(), objects.end(), (*jt)), objects.end());
-		}
+	childrenExist = true;
+}
+
+void Octree::PushDownObjects() {
+	//An object can only fit inside the child it's centre is in, so each object is tested once and
+	// the ones staying here are compacted in place rather than searched for and erased one at a time
+	size_t kept = 0;
+	for (size_t i = 0; i < objects.size(); i++) {
+		PhysicsNode* p = objects[i];
+		Octree* child = children[ChildIndex(p->GetPosition())];
+		if (child->FitsInside(p)) child->StoreObject(p);
+		else objects[kept++] = p;
 	}
-	//cout << endl;
+	objects.resize(kept);
 }
 
 void Octree::AddObjects(std::vector<PhysicsNode*> p) {
 	for (std::vector<PhysicsNode*>::iterator it = p.begin();it != p.end();it++) {
-		objects.push_back(*it);
+		StoreObject(*it);
 	}
 	if (objects.size() > MAXOBJECTS) CreateChildren();
 }
 
+void Octree::BulkLoad(const std::vector<PhysicsNode*>& p) {
+	if (p.empty()) return;
+
+	//Quantize each position within our bounds and interleave the bits as x,y,z so that
+	// the top 3 bits pick the child at depth 0, the next 3 at depth 1 and so on
+	// (matching the i * 4 + j * 2 + k order the children are created in)
+	std::vector<MortonEntry> entries(p.size());
+	for (size_t i = 0; i < p.size(); ++i) {
+		entries[i].node = p[i];
+		entries[i].code = GeometryUtils::MortonCode(p[i]->GetPosition(), origin, range);
+	}
+
+	std::sort(entries.begin(), entries.end(), [](const MortonEntry& a, const MortonEntry& b) { return a.code < b.code; });
+
+	BulkInsert(&entries[0], &entries[0] + entries.size(), 0);
+
+	//Objects are only stored at the bottom of their run, so the nodes above them still need to cover them
+	Refit();
+}
+
+void Octree::BulkInsert(MortonEntry* begin, MortonEntry* end, uint depth) {
+	//Same rule as AddObjects, only split once there are too many objects to keep here
+	const size_t count = end - begin;
+	if (objects.size() + count <= MAXOBJECTS || depth >= OCTREE_MORTON_BITS) {
+		for (MortonEntry* it = begin; it != end; it++) StoreObject(it->node);
+		return;
+	}
+
+	//Builds the children if needed and pushes down any objects already stored here. They are not split
+	// any further yet, each child's BulkInsert counts them along with it's run of new objects instead.
+	BuildChildren();
+	PushDownObjects();
+
+	const uint shift = 3 * (OCTREE_MORTON_BITS - 1 - depth);
+	MortonEntry* runStart = begin;
+	while (runStart != end) {
+		const uint octant = (uint)(runStart->code >> shift) & 7;
+		MortonEntry* runEnd = runStart;
+		while (runEnd != end && ((uint)(runEnd->code >> shift) & 7) == octant) runEnd++;
+
+		//Objects overlapping the edge of the child stay in this node (Partition is stable, so both halves stay sorted)
+		Octree* child = children[octant];
+		MortonEntry* fitsEnd = std::stable_partition(runStart, runEnd, [child](const MortonEntry& e) { return child->FitsInside(e.node); });
+		for (MortonEntry* it = fitsEnd; it != runEnd; it++) StoreObject(it->node);
+
+		child->BulkInsert(runStart, fitsEnd, depth + 1);
+		runStart = runEnd;
+	}
+}
+
+bool Octree::FitsInside(PhysicsNode* p) const {
+	Vector3 position = p->GetPosition();
+	float radius = p->GetCollisionShape() ? p->GetCollisionShape()->GetRadius() : 0.0f;
+	return position.x - radius > origin.x &&
+		position.x + radius < origin.x + range.x &&
+		position.y - radius > origin.y &&
+		position.y + radius < origin.y + range.y &&
+		position.z - radius > origin.z &&
+		position.z + radius < origin.z + range.z;
+}
+
+void Octree::ExpandBounds(const PhysicsNode* p) {
+	const Vector3& position = p->GetPosition();
+	const float radius = p->GetCollisionShape() ? p->GetCollisionShape()->GetRadius() : 0.0f;
+	boundsMin = Vector3(min(boundsMin.x, position.x - radius), min(boundsMin.y, position.y - radius), min(boundsMin.z, position.z - radius));
+	boundsMax = Vector3(max(boundsMax.x, position.x + radius), max(boundsMax.y, position.y + radius), max(boundsMax.z, position.z + radius));
+}
+
+void Octree::GrowBounds(const PhysicsNode* p) {
+	for (Octree* node = this; node != NULL; node = node->parentExist ? node->parent : NULL) {
+		node->ExpandBounds(p);
+	}
+}
+
+void Octree::Refit() {
+	ResetBounds();
+	for (PhysicsNode* p : objects) {
+		ExpandBounds(p);
+	}
+	for (Octree* child : children) {
+		child->Refit();
+		if (child->HasBounds()) {
+			boundsMin = Vector3(min(boundsMin.x, child->boundsMin.x), min(boundsMin.y, child->boundsMin.y), min(boundsMin.z, child->boundsMin.z));
+			boundsMax = Vector3(max(boundsMax.x, child->boundsMax.x), max(boundsMax.y, child->boundsMax.y), max(boundsMax.z, child->boundsMax.z));
+		}
+	}
+}
+
+void Octree::RemoveObject(PhysicsNode* p) {
+	std::vector<PhysicsNode*>::iterator found = std::find(objects.begin(), objects.end(), p);
+	if (found != objects.end()) {
+		*found = objects.back();
+		objects.pop_back();
+	}
+	p->octreeNode = NULL;
+}
+
 void Octree::SetChildrenObjects() {
 	childrenObjects.clear();
 	if (childrenExist) {
@@ -120,7 +203,7 @@ void Octree::DebugDraw() {
 
 void Octree::SendUp() {
 	if (parentExist) {
-		vector<PhysicsNode*> sendMap;
+		std::vector<PhysicsNode*> sendMap;
 		for (std::vector<PhysicsNode*>::iterator it = objects.begin();it != objects.end();it++) {
 			Vector3 position = (*it)->GetPosition();
 
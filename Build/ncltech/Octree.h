@@ -1,14 +1,19 @@
 #pragma once
 
-#include <nclgl\Vector4.h>
+#include <nclgl/Vector4.h>
 #include <vector>
-#include <ncltech\PhysicsNode.h>
+#include <ncltech/PhysicsNode.h>
+#include <ncltech/GeometryUtils.h>
 #include <map>
 #include <algorithm>
-#include <nclgl\NCLDebug.h>
+#include <nclgl/NCLDebug.h>
 
 #define MAXOBJECTS 5
 
+//Number of bits per axis used by the morton codes in BulkLoad (See GeometryUtils::MortonCode),
+// which also limits the depth of the tree it builds
+#define OCTREE_MORTON_BITS MORTON_CODE_BITS
+
 class Octree {
 public:
 	Octree(Vector3, Vector3);
@@ -25,20 +30,86 @@ public:
 
 	void AddObjects(std::vector<PhysicsNode*> p);
 	void AddObject(PhysicsNode* p) {
-		objects.push_back(p);
+		StoreObject(p);
 		CreateChildren();
 	}
+
+	//Removes the object from this node, in O(1) for the usual handful of objects per node
+	// - Call on p->octreeNode (See PhysicsEngine::RemovePhysicsObject)
+	void RemoveObject(PhysicsNode* p);
+	//Inserts a whole batch of objects in a single top-down pass, rather than
+	// redistributing the tree once per object as AddObject does.
+	// The objects are sorted by morton code, so the objects belonging to each
+	// child are always a contiguous run and each level is a single linear scan.
+	void BulkLoad(const std::vector<PhysicsNode*>& p);
+
 	void SetChildrenObjects();
 
-	std::vector<PhysicsNode*> GetObjects() { return objects; }
+	const std::vector<PhysicsNode*>& GetObjects() const { return objects; }
 	std::vector<PhysicsNode*> *GetChildrenObjects() { return &childrenObjects; }
-	std::vector<Octree*> GetChildren() { return children; }
+	const std::vector<Octree*>& GetChildren() const { return children; }
+
+	//Calls objectFunc on every object in this node, and recurses into each child whose
+	// fitted bounds (See Refit) pass nodeTest(min, max - min). The caller decides whether to
+	// visit this node, as the root also holds any objects outside of it's bounds.
+	// Read only, so any number of queries can traverse the tree at once.
+	template <typename NodeTest, typename ObjectFunc>
+	void Query(const NodeTest& nodeTest, const ObjectFunc& objectFunc) const {
+		for (PhysicsNode* p : objects) objectFunc(p);
+		for (const Octree* child : children) {
+			if (child->HasBounds() && nodeTest(child->boundsMin, child->boundsMax - child->boundsMin)) child->Query(nodeTest, objectFunc);
+		}
+	}
+
+	//Fits the bounds of every node to the current positions of the objects stored in it and it's children.
+	// - Objects only move to a better fitting node once per step (See SendUp), so Query tests these rather
+	//   than the node's own cell, which the objects may have already left
+	void Refit();
+
+	//Grows the bounds of this node and it's parents to cover the object's current position
+	void GrowBounds(const PhysicsNode* p);
 
 	bool HasChildren() { return childrenExist; }
 
 	void DebugDraw();
 	void SendUp();
 private:
+	struct MortonEntry
+	{
+		unsigned long long	code;
+		PhysicsNode*		node;
+	};
+
+	void BulkInsert(MortonEntry* begin, MortonEntry* end, uint depth);
+
+	//All objects are stored through this, so each object knows which node it is in
+	// - Objects are only ever moved between a node and it's parent/children, whose bounds
+	//   already cover them, so only this node's bounds need growing
+	inline void StoreObject(PhysicsNode* p) {
+		objects.push_back(p);
+		p->octreeNode = this;
+		ExpandBounds(p);
+	}
+	bool FitsInside(PhysicsNode* p) const;
+
+	//CreateChildren split into it's two halves, so BulkInsert can push down the objects
+	// already here without redistributing the children it is about to fill anyway
+	void BuildChildren();
+	void PushDownObjects();
+
+	//Index of the child containing the position, in the i * 4 + j * 2 + k order they are created in
+	inline uint ChildIndex(const Vector3& position) const {
+		return (position.x > origin.x + range.x * 0.5f ? 4 : 0) +
+			(position.y > origin.y + range.y * 0.5f ? 2 : 0) +
+			(position.z > origin.z + range.z * 0.5f ? 1 : 0);
+	}
+
+	inline bool HasBounds() const { return boundsMin.x <= boundsMax.x; }
+	inline void ResetBounds() {
+		boundsMin = Vector3(FLT_MAX, FLT_MAX, FLT_MAX);
+		boundsMax = Vector3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	}
+	void ExpandBounds(const PhysicsNode* p);
 
 
 	/*
@@ -66,4 +137,7 @@ private:
 	Vector3 origin;
 	Vector3 range;
 
+	//Box around every object in this node and it's children (empty if min > max)
+	Vector3 boundsMin = Vector3(FLT_MAX, FLT_MAX, FLT_MAX);
+	Vector3 boundsMax = Vector3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
 };
\ No newline at end of file
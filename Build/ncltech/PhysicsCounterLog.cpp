@@ -0,0 +1,138 @@
+#include "PhysicsCounterLog.h"
+#include <nclgl/NCLDebug.h>
+#include <cstring>
+
+PhysicsCounterLog::PhysicsCounterLog(uint capacity)
+	: first(0)
+	, numSteps(0)
+	, nextStepIndex(0)
+	, logFile(NULL)
+{
+	memset(&lastStep, 0, sizeof(PhysicsStepCounters));
+	steps.resize(max(capacity, 1u));
+}
+
+PhysicsCounterLog::~PhysicsCounterLog()
+{
+	CloseLogFile();
+}
+
+void PhysicsCounterLog::Record(const PhysicsStepCounters& counters)
+{
+	lastStep = counters;
+	lastStep.step = nextStepIndex++;
+
+	const uint capacity = (uint)steps.size();
+	if (numSteps < capacity)
+	{
+		steps[(first + numSteps) % capacity] = lastStep;
+		numSteps++;
+	}
+	else
+	{
+		steps[first] = lastStep;
+		first = (first + 1) % capacity;
+	}
+
+	if (logFile)
+	{
+		WriteCSVRow(logFile, lastStep);
+	}
+}
+
+void PhysicsCounterLog::Clear()
+{
+	first = 0;
+	numSteps = 0;
+}
+
+void PhysicsCounterLog::SetCapacity(uint capacity)
+{
+	steps.clear();
+	steps.resize(max(capacity, 1u));
+	Clear();
+}
+
+void PhysicsCounterLog::WriteCSVHeader(FILE* file)
+{
+	fputs("step,broadphase_pairs,sat_axes_tested,sat_early_outs,manifolds,contacts,solver_iterations,awake_bodies,allocations,"
+		"broadphase_ms,narrowphase_ms,integration_ms,solver_ms,soft_body_ms\n", file);
+}
+
+void PhysicsCounterLog::WriteCSVRow(FILE* file, const PhysicsStepCounters& c)
+{
+	fprintf(file, "%u,%u,%u,%u,%u,%u,%u,%u,%u,%.4f,%.4f,%.4f,%.4f,%.4f\n",
+		c.step, c.broadphasePairs, c.satAxesTested, c.satEarlyOuts,
+		c.manifolds, c.contacts, c.solverIterations, c.awakeBodies, c.allocations,
+		c.broadphaseMs, c.narrowphaseMs, c.integrationMs, c.solverMs, c.softBodyMs);
+}
+
+bool PhysicsCounterLog::ExportCSV(const std::string& filename) const
+{
+	FILE* file = NULL;
+	if (fopen_s(&file, filename.c_str(), "w") || !file)
+	{
+		NCLDebug::Log("[PhysicsCounterLog] - Unable to open \"%s\" for writing", filename.c_str());
+		return false;
+	}
+
+	WriteCSVHeader(file);
+	for (uint i = 0; i < numSteps; ++i)
+	{
+		WriteCSVRow(file, GetStep(i));
+	}
+
+	fclose(file);
+	return true;
+}
+
+bool PhysicsCounterLog::ExportJSON(const std::string& filename) const
+{
+	FILE* file = NULL;
+	if (fopen_s(&file, filename.c_str(), "w") || !file)
+	{
+		NCLDebug::Log("[PhysicsCounterLog] - Unable to open \"%s\" for writing", filename.c_str());
+		return false;
+	}
+
+	fputs("{\n\t\"steps\": [\n", file);
+	for (uint i = 0; i < numSteps; ++i)
+	{
+		const PhysicsStepCounters& c = GetStep(i);
+		fprintf(file, "\t\t{ \"step\": %u, \"broadphase_pairs\": %u, \"sat_axes_tested\": %u, \"sat_early_outs\": %u, "
+			"\"manifolds\": %u, \"contacts\": %u, \"solver_iterations\": %u, \"awake_bodies\": %u, \"allocations\": %u, "
+			"\"broadphase_ms\": %.4f, \"narrowphase_ms\": %.4f, \"integration_ms\": %.4f, \"solver_ms\": %.4f, \"soft_body_ms\": %.4f }%s\n",
+			c.step, c.broadphasePairs, c.satAxesTested, c.satEarlyOuts,
+			c.manifolds, c.contacts, c.solverIterations, c.awakeBodies, c.allocations,
+			c.broadphaseMs, c.narrowphaseMs, c.integrationMs, c.solverMs, c.softBodyMs,
+			(i + 1 < numSteps) ? "," : "");
+	}
+	fputs("\t]\n}\n", file);
+
+	fclose(file);
+	return true;
+}
+
+bool PhysicsCounterLog::OpenLogFile(const std::string& filename)
+{
+	CloseLogFile();
+
+	if (fopen_s(&logFile, filename.c_str(), "w") || !logFile)
+	{
+		NCLDebug::Log("[PhysicsCounterLog] - Unable to open \"%s\" for writing", filename.c_str());
+		logFile = NULL;
+		return false;
+	}
+
+	WriteCSVHeader(logFile);
+	return true;
+}
+
+void PhysicsCounterLog::CloseLogFile()
+{
+	if (logFile)
+	{
+		fclose(logFile);
+		logFile = NULL;
+	}
+}
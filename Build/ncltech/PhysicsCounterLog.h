@@ -0,0 +1,91 @@
+/******************************************************************************
+Class: PhysicsCounterLog
+Implements:
+Author:
+Pieran Marris      <p.marris@newcastle.ac.uk> and YOU!
+Description:
+
+Keeps a set of hot-path counters (broadphase pairs, SAT axes, contacts etc) and stage timings for every
+physics step in a fixed size ring buffer, so the last few seconds of simulation can be
+inspected or exported to CSV/JSON at any point without the log growing forever.
+
+For headless runs (benchmarks, servers etc) a log file can also be opened, in which case each
+step is appended to it as a CSV row as soon as it is recorded, regardless of the ring buffer size.
+
+*//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <nclgl/common.h>
+#include <vector>
+#include <string>
+#include <cstdio>
+
+struct PhysicsStepCounters
+{
+	uint	step;				//Index of the step since the log was created
+	uint	broadphasePairs;	//Pairs handed to the narrowphase
+	uint	satAxesTested;		//Axes projected by CollisionDetectionSAT
+	uint	satEarlyOuts;		//Pairs rejected by SAT finding a separating axis
+	uint	manifolds;			//Manifolds kept for the solver
+	uint	contacts;			//Contact points across all kept manifolds
+	uint	solverIterations;
+	uint	awakeBodies;		//Dynamic bodies that moved this step
+	uint	allocations;		//Manifolds allocated, including those discarded for having no contacts
+
+	//Time spent in each stage of the step (milliseconds)
+	float	broadphaseMs;
+	float	narrowphaseMs;
+	float	integrationMs;		//Velocity and position integration combined
+	float	solverMs;
+	float	softBodyMs;
+};
+
+class PhysicsCounterLog
+{
+public:
+	PhysicsCounterLog(uint capacity = 600);
+	~PhysicsCounterLog();
+
+	//Adds a step to the ring buffer (overwriting the oldest if full), and the log file if one is open
+	void Record(const PhysicsStepCounters& counters);
+
+	//Removes all recorded steps, the step index carries on from where it was
+	void Clear();
+
+	//Resizes the ring buffer, discarding any recorded steps
+	void SetCapacity(uint capacity);
+	inline uint GetCapacity() const { return (uint)steps.size(); }
+
+	//Recorded steps, GetStep(0) being the oldest
+	inline uint GetNumSteps() const { return numSteps; }
+	inline const PhysicsStepCounters& GetStep(uint idx) const { return steps[(first + idx) % steps.size()]; }
+	inline const PhysicsStepCounters& GetLastStep() const { return lastStep; }
+
+	//Index to be given to the next recorded step
+	inline uint GetNextStepIndex() const { return nextStepIndex; }
+
+
+	//Writes every step currently in the ring buffer, returns false if the file couldn't be opened
+	bool ExportCSV(const std::string& filename) const;
+	bool ExportJSON(const std::string& filename) const;
+
+
+	//Headless logging - every step recorded while the file is open is appended to it as CSV
+	bool OpenLogFile(const std::string& filename);
+	void CloseLogFile();
+	inline bool IsLogFileOpen() const { return logFile != NULL; }
+
+protected:
+	static void WriteCSVHeader(FILE* file);
+	static void WriteCSVRow(FILE* file, const PhysicsStepCounters& counters);
+
+protected:
+	std::vector<PhysicsStepCounters> steps;
+	uint	first;			//Oldest step in the ring buffer
+	uint	numSteps;
+	uint	nextStepIndex;
+
+	PhysicsStepCounters	lastStep;
+	FILE*				logFile;
+};
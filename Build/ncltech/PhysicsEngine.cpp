@@ -1,10 +1,156 @@
 #include "PhysicsEngine.h"
+#ifndef USE_HEADLESS_PHYSICS
 #include "GameObject.h"
+#endif
 #include "CollisionDetectionSAT.h"
-#include <nclgl\NCLDebug.h>
-#include <nclgl\Window.h>
+#include "SphereCollisionShape.h"
+#include "CuboidCollisionShape.h"
+#include "CapsuleCollisionShape.h"
+#include "CompoundCollisionShape.h"
+#include "GeometryUtils.h"
+#include "SnapshotUtils.h"
+#include <nclgl/NCLDebug.h>
+#include <nclgl/Profiler.h>
 #include <omp.h>
 #include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#define PHYSICS_SNAPSHOT_MAGIC		0x504E5350	//'PSNP'
+#define PHYSICS_SNAPSHOT_VERSION	5
+
+//Fixed size header at the start of every snapshot, used to validate the snapshot
+// matches the current world before anything is restored
+// - Only holds plain values, so it can be copied as a whole (See SnapshotUtils::Write)
+struct PhysicsSnapshotHeader
+{
+	uint	magic;
+	uint	version;
+	uint	numPhysicsNodes;
+	uint	numConstraints;
+	uint	constraintBytes;
+	uint	numSoftBodies;
+	uint	softBodyBytes;
+	uint	numTriggerPairs;
+	uint	numStepContacts;
+
+	float	updateTimestep;
+	float	updateRealTimeAccum;
+	float	dampingFactor;
+	float	gravity[3];
+	uint	stepsSinceReorder;
+	uint	lodStepCount;
+	uint	solverIterations;
+	float	lodDistanceScale;
+
+	unsigned long long	randomState;
+};
+
+//Serialized size of each body, it's PhysicsNodeState followed by it's LOD integration state
+#define PHYSICS_SNAPSHOT_NODE_BYTES		(5 * SNAPSHOT_VECTOR3_BYTES + SNAPSHOT_QUATERNION_BYTES + SNAPSHOT_MATRIX3_BYTES \
+										+ 3 * sizeof(float) + sizeof(float) + sizeof(unsigned char))
+
+//Serialized size of last update's trigger pairs and last step's contacts, which are stored by handle index
+#define PHYSICS_SNAPSHOT_TRIGGER_BYTES	(2 * sizeof(uint))
+#define PHYSICS_SNAPSHOT_CONTACT_BYTES	(2 * sizeof(uint) + 2 * SNAPSHOT_VECTOR3_BYTES + sizeof(float))
+
+static void WriteNodeState(unsigned char*& dst, const PhysicsNodeState& state)
+{
+	SnapshotUtils::Write(dst, state.position);
+	SnapshotUtils::Write(dst, state.linVelocity);
+	SnapshotUtils::Write(dst, state.force);
+	SnapshotUtils::Write(dst, state.invMass);
+	SnapshotUtils::Write(dst, state.orientation);
+	SnapshotUtils::Write(dst, state.angVelocity);
+	SnapshotUtils::Write(dst, state.torque);
+	SnapshotUtils::Write(dst, state.invInertia);
+	SnapshotUtils::Write(dst, state.elasticity);
+	SnapshotUtils::Write(dst, state.friction);
+}
+
+static void ReadNodeState(const unsigned char*& src, PhysicsNodeState& state)
+{
+	SnapshotUtils::Read(src, state.position);
+	SnapshotUtils::Read(src, state.linVelocity);
+	SnapshotUtils::Read(src, state.force);
+	SnapshotUtils::Read(src, state.invMass);
+	SnapshotUtils::Read(src, state.orientation);
+	SnapshotUtils::Read(src, state.angVelocity);
+	SnapshotUtils::Read(src, state.torque);
+	SnapshotUtils::Read(src, state.invInertia);
+	SnapshotUtils::Read(src, state.elasticity);
+	SnapshotUtils::Read(src, state.friction);
+}
+
+//Bodies are ordered by their handle slots rather than their pointers, so the order only depends on the
+// order the bodies were added/removed in and is the same on every run
+static inline bool NodeLess(const PhysicsNode* l, const PhysicsNode* r)
+{
+	return l->GetHandle().index < r->GetHandle().index;
+}
+
+static inline bool HandleLess(const PhysicsHandle& l, const PhysicsHandle& r)
+{
+	return (l.index != r.index) ? l.index < r.index : l.generation < r.generation;
+}
+
+//Pairs are ordered by their objects, so the same two objects always end up next to each other once sorted
+// - Broadphase pairs only ever hold live objects, so can be compared through them
+static inline bool PairLess(const CollisionPair& l, const CollisionPair& r)
+{
+	return (l.pObjectA != r.pObjectA) ? NodeLess(l.pObjectA, r.pObjectA) : NodeLess(l.pObjectB, r.pObjectB);
+}
+
+static inline bool PairEqual(const CollisionPair& l, const CollisionPair& r)
+{
+	return l.pObjectA == r.pObjectA && l.pObjectB == r.pObjectB;
+}
+
+// - Pairs kept between steps may outlive their objects, so are compared by the handles they were found with
+template <typename PairType>
+static inline bool PairLess(const PairType& l, const PairType& r)
+{
+	return (l.handleA != r.handleA) ? HandleLess(l.handleA, r.handleA) : HandleLess(l.handleB, r.handleB);
+}
+
+template <typename PairType>
+static inline bool PairEqual(const PairType& l, const PairType& r)
+{
+	return l.handleA == r.handleA && l.handleB == r.handleB;
+}
+
+template <typename PairType>
+static void SortUniquePairs(std::vector<PairType>& pairs)
+{
+	//The broadphase can report the same pair more than once (e.g. objects straddling octree nodes)
+	std::sort(pairs.begin(), pairs.end(), [](const PairType& l, const PairType& r) { return PairLess(l, r); });
+	pairs.erase(std::unique(pairs.begin(), pairs.end(),
+		[](const PairType& l, const PairType& r) { return PairEqual(l, r); }),
+		pairs.end());
+}
+
+//Walks two sorted pair lists in a single merge pass, calling pairFunc(pair, in_curr, in_prev) once for every pair in either list
+template <typename PairType, typename PairFunc>
+static void DiffSortedPairs(const std::vector<PairType>& curr, const std::vector<PairType>& prev, const PairFunc& pairFunc)
+{
+	size_t i = 0, j = 0;
+	while (i < curr.size() || j < prev.size())
+	{
+		if (j == prev.size() || (i < curr.size() && PairLess(curr[i], prev[j])))
+		{
+			pairFunc(curr[i++], true, false);
+		}
+		else if (i == curr.size() || PairLess(prev[j], curr[i]))
+		{
+			pairFunc(prev[j++], false, true);
+		}
+		else
+		{
+			pairFunc(curr[i++], true, true);
+			j++;
+		}
+	}
+}
 
 
 void PhysicsEngine::SetDefaults()
@@ -14,176 +160,1087 @@ void PhysicsEngine::SetDefaults()
 	updateRealTimeAccum = 0.0f;
 	gravity = Vector3(0.0f, -9.81f, 0.0f);
 	dampingFactor = 0.999f;
+	contactListeners.clear();
+
+	lodPolicy = PhysicsLODPolicy();
+	lodInterestPoints.clear();
+	lodStepCount = 0;
+
+	//The budget itself is kept between scenes, but any degradation is not
+	lodDistanceScale = 1.0f;
+	solverIterations = SOLVER_ITERATIONS;
+	avgStepCost = 0.0f;
+	memset(&budgetStats, 0, sizeof(PhysicsBudgetStats));
+
+	stepsSinceReorder = 0;
+	random.Seed(randomSeed);
 }
 
 PhysicsEngine::PhysicsEngine()
 {
 	//Variables set here will /not/ be reset with each scene
 	isPaused = false;
+	stepBudgetMs = 0.0f;
+	maxStepLag = 0.25f;
 	//debugDrawFlags = DEBUGDRAW_FLAGS_MANIFOLD | DEBUGDRAW_FLAGS_CONSTRAINT | DEBUGDRAW_FLAGS_COLLISIONNORMALS | DEBUGDRAW_FLAGS_COLLISIONVOLUMES;
 	//debugDrawFlags = DEBUGDRAW_FLAGS_MANIFOLD | DEBUGDRAW_FLAGS_CONSTRAINT;
 	//debugDrawFlags = DEBUGDRAW_FLAGS_CONSTRAINT;
+	debugDrawFlags = 0;
+	broadphaseMethod = BROADPHASE_OCTREE;
+	isDeterministic = false;
+	randomSeed = PHYSICS_RANDOM_DEFAULT_SEED;
+	reorderInterval = 0;	//Experimental, see SetReorderInterval
 
+	//Created by each scene to fit it's own bounds
 	//octree = new Octree();
+	octree = NULL;
 
 	SetDefaults();
 }
 
-PhysicsEngine::~PhysicsEngine()
-{
-	RemoveAllPhysicsObjects();
-}
+PhysicsEngine::~PhysicsEngine()
+{
+	RemoveAllPhysicsObjects();
+}
+
+PhysicsHandle PhysicsEngine::AllocateHandle(uint dense_index)
+{
+	uint slot;
+	if (!freeHandleSlots.empty())
+	{
+		slot = freeHandleSlots.back();
+		freeHandleSlots.pop_back();
+	}
+	else
+	{
+		slot = (uint)handleSlots.size();
+		PhysicsHandleSlot new_slot;
+		new_slot.generation = 0;
+		handleSlots.push_back(new_slot);
+	}
+
+	handleSlots[slot].denseIndex = dense_index;
+	return PhysicsHandle(slot, handleSlots[slot].generation);
+}
+
+void PhysicsEngine::AddPhysicsObject(PhysicsNode* obj)
+{
+	obj->handle = AllocateHandle((uint)physicsNodes.size());
+	obj->world = this;
+	physicsNodes.push_back(obj);
+	if(octree)	octree->AddObject(obj);
+}
+
+void PhysicsEngine::AddPhysicsObjects(const std::vector<PhysicsNode*>& objs)
+{
+	physicsNodes.reserve(physicsNodes.size() + objs.size());
+	for (PhysicsNode* obj : objs)
+	{
+		obj->handle = AllocateHandle((uint)physicsNodes.size());
+		obj->world = this;
+		physicsNodes.push_back(obj);
+	}
+	if (octree) octree->BulkLoad(objs);
+}
+
+void PhysicsEngine::RemovePhysicsObject(PhysicsNode* obj)
+{
+	//Objects that were never added (or already removed) have an invalid handle
+	if (obj && GetPhysicsObject(obj->handle) == obj)
+	{
+		RemovePhysicsObject(obj->handle);
+	}
+}
+
+void PhysicsEngine::RemovePhysicsObject(const PhysicsHandle& handle)
+{
+	if (!IsHandleValid(handle))
+		return;
+
+	//Swap the last object into the removed object's place, and point it's handle at the new location
+	PhysicsHandleSlot& slot = handleSlots[handle.index];
+	PhysicsNode* obj = physicsNodes[slot.denseIndex];
+	PhysicsNode* last_obj = physicsNodes.back();
+
+	physicsNodes[slot.denseIndex] = last_obj;
+	handleSlots[last_obj->handle.index].denseIndex = slot.denseIndex;
+	physicsNodes.pop_back();
+
+	//Invalidate any existing handles to the object, and recycle the slot
+	slot.generation++;
+	freeHandleSlots.push_back(handle.index);
+	obj->handle = PhysicsHandle();
+	obj->world = NULL;
+
+	//Remove it from the broadphase at the same time
+	if (obj->octreeNode) obj->octreeNode->RemoveObject(obj);
+
+	//Same swap and pop for it's LOD bucket
+	if (obj->lodLevel < lodBuckets.size() && obj->lodBucketIndex < lodBuckets[obj->lodLevel].size())
+	{
+		std::vector<PhysicsNode*>& bucket = lodBuckets[obj->lodLevel];
+		PhysicsNode* last_in_bucket = bucket.back();
+		bucket[obj->lodBucketIndex] = last_in_bucket;
+		last_in_bucket->lodBucketIndex = obj->lodBucketIndex;
+		bucket.pop_back();
+	}
+	obj->lodBucketIndex = PHYSICS_HANDLE_INVALID_INDEX;
+
+	//Any trigger pairs, contacts or events it was part of are left where they are, the handles stored with them
+	// no longer match it's slot's generation so they are skipped without ever touching the object
+}
+
+void PhysicsEngine::ReorderBodies()
+{
+	stepsSinceReorder = 0;
+	if (physicsNodes.size() < 2)
+		return;
+
+	//Codes are built within the bounds of the bodies themselves, so the full precision
+	// is used however large or small the scene is
+	Vector3 lower = physicsNodes[0]->position;
+	Vector3 upper = lower;
+	for (PhysicsNode* obj : physicsNodes)
+	{
+		const Vector3& p = obj->position;
+		lower = Vector3(min(lower.x, p.x), min(lower.y, p.y), min(lower.z, p.z));
+		upper = Vector3(max(upper.x, p.x), max(upper.y, p.y), max(upper.z, p.z));
+	}
+
+	reorderEntries.resize(physicsNodes.size());
+	for (size_t i = 0; i < physicsNodes.size(); ++i)
+	{
+		reorderEntries[i].code = GeometryUtils::MortonCode(physicsNodes[i]->position, lower, upper - lower);
+		reorderEntries[i].node = physicsNodes[i];
+	}
+
+	//Bodies in the same cell are ordered by handle, so the new order only depends on the bodies and not on the old order
+	std::sort(reorderEntries.begin(), reorderEntries.end(), [](const PhysicsReorderEntry& l, const PhysicsReorderEntry& r)
+	{
+		return (l.code != r.code) ? l.code < r.code : NodeLess(l.node, r.node);
+	});
+
+	for (size_t i = 0; i < physicsNodes.size(); ++i)
+	{
+		PhysicsNode* obj = reorderEntries[i].node;
+		physicsNodes[i] = obj;
+		handleSlots[obj->handle.index].denseIndex = (uint)i;
+	}
+}
+
+bool PhysicsEngine::RestoreBodyOrder(const uint* handle_indices)
+{
+	const size_t num_nodes = physicsNodes.size();
+
+	//Every handle has to belong to a body in the world..
+	reorderEntries.resize(num_nodes);
+	for (size_t i = 0; i < num_nodes; ++i)
+	{
+		const uint index = handle_indices[i];
+		if (index >= handleSlots.size())
+			return false;
+
+		const uint dense_index = handleSlots[index].denseIndex;
+		if (dense_index >= num_nodes || physicsNodes[dense_index]->handle.index != index)
+			return false;
+
+		reorderEntries[i].code = dense_index;
+	}
+
+	//..and no body can be listed twice
+	std::sort(reorderEntries.begin(), reorderEntries.end(),
+		[](const PhysicsReorderEntry& l, const PhysicsReorderEntry& r) { return l.code < r.code; });
+	for (size_t i = 0; i < num_nodes; ++i)
+	{
+		if (reorderEntries[i].code != i)
+			return false;
+	}
+
+	for (size_t i = 0; i < num_nodes; ++i)
+	{
+		reorderEntries[i].node = physicsNodes[handleSlots[handle_indices[i]].denseIndex];
+	}
+	for (size_t i = 0; i < num_nodes; ++i)
+	{
+		PhysicsNode* obj = reorderEntries[i].node;
+		physicsNodes[i] = obj;
+		handleSlots[obj->handle.index].denseIndex = (uint)i;
+	}
+	return true;
+}
+
+void PhysicsEngine::RemoveSoftBody(SoftBody* sb)
+{
+	//Not deleted, the caller owns it again (See AddSoftBody)
+	auto found_loc = std::find(softBodies.begin(), softBodies.end(), sb);
+	if (found_loc != softBodies.end())
+	{
+		softBodies.erase(found_loc);
+	}
+}
+
+void PhysicsEngine::RemoveAllPhysicsObjects()
+{
+	//Delete and remove all constraints/collision manifolds
+	for (Constraint* c : constraints)
+	{
+		delete c;
+	}
+	constraints.clear();
+	solverConstraints.clear();
+
+	for (Manifold* m : manifolds)
+	{
+		delete m;
+	}
+	manifolds.clear();
+
+	for (SoftBody* sb : softBodies)
+	{
+		delete sb;
+	}
+	softBodies.clear();
+
+
+	//Delete and remove all physics objects
+	// - we also need to inform the (possibly) associated game-object
+	//   that the physics object no longer exists
+	for (PhysicsNode* obj : physicsNodes)
+	{
+#ifndef USE_HEADLESS_PHYSICS
+		if (obj->GetParent()) obj->GetParent()->SetPhysics(NULL);
+#endif
+		handleSlots[obj->handle.index].generation++;
+		freeHandleSlots.push_back(obj->handle.index);
+		delete obj;
+	}
+	physicsNodes.clear();
+	lodBuckets.clear();
+
+	//Every node of the octree points at the bodies just deleted, and the next scene creates it's own
+	SAFE_DELETE(octree);
+
+	triggerPairs.clear();
+	prevTriggerPairs.clear();
+	stepContacts.clear();
+	prevStepContacts.clear();
+	contactEvents.clear();
+}
+
+
+void PhysicsEngine::UpdateWorlds(PhysicsEngine* const* worlds, uint num_worlds, float deltaTime)
+{
+	//Worlds can take very different amounts of time to step, so they are handed out one at a time
+#pragma omp parallel for schedule(dynamic, 1)
+	for (int i = 0; i < (int)num_worlds; ++i)
+	{
+		worlds[i]->Update(deltaTime);
+	}
+}
+
+void PhysicsEngine::Update(float deltaTime)
+{
+	PROFILE_SCOPE("PhysicsEngine::Update");
+
+	//The physics engine should run independantly to the renderer
+	// - As our codebase is currently single threaded we just need
+	//   a way of calling "UpdatePhysics()" at regular intervals
+	//   or multiple times a frame if the physics timestep is higher
+	//   than the renderers.
+	const int max_updates_per_frame = 5;
+
+	//Events are only kept until the next update, each substep appends to the buffer
+	contactEvents.clear();
+
+	if (!isPaused)
+	{
+		UpdateLODBuckets();
+
+		updateRealTimeAccum += deltaTime;
+		if (stepBudgetMs > 0.0f && !isDeterministic)
+		{
+			StepWithinBudget();
+		}
+		else
+		{
+			for (int i = 0; (updateRealTimeAccum >= updateTimestep) && i < max_updates_per_frame; ++i)
+			{
+				updateRealTimeAccum -= updateTimestep;
+
+				//Additional IsPaused check here incase physics was paused inside one of it's components for debugging or otherwise
+				if (!isPaused) UpdatePhysics();
+			}
+
+			if (updateRealTimeAccum >= updateTimestep)
+			{
+				NCLDebug::Log("Physics too slow to run in real time!");
+				//Drop Time in the hope that it can continue to run faster the next frame
+				updateRealTimeAccum = 0.0f;
+			}
+		}
+	}
+
+	//Done outside of the isPaused check, so objects moved manually while paused are still displayed
+	SyncRenderTransforms();
+
+	if (!contactEvents.empty()) DispatchContactEvents();
+}
+
+void PhysicsEngine::StepWithinBudget()
+{
+	float spent_ms = 0.0f;
+	uint num_steps = 0;
+	while (updateRealTimeAccum >= updateTimestep && !isPaused)
+	{
+		//Always take at least one step, so the simulation keeps moving however slow each step gets
+		if (num_steps > 0 && spent_ms + avgStepCost > stepBudgetMs)
+			break;
+
+		updateRealTimeAccum -= updateTimestep;
+
+		const std::chrono::steady_clock::time_point step_start = std::chrono::steady_clock::now();
+		UpdatePhysics();
+		const float step_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - step_start).count();
+
+		spent_ms += step_ms;
+		num_steps++;
+		avgStepCost = (avgStepCost > 0.0f) ? avgStepCost * 0.8f + step_ms * 0.2f : step_ms;
+	}
+
+	budgetStats.lastFrameCost = spent_ms;
+	budgetStats.lastFrameSteps = num_steps;
+
+	//Carry any time we couldn't get to into the next frame, so game time only slips if we fall too far behind
+	if (updateRealTimeAccum > maxStepLag)
+	{
+		budgetStats.droppedTime += updateRealTimeAccum - maxStepLag;
+		updateRealTimeAccum = maxStepLag;
+	}
+
+	const bool behind = updateRealTimeAccum >= updateTimestep;
+	const bool over_budget = behind || spent_ms > stepBudgetMs;
+	if (over_budget) budgetStats.overrunFrames++;
+
+	AdjustQualityForBudget(over_budget, !behind && spent_ms < stepBudgetMs * 0.5f);
+}
+
+void PhysicsEngine::AdjustQualityForBudget(bool over_budget, bool spare_time)
+{
+	const float min_lod_distance_scale = 0.25f;
+
+	//Drop quickly to get back within budget, and recover slowly so we don't immediately go back over it.
+	// Solver iterations are given up before LOD distance, and restored after it.
+	if (over_budget)
+	{
+		if (solverIterations > MIN_SOLVER_ITERATIONS)
+			solverIterations = max(solverIterations * 3 / 4, (uint)MIN_SOLVER_ITERATIONS);
+		else
+			lodDistanceScale = max(lodDistanceScale * 0.75f, min_lod_distance_scale);
+	}
+	else if (spare_time)
+	{
+		if (lodDistanceScale < 1.0f)
+			lodDistanceScale = min(lodDistanceScale * 1.05f, 1.0f);
+		else if (solverIterations < SOLVER_ITERATIONS)
+			solverIterations++;
+	}
+}
+
+void PhysicsEngine::SetLODPolicy(const PhysicsLODPolicy& policy)
+{
+	lodPolicy = policy;
+	std::sort(lodPolicy.bands.begin(), lodPolicy.bands.end(),
+		[](const PhysicsLODBand& l, const PhysicsLODBand& r) { return l.maxDistance < r.maxDistance; });
+}
+
+void PhysicsEngine::UpdateLODBuckets()
+{
+	if (!IsLODActive())
+	{
+		//Hand back any time still owed to bodies that were part way through a reduced rate step
+		if (!lodBuckets.empty())
+		{
+			for (PhysicsNode* obj : physicsNodes)
+			{
+				obj->lodLevel = 0;
+				obj->lodBucketIndex = PHYSICS_HANDLE_INVALID_INDEX;
+				obj->lodTimeAccum = 0.0f;
+				obj->lodActive = true;
+			}
+			lodBuckets.clear();
+		}
+		return;
+	}
+
+	const uint num_bands = (uint)lodPolicy.bands.size();
+	lodBuckets.resize(num_bands);
+	for (std::vector<PhysicsNode*>& bucket : lodBuckets) bucket.clear();
+
+	for (PhysicsNode* obj : physicsNodes)
+	{
+		//Static bodies are always stepped, and their level is ignored when building manifolds
+		if (obj->invMass == 0.0f)
+		{
+			obj->lodLevel = num_bands;
+			obj->lodBucketIndex = PHYSICS_HANDLE_INVALID_INDEX;
+			obj->lodTimeAccum = 0.0f;
+			obj->lodActive = true;
+			continue;
+		}
+
+		float min_dist_sq = FLT_MAX;
+		for (const Vector3& point : lodInterestPoints)
+		{
+			const Vector3 diff = obj->position - point;
+			min_dist_sq = min(min_dist_sq, Vector3::Dot(diff, diff));
+		}
+
+		uint level = 0;
+		while (level + 1 < num_bands)
+		{
+			const float band_dist = lodPolicy.bands[level].maxDistance * lodDistanceScale;
+			if (min_dist_sq <= band_dist * band_dist)
+				break;
+			level++;
+		}
+
+		obj->lodLevel = level;
+		obj->lodBucketIndex = (uint)lodBuckets[level].size();
+		lodBuckets[level].push_back(obj);
+	}
+}
+
+void PhysicsEngine::BeginLODStep()
+{
+	lodStepCount++;
+	for (uint level = 0; level < lodBuckets.size(); ++level)
+	{
+		const uint interval = max(lodPolicy.bands[level].updateInterval, 1u);
+		const bool active = ((lodStepCount + level) % interval) == 0;
+		for (PhysicsNode* obj : lodBuckets[level])
+		{
+			obj->lodTimeAccum += updateTimestep;
+			obj->lodActive = active;
+		}
+	}
+
+	//Bodies touching a body that is being stepped are stepped with it, so bodies straddling a band
+	// boundary are still pushed apart. Static bodies are always 'active' so never wake anything.
+	for (const CollisionPair& cp : broadphaseColPairs)
+	{
+		const bool drivesA = cp.pObjectA->invMass > 0.0f && cp.pObjectA->lodActive;
+		const bool drivesB = cp.pObjectB->invMass > 0.0f && cp.pObjectB->lodActive;
+		if (drivesA) cp.pObjectB->lodActive = true;
+		if (drivesB) cp.pObjectA->lodActive = true;
+	}
+}
+
+void PhysicsEngine::ApplyLODToManifolds()
+{
+	const uint num_bands = (uint)lodPolicy.bands.size();
+	for (Manifold* m : manifolds)
+	{
+		const uint level = min(m->pnodeA->lodLevel, m->pnodeB->lodLevel);
+		if (level >= num_bands)
+			continue;
+
+		const PhysicsLODBand& band = lodPolicy.bands[level];
+		m->solverIterations = band.solverIterations;
+		m->applyFriction = band.friction;
+	}
+}
+
+void PhysicsEngine::SyncRenderTransforms()
+{
+	for (PhysicsNode* obj : physicsNodes)
+	{
+		if (obj->IsRenderSyncPending()) obj->SyncRenderTarget();
+	}
+}
+
+
+void PhysicsEngine::UpdatePhysics()
+{
+	PROFILE_SCOPE("PhysicsEngine::UpdatePhysics");
+
+	for (Manifold* m : manifolds)
+	{
+		delete m;
+	}
+	manifolds.clear();
+
+	perfUpdate.UpdateRealElapsedTime(updateTimestep);
+	perfBroadphase.UpdateRealElapsedTime(updateTimestep);
+	perfNarrowphase.UpdateRealElapsedTime(updateTimestep);
+	perfSolver.UpdateRealElapsedTime(updateTimestep);
+	perfSoftBody.UpdateRealElapsedTime(updateTimestep);
+
+	memset(&stepCounters, 0, sizeof(PhysicsStepCounters));
+
+	//Keep bodies that are close together in the world close together in the body list (See SetReorderInterval)
+	if (reorderInterval > 0 && ++stepsSinceReorder >= reorderInterval)
+	{
+		PROFILE_SCOPE("Physics - Reorder Bodies");
+		ReorderBodies();
+	}
+
+
+	//A whole physics engine in 6 simple steps =D
+
+	//-- Using positions from last frame --
+	//1. Broadphase Collision Detection (Fast and dirty)
+	{
+		PROFILE_SCOPE("Physics - Broadphase");
+		perfBroadphase.BeginTimingSection();
+		BroadPhaseCollisions();
+		stepCounters.broadphaseMs = perfBroadphase.EndTimingSection();
+	}
+
+	stepCounters.broadphasePairs = (uint)broadphaseColPairs.size();
+
+	//Distant bodies are only stepped every few steps (See SetLODPolicy)
+	const bool lod_active = IsLODActive();
+	if (lod_active) BeginLODStep();
+
+	//2. Narrowphase Collision Detection (Accurate but slow)
+	{
+		PROFILE_SCOPE("Physics - Narrowphase");
+		perfNarrowphase.BeginTimingSection();
+		NarrowPhaseCollisions();
+		FireCollisionCallbacks();
+		UpdateTriggerPairs();
+		stepCounters.narrowphaseMs = perfNarrowphase.EndTimingSection();
+	}
+
+	if (lod_active) ApplyLODToManifolds();
+
+	stepCounters.manifolds = (uint)manifolds.size();
+	for (Manifold* m : manifolds) stepCounters.contacts += (uint)m->contactPoints.size();
+	stepCounters.solverIterations = solverIterations;
+
+	solverConstraints = constraints;
+	random.Shuffle(manifolds);
+	random.Shuffle(solverConstraints);
+
+
+	//3. Initialize Constraint Params (precompute elasticity/baumgarte factor etc)
+	//Optional step to allow constraints to 
+	// precompute values based off current velocities 
+	// before they are updated loop below.
+
+	// - Reduced rate bodies move through all of their skipped time in one go, so contacts are
+	//   corrected over the same (longer) timestep
+	{
+		PROFILE_SCOPE("Physics - PreSolver");
+		for (Manifold* m : manifolds)
+		{
+			m->PreSolverStep(lod_active ? max(updateTimestep, max(m->pnodeA->lodTimeAccum, m->pnodeB->lodTimeAccum)) : updateTimestep, random);
+		}
+		for (Constraint* c : solverConstraints) c->PreSolverStep(updateTimestep);
+	}
+
+
+	//4. Update Velocities
+	{
+		PROFILE_SCOPE("Physics - Integrate Velocity");
+		perfUpdate.BeginTimingSection();
+		if (lod_active)
+		{
+			for (PhysicsNode* obj : physicsNodes) {
+				if (obj->lodActive) obj->IntegrateForVelocity(max(obj->lodTimeAccum, updateTimestep));
+			}
+		}
+		else
+		{
+			for (PhysicsNode* obj : physicsNodes) {
+				obj->IntegrateForVelocity(updateTimestep);
+			}
+		}
+		stepCounters.integrationMs += perfUpdate.EndTimingSection();
+	}
+
+	//5. Constraint Solver
+	{
+		PROFILE_SCOPE("Physics - Solver");
+		perfSolver.BeginTimingSection();
+		for (uint i = 0; i < solverIterations; ++i) {
+			for (Manifold* m : manifolds) {
+				if (i < m->solverIterations) m->ApplyImpulse();
+			}
+			for (Constraint* c : solverConstraints) c->ApplyImpulse();
+		}
+		stepCounters.solverMs = perfSolver.EndTimingSection();
+	}
+
+	//6. Update Positions (with final 'real' velocities)
+	{
+		PROFILE_SCOPE("Physics - Integrate Position");
+		perfUpdate.BeginTimingSection();
+		if (lod_active)
+		{
+			for (PhysicsNode* obj : physicsNodes)
+			{
+				if (!obj->lodActive)
+					continue;
+
+				if (obj->invMass > 0.0f && !obj->IsAtRest()) stepCounters.awakeBodies++;
+				obj->IntegrateForPosition(max(obj->lodTimeAccum, updateTimestep));
+				obj->lodTimeAccum = 0.0f;
+			}
+		}
+		else
+		{
+			for (PhysicsNode* obj : physicsNodes)
+			{
+				if (obj->invMass > 0.0f && !obj->IsAtRest()) stepCounters.awakeBodies++;
+				obj->IntegrateForPosition(updateTimestep);
+			}
+		}
+
+		//Spatial queries made between steps test the octree's bounds, so they need to cover where the bodies are now
+		if (octree) octree->Refit();
+		stepCounters.integrationMs += perfUpdate.EndTimingSection();
+	}
+
+	//7. Soft Bodies (Solved seperately with XPBD, and coupled to the rigid bodies through their own collision pass)
+	{
+		PROFILE_SCOPE("Physics - Soft Bodies");
+		perfSoftBody.BeginTimingSection();
+		for (SoftBody* sb : softBodies) sb->Update(updateTimestep, gravity, dampingFactor, physicsNodes);
+		stepCounters.softBodyMs = perfSoftBody.EndTimingSection();
+	}
+
+	//8. Contact Events (Only recorded here, they are dispatched once per frame at the end of Update())
+	{
+		PROFILE_SCOPE("Physics - Contact Events");
+		UpdateContactEvents();
+	}
+
+	counterLog.Record(stepCounters);
+}
+
+void PhysicsEngine::SaveSnapshot(PhysicsSnapshot& out) const
+{
+	//Zeroed first so the padding bytes are the same in every snapshot
+	PhysicsSnapshotHeader header;
+	memset(&header, 0, sizeof(PhysicsSnapshotHeader));
+	header.magic = PHYSICS_SNAPSHOT_MAGIC;
+	header.version = PHYSICS_SNAPSHOT_VERSION;
+	header.numPhysicsNodes = (uint)physicsNodes.size();
+	header.numConstraints = (uint)constraints.size();
+	header.constraintBytes = 0;
+	for (Constraint* c : constraints) header.constraintBytes += c->GetSnapshotSize();
+	header.numSoftBodies = (uint)softBodies.size();
+	header.softBodyBytes = 0;
+	for (SoftBody* sb : softBodies) header.softBodyBytes += sb->GetSnapshotSize();
+	//Pairs with objects removed since the last update are skipped, as they will never fire another event
+	header.numTriggerPairs = (uint)std::count_if(prevTriggerPairs.begin(), prevTriggerPairs.end(),
+		[this](const TriggerPair& tp) { return IsHandleValid(tp.handleA) && IsHandleValid(tp.handleB); });
+	header.numStepContacts = (uint)std::count_if(prevStepContacts.begin(), prevStepContacts.end(),
+		[this](const PhysicsContactEvent& contact) { return IsHandleValid(contact.handleA) && IsHandleValid(contact.handleB); });
+
+	header.updateTimestep = updateTimestep;
+	header.updateRealTimeAccum = updateRealTimeAccum;
+	header.dampingFactor = dampingFactor;
+	header.gravity[0] = gravity.x;
+	header.gravity[1] = gravity.y;
+	header.gravity[2] = gravity.z;
+	header.stepsSinceReorder = stepsSinceReorder;
+	header.lodStepCount = lodStepCount;
+	header.solverIterations = solverIterations;
+	header.lodDistanceScale = lodDistanceScale;
+	header.randomState = random.GetState();
+
+	//Layout: [Header][Handle index * numPhysicsNodes][Body * numPhysicsNodes][Constraint blocks][Soft body blocks]
+	//        [Trigger pair * numTriggerPairs][Contact * numStepContacts]
+	// - Both body arrays are in the current body order, which the soft body collisions depend on
+	// - The trigger pairs and contacts are kept so the first update after a restore fires the same
+	//   enter/stay/exit and begin/persist/end events as it did when the snapshot was taken
+	const size_t total_size = sizeof(PhysicsSnapshotHeader)
+		+ header.numPhysicsNodes * (sizeof(uint) + PHYSICS_SNAPSHOT_NODE_BYTES)
+		+ header.constraintBytes
+		+ header.softBodyBytes
+		+ header.numTriggerPairs * PHYSICS_SNAPSHOT_TRIGGER_BYTES
+		+ header.numStepContacts * PHYSICS_SNAPSHOT_CONTACT_BYTES;
+	out.resize(total_size);
+
+	unsigned char* dst = &out[0];
+	SnapshotUtils::Write(dst, header);
+
+	for (PhysicsNode* obj : physicsNodes)
+	{
+		SnapshotUtils::Write(dst, obj->handle.index);
+	}
+
+	PhysicsNodeState state;
+	for (PhysicsNode* obj : physicsNodes)
+	{
+		obj->GetState(state);
+		WriteNodeState(dst, state);
+		SnapshotUtils::Write(dst, obj->lodTimeAccum);
+		SnapshotUtils::Write(dst, (unsigned char)(obj->lodActive ? 1 : 0));
+	}
+
+	for (Constraint* c : constraints)
+	{
+		c->SaveSnapshot(dst);
+		dst += c->GetSnapshotSize();
+	}
+
+	for (SoftBody* sb : softBodies)
+	{
+		sb->SaveSnapshot(dst);
+		dst += sb->GetSnapshotSize();
+	}
+
+	for (const TriggerPair& tp : prevTriggerPairs)
+	{
+		if (!IsHandleValid(tp.handleA) || !IsHandleValid(tp.handleB))
+			continue;
+
+		SnapshotUtils::Write(dst, tp.handleA.index);
+		SnapshotUtils::Write(dst, tp.handleB.index);
+	}
+
+	for (const PhysicsContactEvent& contact : prevStepContacts)
+	{
+		if (!IsHandleValid(contact.handleA) || !IsHandleValid(contact.handleB))
+			continue;
+
+		SnapshotUtils::Write(dst, contact.handleA.index);
+		SnapshotUtils::Write(dst, contact.handleB.index);
+		SnapshotUtils::Write(dst, contact.point);
+		SnapshotUtils::Write(dst, contact.normal);
+		SnapshotUtils::Write(dst, contact.penetration);
+	}
+}
+
+PhysicsNode* PhysicsEngine::GetNodeFromHandleIndex(uint index) const
+{
+	if (index >= handleSlots.size())
+		return NULL;
+
+	const uint dense_index = handleSlots[index].denseIndex;
+	if (dense_index >= physicsNodes.size() || physicsNodes[dense_index]->handle.index != index)
+		return NULL;
+
+	return physicsNodes[dense_index];
+}
+
+bool PhysicsEngine::RestoreSnapshot(const PhysicsSnapshot& in)
+{
+	if (in.size() < sizeof(PhysicsSnapshotHeader))
+	{
+		NCLDebug::Log("[PhysicsEngine] - Snapshot is too small to be valid");
+		return false;
+	}
+
+	PhysicsSnapshotHeader header;
+	const unsigned char* src = &in[0];
+	SnapshotUtils::Read(src, header);
+
+	if (header.magic != PHYSICS_SNAPSHOT_MAGIC || header.version != PHYSICS_SNAPSHOT_VERSION)
+	{
+		NCLDebug::Log("[PhysicsEngine] - Snapshot has an unknown format");
+		return false;
+	}
+
+	//Validate the snapshot against the current world before touching anything
+	uint constraint_bytes = 0, softbody_bytes = 0;
+	for (Constraint* c : constraints) constraint_bytes += c->GetSnapshotSize();
+	for (SoftBody* sb : softBodies) softbody_bytes += sb->GetSnapshotSize();
+
+	const size_t total_size = sizeof(PhysicsSnapshotHeader)
+		+ header.numPhysicsNodes * (sizeof(uint) + PHYSICS_SNAPSHOT_NODE_BYTES)
+		+ header.constraintBytes
+		+ header.softBodyBytes
+		+ header.numTriggerPairs * PHYSICS_SNAPSHOT_TRIGGER_BYTES
+		+ header.numStepContacts * PHYSICS_SNAPSHOT_CONTACT_BYTES;
+
+	if (header.numPhysicsNodes != physicsNodes.size()
+		|| header.numConstraints != constraints.size()
+		|| header.constraintBytes != constraint_bytes
+		|| header.numSoftBodies != softBodies.size()
+		|| header.softBodyBytes != softbody_bytes
+		|| in.size() != total_size)
+	{
+		NCLDebug::Log("[PhysicsEngine] - Snapshot does not match the current world (%d bodies, snapshot has %d)",
+			(int)physicsNodes.size(), (int)header.numPhysicsNodes);
+		return false;
+	}
+
+	//Every trigger pair and contact has to be between bodies in the world
+	// - Only their handle indices are checked, so this doesn't depend on the body order restored below
+	const unsigned char* pair_src = &in[0] + total_size
+		- header.numTriggerPairs * PHYSICS_SNAPSHOT_TRIGGER_BYTES
+		- header.numStepContacts * PHYSICS_SNAPSHOT_CONTACT_BYTES;
+	for (uint i = 0; i < header.numTriggerPairs + header.numStepContacts; ++i)
+	{
+		uint index_a, index_b;
+		SnapshotUtils::Read(pair_src, index_a);
+		SnapshotUtils::Read(pair_src, index_b);
+		if (i >= header.numTriggerPairs)
+			pair_src += PHYSICS_SNAPSHOT_CONTACT_BYTES - PHYSICS_SNAPSHOT_TRIGGER_BYTES;
+
+		if (GetNodeFromHandleIndex(index_a) == NULL || GetNodeFromHandleIndex(index_b) == NULL)
+		{
+			NCLDebug::Log("[PhysicsEngine] - Snapshot contacts do not match the current world");
+			return false;
+		}
+	}
+
+	//The bodies may have been reordered since, or the snapshot taken from a different world with the same number of bodies
+	if (!RestoreBodyOrder(reinterpret_cast<const uint*>(src)))
+	{
+		NCLDebug::Log("[PhysicsEngine] - Snapshot bodies do not match the current world");
+		return false;
+	}
+	src += header.numPhysicsNodes * sizeof(uint);
+
+	updateTimestep = header.updateTimestep;
+	updateRealTimeAccum = header.updateRealTimeAccum;
+	dampingFactor = header.dampingFactor;
+	gravity = Vector3(header.gravity[0], header.gravity[1], header.gravity[2]);
+	stepsSinceReorder = header.stepsSinceReorder;
+	lodStepCount = header.lodStepCount;
+	solverIterations = header.solverIterations;
+	lodDistanceScale = header.lodDistanceScale;
+	random.SetState(header.randomState);
+
+	PhysicsNodeState state;
+	for (PhysicsNode* obj : physicsNodes)
+	{
+		ReadNodeState(src, state);
+		obj->SetState(state);
 
-void PhysicsEngine::AddPhysicsObject(PhysicsNode* obj)
-{
-	physicsNodes.push_back(obj);
-	if(octree)	octree->AddObject(obj);
-}
+		unsigned char lod_active;
+		SnapshotUtils::Read(src, obj->lodTimeAccum);
+		SnapshotUtils::Read(src, lod_active);
+		obj->lodActive = (lod_active != 0);
+	}
 
-void PhysicsEngine::RemovePhysicsObject(PhysicsNode* obj)
-{
-	//Lookup the object in question
-	auto found_loc = std::find(physicsNodes.begin(), physicsNodes.end(), obj);
+	for (Constraint* c : constraints)
+	{
+		c->RestoreSnapshot(src);
+		src += c->GetSnapshotSize();
+	}
 
-	//If found, remove it from the list
-	if (found_loc != physicsNodes.end())
+	for (SoftBody* sb : softBodies)
 	{
-		physicsNodes.erase(found_loc);
+		sb->RestoreSnapshot(src);
+		src += sb->GetSnapshotSize();
 	}
-}
 
-void PhysicsEngine::RemoveAllPhysicsObjects()
-{
-	//Delete and remove all constraints/collision manifolds
-	for (Constraint* c : constraints)
+	//Pairs are stored in the order they were sorted in, which only depends on the handle indices (See PairLess)
+	prevTriggerPairs.resize(header.numTriggerPairs);
+	for (TriggerPair& tp : prevTriggerPairs)
 	{
-		delete c;
+		uint index_a, index_b;
+		SnapshotUtils::Read(src, index_a);
+		SnapshotUtils::Read(src, index_b);
+		tp.pObjectA = GetNodeFromHandleIndex(index_a);
+		tp.pObjectB = GetNodeFromHandleIndex(index_b);
+		tp.handleA = tp.pObjectA->GetHandle();
+		tp.handleB = tp.pObjectB->GetHandle();
 	}
-	constraints.clear();
 
+	prevStepContacts.resize(header.numStepContacts);
+	for (PhysicsContactEvent& contact : prevStepContacts)
+	{
+		uint index_a, index_b;
+		SnapshotUtils::Read(src, index_a);
+		SnapshotUtils::Read(src, index_b);
+		contact.pObjectA = GetNodeFromHandleIndex(index_a);
+		contact.pObjectB = GetNodeFromHandleIndex(index_b);
+		contact.handleA = contact.pObjectA->GetHandle();
+		contact.handleB = contact.pObjectB->GetHandle();
+		contact.type = CONTACT_PERSIST;
+		SnapshotUtils::Read(src, contact.point);
+		SnapshotUtils::Read(src, contact.normal);
+		SnapshotUtils::Read(src, contact.penetration);
+	}
+	triggerPairs.clear();
+	stepContacts.clear();
+
+	//Contacts from the last step no longer describe the restored world
 	for (Manifold* m : manifolds)
 	{
 		delete m;
 	}
 	manifolds.clear();
 
+	return true;
+}
 
-	//Delete and remove all physics objects
-	// - we also need to inform the (possibly) associated game-object
-	//   that the physics object no longer exists
-	for (PhysicsNode* obj : physicsNodes)
+template <typename NodeTest, typename ObjectFunc>
+void PhysicsEngine::QueryBroadphase(const NodeTest& nodeTest, const ObjectFunc& objectFunc) const
+{
+	auto shapeFunc = [&](PhysicsNode* obj)
 	{
-		if (obj->GetParent()) obj->GetParent()->SetPhysics(NULL);
-		delete obj;
+		if (obj->GetCollisionShape() != NULL) objectFunc(obj);
+	};
+
+	if (octree)
+	{
+		octree->Query(nodeTest, shapeFunc);
+	}
+	else
+	{
+		for (PhysicsNode* obj : physicsNodes) shapeFunc(obj);
 	}
-	physicsNodes.clear();
 }
 
-
-void PhysicsEngine::Update(float deltaTime)
+bool PhysicsEngine::Cast(const PhysicsRay& ray, PhysicsRayHit& out_hit) const
 {
-	//The physics engine should run independantly to the renderer
-	// - As our codebase is currently single threaded we just need
-	//   a way of calling "UpdatePhysics()" at regular intervals
-	//   or multiple times a frame if the physics timestep is higher
-	//   than the renderers.
-	const int max_updates_per_frame = 5;
-
-	if (!isPaused)
+	out_hit.node = NULL;
+	out_hit.distance = ray.maxDistance;
+
+	//Ray vs (inflated) octree node bounds, skipping any nodes further away than the closest hit so far
+	const float dir[3] = { ray.direction.x, ray.direction.y, ray.direction.z };
+	const float inv_dir[3] = { 1.0f / dir[0], 1.0f / dir[1], 1.0f / dir[2] };
+	const float origin[3] = { ray.origin.x, ray.origin.y, ray.origin.z };
+	auto nodeTest = [&](const Vector3& node_origin, const Vector3& node_range)
 	{
-		updateRealTimeAccum += deltaTime;
-		for (int i = 0; (updateRealTimeAccum >= updateTimestep) && i < max_updates_per_frame; ++i)
+		const float lower[3] = { node_origin.x - ray.radius, node_origin.y - ray.radius, node_origin.z - ray.radius };
+		const float upper[3] = { node_origin.x + node_range.x + ray.radius, node_origin.y + node_range.y + ray.radius, node_origin.z + node_range.z + ray.radius };
+
+		float t_min = 0.0f, t_max = out_hit.distance;
+		for (int i = 0; i < 3; ++i)
 		{
-			updateRealTimeAccum -= updateTimestep;
+			if (fabs(dir[i]) < 1e-8f)
+			{
+				if (origin[i] < lower[i] || origin[i] > upper[i]) return false;
+				continue;
+			}
 
-			//Additional IsPaused check here incase physics was paused inside one of it's components for debugging or otherwise
-			if (!isPaused) UpdatePhysics();
+			float t1 = (lower[i] - origin[i]) * inv_dir[i];
+			float t2 = (upper[i] - origin[i]) * inv_dir[i];
+			t_min = max(t_min, min(t1, t2));
+			t_max = min(t_max, max(t1, t2));
 		}
+		return t_min <= t_max;
+	};
 
-		if (updateRealTimeAccum >= updateTimestep)
+	float dist;
+	Vector3 normal;
+	QueryBroadphase(nodeTest, [&](PhysicsNode* obj)
+	{
+		if (obj->GetCollisionShape()->RayCast(ray.origin, ray.direction, out_hit.distance, ray.radius, dist, normal)
+			&& (out_hit.node == NULL || dist < out_hit.distance))
 		{
-			NCLDebug::Log("Physics too slow to run in real time!");
-			//Drop Time in the hope that it can continue to run faster the next frame
-			updateRealTimeAccum = 0.0f;
+			out_hit.node = obj;
+			out_hit.distance = dist;
+			out_hit.normal = normal;
 		}
-	}
-}
-
+	});
 
-void PhysicsEngine::UpdatePhysics()
-{
-	for (Manifold* m : manifolds)
+	if (out_hit.node)
 	{
-		delete m;
+		out_hit.point = ray.origin + ray.direction * out_hit.distance - out_hit.normal * ray.radius;
 	}
-	manifolds.clear();
-
-	perfUpdate.UpdateRealElapsedTime(updateTimestep);
-	perfBroadphase.UpdateRealElapsedTime(updateTimestep);
-	perfNarrowphase.UpdateRealElapsedTime(updateTimestep);
-	perfSolver.UpdateRealElapsedTime(updateTimestep);
-
-
-
+	return out_hit.node != NULL;
+}
 
-	//A whole physics engine in 6 simple steps =D
+bool PhysicsEngine::RayCast(const Vector3& origin, const Vector3& dir, float max_dist, PhysicsRayHit& out_hit) const
+{
+	PhysicsRay ray;
+	ray.origin = origin;
+	ray.direction = dir;
+	ray.maxDistance = max_dist;
+	ray.radius = 0.0f;
+	return Cast(ray, out_hit);
+}
 
-	//-- Using positions from last frame --
-	//1. Broadphase Collision Detection (Fast and dirty)
-	perfBroadphase.BeginTimingSection();
-	BroadPhaseCollisions();
-	perfBroadphase.EndTimingSection();
+bool PhysicsEngine::SphereCast(const Vector3& origin, const Vector3& dir, float radius, float max_dist, PhysicsRayHit& out_hit) const
+{
+	PhysicsRay ray;
+	ray.origin = origin;
+	ray.direction = dir;
+	ray.maxDistance = max_dist;
+	ray.radius = radius;
+	return Cast(ray, out_hit);
+}
 
-	//2. Narrowphase Collision Detection (Accurate but slow)
-	perfNarrowphase.BeginTimingSection();
-	NarrowPhaseCollisions();
-	perfNarrowphase.EndTimingSection();
+void PhysicsEngine::OverlapSphere(const Vector3& centre, float radius, std::vector<PhysicsNode*>& out_nodes) const
+{
+	auto nodeTest = [&](const Vector3& node_origin, const Vector3& node_range)
+	{
+		const Vector3 node_max = node_origin + node_range;
+		const Vector3 closest = Vector3(
+			min(max(centre.x, node_origin.x), node_max.x),
+			min(max(centre.y, node_origin.y), node_max.y),
+			min(max(centre.z, node_origin.z), node_max.z));
+		const Vector3 diff = centre - closest;
+		return Vector3::Dot(diff, diff) <= radius * radius;
+	};
+
+	QueryBroadphase(nodeTest, [&](PhysicsNode* obj)
+	{
+		if (obj->GetCollisionShape()->OverlapsSphere(centre, radius)) out_nodes.push_back(obj);
+	});
+}
 
-	std::random_shuffle(manifolds.begin(), manifolds.end());
-	std::random_shuffle(constraints.begin(), constraints.end());
+void PhysicsEngine::OverlapBox(const Vector3& centre, const Vector3& half_dims, std::vector<PhysicsNode*>& out_nodes) const
+{
+	const Vector3 box_min = centre - half_dims;
+	const Vector3 box_max = centre + half_dims;
+	auto nodeTest = [&](const Vector3& node_origin, const Vector3& node_range)
+	{
+		const Vector3 node_max = node_origin + node_range;
+		return box_min.x <= node_max.x && box_max.x >= node_origin.x
+			&& box_min.y <= node_max.y && box_max.y >= node_origin.y
+			&& box_min.z <= node_max.z && box_max.z >= node_origin.z;
+	};
 
+	QueryBroadphase(nodeTest, [&](PhysicsNode* obj)
+	{
+		if (obj->GetCollisionShape()->OverlapsBox(centre, half_dims)) out_nodes.push_back(obj);
+	});
+}
 
-	//3. Initialize Constraint Params (precompute elasticity/baumgarte factor etc)
-	//Optional step to allow constraints to 
-	// precompute values based off current velocities 
-	// before they are updated loop below.
+void PhysicsEngine::RayCastBatch(const std::vector<PhysicsRay>& rays, std::vector<PhysicsRayHit>& out_hits) const
+{
+	out_hits.resize(rays.size());
 
-	for (Manifold* m : manifolds) m->PreSolverStep(updateTimestep);
-	for (Constraint* c : constraints) c->PreSolverStep(updateTimestep);
+	//Queries only read the broadphase, so each ray can be cast independantly
+#pragma omp parallel for schedule(dynamic, 64)
+	for (int i = 0; i < (int)rays.size(); ++i)
+	{
+		Cast(rays[i], out_hits[i]);
+	}
+}
 
+void PhysicsEngine::BroadPhaseCollisions()
+{
+	BuildBroadphase();
+	FindBroadphasePairs();
+}
 
-	//4. Update Velocities
-	perfUpdate.BeginTimingSection();
-	for (PhysicsNode* obj : physicsNodes) {
-		obj->IntegrateForVelocity(updateTimestep);
-	}
-	perfUpdate.EndTimingSection();
+void PhysicsEngine::BuildBroadphase()
+{
+	//Objects that have moved out of their node are sent back up the tree (and down into a better fitting one)
+	// - This is done whichever method is finding the pairs, as the spatial queries (RayCast, OverlapSphere etc)
+	//   always go through the octree, and switching back to it shouldn't start from a tree that is many steps out of date
+	if (octree && physicsNodes.size() > 0)
+	{
+		octree->SendUp();
 
-	//5. Constraint Solver
-	perfSolver.BeginTimingSection();
-	for (size_t i = 0; i < SOLVER_ITERATIONS; ++i) {
-		for (Manifold* m : manifolds) m->ApplyImpulse();
-		for (Constraint* c : constraints) c->ApplyImpulse();
+		//Each node caches the objects below it, only needed by OctreeCull
+		if (broadphaseMethod == BROADPHASE_OCTREE)
+			octree->SetChildrenObjects();
 	}
-	perfSolver.EndTimingSection();
-
-	//6. Update Positions (with final 'real' velocities)
-	perfUpdate.BeginTimingSection();
-	for (PhysicsNode* obj : physicsNodes) obj->IntegrateForPosition(updateTimestep);
-	perfUpdate.EndTimingSection();
 }
 
-void PhysicsEngine::BroadPhaseCollisions()
+void PhysicsEngine::FindBroadphasePairs()
 {
 	broadphaseColPairs.clear();
 
 	PhysicsNode *pnodeA, *pnodeB;
 
-
-	//0 is Brute Force
-	//1 is Sphere-Sphere
-	//2 is Octrees
-	int broadPhaseMethod = 2;
+	//Scenes without an octree fall back to testing every bounding sphere
+	PhysicsBroadphaseMethod method = broadphaseMethod;
+	if (method == BROADPHASE_OCTREE && !octree)
+		method = BROADPHASE_SPHERES;
 
 	//	The broadphase needs to build a list of all potentially colliding objects in the world,
 	//	which then get accurately assesed in narrowphase. If this is too coarse then the system slows down with
@@ -193,7 +1250,7 @@ void PhysicsEngine::BroadPhaseCollisions()
 	//	Brute force approach.
 	//  - For every object A, assume it could collide with every other object.. 
 	//    even if they are on the opposite sides of the world.
-	if (broadPhaseMethod == 0) {
+	if (method == BROADPHASE_BRUTEFORCE) {
 		if (physicsNodes.size() > 0)
 		{
 			for (size_t i = 0; i < physicsNodes.size() - 1; ++i)
@@ -212,26 +1269,13 @@ void PhysicsEngine::BroadPhaseCollisions()
 						cp.pObjectA = pnodeA;
 						cp.pObjectB = pnodeB;
 						broadphaseColPairs.push_back(cp);
-					}else if (pnodeA->GetCollisionShape2() != NULL
-						&& pnodeB->GetCollisionShape() != NULL) {
-						CollisionPair cp;
-						cp.pObjectA = pnodeA;
-						cp.pObjectB = pnodeB;
-						broadphaseColPairs.push_back(cp);
-					}
-					else if (pnodeA->GetCollisionShape() != NULL
-						&& pnodeB->GetCollisionShape2() != NULL) {
-						CollisionPair cp;
-						cp.pObjectA = pnodeA;
-						cp.pObjectB = pnodeB;
-						broadphaseColPairs.push_back(cp);
 					}
 				}
 			}
 		}
 	}
 
-	if (broadPhaseMethod == 1) {
+	if (method == BROADPHASE_SPHERES) {
 		if (physicsNodes.size() > 0)
 		{
 			for (size_t i = 0; i < physicsNodes.size() - 1; ++i)
@@ -258,17 +1302,26 @@ void PhysicsEngine::BroadPhaseCollisions()
 			}
 		}
 	}
-	if (broadPhaseMethod == 2) {
+	if (method == BROADPHASE_OCTREE) {
 		if (physicsNodes.size() > 0)
 		{
 			//octree->AddObjects(physicsNodes);
 			//octree->AddObjects(physicsNodes);
-			octree->SendUp();
-			octree->SetChildrenObjects();
 			OctreeCull(octree);
 			//octree->ClearObjects();
 		}
 	}
+
+	//Pairs come out in whatever order the octree happens to store the bodies in, which depends on how
+	// it was built up over time. Sorting them leaves the solver order depending only on the bodies.
+	if (isDeterministic)
+	{
+		for (CollisionPair& cp : broadphaseColPairs)
+		{
+			if (NodeLess(cp.pObjectB, cp.pObjectA)) std::swap(cp.pObjectA, cp.pObjectB);
+		}
+		SortUniquePairs(broadphaseColPairs);
+	}
 }
 
 //__global__ 
@@ -282,14 +1335,53 @@ void PhysicsEngine::NarrowPhaseCollisions()
 		//Collision Detection Algorithm to use
 		CollisionDetectionSAT colDetect;
 
+		const bool lodSkipPairs = IsLODActive();
+
 		// Iterate over all possible collision pairs and perform accurate collision detection
 		for (size_t i = 0; i < broadphaseColPairs.size(); ++i)
 		{
 			CollisionPair& cp = broadphaseColPairs[i];
 
+			//Pairs filtered out by their collision layers are never tested at all
+			if (!cp.pObjectA->CanCollideWith(cp.pObjectB))
+				continue;
+
 			CollisionShape *shapeA = cp.pObjectA->GetCollisionShape();
 			CollisionShape *shapeB = cp.pObjectB->GetCollisionShape();
 
+			//Triggers only need to know if they overlap, so skip SAT and manifold generation entirely
+			if (cp.pObjectA->IsTrigger() || cp.pObjectB->IsTrigger())
+			{
+				if (TriggerShapesOverlap(cp.pObjectA, cp.pObjectB))
+				{
+					TriggerPair tp;
+					tp.pObjectA = cp.pObjectA;
+					tp.pObjectB = cp.pObjectB;
+					if (NodeLess(tp.pObjectB, tp.pObjectA)) std::swap(tp.pObjectA, tp.pObjectB);
+					tp.handleA = tp.pObjectA->GetHandle();
+					tp.handleB = tp.pObjectB->GetHandle();
+					triggerPairs.push_back(tp);
+				}
+				continue;
+			}
+
+			//Neither body is being stepped this step, so their last contacts still stand
+			if (lodSkipPairs
+				&& !(cp.pObjectA->invMass > 0.0f && cp.pObjectA->lodActive)
+				&& !(cp.pObjectB->invMass > 0.0f && cp.pObjectB->lodActive))
+			{
+				continue;
+			}
+
+			//Concave shapes (terrain) build their own contacts and compound shapes test each of their
+			// children, as SAT only works for convex pairs
+			if ((shapeA && (shapeA->IsConcave() || shapeA->IsCompound()))
+				|| (shapeB && (shapeB->IsConcave() || shapeB->IsCompound())))
+			{
+				CompositeCollision(cp, colDetect);
+				continue;
+			}
+
 			colDetect.BeginNewPair(
 				cp.pObjectA,
 				cp.pObjectB,
@@ -298,67 +1390,319 @@ void PhysicsEngine::NarrowPhaseCollisions()
 
 			//--TUTORIAL 4 CODE--
 			// Detects if the objects are colliding
-			if (!(cp.pObjectB->GetParent()->GetName().compare("Spawn") == 0 && cp.pObjectA->GetParent()->GetName().compare("InvisibleWall") == 0) &&
-				!(cp.pObjectB->GetParent()->GetName().compare("soft_body") == 0 && cp.pObjectA->GetParent()->GetName().compare("soft_body") == 0)) {
-				if (colDetect.AreColliding(&colData))
-				{
-					//Note: As at the end of tutorial 4 we have very little to do, this is a bit messier
-					//      than it should be. We now fire oncollision events for the two objects so they
-					//      can handle AI and also optionally draw the collision normals to see roughly
-					//      where and how the objects are colliding.
-
-					//Draw collision data to the window if requested
-					// - Have to do this here as colData is only temporary. 
-					if (debugDrawFlags & DEBUGDRAW_FLAGS_COLLISIONNORMALS)
-					{
-						NCLDebug::DrawPointNDT(colData._pointOnPlane, 0.1f, Vector4(0.5f, 0.5f, 1.0f, 1.0f));
-						NCLDebug::DrawThickLineNDT(colData._pointOnPlane, colData._pointOnPlane - colData._normal * colData._penetration, 0.05f, Vector4(0.0f, 0.0f, 1.0f, 1.0f));
-					}
+			if (colDetect.AreColliding(&colData))
+			{
+				//Note: OnCollision callbacks (AI etc) and the collision normal debug draws are no longer
+				//      handled here, the loop only builds manifolds. Callbacks are fired once every
+				//      pair has been tested (See FireCollisionCallbacks) and the normals are drawn from
+				//      the recorded contacts in DebugRender.
 
-					//Check to see if any of the objects have a OnCollision callback that dont want the objects to physically collide
-					bool okA = cp.pObjectA->FireOnCollisionEvent(cp.pObjectA, cp.pObjectB);
-					bool okB = cp.pObjectB->FireOnCollisionEvent(cp.pObjectB, cp.pObjectA);
+				/* TUTORIAL 5 CODE */
+				Manifold* manifold = new Manifold();
+				stepCounters.allocations++;
 
-					if (okA && okB)
-					{
-						//(*cp.pObjectA->GetParent()->Render()->GetChildIteratorStart())->SetColor(Vector4(0.5f, 0.5f, 0.5f, 1.0f));
-						//(*cp.pObjectB->GetParent()->Render()->GetChildIteratorStart())->SetColor(Vector4(0.5f, 0.5f, 0.5f, 1.0f));
-						/* TUTORIAL 5 CODE */
-						Manifold* manifold = new Manifold();
+				manifold->Initiate(cp.pObjectA, cp.pObjectB);
 
-						manifold->Initiate(cp.pObjectA, cp.pObjectB);
+				colDetect.GenContactPoints(manifold);
 
-						colDetect.GenContactPoints(manifold);
+				if (manifold->contactPoints.size() > 0) {
+					AddContactManifold(manifold, colData._pointOnPlane, colData._normal, colData._penetration);
+				}
+				else {
+					delete manifold;
+				}
+			}
+		}
 
-						if (manifold->contactPoints.size() > 0) {
-							manifolds.push_back(manifold);
-						}
-						else {
-							delete manifold;
-						}
+		stepCounters.satAxesTested += colDetect.GetNumAxesTested();
+		stepCounters.satEarlyOuts += colDetect.GetNumEarlyOuts();
+	}
+}
 
-						if (cp.pObjectB->GetParent()->GetName().compare("Spawn") == 0) {
-							if (cp.pObjectA->GetParent()->GetName().compare("Bad Target") == 0) {
-								score = score - 50;
-							}
-							if (cp.pObjectA->GetParent()->GetName().compare("Good Target") == 0) {
-								score = score + 100;
-							}
-						}
+//Compound shapes are broken down into just the children overlapping the other object's bounds
+static void GetCollisionParts(PhysicsNode* node, const PhysicsNode* other, std::vector<PhysicsNode*>& out_parts)
+{
+	out_parts.clear();
 
-						if (cp.pObjectA->GetParent()->GetName().compare("Spawn") == 0) {
-							if (cp.pObjectB->GetParent()->GetName().compare("Bad Target") == 0) {
-								score = score - 50;
-							}
-							if (cp.pObjectB->GetParent()->GetName().compare("Good Target") == 0) {
-								score = score + 100;
-							}
-						}
-					}
-				}
+	const CollisionShape* shape = node->GetCollisionShape();
+	if (!shape->IsCompound())
+	{
+		out_parts.push_back(node);
+		return;
+	}
+
+	Vector3 other_min, other_max;
+	other->GetCollisionShape()->GetWorldAABB(other_min, other_max);
+	static_cast<const CompoundCollisionShape*>(shape)->ForEachChildInBounds(other_min, other_max, [&](PhysicsNode* child_node) {
+		out_parts.push_back(child_node);
+		return false;
+	});
+}
+
+void PhysicsEngine::CompositeCollision(const CollisionPair& cp, CollisionDetectionSAT& colDetect)
+{
+	if (!cp.pObjectA->GetCollisionShape() || !cp.pObjectB->GetCollisionShape())
+		return;
+
+	//Concave shapes always act as node A, as their contacts point away from them
+	PhysicsNode* nodeA = cp.pObjectA;
+	PhysicsNode* nodeB = cp.pObjectB;
+	if (nodeB->GetCollisionShape()->IsConcave())
+		std::swap(nodeA, nodeB);
+
+	//Concave shapes are always static, so two of them never need to collide
+	if (nodeB->GetCollisionShape()->IsConcave())
+		return;
+
+	GetCollisionParts(nodeA, nodeB, compositePartsA);
+	GetCollisionParts(nodeB, nodeA, compositePartsB);
+	if (compositePartsA.empty() || compositePartsB.empty())
+		return;
+
+	//All contacts between the parts are gathered into the one manifold between the two real bodies
+	Manifold* manifold = new Manifold();
+	stepCounters.allocations++;
+	manifold->Initiate(nodeA, nodeB);
+	for (PhysicsNode* partA : compositePartsA)
+	{
+		for (PhysicsNode* partB : compositePartsB)
+		{
+			if (partA->GetCollisionShape()->IsConcave())
+			{
+				partA->GetCollisionShape()->GenConcaveContactPoints(partB, manifold);
+			}
+			else
+			{
+				colDetect.BeginNewPair(partA, partB, partA->GetCollisionShape(), partB->GetCollisionShape());
+				if (colDetect.AreColliding())
+					colDetect.GenContactPoints(manifold);
+			}
+		}
+	}
+
+	if (manifold->contactPoints.empty())
+	{
+		delete manifold;
+		return;
+	}
+
+	//Report the deepest contact
+	const ContactPoint* deepest = &manifold->contactPoints[0];
+	for (const ContactPoint& c : manifold->contactPoints)
+	{
+		if (c.colPenetration < deepest->colPenetration) deepest = &c;
+	}
+
+	const Vector3 point = nodeA->GetPosition() + deepest->relPosA;
+	AddContactManifold(manifold, point, deepest->colNormal, deepest->colPenetration);
+}
+
+void PhysicsEngine::AddContactManifold(Manifold* manifold, const Vector3& point, const Vector3& normal, float penetration)
+{
+	if (manifold->pnodeA->HasCollisionCallback() || manifold->pnodeB->HasCollisionCallback())
+	{
+		PendingCollision pending;
+		pending.manifoldIndex = (uint)manifolds.size();
+		pending.point = point;
+		pending.normal = normal;
+		pending.penetration = penetration;
+		pendingCollisions.push_back(pending);
+	}
+	else
+	{
+		//Record the contact, events are only processed once the step has been solved
+		RecordContact(manifold->pnodeA, manifold->pnodeB, point, normal, penetration);
+	}
+
+	manifolds.push_back(manifold);
+}
+
+void PhysicsEngine::FireCollisionCallbacks()
+{
+	if (pendingCollisions.empty())
+		return;
+
+	bool any_rejected = false;
+	for (const PendingCollision& pending : pendingCollisions)
+	{
+		Manifold* manifold = manifolds[pending.manifoldIndex];
+		PhysicsNode* nodeA = manifold->pnodeA;
+		PhysicsNode* nodeB = manifold->pnodeB;
+		const PhysicsHandle handleA = nodeA->GetHandle();
+		const PhysicsHandle handleB = nodeB->GetHandle();
+
+		//Check to see if any of the objects have a OnCollision callback that dont want the objects to physically collide
+		// - Callbacks are free to move objects, or remove them, in which case the pair is dropped too
+		bool okA = nodeA->FireOnCollisionEvent(nodeA, nodeB);
+		bool okB = IsHandleValid(handleB) && nodeB->FireOnCollisionEvent(nodeB, nodeA);
+
+		if (okA && okB && IsHandleValid(handleA) && IsHandleValid(handleB))
+		{
+			RecordContact(nodeA, nodeB, pending.point, pending.normal, pending.penetration);
+		}
+		else
+		{
+			delete manifold;
+			manifolds[pending.manifoldIndex] = NULL;
+			any_rejected = true;
+		}
+	}
+	pendingCollisions.clear();
+
+	//Objects removed by a callback may also be part of manifolds that were accepted before it ran
+	for (Manifold*& manifold : manifolds)
+	{
+		if (manifold && (!IsHandleValid(manifold->pnodeA->GetHandle()) || !IsHandleValid(manifold->pnodeB->GetHandle())))
+		{
+			delete manifold;
+			manifold = NULL;
+			any_rejected = true;
+		}
+	}
+
+	if (any_rejected)
+	{
+		manifolds.erase(std::remove(manifolds.begin(), manifolds.end(), (Manifold*)NULL), manifolds.end());
+	}
+}
+
+void PhysicsEngine::RecordContact(PhysicsNode* a, PhysicsNode* b, const Vector3& point, const Vector3& normal, float penetration)
+{
+	PhysicsContactEvent contact;
+	contact.pObjectA = a;
+	contact.pObjectB = b;
+	contact.point = point;
+	contact.normal = normal;
+	contact.penetration = penetration;
+	if (NodeLess(contact.pObjectB, contact.pObjectA))
+	{
+		std::swap(contact.pObjectA, contact.pObjectB);
+		contact.normal = -contact.normal;
+	}
+	contact.handleA = contact.pObjectA->GetHandle();
+	contact.handleB = contact.pObjectB->GetHandle();
+	stepContacts.push_back(contact);
+}
+
+bool PhysicsEngine::TriggerShapesOverlap(const PhysicsNode* a, const PhysicsNode* b)
+{
+	const CollisionShape* shapeA = a->GetCollisionShape();
+	const CollisionShape* shapeB = b->GetCollisionShape();
+	if (!shapeA || !shapeB)
+		return false;
+
+	//Compounds overlap if any of their children do
+	if (shapeA->IsCompound())
+	{
+		Vector3 other_min, other_max;
+		shapeB->GetWorldAABB(other_min, other_max);
+		return static_cast<const CompoundCollisionShape*>(shapeA)->ForEachChildInBounds(other_min, other_max, [&](PhysicsNode* child_node) {
+			return TriggerShapesOverlap(child_node, b);
+		});
+	}
+	if (shapeB->IsCompound())
+		return TriggerShapesOverlap(b, a);
+
+	//Spheres can be tested exactly against any shape
+	const SphereCollisionShape* sphereA = dynamic_cast<const SphereCollisionShape*>(shapeA);
+	if (sphereA) return shapeB->OverlapsSphere(a->GetPosition(), sphereA->GetRadius());
+
+	const SphereCollisionShape* sphereB = dynamic_cast<const SphereCollisionShape*>(shapeB);
+	if (sphereB) return shapeA->OverlapsSphere(b->GetPosition(), sphereB->GetRadius());
+
+	const CuboidCollisionShape* cuboidA = dynamic_cast<const CuboidCollisionShape*>(shapeA);
+	const CuboidCollisionShape* cuboidB = dynamic_cast<const CuboidCollisionShape*>(shapeB);
+	if (cuboidA && cuboidB) return cuboidA->OverlapsCuboid(*cuboidB);
+
+	//Capsules against capsules and cuboids
+	const CapsuleCollisionShape* capsuleA = dynamic_cast<const CapsuleCollisionShape*>(shapeA);
+	const CapsuleCollisionShape* capsuleB = dynamic_cast<const CapsuleCollisionShape*>(shapeB);
+	if (capsuleA && capsuleB) return capsuleA->OverlapsCapsule(*capsuleB);
+	if (capsuleA && cuboidB) return capsuleA->OverlapsCuboid(*cuboidB);
+	if (capsuleB && cuboidA) return capsuleB->OverlapsCuboid(*cuboidA);
+
+	//Unknown shape combination, fall back to the bounding spheres
+	const Vector3 ab = b->GetPosition() - a->GetPosition();
+	const float sum_radius = shapeA->GetRadius() + shapeB->GetRadius();
+	return Vector3::Dot(ab, ab) <= sum_radius * sum_radius;
+}
+
+void PhysicsEngine::UpdateTriggerPairs()
+{
+	SortUniquePairs(triggerPairs);
+
+	//Either object may have been removed since the pair was found (including by an earlier event's callback),
+	// in which case the pair is dropped without an exit event
+	DiffSortedPairs(triggerPairs, prevTriggerPairs, [this](const TriggerPair& tp, bool in_curr, bool in_prev)
+	{
+		if (!IsHandleValid(tp.handleA) || !IsHandleValid(tp.handleB))
+			return;
+
+		const PhysicsTriggerEvent evt = !in_prev ? TRIGGER_ENTER : (in_curr ? TRIGGER_STAY : TRIGGER_EXIT);
+		tp.pObjectA->FireOnTriggerEvent(tp.pObjectB, evt);
+		if (IsHandleValid(tp.handleA) && IsHandleValid(tp.handleB))
+			tp.pObjectB->FireOnTriggerEvent(tp.pObjectA, evt);
+	});
+
+	prevTriggerPairs.swap(triggerPairs);
+	triggerPairs.clear();
+}
+
+void PhysicsEngine::UpdateContactEvents()
+{
+	//Pairs skipped by the narrowphase this step (See SetLODPolicy) are assumed to still be touching
+	if (IsLODActive())
+	{
+		for (const PhysicsContactEvent& contact : prevStepContacts)
+		{
+			if (!IsHandleValid(contact.handleA) || !IsHandleValid(contact.handleB))
+				continue;
+
+			if (!(contact.pObjectA->invMass > 0.0f && contact.pObjectA->lodActive)
+				&& !(contact.pObjectB->invMass > 0.0f && contact.pObjectB->lodActive))
+			{
+				stepContacts.push_back(contact);
 			}
 		}
+	}
+
+	SortUniquePairs(stepContacts);
+
+	//Pairs with removed objects are dropped, rather than ending with a dangling pointer
+	DiffSortedPairs(stepContacts, prevStepContacts, [this](const PhysicsContactEvent& contact, bool in_curr, bool in_prev)
+	{
+		if (!IsHandleValid(contact.handleA) || !IsHandleValid(contact.handleB))
+			return;
+
+		PhysicsContactEvent evt = contact;
+		if (!in_curr)
+		{
+			evt.type = CONTACT_END;
+			evt.point = Vector3(0.0f, 0.0f, 0.0f);
+			evt.normal = Vector3(0.0f, 0.0f, 0.0f);
+			evt.penetration = 0.0f;
+		}
+		else
+		{
+			evt.type = in_prev ? CONTACT_PERSIST : CONTACT_BEGIN;
+		}
+		contactEvents.push_back(evt);
+	});
+
+	prevStepContacts.swap(stepContacts);
+	stepContacts.clear();
+}
+
+void PhysicsEngine::DispatchContactEvents()
+{
+	//Objects removed part way through the update (e.g. by a trigger callback) may still have events from earlier substeps
+	contactEvents.erase(std::remove_if(contactEvents.begin(), contactEvents.end(),
+		[this](const PhysicsContactEvent& evt) { return !IsHandleValid(evt.handleA) || !IsHandleValid(evt.handleB); }),
+		contactEvents.end());
 
+	for (const PhysicsContactListener& listener : contactListeners)
+	{
+		listener(contactEvents.data(), contactEvents.size());
 	}
 }
 
@@ -439,6 +1783,25 @@ void PhysicsEngine::NarrowPhaseCollisions()
 
 void PhysicsEngine::DebugRender()
 {
+	// Soft bodies are rendered by their scene (e.g. GameTech Coursework's RenderNodeSoftBody), this just overlays their surface/constraints
+	if (debugDrawFlags & (DEBUGDRAW_FLAGS_COLLISIONVOLUMES | DEBUGDRAW_FLAGS_CONSTRAINT))
+	{
+		for (SoftBody* sb : softBodies)
+		{
+			sb->DebugDraw((debugDrawFlags & DEBUGDRAW_FLAGS_CONSTRAINT) != 0);
+		}
+	}
+
+	// Draw the collision normal of every pair touching in the last step
+	if (debugDrawFlags & DEBUGDRAW_FLAGS_COLLISIONNORMALS)
+	{
+		for (const PhysicsContactEvent& contact : prevStepContacts)
+		{
+			NCLDebug::DrawPointNDT(contact.point, 0.1f, Vector4(0.5f, 0.5f, 1.0f, 1.0f));
+			NCLDebug::DrawThickLineNDT(contact.point, contact.point - contact.normal * contact.penetration, 0.05f, Vector4(0.0f, 0.0f, 1.0f, 1.0f));
+		}
+	}
+
 	// Draw all collision manifolds
 	if (debugDrawFlags & DEBUGDRAW_FLAGS_MANIFOLD)
 	{
@@ -476,7 +1839,7 @@ void PhysicsEngine::OctreeCull(Octree* o) {
 	std::vector<PhysicsNode*>* privateChildNodes = o->GetChildrenObjects();
 	for (std::vector<PhysicsNode*>::iterator it = privateNodes.begin(); it != privateNodes.end(); it++)
 	{
-		for (vector<PhysicsNode*>::iterator jt = it + 1; jt != privateNodes.end(); ++jt)
+		for (std::vector<PhysicsNode*>::iterator jt = it + 1; jt != privateNodes.end(); ++jt)
 		{
 			pnodeA = *it;
 			pnodeB = *jt;
@@ -499,7 +1862,7 @@ void PhysicsEngine::OctreeCull(Octree* o) {
 	if (o->GetChildren().size() == 8) {
 		for (std::vector<PhysicsNode*>::iterator it = privateNodes.begin(); it != privateNodes.end(); it++)
 		{
-			for (vector<PhysicsNode*>::iterator jt = privateChildNodes->begin(); jt != privateChildNodes->end(); ++jt)
+			for (std::vector<PhysicsNode*>::iterator jt = privateChildNodes->begin(); jt != privateChildNodes->end(); ++jt)
 			{
 				pnodeA = *it;
 				pnodeB = *jt;
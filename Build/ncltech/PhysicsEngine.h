@@ -32,17 +32,29 @@ like distance constraints (Tutorial 3)
 Moves all physics objects through time, updating positions/rotations
 etc. each iteration (Tutorial 2)
 
+Worlds:
+PhysicsEngine::Instance() is the world used by the scenes, but any number of
+other independent worlds can be created with new PhysicsEngine(). Bodies and
+constraints only ever use the world they were added to (See PhysicsNode::GetWorld),
+so separate worlds can be stepped at the same time on different threads, or all
+at once with UpdateWorlds().
+
 *//////////////////////////////////////////////////////////////////////////////
 
 #pragma once
 #include "PhysicsNode.h"
 #include "Constraint.h"
 #include "Manifold.h"
-#include <nclgl\TSingleton.h>
-#include <nclgl\PerfTimer.h>
+#include "SoftBody.h"
+#include "PhysicsCounterLog.h"
+#include "PhysicsRandom.h"
+#include <nclgl/TSingleton.h>
+#include <nclgl/PerfTimer.h>
 #include <vector>
 #include <mutex>
 #include "Octree.h"
+
+class CollisionDetectionSAT;
 //#include <cuda_runtime.h>
 //#include <device_launch_parameters.h>
 
@@ -51,6 +63,9 @@ etc. each iteration (Tutorial 2)
 // assure the constraints are solved. (Last tutorial)
 #define SOLVER_ITERATIONS 50
 
+//Lowest the solver iterations are taken when trying to stay within the step budget (See SetStepBudget)
+#define MIN_SOLVER_ITERATIONS 8
+
 
 //Just saves including windows.h for the sake of defining true/false
 #ifndef FALSE
@@ -65,35 +80,280 @@ etc. each iteration (Tutorial 2)
 #define DEBUGDRAW_FLAGS_COLLISIONVOLUMES		0x4
 #define DEBUGDRAW_FLAGS_COLLISIONNORMALS		0x8
 
+//Contiguous binary blob holding the full state of the physics world (See SaveSnapshot)
+typedef std::vector<unsigned char> PhysicsSnapshot;
+
 struct CollisionPair	//Forms the output of the broadphase collision detection
 {
 	PhysicsNode* pObjectA;
 	PhysicsNode* pObjectB;
 };
 
+struct TriggerPair		//Overlapping trigger pair, kept between updates to work out enter/stay/exit events
+{
+	PhysicsNode*	pObjectA;
+	PhysicsNode*	pObjectB;
+	PhysicsHandle	handleA;	//Handles at the time the pair was found, so pairs with removed objects can be
+	PhysicsHandle	handleB;	// recognised without touching them (See PhysicsEngine::IsHandleValid)
+};
+
+//Broadphase algorithm used to build the list of CollisionPairs each step (See PhysicsEngine::SetBroadphaseMethod)
+enum PhysicsBroadphaseMethod
+{
+	BROADPHASE_BRUTEFORCE = 0,	//Every pair of bodies, regardless of distance
+	BROADPHASE_SPHERES,			//Every pair of bodies with overlapping bounding spheres, O(n^2) tests
+	BROADPHASE_OCTREE			//Bounding sphere tests between bodies sharing an octree node (or it's children)
+};
+
+//Contact events, recorded during each physics step and handed out in one batch at the end of PhysicsEngine::Update
+enum PhysicsContactEventType
+{
+	CONTACT_BEGIN = 0,		//Objects started touching this step
+	CONTACT_PERSIST,		//Objects were already touching last step
+	CONTACT_END				//Objects stopped touching this step
+};
+
+struct PhysicsContactEvent
+{
+	PhysicsNode*			pObjectA;		//pObjectA always has the lower handle index, so each pair is only reported once per step
+	PhysicsNode*			pObjectB;
+	PhysicsContactEventType	type;
+	Vector3					point;			//Contact point, normal (from A to B) and penetration - zero for CONTACT_END
+	Vector3					normal;
+	float					penetration;
+	PhysicsHandle			handleA;		//Handles of the two objects, events are only kept for objects that are still valid
+	PhysicsHandle			handleB;		// at the end of Update() so these only need checking if objects are removed after it
+};
+
+//Called once per Update() with every contact event recorded since the last call
+typedef std::function<void(const PhysicsContactEvent* events, size_t num_events)> PhysicsContactListener;
+
+//Input/Output of the ray and sphere cast queries (See PhysicsEngine::RayCast)
+struct PhysicsRay
+{
+	Vector3 origin;
+	Vector3 direction;		//Must be normalised
+	float	maxDistance;
+	float	radius;			//Zero for a ray cast, otherwise the radius of the sphere to sweep along the ray
+};
+
+struct PhysicsRayHit
+{
+	PhysicsNode*	node;		//NULL if nothing was hit
+	float			distance;	//Distance travelled along the ray before hitting 'node'
+	Vector3			point;		//Contact point on the surface of 'node'
+	Vector3			normal;		//Surface normal of 'node' at the contact point
+};
+
+//Level of detail for distant bodies (See PhysicsEngine::SetLODPolicy)
+struct PhysicsLODBand
+{
+	float	maxDistance;		//Bodies closer than this to the nearest interest point use this band
+	uint	updateInterval;		//Bodies are integrated once every N steps (with all N steps worth of time), 1 for every step
+	uint	solverIterations;	//Solver iterations for contacts where this is the most detailed body involved
+	bool	friction;			//Whether contacts where this is the most detailed body involved apply friction
+};
+
+struct PhysicsLODPolicy
+{
+	bool						enabled;
+	std::vector<PhysicsLODBand>	bands;		//Sorted nearest first, bodies beyond the last band use the last band
+
+	PhysicsLODPolicy() : enabled(false) {}
+};
+
+//Counters for the time budgeted stepping mode (See PhysicsEngine::SetStepBudget)
+struct PhysicsBudgetStats
+{
+	uint	overrunFrames;		//Frames that went over budget, or couldn't step all of the elapsed time
+	float	droppedTime;		//Simulation time (seconds) thrown away because the backlog passed the max lag
+	float	lastFrameCost;		//Milliseconds spent stepping in the last Update()
+	uint	lastFrameSteps;		//Number of steps taken in the last Update()
+};
+
 class PhysicsEngine : public TSingleton<PhysicsEngine>
 {
 	friend class TSingleton < PhysicsEngine >;
 public:
+	//Creates an empty, independent world. Deleting the world deletes everything added to it,
+	// including the octree (See RemoveAllPhysicsObjects).
+	PhysicsEngine();
+	~PhysicsEngine();
+
 	//Reset Default Values like gravity/timestep - called when scene is switched out
 	void SetDefaults();
 
 	//Add/Remove Physics Objects
+	// - Each added object is given a PhysicsHandle (See PhysicsNode::GetHandle), removal is O(1)
+	//   and swaps the last object into the removed object's place.
+	// - Added objects are owned by the physics engine and deleted by RemoveAllPhysicsObjects. Removing
+	//   an object does not delete it, ownership passes back to the caller.
 	void AddPhysicsObject(PhysicsNode* obj);
+	void AddPhysicsObjects(const std::vector<PhysicsNode*>& objs);	//Bulk version, the octree is built in a single pass
 	void RemovePhysicsObject(PhysicsNode* obj);
+	void RemovePhysicsObject(const PhysicsHandle& handle);
+
+	//Handles to removed objects are invalid, and GetPhysicsObject returns NULL for them
+	inline bool IsHandleValid(const PhysicsHandle& handle) const
+	{
+		return handle.index < handleSlots.size() && handleSlots[handle.index].generation == handle.generation;
+	}
+	inline PhysicsNode* GetPhysicsObject(const PhysicsHandle& handle) const
+	{
+		return IsHandleValid(handle) ? physicsNodes[handleSlots[handle.index].denseIndex] : NULL;
+	}
+	inline uint GetNumPhysicsObjects() const { return (uint)physicsNodes.size(); }
 	void RemoveAllPhysicsObjects(); //Delete all physics entities etc and reset-physics environment for new scene to be initialized
 
 									//Add Constraints
 	void AddConstraint(Constraint* c) { constraints.push_back(c); }
 
+	//Add/Remove Soft Bodies (Cloth etc)
+	// - Same ownership as the physics objects above, added soft bodies are deleted by RemoveAllPhysicsObjects,
+	//   while RemoveSoftBody hands the soft body back to the caller to delete
+	void AddSoftBody(SoftBody* sb) { softBodies.push_back(sb); }
+	void RemoveSoftBody(SoftBody* sb);
+
 
 	//Update Physics Engine
 	void Update(float deltaTime);			//DeltaTime here is 'seconds' since last update not milliseconds
 
+	//Calls Update(deltaTime) on every world, spread across the OpenMP worker threads.
+	// - Returns once every world has been updated
+	// - No body or constraint may be shared between the worlds, and contact listeners
+	//   are called from the worker thread updating their world
+	static void UpdateWorlds(PhysicsEngine* const* worlds, uint num_worlds, float deltaTime);
+	static void UpdateWorlds(const std::vector<PhysicsEngine*>& worlds, float deltaTime)
+	{
+		if (!worlds.empty()) UpdateWorlds(&worlds[0], (uint)worlds.size(), deltaTime);
+	}
+
+	//Writes the world transform of every body that has moved since the last call
+	// to it's RenderNode target. Called once at the end of Update(), so RenderNodes
+	// are only touched once per rendered frame regardless of the number of substeps.
+	void SyncRenderTransforms();
+
 											//Debug draw all physics objects, manifolds and constraints
 	void DebugRender();
 
 
+	//Snapshots
+	// - SaveSnapshot writes the state of every body, constraint and soft body into a
+	//   single contiguous blob, reusing the blob's memory if it is already large enough.
+	// - RestoreSnapshot copies that state back into the existing objects, only allocating
+	//   if there are more trigger/contact pairs to restore than last update. The world must still contain the same bodies (with the same handles)
+	//   and constraints (in the same order) as when the snapshot was taken, otherwise it
+	//   returns false and the world is left untouched. Take a new snapshot after adding
+	//   or removing any. The body order is stored too (See SetReorderInterval).
+	// - The LOD and step budget state and last update's trigger/contact pairs are stored too, so
+	//   the first update after a restore carries on (and fires the same events) as it did originally.
+	// Contact manifolds are rebuilt from scratch every step so are not stored.
+	void SaveSnapshot(PhysicsSnapshot& out) const;
+	bool RestoreSnapshot(const PhysicsSnapshot& in);
+
+
+	//Contact Events
+	// - Begin/persist/end events for every touching pair of (non-trigger) objects are recorded into a flat
+	//   buffer during the step, and dispatched to the listeners once all substeps have been solved.
+	//   The same buffer can be polled with GetContactEvents() until the next Update().
+	// - Events involving objects removed during the update are dropped before dispatch. Objects removed
+	//   after it are still in the polled buffer, so check the event's handles with IsHandleValid().
+	// - Listeners are removed when the scene is switched (See SetDefaults).
+	// - PhysicsNode OnCollision callbacks are fired once the narrowphase has finished, before the pair's
+	//   contact is recorded, as their return value can still drop the pair (See PhysicsCollisionCallback).
+	inline void AddContactListener(const PhysicsContactListener& listener) { contactListeners.push_back(listener); }
+	inline const std::vector<PhysicsContactEvent>& GetContactEvents() const { return contactEvents; }
+
+
+	//Spatial Queries
+	// - Traverse the octree (or every body if there is no octree), so use the body
+	//   positions from the last physics update. Bodies without a collision shape are ignored.
+	// - Casts return the closest hit, overlaps append every overlapping body to out_nodes.
+	bool RayCast(const Vector3& origin, const Vector3& dir, float max_dist, PhysicsRayHit& out_hit) const;
+	bool SphereCast(const Vector3& origin, const Vector3& dir, float radius, float max_dist, PhysicsRayHit& out_hit) const;
+	void OverlapSphere(const Vector3& centre, float radius, std::vector<PhysicsNode*>& out_nodes) const;
+	void OverlapBox(const Vector3& centre, const Vector3& half_dims, std::vector<PhysicsNode*>& out_nodes) const;
+
+	//Batched ray/sphere casts split across all cores, out_hits[i] is the closest hit for rays[i]
+	void RayCastBatch(const std::vector<PhysicsRay>& rays, std::vector<PhysicsRayHit>& out_hits) const;
+
+
+	//Level of Detail
+	// - At the start of each Update() every dynamic body is sorted into the first band whose maxDistance
+	//   reaches the nearest interest point (e.g. the camera or players). All bodies in a band are integrated
+	//   on the same steps, so piles of touching bodies stay in sync, and each band is offset by one step
+	//   so the bands don't all land on the same step.
+	// - Pairs where neither dynamic body is integrated this step skip the narrowphase entirely. A body
+	//   touching one that is being integrated is woken up for that step.
+	// - Static bodies are always integrated, and never lower the detail of the contacts they are in.
+	// - With no interest points, or the policy disabled, every body runs at full detail. Both are reset
+	//   when the scene is switched (See SetDefaults).
+	inline const PhysicsLODPolicy& GetLODPolicy() const { return lodPolicy; }
+	void SetLODPolicy(const PhysicsLODPolicy& policy);
+
+	inline void ClearLODInterestPoints() { lodInterestPoints.clear(); }
+	inline void AddLODInterestPoint(const Vector3& point) { lodInterestPoints.push_back(point); }
+
+
+	//Time Budget
+	// - With a budget set, Update() times every step and stops once the next step would take it over
+	//   the budget. Time that couldn't be stepped is carried into the next frame (up to the max lag,
+	//   anything beyond that is dropped and counted in GetBudgetStats) instead of being thrown away.
+	// - Frames that still go over budget first lower the solver iterations (down to MIN_SOLVER_ITERATIONS),
+	//   and then pull the LOD bands in closer to the interest points. Both are slowly restored once
+	//   there is time to spare again.
+	// - A budget of zero (the default) steps up to 5 times a frame, dropping any remaining time.
+	// - Ignored in deterministic mode, as it depends on how long each step took
+	inline float GetStepBudget() const { return stepBudgetMs; }
+	inline void SetStepBudget(float milliseconds) { stepBudgetMs = milliseconds; }
+
+	inline float GetMaxStepLag() const { return maxStepLag; }
+	inline void SetMaxStepLag(float seconds) { maxStepLag = seconds; }
+
+	inline const PhysicsBudgetStats& GetBudgetStats() const { return budgetStats; }
+	inline uint GetSolverIterations() const { return solverIterations; }
+	inline float GetLODDistanceScale() const { return lodDistanceScale; }
+
+
+	//Deterministic Mode (for lockstep networking and replays)
+	// - Two worlds with the same bodies/constraints (added in the same order) given the same
+	//   inputs each Update() stay bitwise identical, on the same build of the engine.
+	// - Broadphase pairs are sorted by their body handles, so the solver order no longer depends
+	//   on the broadphase method or how the octree was built up, and the step budget is ignored.
+	// - The solver order is always shuffled by the world's own random generator, which is reseeded
+	//   from the random seed by SetDefaults() and stored in snapshots, so a restored snapshot
+	//   continues exactly as the original did.
+	inline bool IsDeterministic() const { return isDeterministic; }
+	inline void SetDeterministic(bool deterministic) { isDeterministic = deterministic; }
+
+	inline unsigned long long GetRandomSeed() const { return randomSeed; }
+	inline void SetRandomSeed(unsigned long long seed) { randomSeed = seed; random.Seed(seed); }
+
+
+	//Spatial Reordering (Experimental, off by default)
+	// - Bodies are stored in the order they were added, so bodies that touch can be anywhere in the body
+	//   list. Every few steps the list is re-sorted by the morton code of each body's position instead,
+	//   so the integration, soft body collisions and brute force/sphere broadphase visit neighbouring
+	//   bodies one after another, and the pairs they produce come out grouped together.
+	// - Only the list of pointers is re-sorted, the PhysicsNodes themselves stay where they were allocated.
+	//   So this only improves the visiting order, the bodies' memory is no more contiguous than before,
+	//   and it makes no measurable difference in the Benchmark_Physics scenes. Measure before turning it on.
+	// - Handles (and so GetPhysicsObject) still point at the same bodies after a re-sort.
+	// - An interval of zero (the default) turns it off, the order then only changes when a body is removed.
+	inline uint GetReorderInterval() const { return reorderInterval; }
+	inline void SetReorderInterval(uint steps) { reorderInterval = steps; }
+
+	//Re-sorts the bodies straight away, rather than waiting for the next interval
+	void ReorderBodies();
+
+
+	//Hot Path Counters
+	// - Broadphase pairs, SAT axes, contacts etc are counted every step and kept in a ring buffer
+	//   of recent steps, which can be exported to CSV/JSON or streamed to a log file for headless runs
+	inline PhysicsCounterLog& GetCounterLog() { return counterLog; }
+	inline const PhysicsCounterLog& GetCounterLog() const { return counterLog; }
+
+
 
 	//Getters / Setters 
 	inline bool IsPaused() const { return isPaused; }
@@ -102,8 +362,13 @@ public:
 	inline uint GetDebugDrawFlags() const { return debugDrawFlags; }
 	inline void SetDebugDrawFlags(uint flags) { debugDrawFlags = flags; }
 
+	//The octree method needs the scene to have created an octree, without one the
+	// bounding sphere method is used instead
+	inline PhysicsBroadphaseMethod GetBroadphaseMethod() const { return broadphaseMethod; }
+	inline void SetBroadphaseMethod(PhysicsBroadphaseMethod method) { broadphaseMethod = method; }
+
 	inline float GetUpdateTimestep() const { return updateTimestep; }
-	inline void SetUpdateTimestep(float updateTimestep) { updateTimestep = updateTimestep; }
+	inline void SetUpdateTimestep(float timestep) { updateTimestep = timestep; }
 
 	inline const Vector3& GetGravity() const { return gravity; }
 	inline void SetGravity(const Vector3& g) { gravity = g; }
@@ -119,47 +384,183 @@ public:
 		perfBroadphase.PrintOutputToStatusEntry(color, "    Broadphase  :");
 		perfNarrowphase.PrintOutputToStatusEntry(color, "    Narrowphase :");
 		perfSolver.PrintOutputToStatusEntry(color, "    Solver      :");
+		perfSoftBody.PrintOutputToStatusEntry(color, "    Soft Bodies :");
+
+		const PhysicsStepCounters& c = counterLog.GetLastStep();
+		NCLDebug::AddStatusEntry(color, "    Last Step   : %d pairs, %d SAT axes (%d early outs), %d manifolds, %d contacts",
+			c.broadphasePairs, c.satAxesTested, c.satEarlyOuts, c.manifolds, c.contacts);
+		NCLDebug::AddStatusEntry(color, "                  %d solver iterations, %d awake bodies, %d allocations",
+			c.solverIterations, c.awakeBodies, c.allocations);
+
+		if (stepBudgetMs > 0.0f)
+		{
+			NCLDebug::AddStatusEntry(color, "    Step Budget : %5.2fms [used:%5.2fms, steps:%d, overruns:%d, dropped:%5.2fs]",
+				stepBudgetMs, budgetStats.lastFrameCost, budgetStats.lastFrameSteps, budgetStats.overrunFrames, budgetStats.droppedTime);
+			NCLDebug::AddStatusEntry(color, "    Degradation : %d solver iterations, %3.0f%% LOD distance",
+				solverIterations, lodDistanceScale * 100.0f);
+		}
 	}
 
-	inline int GetScore() { return score; }
+	//The two halves of the broadphase, called in turn at the start of each step. These are public so
+	// the broadphase methods can be timed on their own (See Benchmark_Physics)
+	void BuildBroadphase();			//Brings the octree (if any, whatever the method) up to date with the current body positions
+	void FindBroadphasePairs();		//Fills the broadphase pair list, BuildBroadphase must have been called first
+	inline const std::vector<CollisionPair>& GetBroadphasePairs() const { return broadphaseColPairs; }
 
+	//Created by each scene to fit it's own bounds, and owned by the engine from then on
+	// - Deleted (and set back to NULL) by RemoveAllPhysicsObjects, as it only stores the bodies being deleted
 	Octree* octree;
 
 protected:
-	PhysicsEngine();
-	~PhysicsEngine();
-
 	//The actual time-independant update function
 	void UpdatePhysics();
 
+	//LOD is only applied if the policy has both bands and something to measure the distance to
+	inline bool IsLODActive() const { return lodPolicy.enabled && !lodPolicy.bands.empty() && !lodInterestPoints.empty(); }
+
+	//Sorts every dynamic body into it's distance band, once per Update()
+	void UpdateLODBuckets();
+
+	//Picks which bodies are integrated this step, and wakes any touching a body that is
+	void BeginLODStep();
+
+	//Lowers the solver iterations/friction of each manifold to match it's most detailed body
+	void ApplyLODToManifolds();
+
+	//Budgeted version of the stepping loop in Update() (See SetStepBudget)
+	void StepWithinBudget();
+
+	//Lowers or restores the solver iterations and LOD distances after a budgeted Update()
+	void AdjustQualityForBudget(bool over_budget, bool spare_time);
+
+	//Hands out a handle slot pointing to physicsNodes[dense_index]
+	PhysicsHandle AllocateHandle(uint dense_index);
+
+	//Puts the bodies back into the order given by their handle indices (See SaveSnapshot)
+	// - Returns false, leaving the order untouched, if they are not exactly the bodies in the world
+	bool RestoreBodyOrder(const uint* handle_indices);
+
+	//Finds the body currently using the given handle slot, without knowing it's generation (See SaveSnapshot)
+	PhysicsNode* GetNodeFromHandleIndex(uint index) const;
+
+	//Visits every body in the broadphase nodes that pass nodeTest (See Octree::Query)
+	template <typename NodeTest, typename ObjectFunc>
+	void QueryBroadphase(const NodeTest& nodeTest, const ObjectFunc& objectFunc) const;
+
+	bool Cast(const PhysicsRay& ray, PhysicsRayHit& out_hit) const;
+
 	//Handles broadphase collision detection
 	void BroadPhaseCollisions();
 
 	//Handles narrowphase collision detection
 	virtual void NarrowPhaseCollisions();
 
+	//Narrowphase for pairs involving a concave or compound shape, which are broken down into just the
+	// parts that could be touching (See CollisionShape::GenConcaveContactPoints and CompoundCollisionShape)
+	void CompositeCollision(const CollisionPair& cp, CollisionDetectionSAT& colDetect);
+
+	//Adds a narrowphase manifold (with at least one contact point) to be solved this step
+	// - The contact is recorded straight away, unless either node has an OnCollision callback that could still reject it
+	void AddContactManifold(Manifold* manifold, const Vector3& point, const Vector3& normal, float penetration);
+
+	//Fires the OnCollision callbacks for every manifold held back by AddContactManifold, removing any rejected ones
+	void FireCollisionCallbacks();
+
+	//Adds a touching pair to this step's contacts, which become contact events once the step is solved
+	void RecordContact(PhysicsNode* a, PhysicsNode* b, const Vector3& point, const Vector3& normal, float penetration);
+
+	//Cheap boolean overlap test used for trigger pairs, no contact data is generated
+	static bool TriggerShapesOverlap(const PhysicsNode* a, const PhysicsNode* b);
+
+	//Compares this update's overlapping trigger pairs against last update's and fires the enter/stay/exit events
+	void UpdateTriggerPairs();
+
+	//Compares this step's touching pairs against last step's and appends begin/persist/end events to contactEvents
+	void UpdateContactEvents();
+
+	//Drops events with removed objects, then hands the rest to every listener
+	void DispatchContactEvents();
+
 protected:
 	bool		isPaused;
 	float		updateTimestep, updateRealTimeAccum;
 	uint		debugDrawFlags;
+	PhysicsBroadphaseMethod	broadphaseMethod;
 
 	Vector3		gravity;
 	float		dampingFactor;
 
 
 	std::vector<CollisionPair>  broadphaseColPairs;
+	std::vector<PhysicsNode*>	compositePartsA;		// Scratch lists of the convex parts being tested by CompositeCollision
+	std::vector<PhysicsNode*>	compositePartsB;
+
+	std::vector<TriggerPair>	triggerPairs;			// Overlapping trigger pairs found this update (ordered by handle, See PairLess)
+	std::vector<TriggerPair>	prevTriggerPairs;		// Overlapping trigger pairs from the previous update, sorted
+
+	std::vector<PhysicsContactEvent>	stepContacts;		// Touching pairs found by this step's narrowphase (ordered by handle, See PairLess)
+	std::vector<PhysicsContactEvent>	prevStepContacts;	// Touching pairs from the previous step, sorted
+	std::vector<PhysicsContactEvent>	contactEvents;		// Events from every step of the last Update()
+	std::vector<PhysicsContactListener>	contactListeners;
 
 	std::vector<PhysicsNode*>	physicsNodes;
 
+	struct PhysicsHandleSlot
+	{
+		uint denseIndex;	//Index into physicsNodes
+		uint generation;
+	};
+	std::vector<PhysicsHandleSlot>	handleSlots;
+	std::vector<uint>				freeHandleSlots;
+
+	struct PhysicsReorderEntry
+	{
+		unsigned long long	code;
+		PhysicsNode*		node;
+	};
+	std::vector<PhysicsReorderEntry>	reorderEntries;		// Scratch list for ReorderBodies/RestoreBodyOrder, kept to avoid reallocating
+	uint								reorderInterval;
+	uint								stepsSinceReorder;
+
 	std::vector<Constraint*>	constraints;		// Misc constraints applying to one or more physics objects e.g our DistanceConstraint
+	std::vector<Constraint*>	solverConstraints;	// Shuffled copy of constraints used by the solver, so 'constraints' keeps a stable order for snapshots
 	std::vector<Manifold*>		manifolds;			// Contact constraints between pairs of objects
 
+	struct PendingCollision
+	{
+		uint		manifoldIndex;		//Index into manifolds
+		Vector3		point;
+		Vector3		normal;
+		float		penetration;
+	};
+	std::vector<PendingCollision>	pendingCollisions;	// Manifolds waiting on OnCollision callbacks (See FireCollisionCallbacks)
+
+	std::vector<SoftBody*>		softBodies;			// XPBD Cloth/Soft bodies, solved after the rigid bodies each step
+
+	PhysicsLODPolicy					lodPolicy;
+	std::vector<Vector3>				lodInterestPoints;
+	std::vector<std::vector<PhysicsNode*>>	lodBuckets;		// Dynamic bodies in each LOD band, rebuilt each Update()
+	uint								lodStepCount;
+	float								lodDistanceScale;	// Multiplies every band's maxDistance, lowered when over budget
+
+	float						stepBudgetMs;
+	float						maxStepLag;
+	float						avgStepCost;		// Smoothed milliseconds per step, used to predict if the next step fits
+	uint						solverIterations;
+	PhysicsBudgetStats			budgetStats;
+
+	bool						isDeterministic;
+	unsigned long long			randomSeed;
+	PhysicsRandom				random;				// Shuffles the solver order, never shared between worlds
+
+	PhysicsCounterLog			counterLog;
+	PhysicsStepCounters			stepCounters;		// Counters for the step currently being run
+
 	PerfTimer perfUpdate;
 	PerfTimer perfBroadphase;
 	PerfTimer perfNarrowphase;
 	PerfTimer perfSolver;
-
-	int score = 0;
+	PerfTimer perfSoftBody;
 
 	void OctreeCull(Octree*);
 };
\ No newline at end of file
@@ -1,20 +1,23 @@
 #include "PhysicsNode.h"
 #include "PhysicsEngine.h"
+#ifndef USE_HEADLESS_PHYSICS
+#include <nclgl/RenderNode.h>
+#endif
 
 
 void PhysicsNode::IntegrateForVelocity(float dt)
 {
 	/* TUTORIAL 2 CODE */
 
-	if (invMass > 0.0f) linVelocity += PhysicsEngine::Instance()->GetGravity() * dt;
+	if (invMass > 0.0f) linVelocity += world->GetGravity() * dt;
 
 	linVelocity += force * invMass * dt;
 
-	linVelocity = linVelocity * PhysicsEngine::Instance()->GetDampingFactor();
+	linVelocity = linVelocity * world->GetDampingFactor();
 
 	angVelocity += invInertia * torque * dt;
 
-	angVelocity = angVelocity * PhysicsEngine::Instance()->GetDampingFactor();
+	angVelocity = angVelocity * world->GetDampingFactor();
 }
 
 /* Between these two functions the physics engine will solve for velocity
@@ -26,14 +29,33 @@ void PhysicsNode::IntegrateForPosition(float dt)
 {
 	/* TUTORIAL 2 CODE */
 
+	//Bodies at rest don't need integrating, or their transforms re-syncing
+	if (IsAtRest())
+		return;
+
 	position += linVelocity
 		*dt;
 
 	orientation = orientation + Quaternion(angVelocity * dt * 0.5f, 0.0f) * orientation;
 
 	orientation.Normalise();
-	//Finally: Notify any listener's that this PhysicsNode has a new world transform.
-	// - This is used by GameObject to set the worldTransform of any RenderNode's. 
+	//Finally: Rebuild this PhysicsNode's world transform.
+	// - Any RenderNode target is updated later in the batched PhysicsEngine::SyncRenderTransforms()
+	//   pass, custom listeners are still notified straight away.
 	//   Please don't delete this!!!!!
-	FireOnUpdateCallback();
-}
\ No newline at end of file
+	OnTransformChanged();
+}
+
+void PhysicsNode::SyncRenderTarget()
+{
+	//Headless builds have no renderer, so never have a target to write to
+#ifndef USE_HEADLESS_PHYSICS
+	if (renderTarget) renderTarget->SetTransform(worldTransform);
+#endif
+	renderSyncPending = false;
+}
+
+void PhysicsNode::GrowOctreeBounds()
+{
+	if (octreeNode) octreeNode->GrowBounds(this);
+}
@@ -30,36 +30,106 @@ Matrix3     invInertia;
 *//////////////////////////////////////////////////////////////////////////////
 
 #pragma once
-#include <nclgl\Quaternion.h>
-#include <nclgl\Matrix3.h>
+#include <nclgl/Quaternion.h>
+#include <nclgl/Matrix3.h>
 #include "CollisionShape.h"
 #include <functional>
 
 class PhysicsNode;
+class RenderNode;
 
 //Callback function called whenever a collision is detected between two objects
+// - Called once the narrowphase has finished, for every pair that ended up with contact points, so it is
+//   free to move/remove objects. Pairs that should never collide are better filtered out up front with
+//   collision layers (See PhysicsNode::SetCollisionLayer), which costs nothing per pair.
 //Params:
 //	PhysicsNode* this_obj			- The current object class that contains the callback
 //	PhysicsNode* colliding_obj	- The object that is colliding with the given object
 //Return:
 //  True	- The physics engine should process the collision as normal
-//	False	- The physics engine should drop the collision pair and not do any further collision resolution/manifold generation
+//	False	- The physics engine should drop the collision pair's manifold and not do any further collision resolution
 //			  > This can be useful for AI to see if a player/agent is inside an area/collision volume
 typedef std::function<bool(PhysicsNode* this_obj, PhysicsNode* colliding_obj)> PhysicsCollisionCallback;
 
 
+//Trigger overlap events, fired once per physics update for each overlapping pair that involves a trigger
+enum PhysicsTriggerEvent
+{
+	TRIGGER_ENTER = 0,		//Started overlapping this update
+	TRIGGER_STAY,			//Was already overlapping last update
+	TRIGGER_EXIT			//Stopped overlapping this update
+};
+
+//Callback function called for trigger overlap events (See PhysicsNode::SetTrigger)
+//Params:
+//	PhysicsNode* this_obj			- The current object class that contains the callback
+//	PhysicsNode* other_obj		- The object overlapping (or leaving) this object
+//	PhysicsTriggerEvent event	- Enter/Stay/Exit
+typedef std::function<void(PhysicsNode* this_obj, PhysicsNode* other_obj, PhysicsTriggerEvent event)> PhysicsTriggerCallback;
+
+
 //Callback function called whenever this physicsnode's world transform is updated
+// - Only needed for custom listeners, RenderNode transforms are synchronised in
+//   a single batched pass by the PhysicsEngine (See SetRenderTarget)
 //Params:
 //	const Matrix4& transform - New World transform of the physics node
 typedef std::function<void(const Matrix4& transform)> PhysicsUpdateCallback;
 
 
+//Stable reference to a body added to the PhysicsEngine
+// - index is the body's slot in the engine's handle table, which in turn points to
+//   it's (dense) position in the list of bodies. The slot's generation is bumped each
+//   time a body is removed, so any handles still pointing to that body become invalid.
+#define PHYSICS_HANDLE_INVALID_INDEX 0xFFFFFFFF
+
+struct PhysicsHandle
+{
+	uint index;
+	uint generation;
+
+	PhysicsHandle() : index(PHYSICS_HANDLE_INVALID_INDEX), generation(0) {}
+	PhysicsHandle(uint idx, uint gen) : index(idx), generation(gen) {}
+
+	inline bool operator==(const PhysicsHandle& rhs) const { return index == rhs.index && generation == rhs.generation; }
+	inline bool operator!=(const PhysicsHandle& rhs) const { return !(*this == rhs); }
+};
+
+
+//Plain copy of all the simulation state of a PhysicsNode, so it can be written
+// into (or read out of) a PhysicsEngine snapshot.
+struct PhysicsNodeState
+{
+	Vector3		position;
+	Vector3		linVelocity;
+	Vector3		force;
+	float		invMass;
+
+	Quaternion	orientation;
+	Vector3		angVelocity;
+	Vector3		torque;
+	Matrix3		invInertia;
+
+	float		elasticity;
+	float		friction;
+};
+
+
 class GameObject;
+class Octree;
+class PhysicsEngine;
 class PhysicsNode
 {
+	friend class PhysicsEngine;	//Assigns the handle when the node is added
+	friend class Octree;		//Keeps track of which octree node currently stores this node
+
 public:
 	PhysicsNode()
-		: position(0.0f, 0.0f, 0.0f)
+		: parent(NULL)
+		, renderTarget(NULL)
+		, renderSyncPending(false)
+		, octreeNode(NULL)
+		, world(NULL)
+		, position(0.0f, 0.0f, 0.0f)
 		, linVelocity(0.0f, 0.0f, 0.0f)
 		, force(0.0f, 0.0f, 0.0f)
 		, invMass(0.0f)
@@ -68,15 +138,21 @@ public:
 		, torque(0.0f, 0.0f, 0.0f)
 		, invInertia(Matrix3::ZeroMatrix)
 		, collisionShape(NULL)
-		, friction(0.5f)
+		, isTrigger(false)
+		, collisionLayer(1)
+		, collisionMask(0xFFFFFFFF)
 		, elasticity(0.9f)
+		, friction(0.5f)
+		, lodLevel(0)
+		, lodBucketIndex(PHYSICS_HANDLE_INVALID_INDEX)
+		, lodTimeAccum(0.0f)
+		, lodActive(true)
 	{
 	}
 
 	virtual ~PhysicsNode()
 	{
 		SAFE_DELETE(collisionShape);
-		SAFE_DELETE(collisionShape2);
 	}
 
 
@@ -89,9 +165,22 @@ public:
 
 	//<--------- GETTERS ------------->
 	inline GameObject*			GetParent()					const { return parent; }
+	inline const PhysicsHandle&	GetHandle()					const { return handle; }
+	inline PhysicsEngine*		GetWorld()					const { return world; }
 
 	inline float				GetElasticity()				const { return elasticity; }
 	inline float				GetFriction()				const { return friction; }
+	inline bool					IsTrigger()					const { return isTrigger; }
+	inline uint					GetCollisionLayer()			const { return collisionLayer; }
+	inline uint					GetCollisionMask()			const { return collisionMask; }
+	inline bool					CanCollideWith(const PhysicsNode* other) const
+	{
+		return (collisionLayer & other->collisionMask) != 0 && (other->collisionLayer & collisionMask) != 0;
+	}
+	inline uint					GetLODLevel()				const { return lodLevel; }
+
+	//Bodies with no velocity are skipped by IntegrateForPosition
+	inline bool					IsAtRest()					const { return linVelocity == Vector3(0.0f, 0.0f, 0.0f) && angVelocity == Vector3(0.0f, 0.0f, 0.0f); }
 
 	inline const Vector3&		GetPosition()				const { return position; }
 	inline const Vector3&		GetLinearVelocity()			const { return linVelocity; }
@@ -104,9 +193,10 @@ public:
 	inline const Matrix3&		GetInverseInertia()			const { return invInertia; }
 
 	inline CollisionShape*		GetCollisionShape()			const { return collisionShape; }
-	inline CollisionShape*		GetCollisionShape2()			const { return collisionShape2; }
 
-	const Matrix4&				GetWorldSpaceTransform()    const { return worldTransform; }
+	//World transform is rebuilt whenever the position/orientation changes (See OnTransformChanged), so
+	// this is a plain read that is safe to call from multiple threads during queries
+	inline const Matrix4&		GetWorldSpaceTransform()    const { return worldTransform; }
 
 
 
@@ -117,12 +207,21 @@ public:
 	inline void SetElasticity(float elasticityCoeff) { elasticity = elasticityCoeff; }
 	inline void SetFriction(float frictionCoeff) { friction = frictionCoeff; }
 
-	inline void SetPosition(const Vector3& v) { position = v; FireOnUpdateCallback(); }
+	//Triggers never physically collide, any pair involving a trigger only runs a cheap boolean
+	// overlap test and fires trigger events (See SetOnTriggerCallback) instead of building a manifold
+	inline void SetTrigger(bool trigger) { isTrigger = trigger; }
+
+	//Collision filtering, two objects (triggers included) are only tested against each other if each one's
+	// layer bits overlap the other's mask bits. By default every object is on layer 1 and collides with everything.
+	inline void SetCollisionLayer(uint layer_bits) { collisionLayer = layer_bits; }
+	inline void SetCollisionMask(uint mask_bits) { collisionMask = mask_bits; }
+
+	inline void SetPosition(const Vector3& v) { position = v; OnTransformChanged(); GrowOctreeBounds(); }
 	inline void SetLinearVelocity(const Vector3& v) { linVelocity = v; }
 	inline void SetForce(const Vector3& v) { force = v; }
 	inline void SetInverseMass(const float& v) { invMass = v; }
 
-	inline void SetOrientation(const Quaternion& v) { orientation = v; FireOnUpdateCallback(); }
+	inline void SetOrientation(const Quaternion& v) { orientation = v; OnTransformChanged(); }
 	inline void SetAngularVelocity(const Vector3& v) { angVelocity = v; }
 	inline void SetTorque(const Vector3& v) { torque = v; }
 	inline void SetInverseInertia(const Matrix3& v) { invInertia = v; }
@@ -131,14 +230,45 @@ public:
 	{
 		if (collisionShape) collisionShape->SetParent(NULL);
 		collisionShape = colShape;
-		if (collisionShape) collisionShape->SetParent(this);
+		if (collisionShape)
+		{
+			collisionShape->SetParent(this);
+			collisionShape->OnParentTransformChanged();
+		}
+	}
+
+
+
+
+	//<---------- SNAPSHOTS ------------>
+	inline void GetState(PhysicsNodeState& state) const
+	{
+		state.position = position;
+		state.linVelocity = linVelocity;
+		state.force = force;
+		state.invMass = invMass;
+		state.orientation = orientation;
+		state.angVelocity = angVelocity;
+		state.torque = torque;
+		state.invInertia = invInertia;
+		state.elasticity = elasticity;
+		state.friction = friction;
 	}
 
-	inline void SetCollisionShape2(CollisionShape* colShape)
+	inline void SetState(const PhysicsNodeState& state)
 	{
-		if (collisionShape2) collisionShape2->SetParent(NULL);
-		collisionShape2 = colShape;
-		if (collisionShape2) collisionShape2->SetParent(this);
+		position = state.position;
+		linVelocity = state.linVelocity;
+		force = state.force;
+		invMass = state.invMass;
+		orientation = state.orientation;
+		angVelocity = state.angVelocity;
+		torque = state.torque;
+		invInertia = state.invInertia;
+		elasticity = state.elasticity;
+		friction = state.friction;
+		OnTransformChanged();
+		GrowOctreeBounds();
 	}
 
 
@@ -146,21 +276,54 @@ public:
 
 	//<---------- CALLBACKS ------------>
 	inline void SetOnCollisionCallback(PhysicsCollisionCallback callback) { onCollisionCallback = callback; }
+	inline bool HasCollisionCallback() const { return (bool)onCollisionCallback; }
 	inline bool FireOnCollisionEvent(PhysicsNode* obj_a, PhysicsNode* obj_b)
 	{
 		return (onCollisionCallback) ? onCollisionCallback(obj_a, obj_b) : true;
 	}
 
+	inline void SetOnTriggerCallback(PhysicsTriggerCallback callback) { onTriggerCallback = callback; }
+	inline void FireOnTriggerEvent(PhysicsNode* other_obj, PhysicsTriggerEvent event)
+	{
+		if (onTriggerCallback) onTriggerCallback(this, other_obj, event);
+	}
+
 	inline void SetOnUpdateCallback(PhysicsUpdateCallback callback) { onUpdateCallback = callback; }
 	inline void FireOnUpdateCallback()
 	{
-		//Build world transform
+		//Fire the OnUpdateCallback, notifying any custom listeners that
+		// this PhysicsNode has a new world transform.
+		if (onUpdateCallback) onUpdateCallback(GetWorldSpaceTransform());
+	}
+
+
+	//<---------- RENDER SYNC ---------->
+	// RenderNode that will be given this node's world transform once per rendered
+	// frame, during PhysicsEngine::SyncRenderTransforms(). Only bodies that have
+	// moved since the last sync are written.
+	inline RenderNode* GetRenderTarget() const { return renderTarget; }
+	inline void SetRenderTarget(RenderNode* node)
+	{
+		renderTarget = node;
+		renderSyncPending = (renderTarget != NULL);
+	}
+
+	inline bool IsRenderSyncPending() const { return renderSyncPending; }
+	void SyncRenderTarget();
+
+
+protected:
+	//Moves made outside of the physics update need to be covered by the octree straight away, so
+	// spatial queries can find the body before the next step (See Octree::GrowBounds)
+	void GrowOctreeBounds();
+
+	inline void OnTransformChanged()
+	{
 		worldTransform = orientation.ToMatrix4();
 		worldTransform.SetPositionVector(position);
-
-		//Fire the OnUpdateCallback, notifying GameObject's and other potential
-		// listeners that this PhysicsNode has a new world transform.
-		if (onUpdateCallback) onUpdateCallback(worldTransform);
+		renderSyncPending = (renderTarget != NULL);
+		if (collisionShape) collisionShape->OnParentTransformChanged();
+		FireOnUpdateCallback();
 	}
 
 
@@ -170,6 +333,13 @@ protected:
 	Matrix4					worldTransform;
 	PhysicsUpdateCallback	onUpdateCallback;
 
+	RenderNode*				renderTarget;
+	bool					renderSyncPending;
+
+	PhysicsHandle			handle;			//Invalid until added to the PhysicsEngine
+	Octree*					octreeNode;		//Octree node currently storing this node (if any)
+	PhysicsEngine*			world;			//World the node has been added to, gravity/damping are taken from here
+
 
 	//Added in Tutorial 2
 	//<---------LINEAR-------------->
@@ -188,8 +358,11 @@ protected:
 	//Added in Tutorial 4/5
 	//<----------COLLISION------------>
 	CollisionShape*				collisionShape;
-	CollisionShape*				collisionShape2;
 	PhysicsCollisionCallback	onCollisionCallback;
+	bool						isTrigger;
+	uint						collisionLayer;
+	uint						collisionMask;
+	PhysicsTriggerCallback		onTriggerCallback;
 
 
 	//Added in Tutorial 5
@@ -197,4 +370,12 @@ protected:
 	float				elasticity;		///Value from 0-1 definiing how much the object bounces off other objects
 	float				friction;		///Value from 0-1 defining how much the object can slide off other objects
 
+
+	//<-------LEVEL OF DETAIL--------->
+	// Managed by the PhysicsEngine (See PhysicsEngine::SetLODPolicy)
+	uint				lodLevel;		//Distance band the body was placed in at the start of the frame
+	uint				lodBucketIndex;	//Index into the engine's bucket for lodLevel, so it can be removed without a search
+	float				lodTimeAccum;	//Time since the body was last integrated
+	bool				lodActive;		//Whether the body is integrated this step
+
 };
\ No newline at end of file
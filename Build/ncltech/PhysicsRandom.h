@@ -0,0 +1,60 @@
+/******************************************************************************
+Class: PhysicsRandom
+Implements:
+Author:
+Pieran Marris      <p.marris@newcastle.ac.uk> and YOU!
+Description:
+
+Small xorshift64* random number generator, owned by each PhysicsEngine world and used to shuffle
+the solver order. Unlike rand() (or std::random_shuffle) it is not shared between worlds/threads,
+and the whole state is a single 64 bit value, so it can be reseeded or stored in a snapshot to
+replay a simulation exactly (See PhysicsEngine::SetDeterministic).
+
+The shuffle is written out by hand, as the standard library's shuffles and distributions are free
+to differ between implementations.
+
+*//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <nclgl/common.h>
+#include <vector>
+#include <algorithm>
+
+#define PHYSICS_RANDOM_DEFAULT_SEED 0x9E3779B97F4A7C15ull
+
+class PhysicsRandom
+{
+public:
+	PhysicsRandom() { Seed(PHYSICS_RANDOM_DEFAULT_SEED); }
+
+	//Zero is the one state xorshift can never leave, so it is swapped for the default seed
+	inline void Seed(unsigned long long seed) { state = seed ? seed : PHYSICS_RANDOM_DEFAULT_SEED; }
+
+	inline unsigned long long GetState() const { return state; }
+	inline void SetState(unsigned long long s) { Seed(s); }
+
+	inline uint Next()
+	{
+		state ^= state >> 12;
+		state ^= state << 25;
+		state ^= state >> 27;
+		return (uint)((state * 0x2545F4914F6CDD1Dull) >> 32);
+	}
+
+	//Random integer in [0, n)
+	inline uint NextBelow(uint n) { return (uint)(((unsigned long long)Next() * n) >> 32); }
+
+	//Fisher-Yates shuffle
+	template <typename T>
+	void Shuffle(std::vector<T>& items)
+	{
+		for (size_t i = items.size(); i > 1; --i)
+		{
+			std::swap(items[i - 1], items[NextBelow((uint)i)]);
+		}
+	}
+
+protected:
+	unsigned long long state;
+};
@@ -30,8 +30,9 @@ For example usage see Tuts_Physics project.
 
 #include "GameObject.h"
 #include "PhysicsEngine.h"
-#include <nclgl\NCLDebug.h>
-#include <nclgl\TSingleton.h>
+#include <nclgl/NCLDebug.h>
+#include <nclgl/Profiler.h>
+#include <nclgl/TSingleton.h>
 #include <functional>
 #include <algorithm>
 #include <unordered_map>
@@ -84,6 +85,8 @@ public:
 	//     associated GameObject update callbacks.
 	void FireOnSceneUpdate(float dt)
 	{
+		PROFILE_SCOPE("Scene::FireOnSceneUpdate");
+
 		OnUpdateScene(dt); //Should this just be an optional callback too?
 
 		for (auto&& callbackItr : m_UpdateCallbacks)
@@ -101,6 +104,7 @@ public:
 		{
 			if (game_object->scene) game_object->scene->RemoveGameObject(game_object);
 
+			game_object->sceneIndex = m_vpObjects.size();
 			m_vpObjects.push_back(game_object);
 			game_object->scene = this;
 			game_object->OnAttachedToScene();
@@ -110,9 +114,37 @@ public:
 		}
 	}
 
+	// Add a batch of GameObjects to the scene list
+	//		- Same as calling AddGameObject on each, though the physics
+	//		  bodies are all handed to the physics engine at once so the
+	//		  broadphase can be built in a single pass.
+	void AddGameObjects(const std::vector<GameObject*>& game_objects)
+	{
+		std::vector<PhysicsNode*> physics_nodes;
+		physics_nodes.reserve(game_objects.size());
+
+		for (GameObject* game_object : game_objects)
+		{
+			if (!game_object) continue;
+			if (game_object->scene) game_object->scene->RemoveGameObject(game_object);
+
+			game_object->sceneIndex = m_vpObjects.size();
+			m_vpObjects.push_back(game_object);
+			game_object->scene = this;
+			game_object->OnAttachedToScene();
+
+			if (game_object->renderNode) GraphicsPipeline::Instance()->AddRenderNode(game_object->renderNode);
+			if (game_object->physicsNode) physics_nodes.push_back(game_object->physicsNode);
+		}
+
+		PhysicsEngine::Instance()->AddPhysicsObjects(physics_nodes);
+	}
+
 	// Remove GameObject from the scene list
 	//		- This will just remove it from the list of game objects,
 	//		  it will not call any delete functions.
+	//		- The last object in the list is moved into it's place, so
+	//		  removal is O(1) but does not preserve the order of the list.
 	void RemoveGameObject(GameObject* game_object)
 	{
 		if (game_object && game_object->scene == this)
@@ -120,7 +152,11 @@ public:
 			if (game_object->renderNode) GraphicsPipeline::Instance()->RemoveRenderNode(game_object->renderNode);
 			if (game_object->physicsNode) PhysicsEngine::Instance()->RemovePhysicsObject(game_object->physicsNode);
 
-			m_vpObjects.erase(std::remove(m_vpObjects.begin(), m_vpObjects.end(), game_object), m_vpObjects.end());
+			GameObject* last_object = m_vpObjects.back();
+			m_vpObjects[game_object->sceneIndex] = last_object;
+			last_object->sceneIndex = game_object->sceneIndex;
+			m_vpObjects.pop_back();
+
 			game_object->OnDetachedFromScene();
 			game_object->scene = NULL;
 		}
@@ -1,7 +1,7 @@
 #include "SceneManager.h"
 #include "PhysicsEngine.h"
 #include "CommonMeshes.h"
-#include <nclgl\NCLDebug.h>
+#include <nclgl/NCLDebug.h>
 #include "GraphicsPipeline.h"
 
 SceneManager::SceneManager()
@@ -1,6 +1,6 @@
 #include "ScreenPicker.h"
 #include "GraphicsPipeline.h"
-#include <nclgl\NCLDebug.h>
+#include <nclgl/NCLDebug.h>
 
 ScreenPicker::ScreenPicker()
 	: m_pCurrentlyHeldObject(NULL)
@@ -33,10 +33,10 @@ which can be extended (with the new physics collision shapes) to provide an accu
 *//////////////////////////////////////////////////////////////////////////////
 
 #pragma once
-#include <nclgl\TSingleton.h>
-#include <nclgl\RenderNode.h>
-#include <nclgl\Shader.h>
-#include <GL\glew.h>
+#include <nclgl/TSingleton.h>
+#include <nclgl/RenderNode.h>
+#include <nclgl/Shader.h>
+#include <GL/glew.h>
 
 //Our texture only stores 16bit unsigned shorts, so has a hard limit on the number of values it can store. 
 //  Hopefully you will never be able to trigger this value though. 
@@ -93,6 +93,10 @@ public:
 	//Remove object from the list of 'clickable' objects
 	void UnregisterNodeForMouseCallback(RenderNode* node);
 
+	//World space position under the mouse cursor, as of the last hovered/clicked/dragged object
+	// - Useful in mouse callbacks for objects made up of many parts, to find which part was clicked
+	const Vector3& GetMouseWorldSpacePos() const { return m_OldWorldSpacePos; }
+
 
 
 
@@ -0,0 +1,65 @@
+#pragma once
+#include <nclgl/Vector3.h>
+#include <nclgl/Quaternion.h>
+#include <nclgl/Matrix3.h>
+#include <cstring>
+#include <type_traits>
+
+//Serialized sizes of the maths types, which are stored as their raw floats (See SnapshotUtils::Write)
+#define SNAPSHOT_VECTOR3_BYTES		(3 * sizeof(float))
+#define SNAPSHOT_QUATERNION_BYTES	(4 * sizeof(float))
+#define SNAPSHOT_MATRIX3_BYTES		(9 * sizeof(float))
+
+//Reads/Writes values to and from the byte blocks of a physics snapshot (See PhysicsEngine::SaveSnapshot)
+// - Each call advances the pointer past the value, so blocks can be written/read field by field
+// - The maths types are not trivially copyable (they declare their own constructors/destructors), so
+//   they are copied one float at a time rather than memcpy'd as a whole
+namespace SnapshotUtils
+{
+	template <typename T>
+	inline void Write(unsigned char*& dst, const T& value)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be copied straight into a snapshot");
+		memcpy(dst, &value, sizeof(T));
+		dst += sizeof(T);
+	}
+
+	template <typename T>
+	inline void Read(const unsigned char*& src, T& value)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be copied straight out of a snapshot");
+		memcpy(&value, src, sizeof(T));
+		src += sizeof(T);
+	}
+
+
+	inline void Write(unsigned char*& dst, const Vector3& v)
+	{
+		Write(dst, v.x); Write(dst, v.y); Write(dst, v.z);
+	}
+
+	inline void Read(const unsigned char*& src, Vector3& v)
+	{
+		Read(src, v.x); Read(src, v.y); Read(src, v.z);
+	}
+
+	inline void Write(unsigned char*& dst, const Quaternion& q)
+	{
+		Write(dst, q.x); Write(dst, q.y); Write(dst, q.z); Write(dst, q.w);
+	}
+
+	inline void Read(const unsigned char*& src, Quaternion& q)
+	{
+		Read(src, q.x); Read(src, q.y); Read(src, q.z); Read(src, q.w);
+	}
+
+	inline void Write(unsigned char*& dst, const Matrix3& m)
+	{
+		for (int i = 0; i < 9; ++i) Write(dst, m.mat_array[i]);
+	}
+
+	inline void Read(const unsigned char*& src, Matrix3& m)
+	{
+		for (int i = 0; i < 9; ++i) Read(src, m.mat_array[i]);
+	}
+};
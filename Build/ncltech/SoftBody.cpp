@@ -0,0 +1,516 @@
+#include "SoftBody.h"
+#include "PhysicsNode.h"
+#include "SphereCollisionShape.h"
+#include "CuboidCollisionShape.h"
+#include "CapsuleCollisionShape.h"
+#include "SnapshotUtils.h"
+#include <nclgl/NCLDebug.h>
+#include <algorithm>
+
+
+SoftBody::SoftBody()
+	: hashInvCellSize(1.0f)
+	, color(1.0f, 0.5f, 0.2f, 1.0f)
+	, dimsU(0)
+	, dimsV(0)
+	, particleRadius(0.1f)
+	, friction(0.5f)
+	, numSubsteps(4)
+	, numIterations(2)
+	, selfCollision(true)
+{
+	compliances[SOFTBODY_STRETCH] = 0.0f;
+	compliances[SOFTBODY_SHEAR] = 0.0001f;
+	compliances[SOFTBODY_BEND] = 0.01f;
+}
+
+SoftBody::~SoftBody()
+{
+}
+
+void SoftBody::BuildClothGrid(
+	const Vector3& origin,
+	const Vector3& extentU,
+	const Vector3& extentV,
+	uint dimsU, uint dimsV,
+	float totalMass,
+	float particleRadius)
+{
+	this->dimsU = dimsU;
+	this->dimsV = dimsV;
+	this->particleRadius = particleRadius;
+
+	const uint num_particles = dimsU * dimsV;
+	const float particle_invmass = (totalMass > 0.0f) ? float(num_particles) / totalMass : 0.0f;
+
+	positions.resize(num_particles);
+	prevPositions.resize(num_particles);
+	velocities.assign(num_particles, Vector3(0.0f, 0.0f, 0.0f));
+	restPositions.resize(num_particles);
+	invMasses.assign(num_particles, particle_invmass);
+
+	const Vector3 stepU = extentU / float(max(dimsU - 1, 1u));
+	const Vector3 stepV = extentV / float(max(dimsV - 1, 1u));
+	for (uint u = 0; u < dimsU; ++u)
+	{
+		for (uint v = 0; v < dimsV; ++v)
+		{
+			uint idx = GetClothParticleIndex(u, v);
+			positions[idx] = origin + stepU * float(u) + stepV * float(v);
+			prevPositions[idx] = positions[idx];
+			restPositions[idx] = positions[idx];
+		}
+	}
+
+	//Build constraints
+	constraints.clear();
+	for (uint u = 0; u < dimsU; ++u)
+	{
+		for (uint v = 0; v < dimsV; ++v)
+		{
+			uint idx = GetClothParticleIndex(u, v);
+			if (u + 1 < dimsU) AddConstraint(idx, GetClothParticleIndex(u + 1, v), SOFTBODY_STRETCH);
+			if (v + 1 < dimsV) AddConstraint(idx, GetClothParticleIndex(u, v + 1), SOFTBODY_STRETCH);
+
+			if (u + 1 < dimsU && v + 1 < dimsV)
+			{
+				AddConstraint(idx, GetClothParticleIndex(u + 1, v + 1), SOFTBODY_SHEAR);
+				AddConstraint(GetClothParticleIndex(u + 1, v), GetClothParticleIndex(u, v + 1), SOFTBODY_SHEAR);
+			}
+
+			if (u + 2 < dimsU) AddConstraint(idx, GetClothParticleIndex(u + 2, v), SOFTBODY_BEND);
+			if (v + 2 < dimsV) AddConstraint(idx, GetClothParticleIndex(u, v + 2), SOFTBODY_BEND);
+		}
+	}
+	lambdas.assign(constraints.size(), 0.0f);
+
+	//Build render triangles
+	triangleIndices.clear();
+	for (uint u = 0; u + 1 < dimsU; ++u)
+	{
+		for (uint v = 0; v + 1 < dimsV; ++v)
+		{
+			uint i00 = GetClothParticleIndex(u, v);
+			uint i10 = GetClothParticleIndex(u + 1, v);
+			uint i01 = GetClothParticleIndex(u, v + 1);
+			uint i11 = GetClothParticleIndex(u + 1, v + 1);
+
+			triangleIndices.push_back(i00); triangleIndices.push_back(i10); triangleIndices.push_back(i11);
+			triangleIndices.push_back(i00); triangleIndices.push_back(i11); triangleIndices.push_back(i01);
+		}
+	}
+
+	//Self-Collision hash table, twice the number of particles keeps collisions between cells low
+	hashCellStart.assign(num_particles * 2 + 1, 0);
+	hashCellEntries.resize(num_particles);
+}
+
+void SoftBody::AddConstraint(uint idxA, uint idxB, SoftBodyConstraintType type)
+{
+	SoftBodyConstraint c;
+	c.idxA = idxA;
+	c.idxB = idxB;
+	c.restLength = (positions[idxB] - positions[idxA]).Length();
+	c.type = type;
+	constraints.push_back(c);
+}
+
+void SoftBody::Update(float dt, const Vector3& gravity, float dampingFactor, const std::vector<PhysicsNode*>& rigidBodies)
+{
+	const uint num_particles = GetNumParticles();
+	if (num_particles == 0) return;
+
+	//Find all rigid bodies that could touch the soft body this step
+	// - Done once per step, so the per particle collision pass only has to consider a handful of bodies
+	Vector3 bb_min = positions[0], bb_max = positions[0];
+	for (const Vector3& p : positions)
+	{
+		bb_min.x = min(bb_min.x, p.x); bb_min.y = min(bb_min.y, p.y); bb_min.z = min(bb_min.z, p.z);
+		bb_max.x = max(bb_max.x, p.x); bb_max.y = max(bb_max.y, p.y); bb_max.z = max(bb_max.z, p.z);
+	}
+	float max_speed = 0.0f;
+	for (const Vector3& v : velocities) max_speed = max(max_speed, v.Length());
+
+	Vector3 bb_centre = (bb_min + bb_max) * 0.5f;
+	float bb_radius = (bb_max - bb_min).Length() * 0.5f + max_speed * dt + particleRadius;
+
+	nearbyBodies.clear();
+	for (PhysicsNode* obj : rigidBodies)
+	{
+		CollisionShape* shape = obj->GetCollisionShape();
+		if (shape == NULL) continue;
+
+		float r = bb_radius + shape->GetRadius();
+		if ((obj->GetPosition() - bb_centre).Length() < r)
+			nearbyBodies.push_back(obj);
+	}
+
+	//Find all self-collision candidates for the whole step
+	if (selfCollision)
+	{
+		const float query_distance = particleRadius * 2.0f + max_speed * dt * 2.0f;
+		BuildHashGrid(query_distance);
+		FindSelfCollisionPairs(query_distance);
+	}
+
+	const float sub_dt = dt / float(numSubsteps);
+	for (uint step = 0; step < numSubsteps; ++step)
+	{
+		//1. Predict positions
+		for (uint i = 0; i < num_particles; ++i)
+		{
+			prevPositions[i] = positions[i];
+			if (invMasses[i] > 0.0f)
+			{
+				velocities[i] += gravity * sub_dt;
+				positions[i] += velocities[i] * sub_dt;
+			}
+		}
+
+		//2. Project constraints
+		for (float& l : lambdas) l = 0.0f;
+		for (uint itr = 0; itr < numIterations; ++itr)
+		{
+			SolveConstraints(sub_dt);
+		}
+
+		//3. Collisions (Self and Rigid bodies)
+		if (selfCollision) SolveSelfCollisions();
+		SolveRigidCollisions(sub_dt, nearbyBodies);
+
+		//4. Update velocities from the final positions
+		const float inv_dt = 1.0f / sub_dt;
+		for (uint i = 0; i < num_particles; ++i)
+		{
+			if (invMasses[i] > 0.0f)
+				velocities[i] = (positions[i] - prevPositions[i]) * inv_dt * dampingFactor;
+			else
+				velocities[i].ToZero();
+		}
+	}
+}
+
+void SoftBody::SolveConstraints(float dt)
+{
+	float alpha_tilde[SOFTBODY_NUM_CONSTRAINT_TYPES];
+	for (uint i = 0; i < SOFTBODY_NUM_CONSTRAINT_TYPES; ++i)
+	{
+		alpha_tilde[i] = compliances[i] / (dt * dt);
+	}
+
+	for (size_t i = 0; i < constraints.size(); ++i)
+	{
+		const SoftBodyConstraint& c = constraints[i];
+		const float wA = invMasses[c.idxA];
+		const float wB = invMasses[c.idxB];
+		const float alpha = alpha_tilde[c.type];
+
+		const float denom = wA + wB + alpha;
+		if (denom <= 0.0f) continue;
+
+		Vector3 ab = positions[c.idxB] - positions[c.idxA];
+		float len = ab.Length();
+		if (len < 1e-6f) continue;
+
+		Vector3 n = ab / len;
+		float C = len - c.restLength;
+
+		float dlambda = (-C - alpha * lambdas[i]) / denom;
+		lambdas[i] += dlambda;
+
+		positions[c.idxA] -= n * (dlambda * wA);
+		positions[c.idxB] += n * (dlambda * wB);
+	}
+}
+
+void SoftBody::BuildHashGrid(float cellSize)
+{
+	const uint num_particles = GetNumParticles();
+	const uint num_cells = (uint)hashCellStart.size() - 1;
+	hashInvCellSize = 1.0f / cellSize;
+
+	//Counting sort of all particles into their hashed cells
+	std::fill(hashCellStart.begin(), hashCellStart.end(), 0);
+	for (uint i = 0; i < num_particles; ++i)
+	{
+		const Vector3& p = positions[i];
+		uint h = HashCell((int)floorf(p.x * hashInvCellSize), (int)floorf(p.y * hashInvCellSize), (int)floorf(p.z * hashInvCellSize));
+		hashCellStart[h]++;
+	}
+
+	uint start = 0;
+	for (uint h = 0; h < num_cells; ++h)
+	{
+		start += hashCellStart[h];
+		hashCellStart[h] = start;
+	}
+	hashCellStart[num_cells] = start;
+
+	for (uint i = 0; i < num_particles; ++i)
+	{
+		const Vector3& p = positions[i];
+		uint h = HashCell((int)floorf(p.x * hashInvCellSize), (int)floorf(p.y * hashInvCellSize), (int)floorf(p.z * hashInvCellSize));
+		hashCellEntries[--hashCellStart[h]] = i;
+	}
+}
+
+void SoftBody::FindSelfCollisionPairs(float queryDistance)
+{
+	const uint num_particles = GetNumParticles();
+	const float query_dist_sq = queryDistance * queryDistance;
+	const float rest_dist = particleRadius * 2.0f;
+	const float rest_dist_sq = rest_dist * rest_dist;
+
+	selfCollisionPairs.clear();
+	for (uint i = 0; i < num_particles; ++i)
+	{
+		const Vector3 p = positions[i];
+		const int cx = (int)floorf(p.x * hashInvCellSize);
+		const int cy = (int)floorf(p.y * hashInvCellSize);
+		const int cz = (int)floorf(p.z * hashInvCellSize);
+
+		//Neighbouring cells can hash to the same bucket, which must only be walked once or it's pairs are found twice
+		uint visited[27];
+		uint num_visited = 0;
+
+		for (int x = cx - 1; x <= cx + 1; ++x)
+		{
+			for (int y = cy - 1; y <= cy + 1; ++y)
+			{
+				for (int z = cz - 1; z <= cz + 1; ++z)
+				{
+					uint h = HashCell(x, y, z);
+					if (std::find(visited, visited + num_visited, h) != visited + num_visited) continue;
+					visited[num_visited++] = h;
+
+					for (uint e = hashCellStart[h]; e < hashCellStart[h + 1]; ++e)
+					{
+						uint j = hashCellEntries[e];
+						if (j <= i) continue;
+						if (invMasses[i] == 0.0f && invMasses[j] == 0.0f) continue;
+
+						Vector3 ab = positions[j] - p;
+						if (Vector3::Dot(ab, ab) >= query_dist_sq) continue;
+
+						//Particles that start out within touching distance are connected
+						// by the cloth itself, and colliding them would fight the constraints
+						Vector3 rest_ab = restPositions[j] - restPositions[i];
+						if (Vector3::Dot(rest_ab, rest_ab) < rest_dist_sq) continue;
+
+						selfCollisionPairs.push_back(i);
+						selfCollisionPairs.push_back(j);
+					}
+				}
+			}
+		}
+	}
+}
+
+void SoftBody::SolveSelfCollisions()
+{
+	const float min_dist = particleRadius * 2.0f;
+	const float min_dist_sq = min_dist * min_dist;
+
+	for (size_t k = 0; k + 1 < selfCollisionPairs.size(); k += 2)
+	{
+		const uint i = selfCollisionPairs[k];
+		const uint j = selfCollisionPairs[k + 1];
+
+		Vector3 ab = positions[j] - positions[i];
+		float dist_sq = Vector3::Dot(ab, ab);
+		if (dist_sq >= min_dist_sq || dist_sq < 1e-12f) continue;
+
+		const float wA = invMasses[i];
+		const float wB = invMasses[j];
+		float dist = sqrtf(dist_sq);
+		Vector3 n = ab / dist;
+		float corr = (min_dist - dist) / (wA + wB);
+
+		positions[i] -= n * (corr * wA);
+		positions[j] += n * (corr * wB);
+	}
+}
+
+void SoftBody::SolveRigidCollisions(float dt, const std::vector<PhysicsNode*>& rigidBodies)
+{
+	const uint num_particles = GetNumParticles();
+
+	for (PhysicsNode* obj : rigidBodies)
+	{
+		CollisionShape* shape = obj->GetCollisionShape();
+		SphereCollisionShape* sphere = dynamic_cast<SphereCollisionShape*>(shape);
+		CuboidCollisionShape* cuboid = dynamic_cast<CuboidCollisionShape*>(shape);
+		CapsuleCollisionShape* capsule = dynamic_cast<CapsuleCollisionShape*>(shape);
+		if (sphere == NULL && cuboid == NULL && capsule == NULL) continue;
+
+		const Vector3 centre = obj->GetPosition();
+		const Matrix3 rot = obj->GetOrientation().ToMatrix3();
+		const Matrix3 inv_rot = Matrix3::Transpose(rot);
+		const float broad_radius_sq = (shape->GetRadius() + particleRadius) * (shape->GetRadius() + particleRadius);
+		const float wBody = obj->GetInverseMass();
+
+		Vector3 seg_start, seg_end;
+		if (capsule) capsule->GetWorldSegment(seg_start, seg_end);
+
+		Vector3 body_dv(0.0f, 0.0f, 0.0f);
+
+		for (uint i = 0; i < num_particles; ++i)
+		{
+			Vector3 d = positions[i] - centre;
+			if (Vector3::Dot(d, d) > broad_radius_sq) continue;
+
+			Vector3 normal;
+			float penetration;
+
+			if (sphere || capsule)
+			{
+				//Capsules push particles away from the closest point on their segment, just like a sphere
+				float radius = sphere ? sphere->GetRadius() : capsule->GetCapsuleRadius();
+				if (capsule)
+				{
+					Vector3 on_segment, unused;
+					ClosestPointsSegmentSegment(seg_start, seg_end, positions[i], positions[i], on_segment, unused);
+					d = positions[i] - on_segment;
+				}
+
+				float dist = d.Length();
+				penetration = radius + particleRadius - dist;
+				if (penetration <= 0.0f || dist < 1e-6f) continue;
+				normal = d / dist;
+			}
+			else
+			{
+				//Closest point on the box in it's local space
+				const Vector3& half = cuboid->GetHalfDims();
+				Vector3 local = inv_rot * d;
+				Vector3 clamped(
+					min(max(local.x, -half.x), half.x),
+					min(max(local.y, -half.y), half.y),
+					min(max(local.z, -half.z), half.z));
+
+				Vector3 diff = local - clamped;
+				float dist = diff.Length();
+				if (dist > 1e-6f)
+				{
+					penetration = particleRadius - dist;
+					if (penetration <= 0.0f) continue;
+					normal = rot * (diff / dist);
+				}
+				else
+				{
+					//Inside the box, push out through the nearest face
+					Vector3 face_dist(half.x - fabs(local.x), half.y - fabs(local.y), half.z - fabs(local.z));
+					Vector3 local_normal(0.0f, 0.0f, 0.0f);
+					if (face_dist.x <= face_dist.y && face_dist.x <= face_dist.z)
+					{
+						local_normal.x = (local.x < 0.0f) ? -1.0f : 1.0f;
+						penetration = face_dist.x + particleRadius;
+					}
+					else if (face_dist.y <= face_dist.z)
+					{
+						local_normal.y = (local.y < 0.0f) ? -1.0f : 1.0f;
+						penetration = face_dist.y + particleRadius;
+					}
+					else
+					{
+						local_normal.z = (local.z < 0.0f) ? -1.0f : 1.0f;
+						penetration = face_dist.z + particleRadius;
+					}
+					normal = rot * local_normal;
+				}
+			}
+
+			//Split the correction between the particle and the rigid body by inverse mass
+			const float wParticle = invMasses[i];
+			const float wSum = wParticle + wBody;
+			if (wSum <= 0.0f) continue;
+
+			positions[i] += normal * (penetration * wParticle / wSum);
+			body_dv -= normal * (penetration * wBody / wSum / dt);
+
+			//Simple position based friction, removing a portion of the tangential motion this substep
+			Vector3 dx = positions[i] - prevPositions[i];
+			Vector3 dx_tangent = dx - normal * Vector3::Dot(dx, normal);
+			positions[i] -= dx_tangent * min(friction * obj->GetFriction() * 2.0f, 1.0f);
+		}
+
+		if (wBody > 0.0f && body_dv != Vector3(0.0f, 0.0f, 0.0f))
+		{
+			obj->SetLinearVelocity(obj->GetLinearVelocity() + body_dv);
+		}
+	}
+}
+
+uint SoftBody::FindClosestParticle(const Vector3& pos) const
+{
+	uint closest = 0;
+	float closest_dist_sq = FLT_MAX;
+	for (uint i = 0; i < GetNumParticles(); ++i)
+	{
+		const Vector3 diff = positions[i] - pos;
+		const float dist_sq = Vector3::Dot(diff, diff);
+		if (dist_sq < closest_dist_sq)
+		{
+			closest = i;
+			closest_dist_sq = dist_sq;
+		}
+	}
+	return closest;
+}
+
+void SoftBody::DebugDraw(bool drawConstraints) const
+{
+	//Shade each triangle by it's facing direction so the cloth folds are visible without a lighting pass
+	const Vector3 light_dir = Vector3(0.3f, 1.0f, 0.2f).Normalise();
+	for (size_t i = 0; i + 2 < triangleIndices.size(); i += 3)
+	{
+		const Vector3& v0 = positions[triangleIndices[i]];
+		const Vector3& v1 = positions[triangleIndices[i + 1]];
+		const Vector3& v2 = positions[triangleIndices[i + 2]];
+
+		Vector3 n = Vector3::Cross(v1 - v0, v2 - v0);
+		n.Normalise();
+		float shade = 0.4f + 0.6f * fabs(Vector3::Dot(n, light_dir));
+
+		NCLDebug::DrawTriangle(v0, v1, v2, Vector4(color.x * shade, color.y * shade, color.z * shade, color.w));
+	}
+
+	if (drawConstraints)
+	{
+		for (const SoftBodyConstraint& c : constraints)
+		{
+			if (c.type == SOFTBODY_STRETCH)
+				NCLDebug::DrawHairLine(positions[c.idxA], positions[c.idxB], Vector4(0.0f, 0.0f, 0.0f, 1.0f));
+		}
+	}
+}
+
+
+uint SoftBody::GetSnapshotSize() const
+{
+	return GetNumParticles() * (3 * SNAPSHOT_VECTOR3_BYTES + sizeof(float));
+}
+
+void SoftBody::SaveSnapshot(unsigned char* dst) const
+{
+	const uint n = GetNumParticles();
+	for (uint i = 0; i < n; ++i)
+	{
+		SnapshotUtils::Write(dst, positions[i]);
+		SnapshotUtils::Write(dst, prevPositions[i]);
+		SnapshotUtils::Write(dst, velocities[i]);
+		SnapshotUtils::Write(dst, invMasses[i]);
+	}
+}
+
+void SoftBody::RestoreSnapshot(const unsigned char* src)
+{
+	const uint n = GetNumParticles();
+	for (uint i = 0; i < n; ++i)
+	{
+		SnapshotUtils::Read(src, positions[i]);
+		SnapshotUtils::Read(src, prevPositions[i]);
+		SnapshotUtils::Read(src, velocities[i]);
+		SnapshotUtils::Read(src, invMasses[i]);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,160 @@
+/******************************************************************************
+Class: SoftBody
+Implements:
+Author:
+Pieran Marris      <p.marris@newcastle.ac.uk> and YOU!
+Description:
+
+A cloth/soft-body component solved with extended position based dynamics (XPBD),
+rather than building a grid of full rigid bodies joined by DistanceConstraints.
+
+Particles are stored in flat arrays (position, previous position, velocity and
+inverse mass) with no orientation or inertia, and are solved in three steps
+each substep:
+- Predict positions from velocity and gravity
+- Iteratively project the stretch, shear and bend distance constraints, each
+  with it's own compliance (inverse stiffness), so stiffness is independent of
+  iteration count and timestep.
+- A single collision pass that handles self-collision and couples the cloth to
+  any sphere/cuboid rigid bodies it touches.
+
+Self-collision candidates are found once per step through a spatial hash grid
+(padded by the furthest distance any particle could travel in that step), and
+the cached pair list is then reused by each substep.
+
+Soft bodies are owned by the PhysicsEngine once added (See AddSoftBody) and are
+stepped after the rigid bodies have been integrated.
+
+*//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <nclgl/common.h>
+#include <nclgl/Vector3.h>
+#include <nclgl/Vector4.h>
+#include <vector>
+
+class PhysicsNode;
+
+enum SoftBodyConstraintType
+{
+	SOFTBODY_STRETCH = 0,	//Direct neighbours along the grid axes
+	SOFTBODY_SHEAR,			//Diagonal neighbours
+	SOFTBODY_BEND,			//Neighbours two particles apart along the grid axes
+	SOFTBODY_NUM_CONSTRAINT_TYPES
+};
+
+struct SoftBodyConstraint
+{
+	uint	idxA;
+	uint	idxB;
+	float	restLength;
+	uint	type;			//SoftBodyConstraintType, used to lookup the compliance
+};
+
+class SoftBody
+{
+public:
+	SoftBody();
+	virtual ~SoftBody();
+
+	//Builds a cloth sheet of dimsU * dimsV particles spanning 'origin' to 'origin + extentU + extentV'
+	// - Particle (u, v) is stored at index u * dimsV + v
+	void BuildClothGrid(
+		const Vector3& origin,
+		const Vector3& extentU,
+		const Vector3& extentV,
+		uint dimsU, uint dimsV,
+		float totalMass,
+		float particleRadius);
+
+	//Steps the soft body forward by dt, colliding against the given rigid bodies
+	void Update(float dt, const Vector3& gravity, float dampingFactor, const std::vector<PhysicsNode*>& rigidBodies);
+
+	//Draws the cloth surface (and optionally it's constraints)
+	void DebugDraw(bool drawConstraints) const;
+
+	//Snapshot support (See PhysicsEngine::SaveSnapshot)
+	// - Only the particle state is stored, the constraints are fixed once the cloth is built
+	uint GetSnapshotSize() const;
+	void SaveSnapshot(unsigned char* dst) const;
+	void RestoreSnapshot(const unsigned char* src);
+
+
+	//<--------- GETTERS ------------->
+	inline uint				GetNumParticles()				const { return (uint)positions.size(); }
+	inline uint				GetClothParticleIndex(uint u, uint v) const { return u * dimsV + v; }
+	inline uint				GetClothDimsU()					const { return dimsU; }
+	inline uint				GetClothDimsV()					const { return dimsV; }
+	inline const Vector3&	GetParticlePosition(uint idx)	const { return positions[idx]; }
+	inline float			GetParticleInverseMass(uint idx) const { return invMasses[idx]; }
+	inline float			GetParticleRadius()				const { return particleRadius; }
+	inline const Vector4&	GetColor()						const { return color; }
+
+	//Triangle list covering the cloth surface, as indices into the particles
+	inline const std::vector<uint>& GetTriangleIndices()	const { return triangleIndices; }
+
+	//Index of the particle nearest to pos (e.g. for picking), the soft body must have at least one particle
+	uint FindClosestParticle(const Vector3& pos) const;
+
+	//<--------- SETTERS ------------->
+	//Setting the inverse mass to zero will pin the particle in place
+	inline void SetParticlePosition(uint idx, const Vector3& pos) { positions[idx] = pos; prevPositions[idx] = pos; }
+	inline void SetParticleInverseMass(uint idx, float invMass) { invMasses[idx] = invMass; }
+
+	//Compliance is the inverse stiffness of the constraint in m/N, zero is infinitely stiff
+	inline void SetCompliance(SoftBodyConstraintType type, float compliance) { compliances[type] = compliance; }
+
+	inline void SetSolverSubsteps(uint n) { numSubsteps = max(n, 1u); }
+	inline void SetSolverIterations(uint n) { numIterations = max(n, 1u); }
+
+	inline void SetSelfCollisionEnabled(bool enabled) { selfCollision = enabled; }
+	inline void SetFriction(float f) { friction = f; }
+	inline void SetColor(const Vector4& col) { color = col; }
+
+protected:
+	void AddConstraint(uint idxA, uint idxB, SoftBodyConstraintType type);
+
+	void SolveConstraints(float dt);
+	void BuildHashGrid(float cellSize);
+	void FindSelfCollisionPairs(float queryDistance);
+	void SolveSelfCollisions();
+	void SolveRigidCollisions(float dt, const std::vector<PhysicsNode*>& rigidBodies);
+
+	inline uint HashCell(int x, int y, int z) const
+	{
+		return (((uint)x * 92837111u) ^ ((uint)y * 689287499u) ^ ((uint)z * 283923481u)) % ((uint)hashCellStart.size() - 1);
+	}
+
+protected:
+	//Particle data (Stored as flat arrays indexed by particle)
+	std::vector<Vector3>	positions;
+	std::vector<Vector3>	prevPositions;
+	std::vector<Vector3>	velocities;
+	std::vector<Vector3>	restPositions;		//Used to skip self-collision between particles that start out touching
+	std::vector<float>		invMasses;
+
+	//Constraint data
+	std::vector<SoftBodyConstraint> constraints;
+	std::vector<float>		lambdas;			//XPBD accumulated lagrange multipliers (reset each substep)
+	float					compliances[SOFTBODY_NUM_CONSTRAINT_TYPES];
+
+	//Self-Collision hash grid (cellStart is one larger than the number of cells)
+	std::vector<uint>		hashCellStart;
+	std::vector<uint>		hashCellEntries;
+	float					hashInvCellSize;
+	std::vector<uint>		selfCollisionPairs;	//Flattened (idxA, idxB) candidate pairs for this step
+
+	//Rigid bodies overlapping the soft body this step
+	std::vector<PhysicsNode*> nearbyBodies;
+
+	//Render data
+	std::vector<uint>		triangleIndices;
+	Vector4					color;
+
+	uint	dimsU, dimsV;
+	float	particleRadius;
+	float	friction;
+	uint	numSubsteps;
+	uint	numIterations;
+	bool	selfCollision;
+};
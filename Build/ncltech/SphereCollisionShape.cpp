@@ -1,8 +1,8 @@
 #include "SphereCollisionShape.h"
 #include "PhysicsNode.h"
-#include <nclgl\NCLDebug.h>
-#include <nclgl\Matrix3.h>
-#include <nclgl\Vector3.h>
+#include <nclgl/NCLDebug.h>
+#include <nclgl/Matrix3.h>
+#include <nclgl/Vector3.h>
 
 
 SphereCollisionShape::SphereCollisionShape()
@@ -77,6 +77,66 @@ void SphereCollisionShape::GetIncidentReferencePolygon(
 	out_normal = axis;
 }
 
+bool SphereCollisionShape::RayCast(
+	const Vector3& origin,
+	const Vector3& dir,
+	float max_dist,
+	float inflate,
+	float& out_dist,
+	Vector3& out_normal) const
+{
+	const float radius = m_Radius + inflate;
+	const Vector3 m = origin - Parent()->GetPosition();
+	const float b = Vector3::Dot(m, dir);
+	const float c = Vector3::Dot(m, m) - radius * radius;
+
+	//Starting outside and pointing away
+	if (c > 0.0f && b > 0.0f)
+		return false;
+
+	const float discr = b * b - c;
+	if (discr < 0.0f)
+		return false;
+
+	if (c <= 0.0f)
+	{
+		//Starting inside
+		out_dist = 0.0f;
+		out_normal = -dir;
+		return true;
+	}
+
+	const float t = -b - sqrtf(discr);
+	if (t > max_dist)
+		return false;
+
+	out_dist = t;
+	out_normal = (m + dir * t) / radius;
+	return true;
+}
+
+bool SphereCollisionShape::OverlapsSphere(const Vector3& centre, float radius) const
+{
+	const Vector3 ab = centre - Parent()->GetPosition();
+	const float sum_radius = m_Radius + radius;
+	return Vector3::Dot(ab, ab) <= sum_radius * sum_radius;
+}
+
+bool SphereCollisionShape::OverlapsBox(const Vector3& centre, const Vector3& half_dims) const
+{
+	//Distance from the closest point in the box to our centre
+	const Vector3& pos = Parent()->GetPosition();
+	const Vector3 min_corner = centre - half_dims;
+	const Vector3 max_corner = centre + half_dims;
+	const Vector3 closest = Vector3(
+		min(max(pos.x, min_corner.x), max_corner.x),
+		min(max(pos.y, min_corner.y), max_corner.y),
+		min(max(pos.z, min_corner.z), max_corner.z));
+
+	const Vector3 diff = pos - closest;
+	return Vector3::Dot(diff, diff) <= m_Radius * m_Radius;
+}
+
 void SphereCollisionShape::DebugDraw() const
 {
 	Vector3 pos = Parent()->GetPosition();
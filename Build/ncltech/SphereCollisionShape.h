@@ -59,6 +59,19 @@ public:
 		Vector3& out_normal,
 		std::vector<Plane>& out_adjacent_planes) const override;
 
+
+	// Spatial Queries
+	virtual bool RayCast(
+		const Vector3& origin,
+		const Vector3& dir,
+		float max_dist,
+		float inflate,
+		float& out_dist,
+		Vector3& out_normal) const override;
+
+	virtual bool OverlapsSphere(const Vector3& centre, float radius) const override;
+	virtual bool OverlapsBox(const Vector3& centre, const Vector3& half_dims) const override;
+
 protected:
 	//float	m_Radius;
 };
@@ -2,7 +2,8 @@
 
 #include "Constraint.h"
 #include "PhysicsEngine.h"
-#include <nclgl\NCLDebug.h>
+#include "SnapshotUtils.h"
+#include <nclgl/NCLDebug.h>
 
 class SpringConstraint : public Constraint
 {
@@ -12,6 +13,7 @@ public:
 	{
 		pnodeA = obj1;
 		pnodeB = obj2;
+		timestep = 1.0f / 60.0f;
 
 		//Set the preferred distance of the constraint to enforce 
 		// (ONLY USED FOR BAUMGARTE)
@@ -29,6 +31,12 @@ public:
 		relPosB = Matrix3::Transpose(pnodeB->GetOrientation().ToMatrix3()) * r2;
 	}
 
+	//The timestep is kept for the baumgarte term, so the constraint works in whichever world is stepping it
+	virtual void PreSolverStep(float dt) override
+	{
+		timestep = dt;
+	}
+
 	//Solves the constraint and applies a velocity impulse to the two
 	// objects in order to satisfy the constraint.
 	virtual void ApplyImpulse() override
@@ -60,9 +68,9 @@ public:
 
 			float distance_offset = ab.Length() - targetLength;
 			float bumgarte_scalar = 0.1f;
-			b = -(bumgarte_scalar / PhysicsEngine::Instance()->GetDeltaTime()) * distance_offset;
+			b = -(bumgarte_scalar / timestep) * distance_offset;
 
-			float jn = (distance_offset *0.01) / (constraintMass * PhysicsEngine::Instance()->GetDeltaTime()) - (abnVel * 0.01);
+			float jn = (distance_offset *0.01) / (constraintMass * timestep) - (abnVel * 0.01);
 
 			pnodeA->SetLinearVelocity(pnodeA->GetLinearVelocity() + abn * (pnodeA->GetInverseMass() * jn));
 			pnodeB->SetLinearVelocity(pnodeB->GetLinearVelocity() - abn * (pnodeB->GetInverseMass() * jn));
@@ -83,10 +91,31 @@ public:
 		NCLDebug::DrawPointNDT(globalOnB, 0.05f, Vector4(1.0f, 0.8f, 1.0f, 1.0f));
 	}
 
+	//Snapshot the attachment points and target length
+	virtual uint GetSnapshotSize() const override
+	{
+		return sizeof(float) + 2 * SNAPSHOT_VECTOR3_BYTES;
+	}
+
+	virtual void SaveSnapshot(unsigned char* dst) const override
+	{
+		SnapshotUtils::Write(dst, targetLength);
+		SnapshotUtils::Write(dst, relPosA);
+		SnapshotUtils::Write(dst, relPosB);
+	}
+
+	virtual void RestoreSnapshot(const unsigned char* src) override
+	{
+		SnapshotUtils::Read(src, targetLength);
+		SnapshotUtils::Read(src, relPosA);
+		SnapshotUtils::Read(src, relPosB);
+	}
+
 protected:
 	PhysicsNode *pnodeA, *pnodeB;
 
 	float   targetLength;
+	float	timestep;		//Set by PreSolverStep each step
 
 	Vector3 relPosA;
 	Vector3 relPosB;
@@ -0,0 +1,587 @@
+#include "TriangleMeshCollisionShape.h"
+#include "SphereCollisionShape.h"
+#include "CuboidCollisionShape.h"
+#include "CollisionDetectionSAT.h"
+#include "PhysicsNode.h"
+#include "Manifold.h"
+#include <nclgl/NCLDebug.h>
+#ifndef USE_HEADLESS_PHYSICS
+#include <nclgl/Mesh.h>
+#include <nclgl/ChildMeshInterface.h>
+#endif
+#include <algorithm>
+
+static inline Vector3 ComponentMin(const Vector3& a, const Vector3& b)
+{
+	return Vector3(min(a.x, b.x), min(a.y, b.y), min(a.z, b.z));
+}
+
+static inline Vector3 ComponentMax(const Vector3& a, const Vector3& b)
+{
+	return Vector3(max(a.x, b.x), max(a.y, b.y), max(a.z, b.z));
+}
+
+static inline float GetAxis(const Vector3& v, int axis)
+{
+	return (axis == 0) ? v.x : ((axis == 1) ? v.y : v.z);
+}
+
+//Slab test between a ray and an axis aligned box, returns false if the box is missed within max_dist
+static bool RayIntersectsBounds(const Vector3& origin, const Vector3& dir, const Vector3& lower, const Vector3& upper, float max_dist)
+{
+	const float o[3] = { origin.x, origin.y, origin.z };
+	const float d[3] = { dir.x, dir.y, dir.z };
+	const float lo[3] = { lower.x, lower.y, lower.z };
+	const float hi[3] = { upper.x, upper.y, upper.z };
+
+	float tmin = 0.0f, tmax = max_dist;
+	for (int i = 0; i < 3; ++i)
+	{
+		if (fabs(d[i]) < 1e-8f)
+		{
+			//Parallel to the slab, so must start within it
+			if (o[i] < lo[i] || o[i] > hi[i])
+				return false;
+			continue;
+		}
+
+		float t1 = (lo[i] - o[i]) / d[i];
+		float t2 = (hi[i] - o[i]) / d[i];
+		if (t1 > t2) std::swap(t1, t2);
+		tmin = max(tmin, t1);
+		tmax = min(tmax, t2);
+		if (tmin > tmax)
+			return false;
+	}
+	return true;
+}
+
+
+
+TriangleMeshCollisionShape::TriangleMeshCollisionShape()
+	: localMin(0.0f, 0.0f, 0.0f)
+	, localMax(0.0f, 0.0f, 0.0f)
+{
+	m_Radius = 0.0f;
+}
+
+#ifndef USE_HEADLESS_PHYSICS
+TriangleMeshCollisionShape::TriangleMeshCollisionShape(const Mesh* mesh, const Matrix4& transform)
+	: localMin(0.0f, 0.0f, 0.0f)
+	, localMax(0.0f, 0.0f, 0.0f)
+{
+	m_Radius = 0.0f;
+	AddMesh(mesh, transform);
+	BuildBVH();
+}
+#endif
+
+TriangleMeshCollisionShape::~TriangleMeshCollisionShape()
+{
+
+}
+
+void TriangleMeshCollisionShape::AddTriangle(const Vector3& a, const Vector3& b, const Vector3& c)
+{
+	Vector3 n = Vector3::Cross(b - a, c - a);
+	if (Vector3::Dot(n, n) < 1e-12f)
+		return;
+
+	vertices.push_back(a);
+	vertices.push_back(b);
+	vertices.push_back(c);
+}
+
+#ifndef USE_HEADLESS_PHYSICS
+void TriangleMeshCollisionShape::AddMesh(const Mesh* mesh, const Matrix4& transform)
+{
+	if (mesh == NULL)
+		return;
+
+	if (mesh->vertices != NULL)
+	{
+		//Unindexed meshes just use their vertices in order
+		const uint num_elements = (mesh->indices != NULL) ? mesh->numIndices : mesh->numVertices;
+		auto vertex = [&](uint i) {
+			return transform * mesh->vertices[(mesh->indices != NULL) ? mesh->indices[i] : i];
+		};
+
+		if (mesh->type == GL_TRIANGLES)
+		{
+			for (uint i = 0; i + 2 < num_elements; i += 3)
+				AddTriangle(vertex(i), vertex(i + 1), vertex(i + 2));
+		}
+		else if (mesh->type == GL_TRIANGLE_STRIP)
+		{
+			//Every other triangle in a strip has it's winding reversed
+			for (uint i = 0; i + 2 < num_elements; ++i)
+			{
+				if (i & 1)
+					AddTriangle(vertex(i + 1), vertex(i), vertex(i + 2));
+				else
+					AddTriangle(vertex(i), vertex(i + 1), vertex(i + 2));
+			}
+		}
+	}
+
+	//OBJ and MD5 meshes store every sub-mesh after the first as a child
+	const ChildMeshInterface* parent = dynamic_cast<const ChildMeshInterface*>(mesh);
+	if (parent)
+	{
+		for (const Mesh* child : parent->GetChildren())
+			AddMesh(child, transform);
+	}
+}
+#endif
+
+void TriangleMeshCollisionShape::BuildBVH()
+{
+	nodes.clear();
+
+	const uint num_tris = GetNumTriangles();
+	if (num_tris == 0)
+	{
+		localMin = localMax = Vector3(0.0f, 0.0f, 0.0f);
+		m_Radius = 0.0f;
+		return;
+	}
+
+	std::vector<uint> tri_order(num_tris);
+	std::vector<Vector3> centroids(num_tris);
+	for (uint i = 0; i < num_tris; ++i)
+	{
+		tri_order[i] = i;
+		centroids[i] = (vertices[i * 3] + vertices[i * 3 + 1] + vertices[i * 3 + 2]) / 3.0f;
+	}
+
+	nodes.reserve(2 * (num_tris / MAX_LEAF_TRIANGLES) + 1);
+	BuildNode(tri_order, centroids, 0, num_tris);
+	nodes.shrink_to_fit();
+
+	//Reorder the triangles so every leaf references a contiguous range of them
+	std::vector<Vector3> sorted(vertices.size());
+	for (uint i = 0; i < num_tris; ++i)
+	{
+		sorted[i * 3] = vertices[tri_order[i] * 3];
+		sorted[i * 3 + 1] = vertices[tri_order[i] * 3 + 1];
+		sorted[i * 3 + 2] = vertices[tri_order[i] * 3 + 2];
+	}
+	vertices.swap(sorted);
+
+	localMin = nodes[0].boundsMin;
+	localMax = nodes[0].boundsMax;
+
+	//The broadphase bounds the mesh with a sphere around the parent's position
+	float max_dist_sq = 0.0f;
+	for (const Vector3& v : vertices)
+		max_dist_sq = max(max_dist_sq, Vector3::Dot(v, v));
+	m_Radius = sqrtf(max_dist_sq);
+}
+
+uint TriangleMeshCollisionShape::BuildNode(std::vector<uint>& tri_order, const std::vector<Vector3>& centroids, uint first, uint count)
+{
+	const uint node_idx = (uint)nodes.size();
+	nodes.push_back(TriangleMeshBVHNode());
+
+	Vector3 bounds_min(FLT_MAX, FLT_MAX, FLT_MAX), bounds_max(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	Vector3 centroid_min = bounds_min, centroid_max = bounds_max;
+	for (uint i = first; i < first + count; ++i)
+	{
+		const uint tri = tri_order[i];
+		for (uint j = 0; j < 3; ++j)
+		{
+			bounds_min = ComponentMin(bounds_min, vertices[tri * 3 + j]);
+			bounds_max = ComponentMax(bounds_max, vertices[tri * 3 + j]);
+		}
+		centroid_min = ComponentMin(centroid_min, centroids[tri]);
+		centroid_max = ComponentMax(centroid_max, centroids[tri]);
+	}
+	nodes[node_idx].boundsMin = bounds_min;
+	nodes[node_idx].boundsMax = bounds_max;
+
+	//Split along the longest axis of the triangles' centres
+	const Vector3 extents = centroid_max - centroid_min;
+	int axis = 0;
+	if (extents.y > GetAxis(extents, axis)) axis = 1;
+	if (extents.z > GetAxis(extents, axis)) axis = 2;
+
+	if (count <= MAX_LEAF_TRIANGLES || GetAxis(extents, axis) < 1e-6f)
+	{
+		nodes[node_idx].offset = first;
+		nodes[node_idx].count = count;
+		return node_idx;
+	}
+
+	//Median split keeps the tree balanced, so it's depth is always log2 of the number of triangles
+	const uint mid = first + count / 2;
+	std::nth_element(
+		tri_order.begin() + first,
+		tri_order.begin() + mid,
+		tri_order.begin() + first + count,
+		[&](uint a, uint b) { return GetAxis(centroids[a], axis) < GetAxis(centroids[b], axis); });
+
+	BuildNode(tri_order, centroids, first, mid - first);
+	const uint second_child = BuildNode(tri_order, centroids, mid, first + count - mid);
+
+	nodes[node_idx].offset = second_child;
+	nodes[node_idx].count = 0;
+	return node_idx;
+}
+
+Matrix3 TriangleMeshCollisionShape::BuildInverseInertia(float invMass) const
+{
+	return Matrix3::ZeroMatrix;
+}
+
+void TriangleMeshCollisionShape::GetWorldTransform(Matrix3& out_rotation, Vector3& out_position) const
+{
+	out_rotation = Parent()->GetOrientation().ToMatrix3();
+	out_position = Parent()->GetPosition();
+}
+
+void TriangleMeshCollisionShape::GenConcaveContactPoints(const PhysicsNode* otherObject, Manifold* out_manifold) const
+{
+	Matrix3 rotation;
+	Vector3 position;
+	GetWorldTransform(rotation, position);
+
+	Vector3 world_min, world_max, local_min, local_max;
+	otherObject->GetCollisionShape()->GetWorldAABB(world_min, world_max);
+	WorldToLocalAABB(rotation, position, world_min, world_max, local_min, local_max);
+
+	Vector3 tri[3];
+	ForEachTriangleInBounds(local_min, local_max, [&](uint idx) {
+		tri[0] = position + rotation * vertices[idx * 3];
+		tri[1] = position + rotation * vertices[idx * 3 + 1];
+		tri[2] = position + rotation * vertices[idx * 3 + 2];
+		GenTriangleContactPoints(tri, otherObject, out_manifold);
+		return false;
+	});
+
+	//Neighbouring triangles often generate the same contacts along their shared edges, only keep the deepest
+	std::vector<ContactPoint>& contacts = out_manifold->contactPoints;
+	size_t num_unique = 0;
+	for (size_t i = 0; i < contacts.size(); ++i)
+	{
+		bool duplicate = false;
+		for (size_t j = 0; j < num_unique && !duplicate; ++j)
+		{
+			Vector3 diff = contacts[i].relPosB - contacts[j].relPosB;
+			if (Vector3::Dot(diff, diff) < 1e-6f
+				&& Vector3::Dot(contacts[i].colNormal, contacts[j].colNormal) > 0.999f)
+			{
+				if (contacts[i].colPenetration < contacts[j].colPenetration)
+					contacts[j] = contacts[i];
+				duplicate = true;
+			}
+		}
+
+		if (!duplicate)
+			contacts[num_unique++] = contacts[i];
+	}
+	contacts.resize(num_unique);
+}
+
+void TriangleMeshCollisionShape::GenTriangleContactPoints(
+	const Vector3 tri[3],
+	const PhysicsNode* otherObject,
+	Manifold* out_manifold)
+{
+	const CollisionShape* otherShape = otherObject->GetCollisionShape();
+	Vector3 face_normal = Vector3::Cross(tri[1] - tri[0], tri[2] - tri[0]).Normalise();
+
+	//Spheres - Closest point on the triangle, so they can roll smoothly over edges
+	const SphereCollisionShape* sphere = dynamic_cast<const SphereCollisionShape*>(otherShape);
+	if (sphere)
+	{
+		const Vector3 centre = otherObject->GetPosition();
+		const float radius = sphere->GetRadius();
+
+		Vector3 closest = GetClosestPointTriangle(centre, tri[0], tri[1], tri[2]);
+		Vector3 diff = centre - closest;
+		float dist_sq = Vector3::Dot(diff, diff);
+		if (dist_sq >= radius * radius)
+			return;
+
+		float dist = sqrtf(dist_sq);
+		Vector3 normal = (dist > 1e-6f)
+			? diff / dist
+			: face_normal;
+
+		out_manifold->AddContact(closest, centre - normal * radius, normal, dist - radius);
+		return;
+	}
+
+	//Cuboids - SAT between the triangle and box, then clip the triangle and box face against each other
+	const CuboidCollisionShape* cuboid = dynamic_cast<const CuboidCollisionShape*>(otherShape);
+	if (cuboid)
+	{
+		Vector3 normal;
+		float depth;
+		if (!TriangleBoxOverlap(tri[0], tri[1], tri[2],
+			otherObject->GetPosition(),
+			otherObject->GetOrientation().ToMatrix3(),
+			cuboid->GetHalfDims(),
+			&normal, &depth))
+		{
+			return;
+		}
+
+		//The triangle is the polygon for node A, facing towards the box and clipped by planes along each of it's edges
+		if (Vector3::Dot(face_normal, normal) < 0.0f)
+			face_normal = -face_normal;
+
+		std::list<Vector3> polygon1(tri, tri + 3), polygon2;
+		Vector3 normal1 = face_normal, normal2;
+		std::vector<Plane> adjPlanes1, adjPlanes2;
+		for (int i = 0; i < 3; ++i)
+		{
+			const Vector3& p = tri[i];
+			Vector3 plane_normal = Vector3::Cross(face_normal, tri[(i + 1) % 3] - p).Normalise();
+			if (Vector3::Dot(plane_normal, tri[(i + 2) % 3] - p) < 0.0f)
+				plane_normal = -plane_normal;
+
+			adjPlanes1.push_back(Plane(plane_normal, -Vector3::Dot(plane_normal, p)));
+		}
+
+		cuboid->GetIncidentReferencePolygon(-normal, polygon2, normal2, adjPlanes2);
+
+		CollisionDetectionSAT::ClipPolygonsToManifold(
+			normal, -depth,
+			polygon1, normal1, adjPlanes1,
+			polygon2, normal2, adjPlanes2,
+			out_manifold);
+		return;
+	}
+
+	//Everything else - The shape's furthest point behind the triangle, as long as it's within the triangle's bounds
+	if (Vector3::Dot(face_normal, otherObject->GetPosition() - tri[0]) < 0.0f)
+		face_normal = -face_normal;
+
+	Vector3 deepest, upper;
+	otherShape->GetMinMaxVertexOnAxis(face_normal, deepest, upper);
+
+	const float penetration = Vector3::Dot(deepest - tri[0], face_normal);
+	if (penetration >= 0.0f)
+		return;
+
+	const Vector3 on_plane = deepest - face_normal * penetration;
+	const Vector3 diff = GetClosestPointTriangle(on_plane, tri[0], tri[1], tri[2]) - on_plane;
+	if (Vector3::Dot(diff, diff) > 1e-6f)
+		return;
+
+	out_manifold->AddContact(on_plane, deepest, face_normal, penetration);
+}
+
+bool TriangleMeshCollisionShape::RayCast(
+	const Vector3& origin,
+	const Vector3& dir,
+	float max_dist,
+	float inflate,
+	float& out_dist,
+	Vector3& out_normal) const
+{
+	if (nodes.empty())
+		return false;
+
+	//Cast the ray in local space, so the BVH doesn't need to be transformed
+	Matrix3 rotation;
+	Vector3 position;
+	GetWorldTransform(rotation, position);
+	const Matrix3 inv_rotation = Matrix3::Transpose(rotation);
+	const Vector3 local_origin = inv_rotation * (origin - position);
+	const Vector3 local_dir = inv_rotation * dir;
+	const Vector3 grow = Vector3(inflate, inflate, inflate);
+
+	bool hit = false;
+	float best_dist = max_dist;
+	Vector3 best_normal;
+
+	uint stack[MAX_TREE_DEPTH];
+	uint stack_size = 0;
+	stack[stack_size++] = 0;
+	while (stack_size > 0)
+	{
+		const uint idx = stack[--stack_size];
+		const TriangleMeshBVHNode& node = nodes[idx];
+		if (!RayIntersectsBounds(local_origin, local_dir, node.boundsMin - grow, node.boundsMax + grow, best_dist))
+			continue;
+
+		if (node.count == 0)
+		{
+			stack[stack_size++] = node.offset;
+			stack[stack_size++] = idx + 1;
+			continue;
+		}
+
+		for (uint i = node.offset; i < node.offset + node.count; ++i)
+		{
+			Vector3 a = vertices[i * 3], b = vertices[i * 3 + 1], c = vertices[i * 3 + 2];
+
+			//Triangles are double sided, so always test the side facing the ray
+			Vector3 normal = Vector3::Cross(b - a, c - a).Normalise();
+			if (Vector3::Dot(normal, local_dir) > 0.0f)
+			{
+				normal = -normal;
+				std::swap(b, c);
+			}
+			const Vector3 offset = normal * inflate;
+
+			float dist;
+			if (RayTriangleIntersection(local_origin, local_dir, a + offset, b + offset, c + offset, best_dist, dist))
+			{
+				hit = true;
+				best_dist = dist;
+				best_normal = normal;
+			}
+		}
+	}
+
+	if (hit)
+	{
+		out_dist = best_dist;
+		out_normal = rotation * best_normal;
+	}
+	return hit;
+}
+
+bool TriangleMeshCollisionShape::OverlapsSphere(const Vector3& centre, float radius) const
+{
+	Matrix3 rotation;
+	Vector3 position;
+	GetWorldTransform(rotation, position);
+
+	const Vector3 local_centre = Matrix3::Transpose(rotation) * (centre - position);
+	const Vector3 r = Vector3(radius, radius, radius);
+
+	return ForEachTriangleInBounds(local_centre - r, local_centre + r, [&](uint idx) {
+		Vector3 diff = local_centre - GetClosestPointTriangle(local_centre, vertices[idx * 3], vertices[idx * 3 + 1], vertices[idx * 3 + 2]);
+		return Vector3::Dot(diff, diff) <= radius * radius;
+	});
+}
+
+bool TriangleMeshCollisionShape::OverlapsBox(const Vector3& centre, const Vector3& half_dims) const
+{
+	Matrix3 rotation;
+	Vector3 position;
+	GetWorldTransform(rotation, position);
+
+	Vector3 local_min, local_max;
+	WorldToLocalAABB(rotation, position, centre - half_dims, centre + half_dims, local_min, local_max);
+
+	return ForEachTriangleInBounds(local_min, local_max, [&](uint idx) {
+		return TriangleBoxOverlap(
+			position + rotation * vertices[idx * 3],
+			position + rotation * vertices[idx * 3 + 1],
+			position + rotation * vertices[idx * 3 + 2],
+			centre, Matrix3::Identity, half_dims);
+	});
+}
+
+void TriangleMeshCollisionShape::GetCollisionAxes(
+	const PhysicsNode* otherObject,
+	std::vector<Vector3>& out_axes) const
+{
+	//Not a convex shape, see GenConcaveContactPoints
+}
+
+Vector3 TriangleMeshCollisionShape::GetClosestPoint(const Vector3& point) const
+{
+	if (nodes.empty())
+		return Parent()->GetPosition();
+
+	Matrix3 rotation;
+	Vector3 position;
+	GetWorldTransform(rotation, position);
+	const Vector3 local_point = Matrix3::Transpose(rotation) * (point - position);
+
+	//Only descend into nodes that could contain something closer than the best point found so far
+	float best_dist_sq = FLT_MAX;
+	Vector3 best_point;
+
+	uint stack[MAX_TREE_DEPTH];
+	uint stack_size = 0;
+	stack[stack_size++] = 0;
+	while (stack_size > 0)
+	{
+		const uint idx = stack[--stack_size];
+		const TriangleMeshBVHNode& node = nodes[idx];
+
+		const Vector3 to_box = local_point - ComponentMin(ComponentMax(local_point, node.boundsMin), node.boundsMax);
+		if (Vector3::Dot(to_box, to_box) >= best_dist_sq)
+			continue;
+
+		if (node.count == 0)
+		{
+			stack[stack_size++] = node.offset;
+			stack[stack_size++] = idx + 1;
+			continue;
+		}
+
+		for (uint i = node.offset; i < node.offset + node.count; ++i)
+		{
+			Vector3 closest = GetClosestPointTriangle(local_point, vertices[i * 3], vertices[i * 3 + 1], vertices[i * 3 + 2]);
+			Vector3 diff = local_point - closest;
+			float dist_sq = Vector3::Dot(diff, diff);
+			if (dist_sq < best_dist_sq)
+			{
+				best_dist_sq = dist_sq;
+				best_point = closest;
+			}
+		}
+	}
+
+	return position + rotation * best_point;
+}
+
+void TriangleMeshCollisionShape::GetMinMaxVertexOnAxis(
+	const Vector3& axis,
+	Vector3& out_min,
+	Vector3& out_max) const
+{
+	//Extents of the (rotated) bounding box along the axis
+	Matrix3 rotation;
+	Vector3 position;
+	GetWorldTransform(rotation, position);
+
+	const Vector3 centre = position + rotation * ((localMin + localMax) * 0.5f);
+	const Vector3 half_dims = (localMax - localMin) * 0.5f;
+
+	Vector3 offset = Vector3(0.0f, 0.0f, 0.0f);
+	for (int i = 0; i < 3; ++i)
+	{
+		const Vector3& box_axis = rotation.GetCol(i);
+		const float extent = GetAxis(half_dims, i);
+		offset = offset + box_axis * ((Vector3::Dot(box_axis, axis) >= 0.0f) ? extent : -extent);
+	}
+
+	out_min = centre - offset;
+	out_max = centre + offset;
+}
+
+void TriangleMeshCollisionShape::GetIncidentReferencePolygon(
+	const Vector3& axis,
+	std::list<Vector3>& out_face,
+	Vector3& out_normal,
+	std::vector<Plane>& out_adjacent_planes) const
+{
+	//Not a convex shape, see GenConcaveContactPoints
+}
+
+void TriangleMeshCollisionShape::DebugDraw() const
+{
+	Matrix3 rotation;
+	Vector3 position;
+	GetWorldTransform(rotation, position);
+
+	for (uint i = 0; i < GetNumTriangles(); ++i)
+	{
+		const Vector3 a = position + rotation * vertices[i * 3];
+		const Vector3 b = position + rotation * vertices[i * 3 + 1];
+		const Vector3 c = position + rotation * vertices[i * 3 + 2];
+
+		NCLDebug::DrawHairLine(a, b, Vector4(0.5f, 0.5f, 1.0f, 1.0f));
+		NCLDebug::DrawHairLine(b, c, Vector4(0.5f, 0.5f, 1.0f, 1.0f));
+		NCLDebug::DrawHairLine(c, a, Vector4(0.5f, 0.5f, 1.0f, 1.0f));
+	}
+}
@@ -0,0 +1,181 @@
+/******************************************************************************
+Class: TriangleMeshCollisionShape
+Implements: CollisionShape
+Author:
+Pieran Marris      <p.marris@newcastle.ac.uk> and YOU!
+Description:
+
+Extends CollisionShape to represent an arbitrary (static) triangle soup, such as a level loaded
+from an OBJMesh or the walls of a maze (See MazeRenderer::BuildCollisionShape). The triangles are
+stored relative to the parent PhysicsNode, so the whole level can be moved/rotated as one object
+and only ever takes up a single entry in the broadphase.
+
+To keep contact generation cheap regardless of how many triangles the level has, they are sorted
+into a bounding volume hierarchy. The tree is flattened into a single array with each node's first
+child directly following it, so queries just walk the array with a small stack and only descend into
+nodes whose bounding box overlaps the query.
+
+Triangles are double sided and have no 'inside', so objects moving fast enough to pass all the way
+through a wall in a single timestep will not be pushed back out.
+
+*//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "CollisionShape.h"
+#include <nclgl/common.h>
+#include <nclgl/Matrix4.h>
+
+class Mesh;
+
+//Node in the flattened BVH, leaves reference a contiguous range of triangles
+struct TriangleMeshBVHNode
+{
+	Vector3	boundsMin;
+	Vector3	boundsMax;
+	uint	offset;		//Leaf: First triangle, Internal: Index of the second child (the first always follows it's parent)
+	uint	count;		//Number of triangles in a leaf, zero for internal nodes
+};
+
+class TriangleMeshCollisionShape : public CollisionShape
+{
+public:
+	TriangleMeshCollisionShape();
+
+	//Builds the shape from every triangle of the mesh (and it's child meshes), transformed into the parent's local space
+	// - Meshes are part of the renderer, so this (and AddMesh) aren't available to headless builds
+#ifndef USE_HEADLESS_PHYSICS
+	TriangleMeshCollisionShape(const Mesh* mesh, const Matrix4& transform = Matrix4());
+#endif
+	virtual ~TriangleMeshCollisionShape();
+
+
+	//Adds a triangle (in the parent PhysicsNode's local space), degenerate triangles are ignored.
+	// - BuildBVH must be called once all triangles have been added, before the shape is used
+	void AddTriangle(const Vector3& a, const Vector3& b, const Vector3& c);
+
+	//Adds every triangle of the given mesh, including any child meshes of OBJ/MD5 meshes.
+	// - Only GL_TRIANGLES and GL_TRIANGLE_STRIP meshes that still have their vertex data are supported
+#ifndef USE_HEADLESS_PHYSICS
+	void AddMesh(const Mesh* mesh, const Matrix4& transform = Matrix4());
+#endif
+
+	//Sorts all triangles into the bounding volume hierarchy and updates the bounding radius
+	void BuildBVH();
+
+	inline uint GetNumTriangles() const { return (uint)(vertices.size() / 3); }
+	inline uint GetNumBVHNodes() const { return (uint)nodes.size(); }
+
+
+	// Bounding radius is derived from the triangles
+	virtual void	SetRadius(float radius) override {}
+	virtual float	GetRadius() const override { return m_Radius; }
+
+	// Debug Collision Shape
+	virtual void DebugDraw() const override;
+
+	// Meshes are always static, so have no rotational mass
+	virtual Matrix3 BuildInverseInertia(float invMass) const override;
+
+
+	// Generic Collision Detection Routines
+	//  - The mesh is concave, so these only describe the mesh's bounding box (apart
+	//    from GetClosestPoint) and are never used by the narrowphase
+	virtual void GetCollisionAxes(
+		const PhysicsNode* otherObject,
+		std::vector<Vector3>& out_axes) const override;
+
+	virtual Vector3 GetClosestPoint(const Vector3& point) const override;
+
+	virtual void GetMinMaxVertexOnAxis(
+		const Vector3& axis,
+		Vector3& out_min,
+		Vector3& out_max) const override;
+
+	virtual void GetIncidentReferencePolygon(
+		const Vector3& axis,
+		std::list<Vector3>& out_face,
+		Vector3& out_normal,
+		std::vector<Plane>& out_adjacent_planes) const override;
+
+
+	// Concave Collision Detection
+	//  - Spheres are tested against the closest point on each triangle, cuboids with a triangle/box
+	//    SAT test clipped the same way as CollisionDetectionSAT, and any other convex shape by it's
+	//    furthest point along each triangle's normal.
+	virtual bool IsConcave() const override { return true; }
+	virtual void GenConcaveContactPoints(const PhysicsNode* otherObject, Manifold* out_manifold) const override;
+
+
+	// Spatial Queries
+	//  - Sphere casts offset each triangle by the sphere radius, so are slightly optimistic around
+	//    sharp edges. Rays starting 'inside' a closed mesh still only hit it's surface.
+	virtual bool RayCast(
+		const Vector3& origin,
+		const Vector3& dir,
+		float max_dist,
+		float inflate,
+		float& out_dist,
+		Vector3& out_normal) const override;
+
+	virtual bool OverlapsSphere(const Vector3& centre, float radius) const override;
+	virtual bool OverlapsBox(const Vector3& centre, const Vector3& half_dims) const override;
+
+protected:
+	//Recursively builds the node covering tri_order[first, first + count), returning it's index
+	uint BuildNode(std::vector<uint>& tri_order, const std::vector<Vector3>& centroids, uint first, uint count);
+
+	//Parent's world space rotation/position, which the triangles are stored relative to
+	void GetWorldTransform(Matrix3& out_rotation, Vector3& out_position) const;
+
+	//Calls func(triangle_index) for every triangle in a BVH leaf overlapping the given local space box,
+	// stopping early if func returns true
+	template <typename Func>
+	bool ForEachTriangleInBounds(const Vector3& local_min, const Vector3& local_max, Func func) const
+	{
+		if (nodes.empty())
+			return false;
+
+		uint stack[MAX_TREE_DEPTH];
+		uint stack_size = 0;
+		stack[stack_size++] = 0;
+		while (stack_size > 0)
+		{
+			const uint idx = stack[--stack_size];
+			const TriangleMeshBVHNode& node = nodes[idx];
+			if (node.boundsMin.x > local_max.x || node.boundsMax.x < local_min.x
+				|| node.boundsMin.y > local_max.y || node.boundsMax.y < local_min.y
+				|| node.boundsMin.z > local_max.z || node.boundsMax.z < local_min.z)
+				continue;
+
+			if (node.count > 0)
+			{
+				for (uint i = node.offset; i < node.offset + node.count; ++i)
+				{
+					if (func(i)) return true;
+				}
+			}
+			else
+			{
+				stack[stack_size++] = node.offset;
+				stack[stack_size++] = idx + 1;
+			}
+		}
+		return false;
+	}
+
+	//Contacts between a single world space triangle and the other (convex) object
+	static void GenTriangleContactPoints(
+		const Vector3 tri[3],
+		const PhysicsNode* otherObject,
+		Manifold* out_manifold);
+
+protected:
+	static const uint MAX_LEAF_TRIANGLES = 4;
+	static const uint MAX_TREE_DEPTH = 64;
+
+	std::vector<Vector3>				vertices;	//Three per triangle, in BVH order once built
+	std::vector<TriangleMeshBVHNode>	nodes;		//Depth first, nodes[0] is the root
+
+	Vector3	localMin, localMax;	//Bounding box of all triangles
+};